@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""Performance regression harness for DualSPHysics4CPU.
+
+Runs the cases of RUN_DIRECTORY at several resolutions in benchmark mode
+(-bench:steps:warmup, fixed number of steps without output files), collects
+the Bench.json of each run in one results file and compares steps/s and
+particle-steps/s (total and per timer) against a stored baseline.
+
+  RunBenchmark.py [options]
+    --scales 2,1.5,1   Factors applied to the dp of each case (dp*scale).
+    --steps 100        Measured steps per run.
+    --warmup 10        Steps before measuring.
+    --cases a,b        Only cases whose name contains one of the strings.
+    --save-baseline    Saves the results as the new baseline.
+    --baseline file    Baseline file (Baseline.json by default).
+    --tolerance 0.10   Allowed relative slowdown before reporting regression.
+    --mintimer 5       Minimum share (%) of a timer to be compared.
+
+Exit code is 1 when a run fails or a regression is detected.
+"""
+
+import argparse
+import json
+import os
+import re
+import subprocess
+import sys
+
+DIRSCRIPT = os.path.dirname(os.path.abspath(__file__))
+DIRRUN = os.path.normpath(os.path.join(DIRSCRIPT, '..', '..'))
+DIREXECS = os.path.normpath(os.path.join(DIRRUN, '..', 'EXECS'))
+
+# Cases of RUN_DIRECTORY: (directory, case name, extra options of DualSPHysics).
+# Only cases with a CPU run script are included: 11_CASEMULTIPHASE is GPU-only
+# and 5_CASESLOSHING/CaseFloating_Def.xml is an identical copy of
+# 8_CASEFLOATING/CaseFloating_Def.xml, which is already benchmarked.
+CASES = [
+    ('1_CASEDAMBREAK', 'CaseDambreak', []),
+    ('1_CASEDAMBREAK', 'CaseDambreakVal2D', []),
+    ('2_CASEPERIODICITY', 'CasePeriodicity', []),
+    ('3_CASEMOVINGSQUARE', 'CaseMovingSquare', []),
+    ('4_CASEFORCES', 'CaseForces', ['-cellmode:2H']),
+    ('5_CASESLOSHING', 'CaseSloshingAcc', []),
+    ('5_CASESLOSHING', 'CaseSloshingMotion', []),
+    ('6_CASEWAVEMAKER', 'CaseWavemaker', []),
+    ('6_CASEWAVEMAKER', 'CaseWavemaker2D', []),
+    ('7_CASEWAVEGENERATION', 'CaseWavesREG', []),
+    ('7_CASEWAVEGENERATION', 'CaseWavesIRREG', []),
+    ('8_CASEFLOATING', 'CaseFloating', []),
+    ('8_CASEFLOATING', 'CaseFloatingSphereVal2D', []),
+    ('8_CASEFLOATING', 'CaseFloatingWavesVal', []),
+    ('9_CASEPUMP', 'CasePump', []),
+    ('10_CASEDEM', 'CaseBowling', []),
+    ('10_CASEDEM', 'CaseSolids', []),
+]
+
+
+def case_dp(dircase, name):
+    """Returns the dp of the <definition> element of the case XML."""
+    with open(os.path.join(dircase, name + '_Def.xml'), encoding='latin-1') as f:
+        m = re.search(r'<definition\s+dp="([^"]+)"', f.read())
+    if not m:
+        raise RuntimeError('dp not found in %s_Def.xml' % name)
+    return float(m.group(1))
+
+
+def run(cmd, cwd, env, log):
+    with open(log, 'a') as f:
+        f.write('\n$ %s\n' % ' '.join(cmd))
+        f.flush()
+        return subprocess.call(cmd, cwd=cwd, env=env, stdout=f, stderr=subprocess.STDOUT)
+
+
+def run_case(args, env, dircase, name, options, scale):
+    """Runs GenCase and DualSPHysics in benchmark mode, returns the Bench.json data."""
+    dp = case_dp(dircase, name) * scale
+    dirout = os.path.join(args.dirout, '%s_x%g' % (name, scale))
+    os.makedirs(dirout, exist_ok=True)
+    log = os.path.join(dirout, 'Run.log')
+    if os.path.exists(log):
+        os.remove(log)
+    if run([args.gencase, name + '_Def', os.path.join(dirout, name), '-dp:%g' % dp],
+           dircase, env, log):
+        raise RuntimeError('GenCase failed (see %s)' % log)
+    cmd = [args.dualsphysics, os.path.join(dirout, name), dirout, '-cpu', '-svres:0',
+           '-bench:%d:%d' % (args.steps, args.warmup)] + options
+    if args.ompthreads:
+        cmd.append('-ompthreads:%d' % args.ompthreads)
+    if run(cmd, dircase, env, log):
+        raise RuntimeError('DualSPHysics failed (see %s)' % log)
+    with open(os.path.join(dirout, 'Bench.json')) as f:
+        res = json.load(f)
+    res['dp'] = dp
+    res['scale'] = scale
+    return res
+
+
+def compare(results, baseline, tolerance, mintimer):
+    """Compares results with baseline, returns the number of regressions."""
+    nreg = 0
+    print('\n%-36s %-18s %12s %12s %8s' % ('Run', 'Metric', 'Baseline', 'Current', 'Change'))
+    for key in sorted(results):
+        if key not in baseline:
+            print('%-36s not in baseline' % key)
+            continue
+        cur, ref = results[key], baseline[key]
+        if cur['np'] != ref['np']:
+            print('%-36s np differs (%d != %d), not compared' % (key, cur['np'], ref['np']))
+            continue
+        metrics = [('Total', cur['particlesteps_s'], ref['particlesteps_s'])]
+        for tname, tref in sorted(ref['timers'].items()):
+            tcur = cur['timers'].get(tname)
+            if tcur and tref['percent'] >= mintimer:
+                metrics.append((tname, tcur['particlesteps_s'], tref['particlesteps_s']))
+        for mname, vcur, vref in metrics:
+            change = (vcur / vref - 1.) if vref > 0 else 0.
+            flag = ''
+            if change < -tolerance:
+                flag = '  REGRESSION'
+                nreg += 1
+            print('%-36s %-18s %12.4e %12.4e %+7.1f%%%s' % (key, mname, vref, vcur, change * 100., flag))
+    return nreg
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Performance regression harness for DualSPHysics4CPU.')
+    parser.add_argument('--dualsphysics', default=os.path.join(DIREXECS, 'DualSPHysics4CPU_linux64'))
+    parser.add_argument('--gencase', default=os.path.join(DIREXECS, 'GenCase4_linux64'))
+    parser.add_argument('--dirout', default=os.path.join(DIRSCRIPT, 'Benchmark_out'))
+    parser.add_argument('--scales', default='2,1.5,1')
+    parser.add_argument('--steps', type=int, default=100)
+    parser.add_argument('--warmup', type=int, default=10)
+    parser.add_argument('--ompthreads', type=int, default=0)
+    parser.add_argument('--cases', default='')
+    parser.add_argument('--baseline', default=os.path.join(DIRSCRIPT, 'Baseline.json'))
+    parser.add_argument('--save-baseline', action='store_true')
+    parser.add_argument('--tolerance', type=float, default=0.10)
+    parser.add_argument('--mintimer', type=float, default=5.)
+    args = parser.parse_args()
+    args.dualsphysics = os.path.abspath(args.dualsphysics)
+    args.gencase = os.path.abspath(args.gencase)
+    args.dirout = os.path.abspath(args.dirout)
+    os.makedirs(args.dirout, exist_ok=True)
+
+    env = dict(os.environ)
+    env['LD_LIBRARY_PATH'] = DIREXECS + os.pathsep + env.get('LD_LIBRARY_PATH', '')
+    scales = [float(s) for s in args.scales.split(',') if s]
+    filters = [s for s in args.cases.split(',') if s]
+
+    results = {}
+    nfail = 0
+    for dirname, name, options in CASES:
+        if filters and not any(f in name for f in filters):
+            continue
+        for scale in scales:
+            key = '%s_x%g' % (name, scale)
+            try:
+                res = run_case(args, env, os.path.join(DIRRUN, dirname), name, options, scale)
+            except (RuntimeError, OSError, ValueError) as e:
+                print('%-36s FAILED: %s' % (key, e))
+                nfail += 1
+                continue
+            results[key] = res
+            print('%-36s np=%-9d %10.3f steps/s %12.4e particle-steps/s'
+                  % (key, res['np'], res['steps_s'], res['particlesteps_s']))
+
+    with open(os.path.join(args.dirout, 'Results.json'), 'w') as f:
+        json.dump(results, f, indent=1, sort_keys=True)
+    if args.save_baseline:
+        with open(args.baseline, 'w') as f:
+            json.dump(results, f, indent=1, sort_keys=True)
+        print('\nBaseline saved in %s' % args.baseline)
+        return 1 if nfail else 0
+    if not os.path.exists(args.baseline):
+        print('\nBaseline %s not found (use --save-baseline)' % args.baseline)
+        return 1 if nfail else 0
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+    nreg = compare(results, baseline, args.tolerance, args.mintimer)
+    print('\n%d regressions, %d failed runs (tolerance %g%%)' % (nreg, nfail, args.tolerance * 100.))
+    return 1 if nreg or nfail else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -24,6 +24,13 @@
 #include <cstring>
 #include <stdarg.h>
 #include <algorithm>
+#ifdef WIN32
+  #include <direct.h>
+  #include <io.h>
+  #include <fcntl.h>
+#else
+  #include <unistd.h>
+#endif
 
 #pragma warning(disable : 4996) //Cancels sprintf() deprecated.
 
@@ -515,6 +522,34 @@ int FileType(const std::string &name){
   return(ret);
 }
 
+//==============================================================================
+/// Crea directorio si no existe. Devuelve 0 si el directorio existe o se crea.
+/// Creates directory when it does not exist. Returns 0 if it exists or is created.
+//==============================================================================
+int Mkdir(const std::string &dirname){
+  if(DirExists(dirname))return(0);
+#ifdef WIN32
+  return(_mkdir(dirname.c_str()));
+#else
+  return(mkdir(dirname.c_str(),0777));
+#endif
+}
+
+//==============================================================================
+/// Truncates (or extends) the file to the given size. Returns 0 when no error.
+//==============================================================================
+int FileTruncate(const std::string &file,llong size){
+#ifdef WIN32
+  const int fd=_open(file.c_str(),_O_RDWR|_O_BINARY);
+  if(fd<0)return(-1);
+  const int ret=int(_chsize_s(fd,size));
+  _close(fd);
+  return(ret);
+#else
+  return(truncate(file.c_str(),off_t(size)));
+#endif
+}
+
 //==============================================================================
 /// Returns the parent directory with its path.
 //==============================================================================
@@ -731,6 +766,14 @@ unsigned* ResizeAlloc(unsigned *data,unsigned ndata,unsigned newsize){
   return(data2);
 }
 //==============================================================================
+ullong* ResizeAlloc(ullong *data,unsigned ndata,unsigned newsize){
+  ullong* data2=new ullong[newsize];
+  ndata=std::min(ndata,newsize);
+  if(ndata)memcpy(data2,data,sizeof(ullong)*ndata);
+  delete[] data;
+  return(data2);
+}
+//==============================================================================
 tuint3* ResizeAlloc(tuint3 *data,unsigned ndata,unsigned newsize){
   tuint3* data2=new tuint3[newsize];
   ndata=std::min(ndata,newsize);
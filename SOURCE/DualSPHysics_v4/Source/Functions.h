@@ -120,6 +120,8 @@ void PrintVar(const std::string &name,unsigned value,const std::string &post="")
 int FileType(const std::string &name);
 inline bool FileExists(const std::string &name){ return(FileType(name)==2); }
 inline bool DirExists(const std::string &name){ return(FileType(name)==1); }
+int Mkdir(const std::string &dirname);
+int FileTruncate(const std::string &file,llong size);
 
 std::string GetDirParent(const std::string &ruta);
 std::string GetFile(const std::string &ruta);
@@ -146,6 +148,7 @@ inline void ReverseByteOrder(short *data,int count){ ReverseByteOrder(data,count
 byte*     ResizeAlloc(byte     *data,unsigned ndata,unsigned newsize);
 word*     ResizeAlloc(word     *data,unsigned ndata,unsigned newsize);
 unsigned* ResizeAlloc(unsigned *data,unsigned ndata,unsigned newsize);
+ullong*   ResizeAlloc(ullong   *data,unsigned ndata,unsigned newsize);
 tuint3*   ResizeAlloc(tuint3   *data,unsigned ndata,unsigned newsize);
 int*      ResizeAlloc(int      *data,unsigned ndata,unsigned newsize);
 tint3*    ResizeAlloc(tint3    *data,unsigned ndata,unsigned newsize);
@@ -74,10 +74,10 @@ void* JArraysCpuSize::AllocPointer(unsigned size)const{
       case 2:   pointer=new word[size];      break;
       case 4:   pointer=new int[size];       break;
       case 8:   pointer=new double[size];    break;
-      case 12:  pointer=new int[size*3];     break;
-      case 16:  pointer=new int[size*4];     break;
-      case 24:  pointer=new double[size*3];  break;
-      case 32:  pointer=new double[size*4];  break;
+      case 12:  pointer=new int[size_t(size)*3];     break;
+      case 16:  pointer=new int[size_t(size)*4];     break;
+      case 24:  pointer=new double[size_t(size)*3];  break;
+      case 32:  pointer=new double[size_t(size)*4];  break;
     }
   }
   catch(const std::bad_alloc){
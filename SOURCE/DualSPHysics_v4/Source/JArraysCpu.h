@@ -22,7 +22,7 @@
 
 
 #include "JObject.h"
-#include "TypesDef.h"
+#include "Types.h"
 
 //##############################################################################
 //# JArraysCpuSize
@@ -79,6 +79,7 @@ class JArraysCpu : protected JObject
 {
 public:
   typedef enum{ SIZE_1B=1,SIZE_2B=2,SIZE_4B=4,SIZE_8B=8,SIZE_12B=12,SIZE_16B=16,SIZE_24B=24,SIZE_32B=32 }TpArraySize;  //-Tipos de arrays.
+  static const TpArraySize SIZE_IDP=(sizeof(tpartid)==8? SIZE_8B: SIZE_4B);  //-Tipo de array de ids de particula. Array type of the particle ids.
 
 protected:
   JArraysCpuSize *Arrays1b;
@@ -113,6 +114,8 @@ public:
   tfloat3*     ReserveFloat3(){     return((tfloat3*)Arrays12b->Reserve());     }
   tfloat4*     ReserveFloat4(){     return((tfloat4*)Arrays16b->Reserve());     }
   double*      ReserveDouble(){     return((double*)Arrays8b->Reserve());       }
+  ullong*      ReserveUllong(){     return((ullong*)Arrays8b->Reserve());       }
+  tpartid*     ReserveIdp(){        return((tpartid*)GetArrays(SIZE_IDP)->Reserve()); }
   tdouble2*    ReserveDouble2(){    return((tdouble2*)Arrays16b->Reserve());    }
   tdouble3*    ReserveDouble3(){    return((tdouble3*)Arrays24b->Reserve());    }
   tsymatrix3f* ReserveSymatrix3f(){ return((tsymatrix3f*)Arrays24b->Reserve()); }
@@ -124,6 +127,7 @@ public:
   void Free(tfloat3     *pointer){ Arrays12b->Free(pointer); }
   void Free(tfloat4     *pointer){ Arrays16b->Free(pointer); }
   void Free(double      *pointer){ Arrays8b->Free(pointer);  }
+  void Free(ullong      *pointer){ Arrays8b->Free(pointer);  }
   void Free(tdouble2    *pointer){ Arrays16b->Free(pointer); }
   void Free(tdouble3    *pointer){ Arrays24b->Free(pointer); }
   void Free(tsymatrix3f *pointer){ Arrays24b->Free(pointer); }
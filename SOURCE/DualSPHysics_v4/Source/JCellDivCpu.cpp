@@ -20,6 +20,8 @@
 #include "JCellDivCpu.h"
 #include "Functions.h"
 #include "JFormatFiles2.h"
+#include "JBinaryData.h"
+#include "JMemRegistry.h"
 #include <cfloat>
 #include <climits>
 
@@ -34,6 +36,7 @@ JCellDivCpu::JCellDivCpu(bool stable,bool floating,byte periactive,TpCellOrder c
   CellPart=NULL;    SortPart=NULL;
   PartsInCell=NULL; BeginCell=NULL;
   VSort=NULL;
+  CellSleep=NULL;
   Reset();
 }
 
@@ -73,7 +76,12 @@ void JCellDivCpu::Reset(){
 void JCellDivCpu::FreeMemoryNct(){
   delete[] PartsInCell;   PartsInCell=NULL;
   delete[] BeginCell;     BeginCell=NULL; 
+  delete[] CellSleep;     CellSleep=NULL;
+  SizeCellSleep=NctAsleep=0;
   MemAllocNct=0;
+  JMemRegistry::Set("CellDiv","PartsInCell",0);
+  JMemRegistry::Set("CellDiv","BeginCell",0);
+  JMemRegistry::Set("CellDiv","CellSleep",0);
   BoundDivideOk=false;
 }
 
@@ -86,6 +94,9 @@ void JCellDivCpu::FreeMemoryNp(){
   delete[] SortPart;    SortPart=NULL;
   delete[] VSort;       SetMemoryVSort(NULL);
   MemAllocNp=0;
+  JMemRegistry::Set("CellDiv","CellPart",0);
+  JMemRegistry::Set("CellDiv","SortPart",0);
+  JMemRegistry::Set("CellDiv","VSort",0);
   BoundDivideOk=false;
 }
 
@@ -130,6 +141,9 @@ void JCellDivCpu::AllocMemoryNp(ullong np){
   catch(const std::bad_alloc){
     RunException(met,fun::PrintStr("Failed CPU memory allocation of %.1f MB for %u particles.",double(MemAllocNp)/(1024*1024),SizeNp));
   }
+  JMemRegistry::Set("CellDiv","CellPart",llong(sizeof(unsigned))*SizeNp);
+  JMemRegistry::Set("CellDiv","SortPart",llong(sizeof(unsigned))*SizeNp);
+  JMemRegistry::Set("CellDiv","VSort",llong(sizeof(tdouble3))*SizeNp);
   //-Show requested memory / Muestra la memoria solicitada.
   Log->Printf("**CellDiv: Requested cpu memory for %u particles: %.1f MB.",SizeNp,double(MemAllocNp)/(1024*1024));
 }
@@ -154,6 +168,8 @@ void JCellDivCpu::AllocMemoryNct(ullong nct){
   catch(const std::bad_alloc){
     RunException(met,fun::PrintStr("Failed CPU memory allocation of %.1f MB for %u cells.",double(MemAllocNct)/(1024*1024),SizeNct));
   }
+  JMemRegistry::Set("CellDiv","PartsInCell",llong(sizeof(unsigned))*(nc-1));
+  JMemRegistry::Set("CellDiv","BeginCell",llong(sizeof(unsigned))*nc);
   //-Show requested memory / Muestra la memoria solicitada.
   Log->Printf("**CellDiv: Requested cpu memory for %u cells (CellMode=%s): %.1f MB.",SizeNct,GetNameCellMode(CellMode),double(MemAllocNct)/(1024*1024));
 }
@@ -230,7 +246,7 @@ void JCellDivCpu::VisuBoundaryOut(unsigned p,unsigned id,tdouble3 pos,word code)
 /// In case of there being no valid particles, the minimum is set to be greater than the maximum.
 /// If some excluded particles are encountered, generate an exception showing its info.
 //==============================================================================
-void JCellDivCpu::LimitsCellBound(unsigned n,unsigned pini,const unsigned* dcellc,const word* codec,const unsigned* idpc,const tdouble3* posc,tuint3 &cellmin,tuint3 &cellmax)const{
+void JCellDivCpu::LimitsCellBound(unsigned n,unsigned pini,const unsigned* dcellc,const word* codec,const tpartid* idpc,const tdouble3* posc,tuint3 &cellmin,tuint3 &cellmax)const{
   tuint3 cmin=TUint3(1);
   tuint3 cmax=TUint3(0);
   unsigned nerr=0;
@@ -251,7 +267,7 @@ void JCellDivCpu::LimitsCellBound(unsigned n,unsigned pini,const unsigned* dcell
       if(cmax.z<cz)cmax.z=cz;
     }
     else if(rcodsp>CODE_OUTIGNORE){
-      if(nerr<100)VisuBoundaryOut(p,idpc[p],OrderDecodeValue(CellOrder,posc[p]),rcode);
+      if(nerr<100)VisuBoundaryOut(p,unsigned(idpc[p]),OrderDecodeValue(CellOrder,posc[p]),rcode);
       nerr++;
     }
   }
@@ -266,7 +282,7 @@ void JCellDivCpu::LimitsCellBound(unsigned n,unsigned pini,const unsigned* dcell
 /// Calculate max and min positions of the indicated Bound particle range.
 /// In code[] these particles are already marked as excluded.
 //==============================================================================
-void JCellDivCpu::CalcCellDomainBound(unsigned n,unsigned pini,unsigned n2,unsigned pini2,const unsigned* dcellc,const word* codec,const unsigned* idpc,const tdouble3* posc,tuint3 &cellmin,tuint3 &cellmax){
+void JCellDivCpu::CalcCellDomainBound(unsigned n,unsigned pini,unsigned n2,unsigned pini2,const unsigned* dcellc,const word* codec,const tpartid* idpc,const tdouble3* posc,tuint3 &cellmin,tuint3 &cellmax){
   tuint3 cmin,cmax;
   LimitsCellBound(n,pini,dcellc,codec,idpc,posc,cmin,cmax);
   cellmin=(cmin.x>cmax.x? DomCells: cmin);
@@ -290,7 +306,7 @@ void JCellDivCpu::CalcCellDomainBound(unsigned n,unsigned pini,unsigned n2,unsig
 /// In case of there being no valid particles, the minimum is set to be greater than the maximum.
 /// If some excluded particles are encountered, generate an exception showing its info.
 //==============================================================================
-void JCellDivCpu::LimitsCellFluid(unsigned n,unsigned pini,const unsigned* dcellc,const word* codec,const unsigned* idpc,const tdouble3* posc,tuint3 &cellmin,tuint3 &cellmax,unsigned &npfoutrhop,unsigned &npfoutmove)const{
+void JCellDivCpu::LimitsCellFluid(unsigned n,unsigned pini,const unsigned* dcellc,const word* codec,const tpartid* idpc,const tdouble3* posc,tuint3 &cellmin,tuint3 &cellmax,unsigned &npfoutrhop,unsigned &npfoutmove)const{
   unsigned noutrhop=0,noutmove=0;
   tuint3 cmin=TUint3(1);
   tuint3 cmax=TUint3(0);
@@ -313,7 +329,7 @@ void JCellDivCpu::LimitsCellFluid(unsigned n,unsigned pini,const unsigned* dcell
     }
     else if(rcodsp>CODE_OUTIGNORE){
       if(Floating && CODE_GetType(rcode)==CODE_TYPE_FLOATING){
-        if(nerr<100)VisuBoundaryOut(p,idpc[p],OrderDecodeValue(CellOrder,posc[p]),codec[p]);
+        if(nerr<100)VisuBoundaryOut(p,unsigned(idpc[p]),OrderDecodeValue(CellOrder,posc[p]),codec[p]);
         nerr++;
       }
       if(rcodsp==CODE_OUTRHOP)noutrhop++;
@@ -333,7 +349,7 @@ void JCellDivCpu::LimitsCellFluid(unsigned n,unsigned pini,const unsigned* dcell
 /// Calculate max and min positions of the indicated Fluid particle range.
 /// Ignore excluded particles that are already marked in code[] 
 //==============================================================================
-void JCellDivCpu::CalcCellDomainFluid(unsigned n,unsigned pini,unsigned n2,unsigned pini2,const unsigned* dcellc,const word* codec,const unsigned* idpc,const tdouble3* posc,tuint3 &cellmin,tuint3 &cellmax){
+void JCellDivCpu::CalcCellDomainFluid(unsigned n,unsigned pini,unsigned n2,unsigned pini2,const unsigned* dcellc,const word* codec,const tpartid* idpc,const tdouble3* posc,tuint3 &cellmin,tuint3 &cellmax){
   tuint3 cmin,cmax;
   LimitsCellFluid(n,pini,dcellc,codec,idpc,posc,cmin,cmax,NpfOutRhop,NpfOutMove);
   cellmin=(cmin.x>cmax.x? DomCells: cmin);
@@ -348,78 +364,37 @@ void JCellDivCpu::CalcCellDomainFluid(unsigned n,unsigned pini,unsigned n2,unsig
 }
 
 //==============================================================================
-/// Reordena datos de todas las particulas.
-/// Reorder values of all particles.
-//==============================================================================
-void JCellDivCpu::SortArray(word *vec){
-  const int n=int(Nptot);
-  const int ini=(DivideFull? 0: int(NpbFinal));
-  #ifdef _WITHOMP
-    #pragma omp parallel for schedule (static) if(n>LIMIT_COMPUTELIGHT_OMP)
-  #endif
-  for(int p=ini;p<n;p++)VSortWord[p]=vec[SortPart[p]];
-  memcpy(vec+ini,VSortWord+ini,sizeof(word)*(n-ini));
-}
+/// Reordena datos de todas las particulas usando VSort como buffer auxiliar.
+/// Reorder values of all particles using VSort as auxiliary buffer.
 //==============================================================================
-void JCellDivCpu::SortArray(unsigned *vec){
-  const int n=int(Nptot);
-  const int ini=(DivideFull? 0: int(NpbFinal));
+template<class T> void JCellDivCpu::SortArrayT(T *vec){
+  const llong n=llong(Nptot);
+  const llong ini=(DivideFull? 0: llong(NpbFinal));
+  T *vsort=(T*)VSort;
   #ifdef _WITHOMP
-    #pragma omp parallel for schedule (static) if(n>LIMIT_COMPUTELIGHT_OMP)
+    #pragma omp parallel if(n>LIMIT_COMPUTELIGHT_OMP)
   #endif
-  for(int p=ini;p<n;p++)VSortInt[p]=vec[SortPart[p]];
-  memcpy(vec+ini,VSortInt+ini,sizeof(unsigned)*(n-ini));
-}
-//==============================================================================
-void JCellDivCpu::SortArray(float *vec){
-  const int n=int(Nptot);
-  const int ini=(DivideFull? 0: int(NpbFinal));
-  #ifdef _WITHOMP
-    #pragma omp parallel for schedule (static) if(n>LIMIT_COMPUTELIGHT_OMP)
-  #endif
-  for(int p=ini;p<n;p++)VSortFloat[p]=vec[SortPart[p]];
-  memcpy(vec+ini,VSortFloat+ini,sizeof(float)*(n-ini));
-}
-//==============================================================================
-void JCellDivCpu::SortArray(tdouble3 *vec){
-  const int n=int(Nptot);
-  const int ini=(DivideFull? 0: int(NpbFinal));
-  #ifdef _WITHOMP
-    #pragma omp parallel for schedule (static) if(n>LIMIT_COMPUTELIGHT_OMP)
-  #endif
-  for(int p=ini;p<n;p++)VSortDouble3[p]=vec[SortPart[p]];
-  memcpy(vec+ini,VSortDouble3+ini,sizeof(tdouble3)*(n-ini));
-}
-//==============================================================================
-void JCellDivCpu::SortArray(tfloat3 *vec){
-  const int n=int(Nptot);
-  const int ini=(DivideFull? 0: int(NpbFinal));
-  #ifdef _WITHOMP
-    #pragma omp parallel for schedule (static) if(n>LIMIT_COMPUTELIGHT_OMP)
-  #endif
-  for(int p=ini;p<n;p++)VSortFloat3[p]=vec[SortPart[p]];
-  memcpy(vec+ini,VSortFloat3+ini,sizeof(tfloat3)*(n-ini));
+  {
+    JTraceScope trace("NL-SortArray");
+    #ifdef _WITHOMP
+      #pragma omp for schedule (static)
+    #endif
+    for(llong p=ini;p<n;p++)vsort[p]=vec[SortPart[p]];
+  }
+  memcpy(vec+ini,vsort+ini,sizeof(T)*(n-ini));
 }
 //==============================================================================
-void JCellDivCpu::SortArray(tfloat4 *vec){
-  const int n=int(Nptot);
-  const int ini=(DivideFull? 0: int(NpbFinal));
-  #ifdef _WITHOMP
-    #pragma omp parallel for schedule (static) if(n>LIMIT_COMPUTELIGHT_OMP)
-  #endif
-  for(int p=ini;p<n;p++)VSortFloat4[p]=vec[SortPart[p]];
-  memcpy(vec+ini,VSortFloat4+ini,sizeof(tfloat4)*(n-ini));
-}
+/// Reordena datos de todas las particulas.
+/// Reorder values of all particles.
 //==============================================================================
-void JCellDivCpu::SortArray(tsymatrix3f *vec){
-  const int n=int(Nptot);
-  const int ini=(DivideFull? 0: int(NpbFinal));
-  #ifdef _WITHOMP
-    #pragma omp parallel for schedule (static) if(n>LIMIT_COMPUTELIGHT_OMP)
-  #endif
-  for(int p=ini;p<n;p++)VSortSymmatrix3f[p]=vec[SortPart[p]];
-  memcpy(vec+ini,VSortSymmatrix3f+ini,sizeof(tsymatrix3f)*(n-ini));
-}
+void JCellDivCpu::SortArray(word *vec){        SortArrayT(vec); }
+void JCellDivCpu::SortArray(unsigned *vec){    SortArrayT(vec); }
+void JCellDivCpu::SortArray(ullong *vec){      SortArrayT(vec); }
+void JCellDivCpu::SortArray(float *vec){       SortArrayT(vec); }
+void JCellDivCpu::SortArray(tdouble3 *vec){    SortArrayT(vec); }
+void JCellDivCpu::SortArray(tfloat3 *vec){     SortArrayT(vec); }
+void JCellDivCpu::SortArray(tfloat4 *vec){     SortArrayT(vec); }
+void JCellDivCpu::SortArray(tsymatrix3f *vec){ SortArrayT(vec); }
 
 //==============================================================================
 /// Devuelve limites actuales del dominio.
@@ -436,5 +411,124 @@ tdouble3 JCellDivCpu::GetDomainLimits(bool limitmin,unsigned slicecellmin)const{
   return(limitmin? pmin: pmax);
 }
 
+//==============================================================================
+/// Graba el estado del ultimo divide en bd para el checkpoint.
+/// Stores the state of the last divide in bd for the checkpoint.
+//==============================================================================
+void JCellDivCpu::SaveCheckpoint(JBinaryData *bd)const{
+  bd->SetvUint("Npb1",Npb1);  bd->SetvUint("Npf1",Npf1);
+  bd->SetvUint("Npb2",Npb2);  bd->SetvUint("Npf2",Npf2);
+  bd->SetvUint("NpFinal",NpFinal);  bd->SetvUint("NpbFinal",NpbFinal);
+  bd->SetvUint("NpbIgnore",NpbIgnore);
+  bd->SetvUint3("CellDomainMin",CellDomainMin);  bd->SetvUint3("CellDomainMax",CellDomainMax);
+  bd->SetvUint3("Ncells",TUint3(Ncx,Ncy,Ncz));
+  bd->SetvUint("BoxIgnore",BoxIgnore);  bd->SetvUint("BoxFluid",BoxFluid);
+  bd->SetvUint("BoxBoundOut",BoxBoundOut);  bd->SetvUint("BoxFluidOut",BoxFluidOut);
+  bd->SetvUint("BoxBoundOutIgnore",BoxBoundOutIgnore);  bd->SetvUint("BoxFluidOutIgnore",BoxFluidOutIgnore);
+  bd->SetvBool("BoundLimitOk",BoundLimitOk);
+  bd->SetvUint3("BoundLimitCellMin",BoundLimitCellMin);  bd->SetvUint3("BoundLimitCellMax",BoundLimitCellMax);
+  bd->SetvBool("BoundDivideOk",BoundDivideOk);
+  bd->SetvUint3("BoundDivideCellMin",BoundDivideCellMin);  bd->SetvUint3("BoundDivideCellMax",BoundDivideCellMax);
+  bd->SetvUint("Ndiv",Ndiv);  bd->SetvUint("NdivFull",NdivFull);
+  bd->CreateArray("BeginCell",JBinaryDataDef::DatUint,unsigned(Nctt),BeginCell,false);
+}
 
+//==============================================================================
+/// Recupera el estado del divide grabado con SaveCheckpoint(). Los datos de 
+/// particulas ya estan ordenados por lo que no es necesario reordenar.
+/// Restores the divide state stored by SaveCheckpoint(). Particle data is
+/// already sorted so no reordering is needed.
+//==============================================================================
+void JCellDivCpu::LoadCheckpoint(JBinaryData *bd){
+  const char met[]="LoadCheckpoint";
+  Npb1=bd->GetvUint("Npb1");  Npf1=bd->GetvUint("Npf1");
+  Npb2=bd->GetvUint("Npb2");  Npf2=bd->GetvUint("Npf2");
+  NpFinal=bd->GetvUint("NpFinal");  NpbFinal=bd->GetvUint("NpbFinal");
+  NpbIgnore=bd->GetvUint("NpbIgnore");
+  Nptot=NpFinal;
+  NpbOut=NpfOut=NpbOutIgnore=NpfOutIgnore=0;
+  NpfOutRhop=NpfOutMove=0;
+  CellDomainMin=bd->GetvUint3("CellDomainMin");  CellDomainMax=bd->GetvUint3("CellDomainMax");
+  const tuint3 ncells=bd->GetvUint3("Ncells");
+  Ncx=ncells.x; Ncy=ncells.y; Ncz=ncells.z;
+  Nsheet=Ncx*Ncy; Nct=Nsheet*Ncz; Nctt=SizeBeginCell(Nct);
+  BoxIgnore=bd->GetvUint("BoxIgnore");  BoxFluid=bd->GetvUint("BoxFluid");
+  BoxFloating=BoxFluid+Nct;
+  BoxBoundOut=bd->GetvUint("BoxBoundOut");  BoxFluidOut=bd->GetvUint("BoxFluidOut");
+  BoxBoundOutIgnore=bd->GetvUint("BoxBoundOutIgnore");  BoxFluidOutIgnore=bd->GetvUint("BoxFluidOutIgnore");
+  CheckMemoryNp(Nptot);
+  CheckMemoryNct(Nct);
+  JBinaryDataArray *ar=bd->GetArray("BeginCell");
+  if(!ar || ar->GetType()!=JBinaryDataDef::DatUint || ar->GetCount()!=Nctt)RunException(met,"The array BeginCell is invalid.");
+  memcpy(BeginCell,ar->GetDataPointer(),sizeof(unsigned)*Nctt);
+  //-Memory allocation resets these flags, so they are restored at the end / La reserva de memoria resetea estos valores.
+  BoundLimitOk=bd->GetvBool("BoundLimitOk");
+  BoundLimitCellMin=bd->GetvUint3("BoundLimitCellMin");  BoundLimitCellMax=bd->GetvUint3("BoundLimitCellMax");
+  BoundDivideOk=bd->GetvBool("BoundDivideOk");
+  BoundDivideCellMin=bd->GetvUint3("BoundDivideCellMin");  BoundDivideCellMax=bd->GetvUint3("BoundDivideCellMax");
+  Ndiv=bd->GetvUint("Ndiv");  NdivFull=bd->GetvUint("NdivFull");
+  DivideFull=false;
+}
 
+//==============================================================================
+/// Marca las celdas de fluido dormidas: sus particulas y las de las celdas
+/// vecinas llevan nsteps pasos en reposo y no contienen contorno, de modo que
+/// las celdas junto al contorno siempre estan activas.
+/// Devuelve en listp las particulas de fluido de las celdas activas seguidas
+/// de las de las celdas dormidas (npfasleep) y el numero de activas.
+/// Las celdas con floatings nunca estan en reposo y sus floatings siempre
+/// estan activas.
+/// Marks the asleep fluid cells: their particles and those of the neighbour
+/// cells have been at rest for nsteps steps and they contain no boundary, so
+/// the cells next to the boundary are always active. Returns in listp the fluid particles of the active cells followed
+/// by those of the asleep cells (npfasleep) and the number of active ones.
+/// Cells with floating particles are never quiet and the floating particles
+/// are always active.
+//==============================================================================
+unsigned JCellDivCpu::MarkSleepCells(unsigned nsteps,const word *sleepcount,const word *code,unsigned *listp,unsigned &npfasleep){
+  const char met[]="MarkSleepCells";
+  if(SizeCellSleep<Nct){
+    delete[] CellSleep; CellSleep=NULL;
+    SizeCellSleep=0;
+    try{
+      CellSleep=new byte[SizeNct];
+    }
+    catch(const std::bad_alloc){
+      RunException(met,fun::PrintStr("Failed CPU memory allocation of activity flags for %u cells.",SizeNct));
+    }
+    SizeCellSleep=SizeNct;
+    JMemRegistry::Set("CellDiv","CellSleep",llong(SizeNct));
+  }
+  //-Quiet cells: normal fluid particles at rest and no boundary / Celdas en reposo: fluido normal en reposo y sin contorno.
+  for(unsigned c=0;c<Nct;c++){
+    bool quiet=(BeginCell[c]==BeginCell[c+1]);
+    for(unsigned p=BeginCell[BoxFluid+c];p<BeginCell[BoxFluid+c+1] && quiet;p++)quiet=(sleepcount[p]>=nsteps && CODE_GetSpecialValue(code[p])==CODE_NORMAL);
+    if(Floating && quiet)quiet=(BeginCell[BoxFloating+c]==BeginCell[BoxFloating+c+1]);
+    CellSleep[c]=(quiet? 1: 0);
+  }
+  //-Asleep cells: quiet cells with all the neighbour cells quiet / Celdas dormidas: celdas en reposo con todas las vecinas en reposo.
+  const int hdiv=int(Hdiv),ncx=int(Ncx),ncy=int(Ncy),ncz=int(Ncz);
+  unsigned npfactive=0;
+  NctAsleep=0;
+  for(int cz=0;cz<ncz;cz++)for(int cy=0;cy<ncy;cy++)for(int cx=0;cx<ncx;cx++){
+    const unsigned c=unsigned(cx+cy*ncx+cz*int(Nsheet));
+    bool asleep=(CellSleep[c]&1)!=0;
+    for(int z=max(cz-hdiv,0);z<=min(cz+hdiv,ncz-1) && asleep;z++)for(int y=max(cy-hdiv,0);y<=min(cy+hdiv,ncy-1) && asleep;y++){
+      const int cini=y*ncx+z*int(Nsheet);
+      for(int x=max(cx-hdiv,0);x<=min(cx+hdiv,ncx-1) && asleep;x++)asleep=(CellSleep[cini+x]&1)!=0;
+    }
+    if(asleep){ CellSleep[c]|=2; NctAsleep++; }
+    else npfactive+=BeginCell[BoxFluid+c+1]-BeginCell[BoxFluid+c];
+  }
+  if(Floating)npfactive+=BeginCell[BoxFloating+Nct]-BeginCell[BoxFloating];
+  //-Particles of active cells and then those of asleep cells / Particulas de celdas activas y despues las de celdas dormidas.
+  unsigned ka=0,ks=npfactive;
+  for(unsigned c=0;c<Nct;c++){
+    const unsigned pini=BeginCell[BoxFluid+c],pfin=BeginCell[BoxFluid+c+1];
+    if(CellSleep[c]&2)for(unsigned p=pini;p<pfin;p++)listp[ks++]=p;
+    else for(unsigned p=pini;p<pfin;p++)listp[ka++]=p;
+  }
+  if(Floating)for(unsigned p=BeginCell[BoxFloating];p<BeginCell[BoxFloating+Nct];p++)listp[ka++]=p;
+  npfasleep=ks-npfactive;
+  return(npfactive);
+}
@@ -31,6 +31,8 @@
 #include <iostream>
 #include <fstream>
 
+class JBinaryData;
+
 //##############################################################################
 //# JCellDivCpu
 //##############################################################################
@@ -71,7 +73,8 @@ protected:
   unsigned SizeNct;
   unsigned *PartsInCell;
   unsigned *BeginCell;  //-Get first value of each cell / Contiene el principio de cada celda. 
-  // BeginCell=[BoundOk(nct),BoundIgnore(1),Fluid(nct),BoundOut(1),FluidOut(1),BoundOutIgnore(1),FluidOutIgnore(1),END)]
+  // BeginCell=[BoundOk(nct),BoundIgnore(1),Fluid(nct),Floating(nct),BoundOut(1),FluidOut(1),BoundOutIgnore(1),FluidOutIgnore(1),END)]
+  // Floating(nct) only exists with floating bodies / Floating(nct) solo existe con floatings.
 
   //-Variables to reorder particles / Variables para reordenar particulas
   byte *VSort;//-Memory to reorder particles / Memoria para reordenar particulas. [sizeof(tdouble3)*Np]
@@ -83,6 +86,11 @@ protected:
   tdouble3 *VSortDouble3;//- To order vectors tdouble3 (write to VSort) / Para ordenar vectores tdouble3 (apunta a VSort).
   tsymatrix3f *VSortSymmatrix3f;//-To order vectors tsymatrix3f (write to VSort) / Para ordenar vectores tsymatrix3f (apunta a VSort).
 
+  //-Activity of fluid cells for sleeping particles / Actividad de celdas de fluido para particulas dormidas.
+  unsigned SizeCellSleep;
+  byte *CellSleep;  //-Bit 0: quiet cell, bit 1: asleep cell [Nct] / Bit 0: celda en reposo, bit 1: celda dormida [Nct].
+  unsigned NctAsleep;
+
   llong MemAllocNp;  //-Memory reserved for particles / Mermoria reservada para particulas.
   llong MemAllocNct; //-Memory reserved for cells / Mermoria reservada para celdas.
 
@@ -103,7 +111,7 @@ protected:
   tuint3 CellDomainMin,CellDomainMax; //-Domain limits in cells inside of DomCells / Limites del dominio en celdas dentro de DomCells.
   unsigned Ncx,Ncy,Ncz,Nsheet,Nct;
   ullong Nctt; //-Total number of special cells included  Nctt=SizeBeginCell() / Numero total de celdas incluyendo las especiales Nctt=SizeBeginCell()
-  unsigned BoxIgnore,BoxFluid,BoxBoundOut,BoxFluidOut,BoxBoundOutIgnore,BoxFluidOutIgnore;
+  unsigned BoxIgnore,BoxFluid,BoxFloating,BoxBoundOut,BoxFluidOut,BoxBoundOutIgnore,BoxFluidOutIgnore;
 
   bool BoundLimitOk;  //-Indicate that the boundary limits are already calculated in BoundLimitCellMin & BoundLimitCellMax / Indica que los limites del contorno ya estan calculados en BoundLimitCellMin y BoundLimitCellMax.
   tuint3 BoundLimitCellMin,BoundLimitCellMax;
@@ -125,7 +133,7 @@ protected:
   void CheckMemoryNp(unsigned npmin);
   void CheckMemoryNct(unsigned nctmin);
 
-  ullong SizeBeginCell(ullong nct)const{ return((nct*2)+5+1); } //-[BoundOk(nct),BoundIgnore(1),Fluid(nct),BoundOut(1),FluidOut(1),BoundOutIgnore(1),FluidOutIgnore(1),END(1)]
+  ullong SizeBeginCell(ullong nct)const{ return((nct*(Floating? 3: 2))+5+1); } //-[BoundOk(nct),BoundIgnore(1),Fluid(nct),Floating(nct),BoundOut(1),FluidOut(1),BoundOutIgnore(1),FluidOutIgnore(1),END(1)]
 
   ullong GetAllocMemoryNp()const{ return(MemAllocNp); };
   ullong GetAllocMemoryNct()const{ return(MemAllocNct); };
@@ -133,10 +141,12 @@ protected:
 
   void VisuBoundaryOut(unsigned p,unsigned id,tdouble3 pos,word code)const;
   //tuint3 GetMapCell(const tfloat3 &pos)const;
-  void LimitsCellBound(unsigned n,unsigned pini,const unsigned* dcellc,const word* codec,const unsigned* idpc,const tdouble3* posc,tuint3 &cellmin,tuint3 &cellmax)const;
-  void CalcCellDomainBound(unsigned n,unsigned pini,unsigned n2,unsigned pini2,const unsigned* dcellc,const word* codec,const unsigned* idpc,const tdouble3* posc,tuint3 &cellmin,tuint3 &cellmax);
-  void LimitsCellFluid(unsigned n,unsigned pini,const unsigned* dcellc,const word* codec,const unsigned* idpc,const tdouble3* posc,tuint3 &cellmin,tuint3 &cellmax,unsigned &npfoutrhop,unsigned &npfoutmove)const;
-  void CalcCellDomainFluid(unsigned n,unsigned pini,unsigned n2,unsigned pini2,const unsigned* dcellc,const word* codec,const unsigned* idpc,const tdouble3* posc,tuint3 &cellmin,tuint3 &cellmax);
+  void LimitsCellBound(unsigned n,unsigned pini,const unsigned* dcellc,const word* codec,const tpartid* idpc,const tdouble3* posc,tuint3 &cellmin,tuint3 &cellmax)const;
+  void CalcCellDomainBound(unsigned n,unsigned pini,unsigned n2,unsigned pini2,const unsigned* dcellc,const word* codec,const tpartid* idpc,const tdouble3* posc,tuint3 &cellmin,tuint3 &cellmax);
+  void LimitsCellFluid(unsigned n,unsigned pini,const unsigned* dcellc,const word* codec,const tpartid* idpc,const tdouble3* posc,tuint3 &cellmin,tuint3 &cellmax,unsigned &npfoutrhop,unsigned &npfoutmove)const;
+  void CalcCellDomainFluid(unsigned n,unsigned pini,unsigned n2,unsigned pini2,const unsigned* dcellc,const word* codec,const tpartid* idpc,const tdouble3* posc,tuint3 &cellmin,tuint3 &cellmax);
+
+  template<class T> void SortArrayT(T *vec);
 
   unsigned CellSize(unsigned box)const{ return(BeginCell[box+1]-BeginCell[box]); }
 
@@ -148,6 +158,7 @@ public:
 
   void SortArray(word *vec);
   void SortArray(unsigned *vec);
+  void SortArray(ullong *vec);
   void SortArray(float *vec);
   void SortArray(tdouble3 *vec);
   void SortArray(tfloat3 *vec);
@@ -164,6 +175,7 @@ public:
   unsigned GetNcz()const{ return(Ncz); }
   tuint3 GetNcells()const{ return(TUint3(Ncx,Ncy,Ncz)); }
   unsigned GetBoxFluid()const{ return(BoxFluid); }
+  unsigned GetBoxFloating()const{ return(BoxFloating); }
 
   tuint3 GetCellDomainMin()const{ return(CellDomainMin); }
   tuint3 GetCellDomainMax()const{ return(CellDomainMax); }
@@ -172,6 +184,7 @@ public:
   unsigned GetNpFinal()const{ return(NpFinal); }
   unsigned GetNpbFinal()const{ return(NpbFinal); }
   unsigned GetNpbIgnore()const{ return(NpbIgnore); }
+  bool GetDivideFull()const{ return(DivideFull); }
   unsigned GetNpOut()const{ return(NpbOut+NpfOut); }
   unsigned GetNpbOutIgnore()const{ return(NpbOutIgnore); }
   unsigned GetNpfOutIgnore()const{ return(NpfOutIgnore); }
@@ -181,6 +194,12 @@ public:
   unsigned GetNpfOutRhop()const{ return(NpfOutRhop); }
 
   const unsigned* GetBeginCell(){ return(BeginCell); }
+
+  unsigned MarkSleepCells(unsigned nsteps,const word *sleepcount,const word *code,unsigned *listp,unsigned &npfasleep);
+  unsigned GetNctAsleep()const{ return(NctAsleep); }
+
+  void SaveCheckpoint(JBinaryData *bd)const;
+  void LoadCheckpoint(JBinaryData *bd);
 };
 
 #endif
@@ -37,7 +37,7 @@ JCellDivCpuSingle::JCellDivCpuSingle(bool stable,bool floating,byte periactive,T
 /// If there are some particles excluded of type boundary (including floating) generate
 /// an exception ands show its infor.
 //==============================================================================
-void JCellDivCpuSingle::CalcCellDomain(const unsigned *dcellc,const word* codec,const unsigned* idpc,const tdouble3* posc){
+void JCellDivCpuSingle::CalcCellDomain(const unsigned *dcellc,const word* codec,const tpartid* idpc,const tdouble3* posc){
   //-Calculate boundary domain / Calcula dominio del contorno.
   tuint3 celbmin,celbmax;
   if(!BoundLimitOk){
@@ -88,7 +88,8 @@ void JCellDivCpuSingle::PrepareNct(){
   if(Nctt!=unsigned(Nctt))RunException("PrepareNct","The number of cells is too big.");
   BoxIgnore=Nct; 
   BoxFluid=BoxIgnore+1; 
-  BoxBoundOut=BoxFluid+Nct; 
+  BoxFloating=BoxFluid+Nct; 
+  BoxBoundOut=BoxFloating+(Floating? Nct: 0); 
   BoxFluidOut=BoxBoundOut+1; 
   BoxBoundOutIgnore=BoxFluidOut+1;
   BoxFluidOutIgnore=BoxBoundOutIgnore+1;
@@ -121,8 +122,9 @@ void JCellDivCpuSingle::PreSortFull(unsigned np,const unsigned *dcellc,const wor
     if(xbound){//-Bound particles (except floating) / Particulas bound (excepto floating).
       box=(codeout<CODE_OUTIGNORE? ((cx<Ncx && cy<Ncy && cz<Ncz)? cellsort: BoxIgnore): (codeout==CODE_OUTIGNORE? BoxBoundOutIgnore: BoxBoundOut));
     }
-    else{//-Fluid particles / Particulas fluid.
-      box=(codeout<CODE_OUTIGNORE? BoxFluid+cellsort: (codeout==CODE_OUTIGNORE? BoxFluidOutIgnore: BoxFluidOut));
+    else{//-Fluid and floating particles / Particulas fluid y floating.
+      const unsigned boxcell=(Floating && CODE_GetType(rcode)==CODE_TYPE_FLOATING? BoxFloating: BoxFluid);
+      box=(codeout<CODE_OUTIGNORE? boxcell+cellsort: (codeout==CODE_OUTIGNORE? BoxFluidOutIgnore: BoxFluidOut));
     }
     cellpart[p]=box;
     partsincell[box]++;
@@ -149,8 +151,9 @@ void JCellDivCpuSingle::PreSortFluid(unsigned np,unsigned pini,const unsigned *d
     unsigned cx=PC__Cellx(DomCellCode,rcell)-CellDomainMin.x;
     unsigned cy=PC__Celly(DomCellCode,rcell)-CellDomainMin.y;
     unsigned cz=PC__Cellz(DomCellCode,rcell)-CellDomainMin.z;
-    const unsigned cellsort=BoxFluid+cx+cy*Ncx+cz*Nsheet;
-    const word codeout=CODE_GetSpecialValue(codec[p]);
+    const word rcode=codec[p];
+    const unsigned cellsort=(Floating && CODE_GetType(rcode)==CODE_TYPE_FLOATING? BoxFloating: BoxFluid)+cx+cy*Ncx+cz*Nsheet;
+    const word codeout=CODE_GetSpecialValue(rcode);
     unsigned box=(codeout<CODE_OUTIGNORE? cellsort: (codeout==CODE_OUTIGNORE? BoxFluidOutIgnore: BoxFluidOut));
     cellpart[p]=box;
     partsincell[box]++;
@@ -233,7 +236,7 @@ void JCellDivCpuSingle::PreSort(const unsigned* dcellc,const word* codec){
 /// ignored), but in case of some excluding floating particles an exception is generated 
 /// in CalcCellDomainFluid();
 //==============================================================================
-void JCellDivCpuSingle::Divide(unsigned npb1,unsigned npf1,unsigned npb2,unsigned npf2,bool boundchanged,const unsigned *dcellc,const word* codec,const unsigned* idpc,const tdouble3* posc,TimersCpu timers){
+void JCellDivCpuSingle::Divide(unsigned npb1,unsigned npf1,unsigned npb2,unsigned npf2,bool boundchanged,const unsigned *dcellc,const word* codec,const tpartid* idpc,const tdouble3* posc,TimersCpu timers){
   const char met[]="Divide";
   DivideFull=false;
   TmcStart(timers,TMC_NlLimits);
@@ -30,7 +30,7 @@
 class JCellDivCpuSingle : public JCellDivCpu
 {
 protected:
-  void CalcCellDomain(const unsigned *dcellc,const word* codec,const unsigned* idpc,const tdouble3* posc);
+  void CalcCellDomain(const unsigned *dcellc,const word* codec,const tpartid* idpc,const tdouble3* posc);
   void MergeMapCellBoundFluid(const tuint3 &celbmin,const tuint3 &celbmax,const tuint3 &celfmin,const tuint3 &celfmax,tuint3 &celmin,tuint3 &celmax)const;
   void PrepareNct();
 
@@ -43,7 +43,7 @@ protected:
 public:
   JCellDivCpuSingle(bool stable,bool floating,byte periactive,TpCellOrder cellorder,TpCellMode cellmode,float scell,tdouble3 mapposmin,tdouble3 mapposmax,tuint3 mapcells,unsigned casenbound,unsigned casenfixed,unsigned casenpb,JLog2 *log,std::string dirout);
 
-  void Divide(unsigned npb1,unsigned npf1,unsigned npb2,unsigned npf2,bool boundchanged,const unsigned *dcellc,const word* codec,const unsigned* idpc,const tdouble3* posc,TimersCpu timers);
+  void Divide(unsigned npb1,unsigned npf1,unsigned npb2,unsigned npf2,bool boundchanged,const unsigned *dcellc,const word* codec,const tpartid* idpc,const tdouble3* posc,TimersCpu timers);
 
   ullong GetAllocMemory()const{ return(JCellDivCpu::GetAllocMemory()); }
   ullong GetAllocMemoryNp()const{ return(JCellDivCpu::GetAllocMemoryNp()); };
@@ -49,6 +49,9 @@ void JCfgRun::Reset() {
   SvTimers=true;
   CellOrder=ORDER_None;
   CellMode=CELLMODE_2H;
+  Overlap=false;
+  TaskGraph=0;
+  SleepSteps=0; SleepVel=0.01f; SleepAce=0.1f;
   DomainMode=0;
   DomainParticlesMin=DomainParticlesMax=TDouble3(0);
   DomainParticlesPrcMin=DomainParticlesPrcMax=TDouble3(0);
@@ -60,8 +63,19 @@ void JCfgRun::Reset() {
   Shifting=-1;
   SvRes=true; SvDomainVtk=false;
   Sv_Binx=false; Sv_Info=false; Sv_Vtk=false; Sv_Csv=false;
+  SvSeries=false; SvSeriesParts=0;
+  SvTimersStep=0;
+  SvTrace=0;
+  SvForceStats=false;
+  SvMemory=false;
+  SvPerf=false;
+  SvRoofline=0;
+  SvStatus=0;
+  BenchSteps=0; BenchWarmup=0;
+  MpiBalanceSteps=0; MpiBalanceTol=0.1f;
   CaseName=""; DirOut=""; RunName=""; 
   PartBegin=0; PartBeginFirst=0; PartBeginDir="";
+  RestartFile=""; CheckpointTime=0; CheckpointKeep=2;
   TimeMax=-1; TimePart=-1;
   RhopOutModif=false; RhopOutMin=700; RhopOutMax=1300;
   FtPause=-1;
@@ -79,6 +93,8 @@ void JCfgRun::VisuInfo()const{
   printf("    -cpu        Execution on CPU (option by default)\n");
   printf("    -gpu[:id]   Execution on GPU and id of the device\n");
   printf("    -stable     The result is always the same but the execution is slower\n");
+  printf("                (on CPU the PARTs do not depend on the number of threads,\n");
+  printf("                DualSPHysics4PartDiff compares bitwise two PART series)\n");
   printf("\n");
   printf("    -posdouble:<mode>  Precision used in position for particle interactions\n");
   printf("        0: Use and store in single precision (option by default)\n");
@@ -98,9 +114,21 @@ void JCfgRun::VisuInfo()const{
   printf("    -cellmode:<mode>  Specifies the cell division mode\n");
   printf("        2h        Lowest and the least expensive in memory (by default)\n");
   printf("        h         Fastest and the most expensive in memory\n\n");
+  printf("    -overlap:<0/1>   Creates the periodic particles while the interaction\n");
+  printf("     between the other particles is computed, only for CPU execution with\n");
+  printf("     periodic conditions (0 by default)\n\n");
+  printf("    -taskgraph[:np]  Computes the interaction as tasks over blocks of (np)\n");
+  printf("     consecutive particles (2048 by default) that start as soon as their\n");
+  printf("     dependencies finish instead of one parallel loop per phase, only for\n");
+  printf("     CPU execution\n\n");
   printf("    -symplectic      Symplectic algorithm as time step algorithm\n");
   printf("    -verlet[:steps]  Verlet algorithm as time step algorithm and number of\n");
   printf("                     time steps to switch equations\n\n");
+  printf("    -sleep:<steps>[:vel:ace]  The fluid cells whose particles and neighbour\n");
+  printf("     cells have had velocity below vel (0.01 by default) and acceleration\n");
+  printf("     below ace (0.1 by default) for (steps) steps fall asleep, skip the\n");
+  printf("     computation of forces and stop moving, the cells next to boundaries\n");
+  printf("     never fall asleep, only for CPU execution (0 by default)\n\n");
   printf("    -cubic           Cubic spline kernel\n");
   printf("    -wendland        Wendland kernel\n\n");
   printf("    -viscoart:<float>          Artificial viscosity [0-1]\n");
@@ -119,8 +147,36 @@ void JCfgRun::VisuInfo()const{
   printf("        info    Information about execution in .ibi4 format\n");
   printf("        vtk     VTK files\n");
   printf("        csv     CSV files\n");
+  printf("    -svseries[:parts] Saves binary PART data appended to PartSeries_XXXX.bi4s\n");
+  printf("     files with an index instead of one Part_XXXX.bi4 file per PART, (parts)\n");
+  printf("     is the maximum number of PARTs per file (0 by default, unlimited)\n");
   printf("    -svres:<0/1>     Generates file that summarises the execution process\n");
   printf("    -svtimers:<0/1>  Obtains timing for each individual process\n");
+  printf("    -svtimersstep[:steps] Saves the time of each process, Np, Nct, dt and\n");
+  printf("     the dt-limiting maxima in TimersStep.csv every (steps) steps (1 by default)\n");
+  printf("    -svtrace[:events] Records begin/end of timers and parallel regions of\n");
+  printf("     each thread and saves them in Trace.json (chrome://tracing or Perfetto),\n");
+  printf("     (events) is the size of the ring buffer (1000000 by default)\n");
+  printf("    -svforcestats:<0/1> Saves in PartInfo the histograms of neighbours, the\n");
+  printf("     occupancy of cells and the thread imbalance of the interaction\n");
+  printf("    -svmemory:<0/1>  Registers current and peak memory of each array\n");
+  printf("     (particles, cells, PartsLoad, PartsOut, BinaryData), shows the breakdown\n");
+  printf("     at the end, saves it in PartInfo and the growth events in MemoryEvents.csv\n");
+  printf("    -svperf:<0/1>    Reads hardware performance counters (cycles,\n");
+  printf("     instructions, LLC and dTLB misses) of each process (Linux perf_event)\n");
+  printf("    -svroofline[:mb] Measures memory bandwidth (triad with arrays of (mb) MB,\n");
+  printf("     64 by default) and peak GFLOP/s at startup and shows the achieved GB/s,\n");
+  printf("     GFLOP/s and arithmetic intensity of force, sort, integration and periodic\n");
+  printf("     phases at the end of the run\n");
+  printf("    -svstatus[:sec]  Rewrites Status.json every (sec) seconds (10 by default)\n");
+  printf("     with time, part, steps/s, ETA, Np, memory, last dt and timers of the\n");
+  printf("     last interval, the file is replaced atomically to be polled\n");
+  printf("    -bench:steps[:warmup] Benchmark mode, runs (steps) steps after (warmup)\n");
+  printf("     steps (10 by default) without output files and ignoring TimeMax, and\n");
+  printf("     saves steps/s and particle-steps/s of each process in Bench.json\n");
+  printf("    -mpibalance:steps[:tol] Every (steps) steps moves the limits of the MPI\n");
+  printf("     slabs when the force computation of the slowest process exceeds the mean\n");
+  printf("     by more than (tol) (0.1 by default), using the measured cost per cell\n");
   printf("    -svdomainvtk:<0/1>  Generates VTK file with domain limits\n");
   printf("    -name <string>      Specifies path and name of the case \n");
   printf("    -runname <string>   Specifies name for case execution\n");
@@ -129,6 +185,10 @@ void JCfgRun::VisuInfo()const{
   printf("     Specifies the beginning of the simulation starting from a given PART\n");
   printf("     (begin) and located in the directory (dir), (first) indicates the\n");
   printf("     number of the first PART to be generated\n\n");
+  printf("    -checkpoint:tout[:keep]  Writes checkpoint files with the exact state of\n");
+  printf("     the simulation every (tout) seconds of simulation, keeping the last\n");
+  printf("     (keep) files (2 by default)\n");
+  printf("    -restart <file>  Restarts the simulation from a checkpoint file\n\n");
   printf("    -incz:<float>    Allows increase in Z+ direction \n");
   printf("    -rhopout:min:max Excludes fluid particles out of these density limits\n\n");
   printf("    -ftpause:<float> Time to start floating bodies movement. By default 0\n");
@@ -156,6 +216,9 @@ void JCfgRun::VisuConfig()const{
   PrintVar("  PartBegin",PartBegin,ln);
   PrintVar("  PartBeginFirst",PartBeginFirst,ln);
   PrintVar("  PartBeginDir",PartBeginDir,ln);
+  PrintVar("  RestartFile",RestartFile,ln);
+  PrintVar("  CheckpointTime",CheckpointTime,ln);
+  PrintVar("  CheckpointKeep",CheckpointKeep,ln);
   PrintVar("  Cpu",Cpu,ln);
   printf("  %s  %s\n",VarStr("Gpu",Gpu).c_str(),VarStr("GpuId",GpuId).c_str());
   PrintVar("  GpuFree",GpuFree,ln);
@@ -165,8 +228,13 @@ void JCfgRun::VisuConfig()const{
   PrintVar("  BlockSize",BlockSizeMode,ln);
   PrintVar("  CellOrder",GetNameCellOrder(CellOrder),ln);
   PrintVar("  CellMode",GetNameCellMode(CellMode),ln);
+  PrintVar("  Overlap",Overlap,ln);
+  PrintVar("  TaskGraph",TaskGraph,ln);
   PrintVar("  TStep",TStep,ln);
   PrintVar("  VerletSteps",VerletSteps,ln);
+  PrintVar("  SleepSteps",SleepSteps,ln);
+  PrintVar("  SleepVel",SleepVel,ln);
+  PrintVar("  SleepAce",SleepAce,ln);
   PrintVar("  TKernel",TKernel,ln);
   PrintVar("  TVisco",TVisco,ln);
   PrintVar("  Visco",Visco,ln);
@@ -180,6 +248,19 @@ void JCfgRun::VisuConfig()const{
   PrintVar("  Sv_Info",Sv_Info,ln);
   PrintVar("  Sv_Vtk",Sv_Vtk,ln);
   PrintVar("  Sv_Csv",Sv_Csv,ln);
+  PrintVar("  SvSeries",SvSeries,ln);
+  PrintVar("  SvSeriesParts",SvSeriesParts,ln);
+  PrintVar("  SvTimersStep",SvTimersStep,ln);
+  PrintVar("  SvTrace",SvTrace,ln);
+  PrintVar("  SvForceStats",SvForceStats,ln);
+  PrintVar("  SvMemory",SvMemory,ln);
+  PrintVar("  SvPerf",SvPerf,ln);
+  PrintVar("  SvRoofline",SvRoofline,ln);
+  PrintVar("  SvStatus",SvStatus,ln);
+  PrintVar("  BenchSteps",BenchSteps,ln);
+  PrintVar("  BenchWarmup",BenchWarmup,ln);
+  PrintVar("  MpiBalanceSteps",MpiBalanceSteps,ln);
+  PrintVar("  MpiBalanceTol",MpiBalanceTol,ln);
   PrintVar("  RhopOutModif",RhopOutModif,ln);
   if(RhopOutModif){
     PrintVar("  RhopOutMin",RhopOutMin,ln);
@@ -350,10 +431,24 @@ void JCfgRun::LoadOpts(string *optlis,int optn,int lv,string file){
         else ok=false;
         if(!ok)ErrorParm(opt,c,lv,file);
       }
+      else if(txword=="OVERLAP")Overlap=(txopt!=""? atoi(txopt.c_str()): 1)!=0;
+      else if(txword=="TASKGRAPH"){
+        const int v=(txopt!=""? atoi(txopt.c_str()): 2048);
+        if(v<0)ErrorParm(opt,c,lv,file);
+        TaskGraph=unsigned(v);
+      }
       else if(txword=="SYMPLECTIC")TStep=STEP_Symplectic;
       else if(txword=="VERLET"){ TStep=STEP_Verlet; 
         if(txopt!="")VerletSteps=atoi(txopt.c_str()); 
       }
+      else if(txword=="SLEEP"){
+        const int v=atoi(txopt.c_str());
+        if(v<0 || v>=65535)ErrorParm(opt,c,lv,file);
+        SleepSteps=unsigned(v);
+        if(txopt2!="")SleepVel=float(atof(txopt2.c_str()));
+        if(txopt3!="")SleepAce=float(atof(txopt3.c_str()));
+        if(SleepVel<0 || SleepAce<0)ErrorParm(opt,c,lv,file);
+      }
       else if(txword=="CUBIC")TKernel=KERNEL_Cubic;
       else if(txword=="WENDLAND")TKernel=KERNEL_Wendland;
       else if(txword=="VISCOART"){ 
@@ -385,6 +480,45 @@ void JCfgRun::LoadOpts(string *optlis,int optn,int lv,string file){
       else if(txword=="SVRES")SvRes=(txopt!=""? atoi(txopt.c_str()): 1)!=0;
       else if(txword=="SVTIMERS")SvTimers=(txopt!=""? atoi(txopt.c_str()): 1)!=0;
       else if(txword=="SVDOMAINVTK")SvDomainVtk=(txopt!=""? atoi(txopt.c_str()): 1)!=0;
+      else if(txword=="SVTIMERSSTEP"){
+        const int v=(txopt!=""? atoi(txopt.c_str()): 1);
+        if(v<=0)ErrorParm(opt,c,lv,file);
+        SvTimersStep=unsigned(v);
+      }
+      else if(txword=="SVTRACE"){
+        const int v=(txopt!=""? atoi(txopt.c_str()): 1000000);
+        if(v<=0)ErrorParm(opt,c,lv,file);
+        SvTrace=unsigned(v);
+      }
+      else if(txword=="SVFORCESTATS")SvForceStats=(txopt!=""? atoi(txopt.c_str()): 1)!=0;
+      else if(txword=="SVMEMORY")SvMemory=(txopt!=""? atoi(txopt.c_str()): 1)!=0;
+      else if(txword=="SVPERF")SvPerf=(txopt!=""? atoi(txopt.c_str()): 1)!=0;
+      else if(txword=="SVROOFLINE"){
+        const int v=(txopt!=""? atoi(txopt.c_str()): 64);
+        if(v<0)ErrorParm(opt,c,lv,file);
+        SvRoofline=unsigned(v);
+      }
+      else if(txword=="SVSTATUS"){
+        SvStatus=(txopt!=""? atof(txopt.c_str()): 10);
+        if(SvStatus<0)ErrorParm(opt,c,lv,file);
+      }
+      else if(txword=="BENCH"){
+        const int v=atoi(txopt.c_str());
+        const int v2=(txopt2!=""? atoi(txopt2.c_str()): 10);
+        if(v<=0||v2<0)ErrorParm(opt,c,lv,file);
+        BenchSteps=unsigned(v); BenchWarmup=unsigned(v2);
+      }
+      else if(txword=="MPIBALANCE"){
+        const int v=atoi(txopt.c_str());
+        const float v2=(txopt2!=""? float(atof(txopt2.c_str())): 0.1f);
+        if(v<=0||v2<0)ErrorParm(opt,c,lv,file);
+        MpiBalanceSteps=unsigned(v); MpiBalanceTol=v2;
+      }
+      else if(txword=="SVSERIES"){
+        const int v=(txopt!=""? atoi(txopt.c_str()): 0);
+        if(v<0)ErrorParm(opt,c,lv,file);
+        SvSeries=true; SvSeriesParts=unsigned(v);
+      }
       else if(txword=="SV"){
         string txop=StrUpper(txopt);
         while(txop.length()>0){
@@ -415,6 +549,12 @@ void JCfgRun::LoadOpts(string *optlis,int optn,int lv,string file){
         }
         PartBeginDir=optlis[c+1]; c++; 
       }
+      else if(txword=="CHECKPOINT"){
+        CheckpointTime=atof(txopt.c_str());
+        if(!txopt2.empty())CheckpointKeep=unsigned(atoi(txopt2.c_str()));
+        if(CheckpointTime<0||!CheckpointKeep)ErrorParm(opt,c,lv,file);
+      }
+      else if(txword=="RESTART"&&c+1<optn){ RestartFile=optlis[c+1]; c++; }
       else if(txword=="RHOPOUT"){ 
         RhopOutMin=float(atof(txopt.c_str())); 
         RhopOutMax=float(atof(txopt2.c_str())); 
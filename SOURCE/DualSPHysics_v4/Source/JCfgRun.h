@@ -59,8 +59,13 @@ public:
 
   TpCellOrder CellOrder;
   TpCellMode  CellMode;
+  bool Overlap;  ///<Creates the periodic copies while the interior cells are computed.
+  unsigned TaskGraph;  ///<Particles per block of the task graph of the interaction (0: disabled).
   TpStep TStep;
   int VerletSteps;
+  unsigned SleepSteps; ///<Steps at rest before the fluid particles fall asleep (0: disabled).
+  float SleepVel;      ///<Maximum velocity of a fluid particle at rest.
+  float SleepAce;      ///<Maximum acceleration of a fluid particle at rest.
   TpKernel TKernel;
   TpVisco TVisco;
   float Visco;
@@ -70,9 +75,25 @@ public:
   int Shifting; //-Shifting mode -1:sin definir, 0:none, 1:nobound, 2:nofixed, 3:full
   bool SvRes,SvTimers,SvDomainVtk;
   bool Sv_Binx,Sv_Info,Sv_Csv,Sv_Vtk;
+  bool SvSeries;             ///<Saves PART data in series files with index instead of one file per PART.
+  unsigned SvSeriesParts;    ///<Maximum number of PARTs per series file (0: unlimited).
+  unsigned SvTimersStep;     ///<Saves timers and step values in TimersStep.csv every N steps (0: disabled).
+  unsigned SvTrace;          ///<Size of the ring buffer of trace events saved in Trace.json (0: disabled).
+  bool SvMemory;             ///<Registers current and peak memory of each array and saves the breakdown in PartInfo.
+  bool SvForceStats;         ///<Saves neighbour, cell and thread statistics of the interaction in PartInfo.
+  double SvStatus;           ///<Interval (s) to rewrite the status file Status.json (0: disabled).
+  unsigned SvRoofline;       ///<Size (MB) of the arrays of the bandwidth test of the roofline report (0: disabled).
+  bool SvPerf;               ///<Reads hardware performance counters for each timer.
+  unsigned BenchSteps;       ///<Number of measured steps in benchmark mode (0: disabled).
+  unsigned BenchWarmup;      ///<Number of steps before measuring in benchmark mode.
+  unsigned MpiBalanceSteps;  ///<Steps between load balancing checks of the MPI slabs (0: disabled).
+  float MpiBalanceTol;       ///<Imbalance (max/mean-1) of the force computation that moves the MPI slabs.
   std::string CaseName,RunName,DirOut;
   std::string PartBeginDir;
   unsigned PartBegin,PartBeginFirst;
+  std::string RestartFile;   ///<Checkpoint file used to restart the simulation.
+  double CheckpointTime;     ///<Simulated time between checkpoints (0: disabled).
+  unsigned CheckpointKeep;   ///<Number of checkpoint files that are kept.
   float FtPause;
   bool RhopOutModif;              ///<Indicates whether \ref RhopOutMin or RhopOutMax is changed.
   float RhopOutMin,RhopOutMax;    ///<Limits for \ref RhopOut density correction.
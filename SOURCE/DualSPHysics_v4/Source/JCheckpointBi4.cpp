@@ -0,0 +1,252 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JCheckpointBi4.cpp \brief Implements the classes \ref JCheckpointBi4Save and \ref JCheckpointBi4Load.
+
+#include "JCheckpointBi4.h"
+#include "Functions.h"
+#include "JException.h"
+#include "JTraceEvents.h"
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+//##############################################################################
+//# JCheckpointBi4Save
+//##############################################################################
+//==============================================================================
+/// Constructor.
+//==============================================================================
+JCheckpointBi4Save::JCheckpointBi4Save(){
+  ClassName="JCheckpointBi4Save";
+  Data=NULL; DataSave=NULL;
+  Writer=NULL;
+  Reset();
+}
+
+//==============================================================================
+/// Destructor.
+//==============================================================================
+JCheckpointBi4Save::~JCheckpointBi4Save(){
+  Reset();
+}
+
+//==============================================================================
+/// Initialisation of variables.
+//==============================================================================
+void JCheckpointBi4Save::Reset(){
+  if(Writer){
+    Writer->join(); delete Writer; Writer=NULL;
+    if(!WriterError)while(unsigned(Files.size())>Keep){ remove(Files[0].c_str()); Files.erase(Files.begin()); }
+  }
+  delete Data;     Data=NULL;
+  delete DataSave; DataSave=NULL;
+  WriterError=false; WriterErrorText="";
+  Dir="";
+  Keep=0;
+  Count=0;
+  Files.clear();
+}
+
+//==============================================================================
+/// Devuelve la memoria reservada.
+/// Returns allocated memory.
+//==============================================================================
+llong JCheckpointBi4Save::GetAllocMemory()const{
+  llong s=0;
+  if(Data)s+=Data->GetAllocMemory();
+  if(DataSave)s+=DataSave->GetAllocMemory();
+  return(s);
+}
+
+//==============================================================================
+/// Devuelve nombre de fichero de checkpoint segun su numero.
+/// Returns the checkpoint filename according to its number.
+//==============================================================================
+std::string JCheckpointBi4Save::GetFileName(unsigned num){
+  return(fun::PrintStr("Checkpoint_%04u.cbi4",num));
+}
+
+//==============================================================================
+/// Configuracion del objeto.
+/// Object configuration.
+//==============================================================================
+void JCheckpointBi4Save::Config(const std::string &dir,unsigned keep){
+  Reset();
+  Dir=fun::GetDirWithSlash(dir);
+  Keep=(keep? keep: 1);
+}
+
+//==============================================================================
+/// Continua la numeracion despues del checkpoint num usado para reanudar. Los
+/// ficheros existentes se incluyen en la rotacion y nunca se sobrescriben.
+/// Continues the numbering after the checkpoint num used to restart. Existing
+/// files are included in the rotation and are never overwritten.
+//==============================================================================
+void JCheckpointBi4Save::ConfigRestart(unsigned num){
+  Files.clear();
+  Count=0;
+  for(;;Count++){
+    const string file=Dir+GetFileName(Count);
+    if(fun::FileExists(file))Files.push_back(file);
+    else if(Count>num)break;
+  }
+}
+
+//==============================================================================
+/// Crea nuevo objeto Data para almacenar el estado de la simulacion.
+/// Creates a new Data object to store the simulation state.
+//==============================================================================
+JBinaryData* JCheckpointBi4Save::InitData(unsigned part,double timestep,int nstep){
+  delete Data;
+  Data=new JBinaryData("JCheckpointBi4");
+  Data->SetvUint("FormatVer",FormatVerDef);
+  Data->SetvUint("Num",Count);
+  Data->SetvUint("Part",part);
+  Data->SetvDouble("TimeStep",timestep);
+  Data->SetvInt("Nstep",nstep);
+  return(Data);
+}
+
+//==============================================================================
+/// Graba fichero de checkpoint (ejecutado en el hilo de grabacion).
+/// Writes the checkpoint file (executed in the writer thread).
+//==============================================================================
+void JCheckpointBi4Save::WriteFile(JCheckpointBi4Save *obj,std::string file){
+  const string filetmp=file+".tmp";
+  JTraceEvents::SetThreadTrack("CheckpointWriter");
+  JTraceScope trace("WR-Checkpoint");
+  try{
+    obj->DataSave->SaveFile(filetmp,false,true);
+    remove(file.c_str());
+    if(rename(filetmp.c_str(),file.c_str())!=0)throw string("Cannot rename the file ")+filetmp;
+  }
+  catch(const JException &e){
+    obj->WriterError=true; obj->WriterErrorText=e.ToStr();
+  }
+  catch(const string &e){
+    obj->WriterError=true; obj->WriterErrorText=e;
+  }
+}
+
+//==============================================================================
+/// Espera a que termine la grabacion pendiente y comprueba errores.
+/// Waits for the pending write and checks for errors.
+//==============================================================================
+void JCheckpointBi4Save::WaitSave(){
+  if(Writer){
+    Writer->join();
+    delete Writer; Writer=NULL;
+    delete DataSave; DataSave=NULL;
+    if(WriterError)RunException("WaitSave",string("Error writing checkpoint file. ")+WriterErrorText);
+    //-Removes old checkpoint files.
+    while(unsigned(Files.size())>Keep){
+      remove(Files[0].c_str());
+      Files.erase(Files.begin());
+    }
+  }
+}
+
+//==============================================================================
+/// Lanza la grabacion en segundo plano del checkpoint preparado en Data.
+/// Launches the background write of the checkpoint prepared in Data.
+//==============================================================================
+void JCheckpointBi4Save::SaveData(){
+  const char met[]="SaveData";
+  if(!Data)RunException(met,"There is no checkpoint data to save.");
+  WaitSave();
+  DataSave=Data; Data=NULL;
+  const string file=Dir+GetFileName(Count);
+  Files.push_back(file);
+  Count++;
+  WriterError=false; WriterErrorText="";
+  Writer=new std::thread(WriteFile,this,file);
+}
+
+
+//##############################################################################
+//# JCheckpointBi4Load
+//##############################################################################
+//==============================================================================
+/// Constructor.
+//==============================================================================
+JCheckpointBi4Load::JCheckpointBi4Load(){
+  ClassName="JCheckpointBi4Load";
+  Data=NULL;
+  Reset();
+}
+
+//==============================================================================
+/// Destructor.
+//==============================================================================
+JCheckpointBi4Load::~JCheckpointBi4Load(){
+  Reset();
+}
+
+//==============================================================================
+/// Initialisation of variables.
+//==============================================================================
+void JCheckpointBi4Load::Reset(){
+  delete Data; Data=NULL;
+  FileData="";
+}
+
+//==============================================================================
+/// Devuelve la memoria reservada.
+/// Returns allocated memory.
+//==============================================================================
+llong JCheckpointBi4Load::GetAllocMemory()const{
+  return(Data? Data->GetAllocMemory(): 0);
+}
+
+//==============================================================================
+/// Carga datos de fichero y comprueba cabecera.
+/// Loads data from file and verifies header.
+//==============================================================================
+void JCheckpointBi4Load::LoadFile(const std::string &file){
+  const char met[]="LoadFile";
+  Reset();
+  if(!fun::FileExists(file))RunException(met,"File not found.",file);
+  Data=new JBinaryData("JCheckpointBi4");
+  Data->LoadFile(file,"JCheckpointBi4");
+  if(!Data->GetvUint("FormatVer",true,0))RunException(met,"The format version is invalid.",file);
+  FileData=file;
+}
+
+//==============================================================================
+/// Devuelve array comprobando su tipo y tamanho.
+/// Returns array checking its type and size.
+//==============================================================================
+JBinaryDataArray* JCheckpointBi4Load::CheckArray(JBinaryData *bd,const std::string &name,JBinaryDataDef::TpData type,unsigned count){
+  const char met[]="CheckArray";
+  JBinaryDataArray *ar=bd->GetArray(name);
+  if(!ar)RunException(met,string("The array ")+name+" is missing.",FileData);
+  if(ar->GetType()!=type)RunException(met,string("The type of array ")+name+" does not match.",FileData);
+  if(ar->GetCount()!=count)RunException(met,string("The size of array ")+name+" does not match.",FileData);
+  return(ar);
+}
+
+//==============================================================================
+/// Copia datos de array en ptr.
+/// Copies array data to ptr.
+//==============================================================================
+void JCheckpointBi4Load::LoadArray(JBinaryData *bd,const std::string &name,JBinaryDataDef::TpData type,unsigned count,void *ptr){
+  JBinaryDataArray *ar=CheckArray(bd,name,type,count);
+  if(count)memcpy(ptr,ar->GetDataPointer(),JBinaryDataDef::SizeOfType(type)*count);
+}
+
@@ -0,0 +1,101 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JCheckpointBi4.h \brief Declares the classes \ref JCheckpointBi4Save and \ref JCheckpointBi4Load.
+
+#ifndef _JCheckpointBi4_
+#define _JCheckpointBi4_
+
+#include "JObject.h"
+#include "TypesDef.h"
+#include "JBinaryData.h"
+#include <string>
+#include <vector>
+#include <thread>
+
+//##############################################################################
+//# JCheckpointBi4Save
+//##############################################################################
+/// \brief Writes rolling checkpoint files with the exact state of the simulation.
+/// The state is copied into a JBinaryData object by the solver and written to
+/// disk in a background thread, so the simulation only waits for the copy.
+
+class JCheckpointBi4Save : protected JObject
+{
+ private:
+  static const unsigned FormatVerDef=161018;  ///<Version de formato by default. Version of format by default.
+
+  std::string Dir;       ///<Directorio de datos. Data directory.
+  unsigned Keep;         ///<Numero de ficheros que se mantienen. Number of checkpoint files that are kept.
+  unsigned Count;        ///<Numero de checkpoints grabados. Number of recorded checkpoints.
+
+  JBinaryData *Data;     ///<Checkpoint en preparacion. Checkpoint being prepared.
+  JBinaryData *DataSave; ///<Checkpoint en grabacion. Checkpoint being written.
+  std::thread *Writer;   ///<Hilo de grabacion. Writer thread.
+  bool WriterError;      ///<Indica error en la ultima grabacion. Indicates an error in the last write.
+  std::string WriterErrorText;
+
+  std::vector<std::string> Files;  ///<Ficheros grabados pendientes de borrar. Written files to be removed when Keep is exceeded.
+
+  static void WriteFile(JCheckpointBi4Save *obj,std::string file);
+
+ public:
+  JCheckpointBi4Save();
+  ~JCheckpointBi4Save();
+  void Reset();
+  llong GetAllocMemory()const;
+
+  static std::string GetFileName(unsigned num);
+
+  void Config(const std::string &dir,unsigned keep);
+  void ConfigRestart(unsigned num);
+  unsigned GetCount()const{ return(Count); }
+
+  JBinaryData* InitData(unsigned part,double timestep,int nstep);
+  void SaveData();
+  void WaitSave();
+};
+
+
+//##############################################################################
+//# JCheckpointBi4Load
+//##############################################################################
+/// \brief Reads a checkpoint file written by \ref JCheckpointBi4Save.
+
+class JCheckpointBi4Load : protected JObject
+{
+ private:
+  std::string FileData;  ///<Fichero cargado. Loaded file.
+  JBinaryData *Data;     ///<Almacena la informacion del checkpoint. Stores the checkpoint information.
+
+ public:
+  JCheckpointBi4Load();
+  ~JCheckpointBi4Load();
+  void Reset();
+  llong GetAllocMemory()const;
+
+  void LoadFile(const std::string &file);
+  std::string GetFile()const{ return(FileData); }
+
+  JBinaryData* GetData()const{ return(Data); }
+  JBinaryDataArray* CheckArray(JBinaryData *bd,const std::string &name,JBinaryDataDef::TpData type,unsigned count);
+  void LoadArray(JBinaryData *bd,const std::string &name,JBinaryDataDef::TpData type,unsigned count,void *ptr);
+};
+
+#endif
+
+
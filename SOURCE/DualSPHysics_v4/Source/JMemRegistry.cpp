@@ -0,0 +1,175 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JMemRegistry.cpp \brief Implements the class \ref JMemRegistry.
+
+#include "JMemRegistry.h"
+#include "Functions.h"
+#include "JLog2.h"
+#include <fstream>
+#include <algorithm>
+
+using namespace std;
+
+std::mutex JMemRegistry::Mtx;
+std::vector<JMemRegistry::StEntry> JMemRegistry::Entries;
+std::vector<JMemRegistry::StEvent> JMemRegistry::Events;
+ullong JMemRegistry::EventsLost=0;
+llong JMemRegistry::Total=0;
+llong JMemRegistry::TotalPeak=0;
+double JMemRegistry::TimeStep=0;
+std::chrono::steady_clock::time_point JMemRegistry::TimeStart;
+bool JMemRegistry::Active=false;
+
+//==============================================================================
+/// Activa el registro. Las asignaciones anteriores no se conocen.
+/// Activates the registry. Previous allocations are not known.
+//==============================================================================
+void JMemRegistry::Config(){
+  Free();
+  TimeStart=std::chrono::steady_clock::now();
+  Active=true;
+}
+
+//==============================================================================
+/// Desactiva el registro y borra las asignaciones y eventos.
+/// Deactivates the registry and clears allocations and events.
+//==============================================================================
+void JMemRegistry::Free(){
+  lock_guard<mutex> lock(Mtx);
+  Active=false;
+  Entries.clear();
+  Events.clear();
+  EventsLost=0;
+  Total=TotalPeak=0;
+  TimeStep=0;
+}
+
+//==============================================================================
+/// Devuelve el indice de la asignacion y la crea si no existe.
+/// Returns the index of the allocation and creates it when it does not exist.
+//==============================================================================
+unsigned JMemRegistry::GetEntry(const char *subsystem,const std::string &name){
+  const unsigned n=unsigned(Entries.size());
+  for(unsigned c=0;c<n;c++)if(Entries[c].name==name && Entries[c].subsystem==subsystem)return(c);
+  StEntry e;
+  e.subsystem=subsystem; e.name=name;
+  e.cur=e.peak=e.atpeak=0; e.growths=0;
+  Entries.push_back(e);
+  return(n);
+}
+
+//==============================================================================
+/// Cambia los bytes de una asignacion, registra el evento si crece y guarda
+/// el reparto cuando el total alcanza un nuevo maximo.
+/// Changes the bytes of an allocation, records the event when it grows and
+/// stores the breakdown when the total reaches a new peak.
+//==============================================================================
+void JMemRegistry::Update(unsigned entry,llong bytes){
+  StEntry &e=Entries[entry];
+  bytes=max(bytes,llong(0)); //-Allocations made before Config() are not known.
+  const llong delta=bytes-e.cur;
+  if(!delta)return;
+  e.cur=bytes;
+  e.peak=max(e.peak,bytes);
+  Total+=delta;
+  if(delta>0){
+    e.growths++;
+    if(Events.size()<MaxEvents){
+      StEvent ev;
+      ev.wall=std::chrono::duration<double>(std::chrono::steady_clock::now()-TimeStart).count();
+      ev.timestep=TimeStep;
+      ev.entry=entry; ev.bytes=bytes; ev.total=Total;
+      Events.push_back(ev);
+    }
+    else EventsLost++;
+    if(Total>TotalPeak){
+      TotalPeak=Total;
+      for(unsigned c=0;c<unsigned(Entries.size());c++)Entries[c].atpeak=Entries[c].cur;
+    }
+  }
+}
+
+//==============================================================================
+/// Cambia el tamanho actual de una asignacion con un unico propietario.
+/// Sets the current size of an allocation with a single owner.
+//==============================================================================
+void JMemRegistry::Set(const char *subsystem,const std::string &name,llong bytes){
+  if(!Active)return;
+  lock_guard<mutex> lock(Mtx);
+  const unsigned entry=GetEntry(subsystem,name);
+  Update(entry,bytes);
+}
+
+//==============================================================================
+/// Suma bytes (negativos para liberar) a una asignacion compartida.
+/// Adds bytes (negative to free) to a shared allocation.
+//==============================================================================
+void JMemRegistry::Add(const char *subsystem,const std::string &name,llong bytes){
+  if(!Active || !bytes)return;
+  lock_guard<mutex> lock(Mtx);
+  const unsigned entry=GetEntry(subsystem,name);
+  Update(entry,Entries[entry].cur+bytes);
+}
+
+//==============================================================================
+/// Devuelve una copia de las asignaciones registradas.
+/// Returns a copy of the registered allocations.
+//==============================================================================
+std::vector<JMemRegistry::StEntry> JMemRegistry::GetEntries(){
+  lock_guard<mutex> lock(Mtx);
+  return(Entries);
+}
+
+//==============================================================================
+/// Muestra el reparto de memoria actual, maximo y en el maximo del total.
+/// Shows the breakdown of current memory, peak and at the peak of the total.
+//==============================================================================
+void JMemRegistry::Print(JLog2 *log){
+  lock_guard<mutex> lock(Mtx);
+  const double mb=1024.*1024.;
+  log->Print("\n[Memory registry]");
+  log->Printf("Total: %.3f MB, peak: %.3f MB, growth events: %u%s",Total/mb,TotalPeak/mb,unsigned(Events.size())
+    ,(EventsLost? fun::PrintStr(" (%llu not stored)",EventsLost).c_str(): ""));
+  log->Printf("%-12s %-16s %12s %12s %12s %7s %8s","Subsystem","Array","Current(MB)","Peak(MB)","AtPeak(MB)","%Peak","Growths");
+  for(unsigned c=0;c<unsigned(Entries.size());c++){
+    const StEntry &e=Entries[c];
+    if(!e.peak)continue;
+    log->Printf("%-12s %-16s %12.3f %12.3f %12.3f %6.1f%% %8u",e.subsystem.c_str(),e.name.c_str(),e.cur/mb,e.peak/mb
+      ,e.atpeak/mb,(TotalPeak? double(e.atpeak)/TotalPeak*100.: 0),e.growths);
+  }
+}
+
+//==============================================================================
+/// Graba los eventos de crecimiento en formato CSV.
+/// Saves the growth events in CSV format.
+//==============================================================================
+void JMemRegistry::SaveCsv(const std::string &file){
+  lock_guard<mutex> lock(Mtx);
+  ofstream pf;
+  pf.open(file.c_str());
+  if(!pf)throw string("JMemRegistry::SaveCsv: File could not be opened. File: ")+file;
+  pf << "Wall [s];TimeStep [s];Subsystem;Array;Bytes;Total" << endl;
+  for(unsigned c=0;c<unsigned(Events.size());c++){
+    const StEvent &ev=Events[c];
+    const StEntry &e=Entries[ev.entry];
+    pf << fun::PrintStr("%.6f;%.9g;%s;%s;%lld;%lld",ev.wall,ev.timestep,e.subsystem.c_str(),e.name.c_str(),ev.bytes,ev.total) << endl;
+  }
+  if(pf.fail())throw string("JMemRegistry::SaveCsv: File writing failure. File: ")+file;
+  pf.close();
+}
+
@@ -0,0 +1,97 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JMemRegistry.h \brief Declares the class \ref JMemRegistry.
+
+#ifndef _JMemRegistry_
+#define _JMemRegistry_
+
+#include "TypesDef.h"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+
+class JLog2;
+
+//##############################################################################
+//# JMemRegistry
+//##############################################################################
+/// \brief Registry of the memory allocated by name (subsystem and array) with
+/// current size, peak size and growth events over time. The state is static
+/// so the allocation functions of any class can report to it without passing
+/// an object, and it does nothing when it is not active.
+
+class JMemRegistry
+{
+ public:
+  ///Datos de una asignacion con nombre. Data of a named allocation.
+  typedef struct{
+    std::string subsystem;
+    std::string name;
+    llong cur;         ///<Bytes actuales. Current bytes.
+    llong peak;        ///<Maximo de bytes. Peak of bytes.
+    llong atpeak;      ///<Bytes en el maximo del total. Bytes at the peak of the total.
+    unsigned growths;  ///<Numero de incrementos. Number of increments.
+  }StEntry;
+
+  ///Evento de crecimiento. Growth event.
+  typedef struct{
+    double wall;       ///<Segundos desde Config(). Seconds since Config().
+    double timestep;   ///<Instante de simulacion. Simulation instant.
+    unsigned entry;    ///<Indice de la asignacion. Index of the allocation.
+    llong bytes;       ///<Bytes de la asignacion tras el evento. Bytes of the allocation after the event.
+    llong total;       ///<Total tras el evento. Total after the event.
+  }StEvent;
+
+  static const unsigned MaxEvents=100000;  ///<Numero maximo de eventos guardados. Maximum number of stored events.
+
+ private:
+  static std::mutex Mtx;
+  static std::vector<StEntry> Entries;
+  static std::vector<StEvent> Events;
+  static ullong EventsLost;
+  static llong Total,TotalPeak;
+  static double TimeStep;
+  static std::chrono::steady_clock::time_point TimeStart;
+
+  static unsigned GetEntry(const char *subsystem,const std::string &name);
+  static void Update(unsigned entry,llong bytes);
+
+ public:
+  static bool Active;  ///<Indica si se registran asignaciones. Indicates whether allocations are recorded.
+
+  static void Config();
+  static void Free();
+
+  /// Sets the current size of a named allocation (single owner).
+  static void Set(const char *subsystem,const std::string &name,llong bytes);
+  /// Adds bytes (negative to free) to a named allocation shared by several owners.
+  static void Add(const char *subsystem,const std::string &name,llong bytes);
+  /// Sets the simulation instant of the next growth events.
+  static void SetTimeStep(double timestep){ TimeStep=timestep; }
+
+  static llong GetTotal(){ return(Total); }
+  static llong GetTotalPeak(){ return(TotalPeak); }
+  static std::vector<StEntry> GetEntries();
+
+  static void Print(JLog2 *log);
+  static void SaveCsv(const std::string &file);
+};
+
+#endif
+
@@ -18,6 +18,7 @@
 /// \file JPartDataBi4.cpp \brief Implements the class \ref JPartDataBi4.
 
 #include "JPartDataBi4.h"
+#include "JPartSeriesBi4.h"
 //#include "JBinaryData.h"
 #include "Functions.h"
 
@@ -41,6 +42,7 @@ using namespace std;
 JPartDataBi4::JPartDataBi4(){
   ClassName="JPartDataBi4";
   Data=NULL;
+  SeriesSave=NULL;
   Reset();
 }
 
@@ -49,6 +51,7 @@ JPartDataBi4::JPartDataBi4(){
 //==============================================================================
 JPartDataBi4::~JPartDataBi4(){
   delete Data; Data=NULL;
+  delete SeriesSave; SeriesSave=NULL;
 }
 
 //==============================================================================
@@ -59,6 +62,7 @@ void JPartDataBi4::Reset(){
   Dir="";
   Piece=0;
   Npiece=1;
+  delete SeriesSave; SeriesSave=NULL;
 }
 
 //==============================================================================
@@ -258,6 +262,19 @@ void JPartDataBi4::ConfigSplitting(bool splitting){
   Data->SetvBool("Splitting",splitting);
 }
 
+//==============================================================================
+/// Configura grabacion de PARTs en ficheros de series con partsfile PARTs por
+/// fichero (0:sin limite).
+/// Configures saving of PARTs in series files with partsfile PARTs per file
+/// (0:unlimited).
+//==============================================================================
+void JPartDataBi4::ConfigSeries(unsigned partsfile){
+  if(Npiece>1)RunException("ConfigSeries","Series files are not available with several pieces.");
+  delete SeriesSave;
+  SeriesSave=new JPartSeriesBi4Save();
+  SeriesSave->Config(Dir,partsfile);
+}
+
 //==============================================================================
 /// Devuelve nombre de part segun su numero.
 /// Returns name of part according to their number.
@@ -363,7 +380,12 @@ void JPartDataBi4::SaveFileCase(std::string casename){
 /// Writes file PART with data of particles.
 //==============================================================================
 void JPartDataBi4::SaveFilePart(){
-  SaveFileData(GetFileNamePart(Cpart,Piece,Npiece));
+  if(SeriesSave){
+    if(!Part->GetArraysCount())RunException("SaveFilePart","There is not array of particles data.");
+    SeriesSave->SavePart(Data,Part);
+    Part->RemoveArrays();
+  }
+  else SaveFileData(GetFileNamePart(Cpart,Piece,Npiece));
 }
 
 //==============================================================================
@@ -444,6 +466,35 @@ void JPartDataBi4::LoadFilePart(std::string dir,unsigned cpart,unsigned piece,un
   LoadFileData(fun::GetDirWithSlash(dir)+GetFileNamePart(cpart,piece,npiece),cpart,piece,npiece);
 }
 
+//==============================================================================
+/// Carga PART de ficheros de series usando el indice ya cargado en series.
+/// Los datos de los arrays se leen bajo demanda.
+/// Loads PART from series files using the index already loaded in series.
+/// The array data is read on demand.
+//==============================================================================
+void JPartDataBi4::LoadFileSeries(const JPartSeriesBi4Load *series,unsigned cpart){
+  const char met[]="LoadFileSeries";
+  ResetData();
+  const JPartSeriesBi4Load::StPartPos &ps=series->GetPart(cpart);
+  Data->OpenFileSeries(series->GetFile(ps.file),ClassName);
+  Data->LoadFileSeriesItem(series->GetDataPos(ps.file),false,true);
+  Part=Data->LoadFileSeriesItem(ps.pos,true,false);
+  if(Part->GetName()!=GetNamePart(cpart))RunException(met,"PART data is invalid.",series->GetFile(ps.file));
+  Cpart=Part->GetvUint("Cpart");
+  Piece=Data->GetvUint("Piece");
+  Npiece=Data->GetvUint("Npiece");
+}
+
+//==============================================================================
+/// Carga PART de los ficheros de series del directorio indicado.
+/// Loads PART from the series files in the given directory.
+//==============================================================================
+void JPartDataBi4::LoadFileSeries(std::string dir,unsigned cpart){
+  JPartSeriesBi4Load series;
+  series.Config(dir);
+  LoadFileSeries(&series,cpart);
+}
+
 //==============================================================================
 /// Devuelve el puntero a Part con los datos del PART.
 /// Returns a pointer to Part with the data of the PART.
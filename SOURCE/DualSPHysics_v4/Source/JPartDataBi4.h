@@ -28,6 +28,8 @@
 #include <vector>
 #include <fstream>
 
+class JPartSeriesBi4Save;
+class JPartSeriesBi4Load;
 
 //##############################################################################
 //# JPartDataBi4
@@ -53,6 +55,8 @@ class JPartDataBi4 : protected JObject
   unsigned Npiece;   ///<Numero total de partes. Number of total parts.
   unsigned Cpart;    ///<Numero de PART. PART number.
 
+  JPartSeriesBi4Save *SeriesSave;  ///<Grabacion de PARTs en ficheros de series (NULL:un fichero por PART). Saves PARTs in series files (NULL:one file per PART).
+
   static std::string GetNamePart(unsigned cpart);
   void AddPartData(unsigned npok,const unsigned *idp,const ullong *idpd,const tfloat3 *pos,const tdouble3 *posd,const tfloat3 *vel,const float *rhop);
   void AddPartDataVar(const std::string &name,JBinaryDataDef::TpData type,unsigned npok,const void *v);
@@ -85,6 +89,8 @@ class JPartDataBi4 : protected JObject
   void ConfigSimPeri(TpPeri periactive,tdouble3 perixinc,tdouble3 periyinc,tdouble3 perizinc);
   void ConfigSimDiv(TpAxisDiv axisdiv);
   void ConfigSplitting(bool splitting);
+  void ConfigSeries(unsigned partsfile);
+  JPartSeriesBi4Save* GetSeries()const{ return(SeriesSave); }
 
   //-Configuracion de parts. Configuration of parts.
   JBinaryData* AddPartInfo(unsigned cpart,double timestep,unsigned npok,unsigned nout,unsigned step,double runtime,tdouble3 domainmin,tdouble3 domainmax,ullong nptotal=0,ullong idmax=0);
@@ -124,6 +130,8 @@ class JPartDataBi4 : protected JObject
   unsigned GetPiecesFilePart(std::string dir,unsigned cpart)const;
   void LoadFileCase(std::string dir,std::string casename,unsigned piece=0,unsigned npiece=1);
   void LoadFilePart(std::string dir,unsigned cpart,unsigned piece=0,unsigned npiece=1);
+  void LoadFileSeries(const JPartSeriesBi4Load *series,unsigned cpart);
+  void LoadFileSeries(std::string dir,unsigned cpart);
 
   //Obtencion de datos basicos:
   //Obtaining basic data:
@@ -200,6 +208,8 @@ class JPartDataBi4 : protected JObject
   unsigned Get_Rhop (unsigned size,float    *data)const{ return(GetArray("Rhop",JBinaryDataDef::DatFloat  )->GetDataCopy(size,data)); }
   unsigned Get_Mass (unsigned size,float    *data)const{ return(GetArray("Mass",JBinaryDataDef::DatFloat  )->GetDataCopy(size,data)); }
   unsigned Get_Hvar (unsigned size,float    *data)const{ return(GetArray("Hvar",JBinaryDataDef::DatFloat  )->GetDataCopy(size,data)); }
+  unsigned Get_ArrayRange(std::string name,JBinaryDataDef::TpData type,unsigned first,unsigned count,void *data)const{ return(GetArray(name,type)->GetDataRange(first,count,data)); }
+  unsigned GetArraysToc(std::vector<JBinaryData::StFileArray> &toc)const{ return(GetPart()->GetFileToc(toc)); }
 };
 
 
@@ -0,0 +1,484 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JPartSeriesBi4.cpp \brief Implements the classes \ref JPartSeriesBi4Save and \ref JPartSeriesBi4Load.
+
+#include "JPartSeriesBi4.h"
+#include "Functions.h"
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+//##############################################################################
+//# JPartSeriesBi4Save
+//##############################################################################
+//==============================================================================
+/// Constructor.
+//==============================================================================
+JPartSeriesBi4Save::JPartSeriesBi4Save(){
+  ClassName="JPartSeriesBi4Save";
+  Reset();
+}
+
+//==============================================================================
+/// Destructor.
+//==============================================================================
+JPartSeriesBi4Save::~JPartSeriesBi4Save(){
+  Reset();
+}
+
+//==============================================================================
+/// Initialisation of variables.
+//==============================================================================
+void JPartSeriesBi4Save::Reset(){
+  Dir="";
+  PartsFile=0;
+  FileNum=0;
+  ClearIndex();
+}
+
+//==============================================================================
+/// Elimina indice del fichero actual.
+/// Removes index of current file.
+//==============================================================================
+void JPartSeriesBi4Save::ClearIndex(){
+  DataPos=0;
+  IndexPos=0;
+  FileParts=0;
+}
+
+//==============================================================================
+/// Devuelve nombre de fichero segun su numero.
+/// Returns the filename according to its number.
+//==============================================================================
+std::string JPartSeriesBi4Save::GetFileName(unsigned num){
+  return(fun::PrintStr("PartSeries_%04u.bi4s",num));
+}
+
+//==============================================================================
+/// Genera footer de fichero.
+/// Generates file footer.
+//==============================================================================
+void JPartSeriesBi4Save::MakeFooter(StFooter &foot,llong indexpos,unsigned nparts){
+  memset(&foot,0,sizeof(StFooter));
+  foot.indexpos=indexpos;
+  foot.nparts=nparts;
+  foot.formatver=FormatVerDef;
+  strcpy(foot.code,"#JPartSeriesEnd");
+}
+
+//==============================================================================
+/// Comprueba validez de footer.
+/// Checks validity of footer.
+//==============================================================================
+bool JPartSeriesBi4Save::CheckFooter(const StFooter &foot){
+  return(foot.code[15]==0 && !strcmp(foot.code,"#JPartSeriesEnd") && foot.formatver==FormatVerDef && foot.indexpos>0);
+}
+
+//==============================================================================
+/// Busca el ultimo footer completo del fichero y devuelve su posicion (-1:no
+/// hay ninguno). Normalmente es el final del fichero pero mientras se graba un
+/// PART se busca hacia atras el footer del PART anterior.
+/// Searches for the last complete footer of the file and returns its position
+/// (-1:there is none). Usually it is the end of the file but while a PART is
+/// being written the footer of the previous PART is searched backwards.
+//==============================================================================
+llong JPartSeriesBi4Save::FindFooter(std::ifstream &pf,StFooter &foot){
+  const llong sfoot=llong(sizeof(StFooter));
+  const llong scode=llong(sizeof(foot.code));
+  const llong poscode=sfoot-scode;
+  pf.clear();
+  pf.seekg(0,ios::end);
+  const llong fsize=(llong)pf.tellg();
+  if(fsize<sfoot)return(-1);
+  pf.seekg(fsize-sfoot,ios::beg);
+  pf.read((char*)&foot,sfoot);
+  if(!pf.fail() && CheckFooter(foot) && foot.indexpos<fsize-sfoot)return(fsize-sfoot);
+  //-Busca hacia atras por bloques que se solapan en sfoot-1 bytes.
+  //-Searches backwards by blocks that overlap in sfoot-1 bytes.
+  const llong sbuf=1024*1024;
+  vector<char> buf(size_t(sbuf+sfoot));
+  llong end=fsize;
+  while(end>=sfoot){
+    const llong ini=max(end-sbuf-sfoot+1,llong(0));
+    const llong n=end-ini;
+    pf.clear();
+    pf.seekg(ini,ios::beg);
+    pf.read(&buf[0],n);
+    if(pf.fail())return(-1);
+    for(llong c=n-sfoot;c>=0;c--)if(buf[size_t(c+poscode)]=='#'){
+      memcpy(&foot,&buf[size_t(c)],size_t(sfoot));
+      if(CheckFooter(foot) && foot.indexpos<ini+c)return(ini+c);
+    }
+    if(!ini)break;
+    end=ini+sfoot-1;
+  }
+  return(-1);
+}
+
+//==============================================================================
+/// Comprueba que el item es un indice valido con nparts PARTs.
+/// Checks that the item is a valid index with nparts PARTs.
+//==============================================================================
+bool JPartSeriesBi4Save::CheckIndex(const JBinaryData *idx,unsigned nparts){
+  return(idx->GetName()=="Index" && idx->GetvUint("FormatVer",true,0)==FormatVerDef && idx->GetvUint("Nparts",true,0)==nparts);
+}
+
+//==============================================================================
+/// Configuracion del objeto.
+/// Object configuration.
+//==============================================================================
+void JPartSeriesBi4Save::Config(const std::string &dir,unsigned partsfile){
+  Reset();
+  Dir=fun::GetDirWithSlash(dir);
+  PartsFile=partsfile;
+}
+
+//==============================================================================
+/// Graba el indice del PART grabado en partpos y su footer en la posicion
+/// actual, que pasa a ser IndexPos.
+/// Writes the index of the PART written at partpos and its footer at the
+/// current position, which becomes IndexPos.
+//==============================================================================
+void JPartSeriesBi4Save::WriteIndex(std::fstream *pf,unsigned cpart,double timestep,llong partpos,llong partsize,const std::vector<JBinaryData::StFileArray> &arrays){
+  const llong indexpos=(llong)pf->tellp();
+  const unsigned na=unsigned(arrays.size());
+  const unsigned dirbegin=0;
+  vector<string> dirname(na);
+  vector<int> dirtype(na);
+  vector<unsigned> dircount(na),dirsize(na);
+  vector<llong> dirpos(na);
+  for(unsigned c=0;c<na;c++){
+    const JBinaryData::StFileArray &fa=arrays[c];
+    dirname[c]=fa.name; dirtype[c]=int(fa.type); dircount[c]=fa.count; dirsize[c]=fa.size; dirpos[c]=fa.pos;
+  }
+  JBinaryData idx("Index");
+  idx.SetvUint("FormatVer",FormatVerDef);
+  idx.SetvLlong("DataPos",DataPos);
+  idx.SetvLlong("PrevIndex",IndexPos);
+  idx.SetvUint("Nparts",FileParts+1);
+  idx.CreateArray("Cpart"   ,JBinaryDataDef::DatUint  ,1,&cpart,true);
+  idx.CreateArray("TimeStep",JBinaryDataDef::DatDouble,1,&timestep,true);
+  idx.CreateArray("PartPos" ,JBinaryDataDef::DatLlong ,1,&partpos,true);
+  idx.CreateArray("PartSize",JBinaryDataDef::DatLlong ,1,&partsize,true);
+  idx.CreateArray("DirBegin",JBinaryDataDef::DatUint  ,1,&dirbegin,true);
+  idx.CreateArray("DirName" ,JBinaryDataDef::DatText  ,na,(na? &dirname[0]: NULL),true);
+  idx.CreateArray("DirType" ,JBinaryDataDef::DatInt   ,na,(na? &dirtype[0]: NULL),true);
+  idx.CreateArray("DirCount",JBinaryDataDef::DatUint  ,na,(na? &dircount[0]: NULL),true);
+  idx.CreateArray("DirSize" ,JBinaryDataDef::DatUint  ,na,(na? &dirsize[0]: NULL),true);
+  idx.CreateArray("DirPos"  ,JBinaryDataDef::DatLlong ,na,(na? &dirpos[0]: NULL),true);
+  idx.SaveFileSeriesItem(pf,true);
+  StFooter foot;
+  MakeFooter(foot,indexpos,FileParts+1);
+  pf->write((char*)&foot,sizeof(StFooter));
+  IndexPos=indexpos;
+  FileParts++;
+}
+
+//==============================================================================
+/// Continua la grabacion tras los primeros fileparts PARTs del fichero filenum
+/// (usado al reiniciar desde un checkpoint). Los PARTs y ficheros posteriores
+/// se descartan.
+/// Continues writing after the first fileparts PARTs of file filenum (used
+/// when restarting from a checkpoint). Later PARTs and files are discarded.
+//==============================================================================
+void JPartSeriesBi4Save::Resume(unsigned filenum,unsigned fileparts){
+  const char met[]="Resume";
+  ClearIndex();
+  FileNum=filenum;
+  for(unsigned num=filenum+1;fun::FileExists(Dir+GetFileName(num));num++)remove((Dir+GetFileName(num)).c_str());
+  const string file=Dir+GetFileName(FileNum);
+  if(!fileparts){
+    remove(file.c_str());
+    return;
+  }
+  //-Sigue los indices desde el ultimo footer completo hasta el PART fileparts-1.
+  //-Follows the indices from the last complete footer to PART fileparts-1.
+  llong fsize=0;
+  {
+    JBinaryData bd("JPartDataBi4");
+    bd.OpenFileSeries(file,"JPartDataBi4");
+    ifstream *pf=bd.GetFileStructure();
+    StFooter foot;
+    if(FindFooter(*pf,foot)<0 || foot.nparts<fileparts)RunException(met,"The file does not contain the PARTs of the checkpoint.",file);
+    llong pos=foot.indexpos;
+    for(unsigned np=foot.nparts;;np--){
+      JBinaryData *idx=bd.LoadFileSeriesItem(pos,true,true);
+      if(!CheckIndex(idx,np))RunException(met,"The index of the file is invalid.",file);
+      if(np==fileparts){
+        DataPos=idx->GetvLlong("DataPos");
+        IndexPos=pos;
+        FileParts=fileparts;
+        fsize=(llong)pf->tellg()+llong(sizeof(StFooter));
+        break;
+      }
+      pos=idx->GetvLlong("PrevIndex");
+      bd.RemoveItems();
+    }
+    bd.CloseFileStructure();
+  }
+  //-Elimina el resto del fichero tras el footer del PART fileparts-1.
+  //-Removes the rest of the file after the footer of PART fileparts-1.
+  if(fun::FileTruncate(file,fsize))RunException(met,"Cannot truncate the file.",file);
+}
+
+//==============================================================================
+/// Anhade el PART indicado (perteneciente a data) al final del fichero actual
+/// seguido de su indice y footer. Los datos grabados antes no se modifican.
+/// Appends the given PART (belonging to data) at the end of the current file
+/// followed by its index and footer. Previously written data is not modified.
+//==============================================================================
+void JPartSeriesBi4Save::SavePart(JBinaryData *data,JBinaryData *part){
+  const char met[]="SavePart";
+  //-Pasa al siguiente fichero cuando se alcanza PartsFile.
+  //-Moves to the next file when PartsFile is reached.
+  if(IndexPos && PartsFile && FileParts>=PartsFile){
+    ClearIndex();
+    FileNum++;
+  }
+  const string file=Dir+GetFileName(FileNum);
+  fstream pf;
+  if(!IndexPos)pf.open(file.c_str(),ios::binary|ios::out|ios::trunc);
+  else pf.open(file.c_str(),ios::binary|ios::out|ios::in);
+  if(!pf)RunException(met,"Cannot open the file.",file);
+  if(!IndexPos){//-Graba cabecera y datos generales. Writes header and general data.
+    data->SaveFileSeriesHead(&pf,data->GetName());
+    data->SetHideItems(true,false);
+    DataPos=data->SaveFileSeriesItem(&pf,false);
+    data->SetHideItems(false,false);
+  }
+  else pf.seekp(0,ios::end);
+  //-Graba PART, su indice y footer. Writes PART, its index and footer.
+  vector<JBinaryData::StFileArray> arrays;
+  const llong pos=part->SaveFileSeriesItem(&pf,true,&arrays);
+  const llong size=(llong)pf.tellp()-pos;
+  WriteIndex(&pf,part->GetvUint("Cpart"),part->GetvDouble("TimeStep"),pos,size,arrays);
+  if(pf.fail())RunException(met,"File writing failure.",file);
+  pf.close();
+}
+
+
+//##############################################################################
+//# JPartSeriesBi4Load
+//##############################################################################
+//==============================================================================
+/// Constructor.
+//==============================================================================
+JPartSeriesBi4Load::JPartSeriesBi4Load(){
+  ClassName="JPartSeriesBi4Load";
+  Reset();
+}
+
+//==============================================================================
+/// Destructor.
+//==============================================================================
+JPartSeriesBi4Load::~JPartSeriesBi4Load(){
+  Reset();
+}
+
+//==============================================================================
+/// Initialisation of variables.
+//==============================================================================
+void JPartSeriesBi4Load::Reset(){
+  Dir="";
+  FilesDataPos.clear();
+  LastFileParts=0;
+  Parts.clear();
+  PartIndex.clear();
+  Arrays.clear();
+}
+
+//==============================================================================
+/// Indica si existen ficheros de series en el directorio.
+/// Indicates whether there are series files in the directory.
+//==============================================================================
+bool JPartSeriesBi4Load::Exists(const std::string &dir){
+  return(fun::FileExists(fun::GetDirWithSlash(dir)+JPartSeriesBi4Save::GetFileName(0)));
+}
+
+//==============================================================================
+/// Configura directorio y carga los indices de los ficheros.
+/// Configures directory and loads the indices of the files.
+//==============================================================================
+void JPartSeriesBi4Load::Config(const std::string &dir){
+  Reset();
+  Dir=fun::GetDirWithSlash(dir);
+  if(!Exists(Dir))RunException("Config","File of series was not found.",GetFile(0));
+  Refresh();
+}
+
+//==============================================================================
+/// Devuelve nombre de fichero segun su numero.
+/// Returns the filename according to its number.
+//==============================================================================
+std::string JPartSeriesBi4Load::GetFile(unsigned num)const{
+  return(Dir+JPartSeriesBi4Save::GetFileName(num));
+}
+
+//==============================================================================
+/// Devuelve la posicion del item Data del fichero indicado.
+/// Returns the position of Data item of the given file.
+//==============================================================================
+llong JPartSeriesBi4Load::GetDataPos(unsigned num)const{
+  if(num>=GetFilesCount())RunException("GetDataPos","Number of file is invalid.");
+  return(FilesDataPos[num]);
+}
+
+//==============================================================================
+/// Devuelve array del indice comprobando su tipo y tamanho.
+/// Returns array of the index checking its type and size.
+//==============================================================================
+JBinaryDataArray* JPartSeriesBi4Load::CheckIndexArray(JBinaryData *idx,const std::string &name,JBinaryDataDef::TpData type,unsigned count,const std::string &file){
+  JBinaryDataArray *ar=idx->GetArray(name);
+  if(!ar || ar->GetType()!=type || ar->GetCount()!=count)RunException("CheckIndexArray",string("The array ")+name+" of the index is invalid.",file);
+  return(ar);
+}
+
+//==============================================================================
+/// Carga los PARTs del fichero num a partir de los nparts ya cargados.
+/// Devuelve el numero de PARTs del fichero o nparts cuando no hay PARTs nuevos
+/// completos (fichero en escritura).
+/// Loads the PARTs of file num after the nparts already loaded.
+/// Returns the number of PARTs of the file or nparts when there are no new
+/// complete PARTs (file being written).
+//==============================================================================
+unsigned JPartSeriesBi4Load::LoadIndex(unsigned num,unsigned nparts){
+  const char met[]="LoadIndex";
+  const string file=GetFile(num);
+  JBinaryData bd("JPartDataBi4");
+  bd.OpenFileSeries(file,"JPartDataBi4");
+  //-Lee el ultimo footer completo. Reads the last complete footer.
+  JPartSeriesBi4Save::StFooter foot;
+  if(JPartSeriesBi4Save::FindFooter(*bd.GetFileStructure(),foot)<0 || foot.nparts<=nparts)return(nparts);
+  //-Sigue los indices hacia atras hasta el primer PART sin cargar.
+  //-Follows the indices backwards to the first PART not loaded.
+  vector<llong> idxpos;
+  llong pos=foot.indexpos;
+  for(unsigned np=foot.nparts;np>nparts;){
+    JBinaryData *idx=bd.LoadFileSeriesItem(pos,true,true);
+    if(!JPartSeriesBi4Save::CheckIndex(idx,np))RunException(met,"The index of the file is invalid.",file);
+    const unsigned m=(idx->GetArray("Cpart")? idx->GetArray("Cpart")->GetCount(): 0);
+    if(!m || m>np)RunException(met,"The index of the file is invalid.",file);
+    idxpos.push_back(pos);
+    np-=m;
+    pos=idx->GetvLlong("PrevIndex");
+    if(np>nparts && !pos)RunException(met,"The index of the file is invalid.",file);
+    if(num==GetFilesCount() && np<=nparts)FilesDataPos.push_back(idx->GetvLlong("DataPos"));
+    bd.RemoveItems();
+  }
+  //-Carga los indices nuevos en orden. Loads the new indices in order.
+  for(unsigned ci=unsigned(idxpos.size());ci-->0;){
+    JBinaryData *idx=bd.LoadFileSeriesItem(idxpos[ci],true,true);
+    const unsigned npidx=idx->GetvUint("Nparts");
+    const unsigned m=idx->GetArray("Cpart")->GetCount();
+    const unsigned na=idx->GetArray("DirName")? idx->GetArray("DirName")->GetCount(): 0;
+    const unsigned *cpart   =(const unsigned*)CheckIndexArray(idx,"Cpart"   ,JBinaryDataDef::DatUint  ,m,file)->GetDataPointer();
+    const double   *timestep=(const double*)  CheckIndexArray(idx,"TimeStep",JBinaryDataDef::DatDouble,m,file)->GetDataPointer();
+    const llong    *partpos =(const llong*)   CheckIndexArray(idx,"PartPos" ,JBinaryDataDef::DatLlong ,m,file)->GetDataPointer();
+    const llong    *partsize=(const llong*)   CheckIndexArray(idx,"PartSize",JBinaryDataDef::DatLlong ,m,file)->GetDataPointer();
+    const unsigned *dirbegin=(const unsigned*)CheckIndexArray(idx,"DirBegin",JBinaryDataDef::DatUint  ,m,file)->GetDataPointer();
+    const string   *dirname =(const string*)  CheckIndexArray(idx,"DirName" ,JBinaryDataDef::DatText  ,na,file)->GetDataPointer();
+    const int      *dirtype =(const int*)     CheckIndexArray(idx,"DirType" ,JBinaryDataDef::DatInt   ,na,file)->GetDataPointer();
+    const unsigned *dircount=(const unsigned*)CheckIndexArray(idx,"DirCount",JBinaryDataDef::DatUint  ,na,file)->GetDataPointer();
+    const unsigned *dirsize =(const unsigned*)CheckIndexArray(idx,"DirSize" ,JBinaryDataDef::DatUint  ,na,file)->GetDataPointer();
+    const llong    *dirpos  =(const llong*)   CheckIndexArray(idx,"DirPos"  ,JBinaryDataDef::DatLlong ,na,file)->GetDataPointer();
+    for(unsigned p=0;p<m;p++)if(npidx-m+p>=nparts){
+      StPartPos ps;
+      ps.cpart=cpart[p];
+      ps.timestep=timestep[p];
+      ps.file=num;
+      ps.pos=partpos[p];
+      ps.size=partsize[p];
+      ps.dirbegin=unsigned(Arrays.size());
+      const unsigned dirend=(p+1<m? dirbegin[p+1]: na);
+      ps.dircount=dirend-dirbegin[p];
+      for(unsigned c=dirbegin[p];c<dirend;c++){
+        JBinaryData::StFileArray fa;
+        fa.name=dirname[c];
+        fa.type=JBinaryDataDef::TpData(dirtype[c]);
+        fa.count=dircount[c];
+        fa.size=dirsize[c];
+        fa.pos=dirpos[c];
+        Arrays.push_back(fa);
+      }
+      if(ps.cpart>=unsigned(PartIndex.size()))PartIndex.resize(ps.cpart+1,-1);
+      PartIndex[ps.cpart]=int(Parts.size());
+      Parts.push_back(ps);
+    }
+    bd.RemoveItems();
+  }
+  return(foot.nparts);
+}
+
+//==============================================================================
+/// Carga los PARTs nuevos del ultimo fichero y de los ficheros siguientes.
+/// Devuelve el numero de PARTs nuevos.
+/// Loads the new PARTs of the last file and of the following files.
+/// Returns the number of new PARTs.
+//==============================================================================
+unsigned JPartSeriesBi4Load::Refresh(){
+  const unsigned n0=GetCount();
+  unsigned num=(GetFilesCount()? GetFilesCount()-1: 0);
+  while(fun::FileExists(GetFile(num))){
+    const unsigned nread=(num+1==GetFilesCount()? LastFileParts: 0);
+    const unsigned nparts=LoadIndex(num,nread);
+    if(!nparts)break;
+    LastFileParts=nparts;
+    num++;
+  }
+  return(GetCount()-n0);
+}
+
+//==============================================================================
+/// Devuelve la localizacion del PART segun su posicion en la serie.
+/// Returns the location of the PART according to its position in the series.
+//==============================================================================
+const JPartSeriesBi4Load::StPartPos& JPartSeriesBi4Load::GetPartPos(unsigned ipart)const{
+  if(ipart>=GetCount())RunException("GetPartPos","Number of PART is invalid.");
+  return(Parts[ipart]);
+}
+
+//==============================================================================
+/// Devuelve la localizacion del PART indicado.
+/// Returns the location of the given PART.
+//==============================================================================
+const JPartSeriesBi4Load::StPartPos& JPartSeriesBi4Load::GetPart(unsigned cpart)const{
+  if(!PartExists(cpart))RunException("GetPart",fun::PrintStr("PART %u is not available.",cpart),Dir);
+  return(Parts[PartIndex[cpart]]);
+}
+
+//==============================================================================
+/// Devuelve la entrada indicada del directorio de arrays.
+/// Returns the given entry of the array directory.
+//==============================================================================
+const JBinaryData::StFileArray& JPartSeriesBi4Load::GetArray(unsigned num)const{
+  if(num>=unsigned(Arrays.size()))RunException("GetArray","Number of array is invalid.");
+  return(Arrays[num]);
+}
+
+//==============================================================================
+/// Devuelve la entrada del directorio del array indicado del PART o NULL.
+/// Returns the directory entry of the given array of the PART or NULL.
+//==============================================================================
+const JBinaryData::StFileArray* JPartSeriesBi4Load::GetPartArray(unsigned cpart,const std::string &name)const{
+  const StPartPos &ps=GetPart(cpart);
+  for(unsigned c=ps.dirbegin;c<ps.dirbegin+ps.dircount;c++)if(Arrays[c].name==name)return(&Arrays[c]);
+  return(NULL);
+}
+
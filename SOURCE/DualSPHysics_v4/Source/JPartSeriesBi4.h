@@ -0,0 +1,161 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JPartSeriesBi4.h \brief Declares the classes \ref JPartSeriesBi4Save and \ref JPartSeriesBi4Load.
+
+#ifndef _JPartSeriesBi4_
+#define _JPartSeriesBi4_
+
+#include "JObject.h"
+#include "TypesDef.h"
+#include "JBinaryData.h"
+#include <string>
+#include <vector>
+
+//##############################################################################
+//# File format.
+//##############################################################################
+// PartSeries_XXXX.bi4s
+//   [Head]     StHeadFmtBin of JBinaryData with filecode "JPartDataBi4".
+//   [Data]     Item with the general values of JPartDataBi4 (without PARTs).
+//   [PART_0]   Item PART_XXXX as in Part_XXXX.bi4.
+//   [Index_0]  Item "Index" with arrays Cpart, TimeStep, PartPos, PartSize and
+//              the array directory (DirBegin, DirName, DirType, DirCount,
+//              DirSize, DirPos) of PART_0, the number of PARTs of the file
+//              up to PART_0 (Nparts) and the position of the previous index
+//              (PrevIndex, 0 for the first one).
+//   [Footer_0] StFooter with the position of Index_0.
+//   [PART_1]
+//   [Index_1]
+//   [Footer_1]
+//   ...
+// Each new PART is appended after the last footer with its own index and
+// footer, so the written data never changes and saving a PART does not depend
+// on the number of previous PARTs. Readers take the footer at the end of the
+// file or, when the file is being written, search backwards for the last
+// complete footer, and follow PrevIndex back to the PARTs not loaded yet.
+
+//##############################################################################
+//# JPartSeriesBi4Save
+//##############################################################################
+/// \brief Appends PART data of \ref JPartDataBi4 to one or several rolling
+/// files with a trailing index instead of one file per PART.
+
+class JPartSeriesBi4Save : protected JObject
+{
+ public:
+  static const unsigned FormatVerDef=161021;  ///<Version de formato by default. Version of format by default.
+
+  ///Structure of the footer at the end of each file.
+  typedef struct{
+    llong indexpos;      ///<Posicion del indice. Position of the index.
+    unsigned nparts;     ///<Numero de PARTs en el fichero. Number of PARTs in the file.
+    unsigned formatver;  ///<Version de formato. Version of format.
+    char code[16];       ///<Codigo de validacion. Validation code "#JPartSeriesEnd".
+  }StFooter;//-sizeof(32)
+
+  static void MakeFooter(StFooter &foot,llong indexpos,unsigned nparts);
+  static bool CheckFooter(const StFooter &foot);
+  static llong FindFooter(std::ifstream &pf,StFooter &foot);
+  static bool CheckIndex(const JBinaryData *idx,unsigned nparts);
+
+ private:
+  std::string Dir;       ///<Directorio de datos. Data directory.
+  unsigned PartsFile;    ///<Numero maximo de PARTs por fichero (0:sin limite). Maximum number of PARTs per file (0:unlimited).
+  unsigned FileNum;      ///<Numero del fichero actual. Number of current file.
+  llong DataPos;         ///<Posicion del item Data en el fichero actual. Position of Data item in current file.
+  llong IndexPos;        ///<Posicion del ultimo indice en el fichero actual (0:fichero sin crear). Position of the last index in current file (0:file not created).
+  unsigned FileParts;    ///<Numero de PARTs del fichero actual. Number of PARTs of current file.
+
+  void ClearIndex();
+  void WriteIndex(std::fstream *pf,unsigned cpart,double timestep,llong partpos,llong partsize,const std::vector<JBinaryData::StFileArray> &arrays);
+
+ public:
+  JPartSeriesBi4Save();
+  ~JPartSeriesBi4Save();
+  void Reset();
+
+  static std::string GetFileName(unsigned num);
+
+  void Config(const std::string &dir,unsigned partsfile);
+  unsigned GetPartsFile()const{ return(PartsFile); }
+  unsigned GetFileNum()const{ return(FileNum); }
+  unsigned GetFileParts()const{ return(FileParts); }
+
+  void Resume(unsigned filenum,unsigned fileparts);
+  void SavePart(JBinaryData *data,JBinaryData *part);
+};
+
+
+//##############################################################################
+//# JPartSeriesBi4Load
+//##############################################################################
+/// \brief Reads the index of the files written by \ref JPartSeriesBi4Save.
+/// Refresh() reads only the new PARTs, so it can be used to follow the files
+/// while the simulation is running.
+
+class JPartSeriesBi4Load : protected JObject
+{
+ public:
+  ///Structure with the location of a PART.
+  typedef struct{
+    unsigned cpart;     ///<Numero de PART. PART number.
+    double timestep;    ///<Instante de simulacion. Simulation instant.
+    unsigned file;      ///<Numero de fichero. Number of file.
+    llong pos;          ///<Posicion del item en el fichero. Position of the item in the file.
+    llong size;         ///<Size del item en el fichero. Size of the item in the file.
+    unsigned dirbegin;  ///<Primera entrada en el directorio de arrays. First entry in the array directory.
+    unsigned dircount;  ///<Numero de arrays. Number of arrays.
+  }StPartPos;
+
+ private:
+  std::string Dir;                  ///<Directorio de datos. Data directory.
+  std::vector<llong> FilesDataPos;  ///<Posicion del item Data en cada fichero. Position of Data item in each file.
+  unsigned LastFileParts;           ///<Numero de PARTs leidos del ultimo fichero. Number of PARTs read from the last file.
+  std::vector<StPartPos> Parts;
+  std::vector<int> PartIndex;       ///<Posicion en Parts segun cpart (-1:no existe). Position in Parts according to cpart (-1:missing).
+  std::vector<JBinaryData::StFileArray> Arrays;
+
+  JBinaryDataArray* CheckIndexArray(JBinaryData *idx,const std::string &name,JBinaryDataDef::TpData type,unsigned count,const std::string &file);
+  unsigned LoadIndex(unsigned num,unsigned nparts);
+
+ public:
+  JPartSeriesBi4Load();
+  ~JPartSeriesBi4Load();
+  void Reset();
+
+  static bool Exists(const std::string &dir);
+
+  void Config(const std::string &dir);
+  unsigned Refresh();
+
+  std::string GetDir()const{ return(Dir); }
+  std::string GetFile(unsigned num)const;
+  unsigned GetFilesCount()const{ return(unsigned(FilesDataPos.size())); }
+  llong GetDataPos(unsigned num)const;
+
+  unsigned GetCount()const{ return(unsigned(Parts.size())); }
+  const StPartPos& GetPartPos(unsigned ipart)const;
+  bool PartExists(unsigned cpart)const{ return(cpart<unsigned(PartIndex.size()) && PartIndex[cpart]>=0); }
+  const StPartPos& GetPart(unsigned cpart)const;
+  const JBinaryData::StFileArray& GetArray(unsigned num)const;
+  const JBinaryData::StFileArray* GetPartArray(unsigned cpart,const std::string &name)const;
+};
+
+#endif
+
+
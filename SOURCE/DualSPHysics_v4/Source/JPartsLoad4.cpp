@@ -20,6 +20,8 @@
 #include "JPartsLoad4.h"
 #include "Functions.h"
 #include "JPartDataBi4.h"
+#include "JMemRegistry.h"
+#include "JPartSeriesBi4.h"
 #include "JRadixSort.h"
 #include <climits>
 #include <cfloat>
@@ -67,7 +69,7 @@ void JPartsLoad4::AllocMemory(unsigned count){
   delete[] VelRhop;  VelRhop=NULL; 
   if(Count){
     try{
-      Idp=new unsigned[Count];
+      Idp=new tpartid[Count];
       Pos=new tdouble3[Count];
       VelRhop=new tfloat4[Count];
     }
@@ -75,6 +77,9 @@ void JPartsLoad4::AllocMemory(unsigned count){
       RunException("AllocMemory","Could not allocate the requested memory.");
     }
   } 
+  JMemRegistry::Set("PartsLoad","Idp",llong(sizeof(tpartid))*Count);
+  JMemRegistry::Set("PartsLoad","Pos",llong(sizeof(tdouble3))*Count);
+  JMemRegistry::Set("PartsLoad","VelRhop",llong(sizeof(tfloat4))*Count);
 }
 
 //==============================================================================
@@ -83,7 +88,7 @@ void JPartsLoad4::AllocMemory(unsigned count){
 llong JPartsLoad4::GetAllocMemory()const{  
   llong s=0;
   //Reservada en AllocMemory()
-  if(Idp)s+=sizeof(unsigned)*Count;
+  if(Idp)s+=sizeof(tpartid)*Count;
   if(Pos)s+=sizeof(tdouble3)*Count;
   if(VelRhop)s+=sizeof(tfloat4)*Count;
   return(s);
@@ -135,6 +140,7 @@ void JPartsLoad4::LoadParticles(const std::string &casedir,const std::string &ca
     const string file1=dir+JPartDataBi4::GetFileNamePart(PartBegin,0,1);
     if(fun::FileExists(file1))pd.LoadFilePart(dir,PartBegin,0,1);
     else if(fun::FileExists(dir+JPartDataBi4::GetFileNamePart(PartBegin,0,2)))pd.LoadFilePart(dir,PartBegin,0,2);
+    else if(JPartSeriesBi4Load::Exists(dir))pd.LoadFileSeries(dir,PartBegin);
     else RunException(met,"File of the particles was not found.",file1);
   }
   //-Obtiene configuracion.
@@ -167,7 +173,10 @@ void JPartsLoad4::LoadParticles(const std::string &casedir,const std::string &ca
   CasePosMin=pd.Get_CasePosMin();
   CasePosMax=pd.Get_CasePosMax();
   const bool possimple=pd.Get_PosSimple();
-  if(!pd.Get_IdpSimple())RunException(met,"Only Idp (32 bits) is valid at the moment.");
+  const bool idpsimple=pd.Get_IdpSimple();
+#ifndef PARTIDS_64BIT
+  if(!idpsimple)RunException(met,"Only Idp (32 bits) is valid without PARTIDS_64BIT.");
+#endif
   //-Calcula numero de particulas.
   unsigned sizetot=pd.Get_Npok();
   for(unsigned piece=1;piece<Npiece;piece++){
@@ -203,7 +212,17 @@ void JPartsLoad4::LoadParticles(const std::string &casedir,const std::string &ca
           for(unsigned p=0;p<npok;p++)Pos[ntot+p]=ToTDouble3(auxf3[p]);
         }
         else pd.Get_Posd(npok,Pos+ntot);
-        pd.Get_Idp(npok,Idp+ntot);  
+#ifdef PARTIDS_64BIT
+        if(!idpsimple)pd.Get_Idpd(npok,Idp+ntot);
+        else{
+          unsigned *auxu=new unsigned[npok];
+          pd.Get_Idp(npok,auxu);
+          for(unsigned p=0;p<npok;p++)Idp[ntot+p]=auxu[p];
+          delete[] auxu;
+        }
+#else
+        pd.Get_Idp(npok,Idp+ntot);
+#endif
         pd.Get_Vel(npok,auxf3);  
         pd.Get_Rhop(npok,auxf);  
         for(unsigned p=0;p<npok;p++)VelRhop[ntot+p]=TFloat4(auxf3[p].x,auxf3[p].y,auxf3[p].z,auxf[p]);
@@ -245,12 +264,12 @@ void JPartsLoad4::RemoveBoundary(){
   for(;nbound<Count && Idp[nbound]<casenbound;nbound++);
   //-Saves old pointers and allocates new memory.
   unsigned count0=Count;
-  unsigned *idp0=Idp;        Idp=NULL;
+  tpartid *idp0=Idp;         Idp=NULL;
   tdouble3 *pos0=Pos;        Pos=NULL;
   tfloat4 *velrhop0=VelRhop; VelRhop=NULL;
   AllocMemory(count0-nbound);
   //-Copies data in new pointers.
-  memcpy(Idp,idp0+nbound,sizeof(unsigned)*Count);
+  memcpy(Idp,idp0+nbound,sizeof(tpartid)*Count);
   memcpy(Pos,pos0+nbound,sizeof(tdouble3)*Count);
   memcpy(VelRhop,velrhop0+nbound,sizeof(tfloat4)*Count);
   //-Frees old pointers.
@@ -21,7 +21,7 @@
 #define _JPartsLoad4_
 
 
-#include "TypesDef.h"
+#include "Types.h"
 #include "JObject.h"
 #include <cstring>
 
@@ -62,7 +62,7 @@ protected:
 
   //-Vars para particulas
   unsigned Count;    //-Numero de particulas.
-  unsigned *Idp;
+  tpartid *Idp;
   tdouble3 *Pos;
   tfloat4 *VelRhop;
 
@@ -90,7 +90,7 @@ public:
   double GetPartBeginTimeStep()const{ return(PartBeginTimeStep); }
   ullong GetPartBeginTotalNp()const{ return(PartBeginTotalNp); }
 
-  const unsigned* GetIdp(){ return(Idp); }
+  const tpartid* GetIdp(){ return(Idp); }
   const tdouble3* GetPos(){ return(Pos); }
   const tfloat4* GetVelRhop(){ return(VelRhop); }
 
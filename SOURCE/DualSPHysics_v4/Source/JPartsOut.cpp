@@ -19,6 +19,7 @@
 
 #include "JPartsOut.h"
 #include "Functions.h"
+#include "JMemRegistry.h"
 #include <algorithm>
 
 using namespace std;
@@ -72,6 +73,10 @@ void JPartsOut::AllocMemory(unsigned size,bool reset){
       RunException("AllocMemory","Could not allocate the requested memory.");
     }
   }
+  JMemRegistry::Set("PartsOut","Idp",(Idp? llong(sizeof(tpartid))*Size: 0));
+  JMemRegistry::Set("PartsOut","Pos",(Pos? llong(sizeof(tdouble3))*Size: 0));
+  JMemRegistry::Set("PartsOut","Vel",(Vel? llong(sizeof(tfloat3))*Size: 0));
+  JMemRegistry::Set("PartsOut","Rhop",(Rhop? llong(sizeof(float))*Size: 0));
 }
 
 //==============================================================================
@@ -81,7 +86,7 @@ llong JPartsOut::GetAllocMemory()const{
   llong s=0;
   //Reservada en AllocMemory()
   //Allocated in AllocMemory()
-  if(Idp)s+=sizeof(unsigned)*Size;
+  if(Idp)s+=sizeof(tpartid)*Size;
   if(Pos)s+=sizeof(tdouble3)*Size;
   if(Vel)s+=sizeof(tfloat3)*Size;
   if(Rhop)s+=sizeof(float)*Size;
@@ -91,9 +96,9 @@ llong JPartsOut::GetAllocMemory()const{
 //==============================================================================
 /// Resizes arrays for particles.
 //==============================================================================
-void JPartsOut::AddParticles(unsigned np,const unsigned* idp,const tdouble3* pos,const tfloat3* vel,const float* rhop,unsigned outrhop,unsigned outmove){
+void JPartsOut::AddParticles(unsigned np,const tpartid* idp,const tdouble3* pos,const tfloat3* vel,const float* rhop,unsigned outrhop,unsigned outmove){
   if(Count+np>Size)AllocMemory(Count+np+SizeIni,false);
-  memcpy(Idp+Count,idp,sizeof(unsigned)*np);
+  memcpy(Idp+Count,idp,sizeof(tpartid)*np);
   memcpy(Pos+Count,pos,sizeof(tdouble3)*np);
   memcpy(Vel+Count,vel,sizeof(tfloat3)*np);
   memcpy(Rhop+Count,rhop,sizeof(float)*np);
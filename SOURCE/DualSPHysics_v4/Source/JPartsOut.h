@@ -21,7 +21,7 @@
 #define _JPartsOut_
 
 
-#include "TypesDef.h"
+#include "Types.h"
 #include "JObject.h"
 #include <cstring>
 
@@ -41,7 +41,7 @@ protected:
   
   unsigned OutPosCount,OutRhopCount,OutMoveCount;
 
-  unsigned *Idp;
+  tpartid *Idp;
   tdouble3 *Pos;
   tfloat3 *Vel;
   float* Rhop;
@@ -53,7 +53,7 @@ public:
   ~JPartsOut();
   void Reset();
   llong GetAllocMemory()const;
-  void AddParticles(unsigned np,const unsigned* idp,const tdouble3* pos,const tfloat3* vel,const float* rhop,unsigned outrhop,unsigned outmove);
+  void AddParticles(unsigned np,const tpartid* idp,const tdouble3* pos,const tfloat3* vel,const float* rhop,unsigned outrhop,unsigned outmove);
 
   unsigned GetSize()const{ return(Size); }
   unsigned GetCount()const{ return(Count); }
@@ -62,7 +62,7 @@ public:
   unsigned GetOutRhopCount()const{ return(OutRhopCount); }
   unsigned GetOutMoveCount()const{ return(OutMoveCount); }
 
-  const unsigned* GetIdpOut(){ return(Idp); }
+  const tpartid* GetIdpOut(){ return(Idp); }
   const tdouble3* GetPosOut(){ return(Pos); }
   const tfloat3* GetVelOut(){ return(Vel); }
   const float* GetRhopOut(){ return(Rhop); }
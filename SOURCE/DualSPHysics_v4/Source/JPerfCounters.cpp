@@ -0,0 +1,221 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JPerfCounters.cpp \brief Implements the class \ref JPerfCounters.
+
+#include "JPerfCounters.h"
+#include "Types.h"
+#include "Functions.h"
+#include <cstring>
+#include <cerrno>
+#ifdef _WITHOMP
+  #include <omp.h>
+#endif
+#ifdef __linux__
+  #include <unistd.h>
+  #include <sys/syscall.h>
+  #include <sys/ioctl.h>
+  #include <linux/perf_event.h>
+#endif
+
+using namespace std;
+
+int JPerfCounters::NumThreads=0;
+int* JPerfCounters::Fds=NULL;
+int* JPerfCounters::Slots=NULL;
+ullong* JPerfCounters::StartVals=NULL;
+bool JPerfCounters::Started[JPerfCounters::SectionsMax];
+double JPerfCounters::Values[JPerfCounters::SectionsMax][JPerfCounters::CountersNum];
+ullong JPerfCounters::Calls[JPerfCounters::SectionsMax];
+bool JPerfCounters::Available[JPerfCounters::CountersNum];
+std::string JPerfCounters::Error;
+bool JPerfCounters::Active=false;
+
+#ifdef __linux__
+//==============================================================================
+/// Abre un contador del hilo que llama (solo espacio de usuario).
+/// Opens a counter of the calling thread (only user space).
+//==============================================================================
+static int PerfOpen(JPerfCounters::TpCounter c,int groupfd){
+  struct perf_event_attr pe;
+  memset(&pe,0,sizeof(pe));
+  pe.size=sizeof(pe);
+  switch(c){
+    case JPerfCounters::PCNT_Cycles:       pe.type=PERF_TYPE_HARDWARE; pe.config=PERF_COUNT_HW_CPU_CYCLES;    break;
+    case JPerfCounters::PCNT_Instructions: pe.type=PERF_TYPE_HARDWARE; pe.config=PERF_COUNT_HW_INSTRUCTIONS;  break;
+    case JPerfCounters::PCNT_LlcMisses:    pe.type=PERF_TYPE_HARDWARE; pe.config=PERF_COUNT_HW_CACHE_MISSES;  break;
+    case JPerfCounters::PCNT_DtlbMisses:   pe.type=PERF_TYPE_HW_CACHE; 
+      pe.config=PERF_COUNT_HW_CACHE_DTLB|(PERF_COUNT_HW_CACHE_OP_READ<<8)|(PERF_COUNT_HW_CACHE_RESULT_MISS<<16); break;
+  }
+  pe.read_format=PERF_FORMAT_GROUP|PERF_FORMAT_TOTAL_TIME_ENABLED|PERF_FORMAT_TOTAL_TIME_RUNNING;
+  pe.exclude_kernel=1;
+  pe.exclude_hv=1;
+  pe.disabled=(groupfd<0? 1: 0);
+  return(int(syscall(__NR_perf_event_open,&pe,0,-1,groupfd,0)));
+}
+#endif
+
+//==============================================================================
+/// Abre los contadores en cada hilo OpenMP (el primero es el lider del grupo).
+/// Devuelve false cuando no estan disponibles.
+/// Opens the counters in each OpenMP thread (the first is the group leader).
+/// Returns false when they are not available.
+//==============================================================================
+bool JPerfCounters::Config(int nthreads){
+  Free();
+  Error="";
+#ifdef __linux__
+  NumThreads=(nthreads>0? nthreads: 1);
+  Fds=new int[NumThreads*CountersNum];
+  Slots=new int[NumThreads*CountersNum];
+  StartVals=new ullong[SectionsMax*NumThreads*GroupSize];
+  for(int c=0;c<NumThreads*int(CountersNum);c++){ Fds[c]=-1; Slots[c]=-1; }
+  int errleader=0;
+  #ifdef _WITHOMP
+    #pragma omp parallel num_threads(NumThreads)
+  #endif
+  {
+  #ifdef _WITHOMP
+    const int th=omp_get_thread_num();
+  #else
+    const int th=0;
+  #endif
+    int *fds=Fds+th*CountersNum,*slots=Slots+th*CountersNum;
+    fds[0]=PerfOpen(PCNT_Cycles,-1);
+    if(fds[0]<0){
+      #pragma omp critical
+      { errleader=errno; }
+    }
+    else{
+      int ns=1; slots[0]=0;
+      for(unsigned c=1;c<CountersNum;c++){
+        fds[c]=PerfOpen(TpCounter(c),fds[0]);
+        if(fds[c]>=0)slots[c]=ns++;
+      }
+      ioctl(fds[0],PERF_EVENT_IOC_RESET,PERF_IOC_FLAG_GROUP);
+      ioctl(fds[0],PERF_EVENT_IOC_ENABLE,PERF_IOC_FLAG_GROUP);
+    }
+  }
+  if(errleader){
+    Error=fun::PrintStr("perf_event_open failed (%s)",strerror(errleader));
+    if(errleader==EACCES || errleader==EPERM)Error=Error+", check /proc/sys/kernel/perf_event_paranoid";
+    Free();
+    return(false);
+  }
+  for(unsigned c=0;c<CountersNum;c++){
+    Available[c]=true;
+    for(int th=0;th<NumThreads;th++)if(Slots[th*CountersNum+c]<0)Available[c]=false;
+  }
+  Reset();
+  Active=true;
+  return(true);
+#else
+  Error="hardware counters are only supported on Linux";
+  return(false);
+#endif
+}
+
+//==============================================================================
+/// Cierra los contadores y desactiva la lectura.
+/// Closes the counters and deactivates the reading.
+//==============================================================================
+void JPerfCounters::Free(){
+  Active=false;
+#ifdef __linux__
+  if(Fds)for(int c=NumThreads*int(CountersNum)-1;c>=0;c--)if(Fds[c]>=0)close(Fds[c]);
+#endif
+  delete[] Fds;       Fds=NULL;
+  delete[] Slots;     Slots=NULL;
+  delete[] StartVals; StartVals=NULL;
+  NumThreads=0;
+  memset(Available,0,sizeof(Available));
+}
+
+//==============================================================================
+/// Inicializa los valores acumulados.
+/// Initialises the accumulated values.
+//==============================================================================
+void JPerfCounters::Reset(){
+  memset(Started,0,sizeof(Started));
+  memset(Values,0,sizeof(Values));
+  memset(Calls,0,sizeof(Calls));
+}
+
+//==============================================================================
+/// Lee el grupo de contadores de un hilo: time_enabled, time_running y los 
+/// valores de cada contador en vals[GroupSize].
+/// Reads the group of counters of one thread: time_enabled, time_running and
+/// the values of each counter in vals[GroupSize].
+//==============================================================================
+void JPerfCounters::ReadThread(int th,ullong *vals){
+  memset(vals,0,sizeof(ullong)*GroupSize);
+#ifdef __linux__
+  ullong buf[3+CountersNum];  //-nr, time_enabled, time_running, values[nr].
+  if(read(Fds[th*CountersNum],buf,sizeof(buf))>=ssize_t(sizeof(ullong)*3)){
+    vals[0]=buf[1]; vals[1]=buf[2];
+    const int *slots=Slots+th*CountersNum;
+    for(unsigned c=0;c<CountersNum;c++)if(slots[c]>=0 && ullong(slots[c])<buf[0])vals[2+c]=buf[3+slots[c]];
+  }
+#endif
+}
+
+//==============================================================================
+/// Guarda los valores de todos los hilos al inicio de la seccion.
+/// Stores the values of all threads at the start of the section.
+//==============================================================================
+void JPerfCounters::Start(unsigned id){
+  if(!Active || id>=SectionsMax)return;
+  ullong *vals=StartVals+id*NumThreads*GroupSize;
+  for(int th=0;th<NumThreads;th++)ReadThread(th,vals+th*GroupSize);
+  Started[id]=true;
+}
+
+//==============================================================================
+/// Acumula los incrementos de todos los hilos desde Start(). Los valores se
+/// escalan cuando el kernel multiplexa los contadores (running<enabled).
+/// Accumulates the increments of all threads since Start(). The values are
+/// scaled when the kernel multiplexes the counters (running<enabled).
+//==============================================================================
+void JPerfCounters::Stop(unsigned id){
+  if(!Active || id>=SectionsMax || !Started[id])return;
+  const ullong *vals0=StartVals+id*NumThreads*GroupSize;
+  ullong vals[GroupSize];
+  for(int th=0;th<NumThreads;th++){
+    ReadThread(th,vals);
+    const ullong *v0=vals0+th*GroupSize;
+    const ullong enabled=vals[0]-v0[0],running=vals[1]-v0[1];
+    const double scale=(running && running<enabled? double(enabled)/double(running): 1.);
+    for(unsigned c=0;c<CountersNum;c++)Values[id][c]+=double(vals[2+c]-v0[2+c])*scale;
+  }
+  Calls[id]++;
+  Started[id]=false;
+}
+
+//==============================================================================
+/// Devuelve el nombre del contador.
+/// Returns the name of the counter.
+//==============================================================================
+const char* JPerfCounters::GetCounterName(TpCounter c){
+  switch(c){
+    case PCNT_Cycles:       return("cycles");
+    case PCNT_Instructions: return("instructions");
+    case PCNT_LlcMisses:    return("LLC-misses");
+    case PCNT_DtlbMisses:   return("dTLB-misses");
+  }
+  return("???");
+}
+
@@ -0,0 +1,82 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JPerfCounters.h \brief Declares the class \ref JPerfCounters.
+
+#ifndef _JPerfCounters_
+#define _JPerfCounters_
+
+#include "TypesDef.h"
+#include <string>
+
+//##############################################################################
+//# JPerfCounters
+//##############################################################################
+/// \brief Reads hardware performance counters (perf_event_open on Linux) of
+/// every OpenMP thread and accumulates them by section. The state is static
+/// so it can be used from the inline timer functions (TmcStart/TmcStop).
+/// When the counters are not permitted or not supported Config() returns
+/// false, GetError() gives the reason and Start()/Stop() do nothing.
+
+class JPerfCounters
+{
+ public:
+  ///Contadores medidos. Measured counters.
+  typedef enum{
+    PCNT_Cycles=0,        ///<Ciclos de CPU. CPU cycles.
+    PCNT_Instructions=1,  ///<Instrucciones ejecutadas. Executed instructions.
+    PCNT_LlcMisses=2,     ///<Fallos de cache de ultimo nivel. Last level cache misses.
+    PCNT_DtlbMisses=3     ///<Fallos de lectura de dTLB. dTLB read misses.
+  }TpCounter;
+  static const unsigned CountersNum=4;
+  static const unsigned SectionsMax=32;  ///<Numero maximo de secciones. Maximum number of sections.
+
+ private:
+  static const unsigned GroupSize=CountersNum+2;  ///<time_enabled, time_running and values.
+
+  static int NumThreads;
+  static int *Fds;            ///<Descriptores de cada hilo y contador [NumThreads*CountersNum] (-1:no abierto). Descriptors of each thread and counter.
+  static int *Slots;          ///<Posicion de cada contador en el grupo del hilo [NumThreads*CountersNum] (-1:no disponible). Position of each counter in the group of the thread.
+  static ullong *StartVals;   ///<Valores al iniciar cada seccion [SectionsMax*NumThreads*GroupSize]. Values at the start of each section.
+  static bool Started[SectionsMax];
+  static double Values[SectionsMax][CountersNum];
+  static ullong Calls[SectionsMax];
+  static bool Available[CountersNum];
+  static std::string Error;
+
+  static void ReadThread(int th,ullong *vals);
+
+ public:
+  static bool Active;  ///<Indica si los contadores se leen. Indicates whether counters are read.
+
+  static bool Config(int nthreads);
+  static void Free();
+  static void Reset();
+
+  static void Start(unsigned id);
+  static void Stop(unsigned id);
+
+  static std::string GetError(){ return(Error); }
+  static int GetNumThreads(){ return(NumThreads); }
+  static bool IsAvailable(TpCounter c){ return(Active && Available[c]); }
+  static ullong GetCalls(unsigned id){ return(id<SectionsMax? Calls[id]: 0); }
+  static double GetValue(unsigned id,TpCounter c){ return(id<SectionsMax? Values[id][c]: 0); }
+  static const char* GetCounterName(TpCounter c);
+};
+
+#endif
+
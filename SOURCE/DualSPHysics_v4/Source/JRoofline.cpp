@@ -0,0 +1,170 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JRoofline.cpp \brief Implements the class \ref JRoofline.
+
+#include "JRoofline.h"
+#include "Types.h"
+#include "Functions.h"
+#include "JLog2.h"
+#include "JTimer.h"
+#include <cfloat>
+#include <algorithm>
+#ifdef _WITHOMP
+  #include <omp.h>
+#endif
+
+using namespace std;
+
+//==============================================================================
+/// Constructor.
+//==============================================================================
+JRoofline::JRoofline(){
+  Reset();
+}
+
+//==============================================================================
+/// Initialisation of variables.
+//==============================================================================
+void JRoofline::Reset(){
+  PeakBw=PeakFlops=0;
+  Threads=0; ArrayMb=0;
+  Phases.clear();
+}
+
+//==============================================================================
+/// Devuelve el mejor ancho de banda (GB/s) de la triada a[i]=b[i]+s*c[i] con
+/// arrays de mb MB. Cuenta 3 accesos por elemento como STREAM.
+/// Returns the best bandwidth (GB/s) of the triad a[i]=b[i]+s*c[i] with
+/// arrays of mb MB. Counts 3 accesses per element like STREAM.
+//==============================================================================
+double JRoofline::MeasureTriad(int nthreads,unsigned mb){
+  const int n=int((size_t(mb)*1024*1024)/sizeof(double));
+  double *a=new double[n],*b=new double[n],*c=new double[n];
+  //-First touch with the same distribution of the triad.
+  #ifdef _WITHOMP
+    #pragma omp parallel for schedule (static) num_threads(nthreads)
+  #endif
+  for(int p=0;p<n;p++){ a[p]=0; b[p]=1.; c[p]=2.; }
+  const double s=3.;
+  double tmin=DBL_MAX;
+  JTimer timer;
+  for(unsigned rep=0;rep<6;rep++){
+    timer.Start();
+    #ifdef _WITHOMP
+      #pragma omp parallel for schedule (static) num_threads(nthreads)
+    #endif
+    for(int p=0;p<n;p++)a[p]=b[p]+s*c[p];
+    timer.Stop();
+    if(rep)tmin=min(tmin,timer.GetElapsedTimeD()/1000.); //-The first repetition is not used.
+  }
+  const double check=a[n/2];
+  delete[] a; delete[] b; delete[] c;
+  return(check==7. && tmin>0? 3.*sizeof(double)*n/tmin/1.e9: 0);
+}
+
+//==============================================================================
+/// Devuelve GFLOP/s en float con multiplicaciones y sumas independientes que
+/// el compilador puede vectorizar (32 cadenas por hilo).
+/// Returns GFLOP/s in float with independent multiplications and additions
+/// that the compiler can vectorise (32 chains per thread).
+//==============================================================================
+double JRoofline::MeasureFlops(int nthreads){
+  const unsigned nchain=32,nrep=4000000;
+  float sink[MAXTHREADS_OMP];
+  for(int th=0;th<MAXTHREADS_OMP;th++)sink[th]=0;
+  double tmin=DBL_MAX;
+  JTimer timer;
+  for(unsigned rep=0;rep<3;rep++){
+    timer.Start();
+    #ifdef _WITHOMP
+      #pragma omp parallel num_threads(nthreads)
+    #endif
+    {
+    #ifdef _WITHOMP
+      const int th=omp_get_thread_num();
+    #else
+      const int th=0;
+    #endif
+      float v[nchain];
+      for(unsigned c=0;c<nchain;c++)v[c]=float(c+th)*0.001f;
+      const float fa=0.9999999f,fb=0.0000001f;
+      for(unsigned r=0;r<nrep;r++)for(unsigned c=0;c<nchain;c++)v[c]=v[c]*fa+fb;
+      float sum=0;
+      for(unsigned c=0;c<nchain;c++)sum+=v[c];
+      sink[th%MAXTHREADS_OMP]+=sum;
+    }
+    timer.Stop();
+    tmin=min(tmin,timer.GetElapsedTimeD()/1000.);
+  }
+  float total=0;
+  for(int th=0;th<MAXTHREADS_OMP;th++)total+=sink[th];
+  return(total==total && tmin>0? 2.*nchain*double(nrep)*nthreads/tmin/1.e9: 0);
+}
+
+//==============================================================================
+/// Mide los picos de ancho de banda y GFLOP/s de la maquina.
+/// Measures the peaks of bandwidth and GFLOP/s of the machine.
+//==============================================================================
+void JRoofline::MeasurePeaks(int nthreads,unsigned arraymb){
+  Threads=max(nthreads,1);
+  ArrayMb=max(arraymb,1u);
+  PeakBw=MeasureTriad(Threads,ArrayMb);
+  PeakFlops=MeasureFlops(Threads);
+}
+
+//==============================================================================
+/// Anhade una fase con su tiempo (s), bytes y flops estimados.
+/// Adds a phase with its time (s), estimated bytes and flops.
+//==============================================================================
+void JRoofline::AddPhase(const std::string &name,double time,double bytes,double flops){
+  StPhase ph={name,time,bytes,flops};
+  Phases.push_back(ph);
+}
+
+//==============================================================================
+/// Muestra el rendimiento de cada fase frente a los picos medidos. Una fase
+/// esta limitada por memoria cuando su intensidad aritmetica es menor que la
+/// del punto de cruce (PeakFlops/PeakBw).
+/// Shows the performance of each phase versus the measured peaks. A phase is
+/// memory bound when its arithmetic intensity is lower than the ridge point
+/// (PeakFlops/PeakBw).
+//==============================================================================
+void JRoofline::Print(JLog2 *log)const{
+  const double ridge=(PeakBw>0? PeakFlops/PeakBw: 0);
+  log->Print("\n[Roofline]");
+  log->Printf("Peaks with %d threads: triad %.2f GB/s (arrays of %u MB), float %.2f GFLOP/s, ridge %.2f flop/byte"
+    ,Threads,PeakBw,ArrayMb,PeakFlops,ridge);
+  log->Printf("%-14s %9s %9s %9s %8s %8s %6s %8s %6s %7s %-7s","Phase","Time(s)","GB","GFLOP","AI"
+    ,"GB/s","%BW","GFLOP/s","%Peak","%Roof","Bound");
+  for(unsigned c=0;c<unsigned(Phases.size());c++){
+    const StPhase &ph=Phases[c];
+    if(ph.time<=0)continue;
+    const double gbs=ph.bytes/ph.time/1.e9,gfs=ph.flops/ph.time/1.e9;
+    const double ai=(ph.bytes>0? ph.flops/ph.bytes: 0);
+    const double roof=min(PeakFlops,ai*PeakBw);  //-Attainable GFLOP/s.
+    const bool membound=(ai<ridge);
+    const double eff=(membound? (PeakBw>0? gbs/PeakBw: 0): (roof>0? gfs/roof: 0));
+    log->Printf("%-14s %9.3f %9.3f %9.3f %8.3f %8.2f %5.1f%% %8.2f %5.1f%% %6.1f%% %-7s",ph.name.c_str(),ph.time
+      ,ph.bytes/1.e9,ph.flops/1.e9,ai,gbs,(PeakBw>0? gbs/PeakBw*100: 0),gfs,(PeakFlops>0? gfs/PeakFlops*100: 0)
+      ,eff*100,(membound? "memory": "compute"));
+  }
+  log->Print("Bytes are the compulsory traffic of the particle arrays and flops are estimated from pair");
+  log->Print("counts of the last state, %Roof compares with the attainable limit of each phase");
+  log->Print("(values over 100% of bandwidth mean that the arrays of the phase fit in cache).");
+}
+
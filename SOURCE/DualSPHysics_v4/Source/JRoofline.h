@@ -0,0 +1,71 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JRoofline.h \brief Declares the class \ref JRoofline.
+
+#ifndef _JRoofline_
+#define _JRoofline_
+
+#include "TypesDef.h"
+#include <string>
+#include <vector>
+
+class JLog2;
+
+//##############################################################################
+//# JRoofline
+//##############################################################################
+/// \brief Measures the memory bandwidth (STREAM triad) and a peak of floating
+/// point operations of the host and compares them with the bytes and flops
+/// estimated for each phase of the simulation (roofline model).
+
+class JRoofline
+{
+ public:
+  ///Datos de una fase. Data of one phase.
+  typedef struct{
+    std::string name;
+    double time;   ///<Tiempo medido (s). Measured time (s).
+    double bytes;  ///<Bytes estimados. Estimated bytes.
+    double flops;  ///<Operaciones en coma flotante estimadas. Estimated floating point operations.
+  }StPhase;
+
+ private:
+  double PeakBw;     ///<Ancho de banda de la triada (GB/s). Bandwidth of the triad (GB/s).
+  double PeakFlops;  ///<Pico de GFLOP/s en float. Peak of GFLOP/s in float.
+  int Threads;
+  unsigned ArrayMb;  ///<Tamanho de cada array de la triada (MB). Size of each array of the triad (MB).
+  std::vector<StPhase> Phases;
+
+  static double MeasureTriad(int nthreads,unsigned mb);
+  static double MeasureFlops(int nthreads);
+
+ public:
+  JRoofline();
+  void Reset();
+  void MeasurePeaks(int nthreads,unsigned arraymb);
+  void AddPhase(const std::string &name,double time,double bytes,double flops);
+  void Print(JLog2 *log)const;
+
+  double GetPeakBw()const{ return(PeakBw); }
+  double GetPeakFlops()const{ return(PeakFlops); }
+  unsigned GetPhasesCount()const{ return(unsigned(Phases.size())); }
+  StPhase GetPhase(unsigned c)const{ return(Phases[c]); }
+};
+
+#endif
+
@@ -0,0 +1,240 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JSaveFilter.cpp \brief Implements the class \ref JSaveFilter.
+
+#include "JSaveFilter.h"
+#include "JLog2.h"
+#include "JXml.h"
+#include "JTimeOut.h"
+#include "JRangeFilter.h"
+#include "JPartDataBi4.h"
+#include "Functions.h"
+#include <cstring>
+#include <cfloat>
+#include <climits>
+
+using namespace std;
+
+//##############################################################################
+//# JSaveFilter
+//##############################################################################
+//==============================================================================
+/// Constructor.
+//==============================================================================
+JSaveFilter::JSaveFilter(unsigned num){
+  ClassName="JSaveFilter";
+  TimeOut=NULL;
+  FilterMk=NULL; FilterMkBound=NULL; FilterMkFluid=NULL; FilterId=NULL;
+  DataBi4=NULL;
+  SelIdp=NULL; SelPos=NULL; SelVel=NULL; SelRhop=NULL;
+  Reset();
+  Name=fun::PrintStr("Filter%u",num);
+}
+
+//==============================================================================
+/// Destructor.
+//==============================================================================
+JSaveFilter::~JSaveFilter(){
+  Reset();
+}
+
+//==============================================================================
+/// Initialisation of variables.
+//==============================================================================
+void JSaveFilter::Reset(){
+  Name="";
+  delete TimeOut; TimeOut=NULL;
+  TimeNext=0;
+  Part=0;
+  BoxMin.clear(); BoxMax.clear();
+  delete FilterMk;      FilterMk=NULL;
+  delete FilterMkBound; FilterMkBound=NULL;
+  delete FilterMkFluid; FilterMkFluid=NULL;
+  delete FilterId;      FilterId=NULL;
+  Stride=1;
+  MkCodes.clear();
+  delete DataBi4; DataBi4=NULL;
+  ResizeSel(0);
+}
+
+//==============================================================================
+/// Devuelve la memoria reservada.
+/// Returns allocated memory.
+//==============================================================================
+llong JSaveFilter::GetAllocMemory()const{
+  return(llong(sizeof(tpartid)+sizeof(tdouble3)+sizeof(tfloat3)+sizeof(float))*SizeSel);
+}
+
+//==============================================================================
+/// Redimensiona arrays de seleccion.
+/// Resizes selection arrays.
+//==============================================================================
+void JSaveFilter::ResizeSel(unsigned size){
+  delete[] SelIdp;  SelIdp=NULL;
+  delete[] SelPos;  SelPos=NULL;
+  delete[] SelVel;  SelVel=NULL;
+  delete[] SelRhop; SelRhop=NULL;
+  SizeSel=0;
+  if(size){
+    try{
+      SelIdp=new tpartid[size];
+      SelPos=new tdouble3[size];
+      SelVel=new tfloat3[size];
+      SelRhop=new float[size];
+    }
+    catch(const std::bad_alloc){
+      RunException("ResizeSel","The requested memory could not be allocated.");
+    }
+    SizeSel=size;
+  }
+}
+
+//==============================================================================
+/// Configures object.
+//==============================================================================
+void JSaveFilter::Config(JXml *sxml,TiXmlElement* ele,double timeoutdef){
+  Name=sxml->GetAttributeStr(ele,"name",true,Name);
+  if(Name.empty())sxml->ErrReadAtrib(ele,"name",false);
+  TimeOut=new JTimeOut();
+  TimeOut->Config(sxml,ele,sxml->GetAttributeDouble(ele,"timeout",true,timeoutdef));
+  ReadXml(sxml,ele);
+  DataBi4=new JPartDataBi4();
+}
+
+//==============================================================================
+/// Reads configuration of the filter in the XML node.
+//==============================================================================
+void JSaveFilter::ReadXml(JXml *sxml,TiXmlElement* ele){
+  TiXmlElement* elebox=ele->FirstChildElement("box");
+  while(elebox){
+    const tdouble3 pmin=sxml->ReadElementDouble3(elebox,"pointmin");
+    const tdouble3 pmax=sxml->ReadElementDouble3(elebox,"pointmax");
+    if(pmin.x>pmax.x||pmin.y>pmax.y||pmin.z>pmax.z)sxml->ErrReadElement(elebox,"box",false);
+    BoxMin.push_back(pmin); BoxMax.push_back(pmax);
+    elebox=elebox->NextSiblingElement("box");
+  }
+  string tx;
+  tx=sxml->ReadElementStr(ele,"mk","value",true);
+  if(!tx.empty())FilterMk=new JRangeFilter(tx);
+  tx=sxml->ReadElementStr(ele,"mkbound","value",true);
+  if(!tx.empty())FilterMkBound=new JRangeFilter(tx);
+  tx=sxml->ReadElementStr(ele,"mkfluid","value",true);
+  if(!tx.empty())FilterMkFluid=new JRangeFilter(tx);
+  tx=sxml->ReadElementStr(ele,"idrange","value",true);
+  if(!tx.empty())FilterId=new JRangeFilter(tx);
+  Stride=sxml->ReadElementUnsigned(ele,"stride","value",true,1);
+  if(!Stride)sxml->ErrReadElement(ele,"stride",false);
+}
+
+//==============================================================================
+/// Shows object configuration using Log.
+//==============================================================================
+void JSaveFilter::VisuConfig(JLog2 *log,std::string txhead,std::string txfoot)const{
+  if(!txhead.empty())log->Print(txhead);
+  for(unsigned c=0;c<unsigned(BoxMin.size());c++)log->Printf("  Box     : %s",fun::Double3gRangeStr(BoxMin[c],BoxMax[c]).c_str());
+  if(FilterMk)     log->Printf("  Mk      : %s",FilterMk->ToString().c_str());
+  if(FilterMkBound)log->Printf("  MkBound : %s",FilterMkBound->ToString().c_str());
+  if(FilterMkFluid)log->Printf("  MkFluid : %s",FilterMkFluid->ToString().c_str());
+  if(FilterId)     log->Printf("  Id      : %s",FilterId->ToString().c_str());
+  if(Stride>1)     log->Printf("  Stride  : %u",Stride);
+  TimeOut->VisuConfig(log,"","");
+  if(!txfoot.empty())log->Print(txfoot);
+}
+
+//==============================================================================
+/// Indica si un bloque mk esta seleccionado.
+/// Indicates whether a mk block is selected.
+//==============================================================================
+bool JSaveFilter::CheckMk(unsigned mk,unsigned mktype,bool fluid)const{
+  return((FilterMk && FilterMk->CheckValue(mk))
+    || (!fluid && FilterMkBound && FilterMkBound->CheckValue(mktype))
+    || ( fluid && FilterMkFluid && FilterMkFluid->CheckValue(mktype)));
+}
+
+//==============================================================================
+/// Anhade el codigo de un bloque mk seleccionado.
+/// Adds the code of a selected mk block.
+//==============================================================================
+void JSaveFilter::AddMkCode(word code){
+  if(MkCodes.empty())MkCodes.resize(CODE_MASKTYPEVALUE+1,false);
+  MkCodes[CODE_GetTypeAndValue(code)]=true;
+}
+
+//==============================================================================
+/// Indica si la posicion esta dentro de alguna caja.
+/// Indicates whether the position is inside any box.
+//==============================================================================
+bool JSaveFilter::CheckPos(const tdouble3 &ps)const{
+  const unsigned nbox=unsigned(BoxMin.size());
+  bool ok=(nbox==0);
+  for(unsigned c=0;c<nbox && !ok;c++){
+    const tdouble3 &pmin=BoxMin[c],&pmax=BoxMax[c];
+    ok=(pmin.x<=ps.x && ps.x<=pmax.x && pmin.y<=ps.y && ps.y<=pmax.y && pmin.z<=ps.z && ps.z<=pmax.z);
+  }
+  return(ok);
+}
+
+//==============================================================================
+/// Selecciona las particulas del filtro y graba el PART correspondiente.
+/// Devuelve el numero de particulas grabadas.
+/// Selects the particles of the filter and saves the corresponding PART.
+/// Returns the number of saved particles.
+//==============================================================================
+unsigned JSaveFilter::SavePart(double timestep,unsigned step,unsigned np,const tpartid *idp,const tdouble3 *pos,const tfloat3 *vel,const float *rhop,const word *code,bool svdouble){
+  if(SizeSel<np)ResizeSel(np);
+  const bool usemk=UseMk();
+  if(usemk && MkCodes.empty())MkCodes.resize(CODE_MASKTYPEVALUE+1,false); //-No mk block was selected.
+  unsigned nsel=0;
+  for(unsigned p=0;p<np;p++){
+    const tpartid id=idp[p];
+    bool sel=(Stride<=1 || id%Stride==0);
+    if(sel && FilterId)sel=(id<=UINT_MAX && FilterId->CheckValue(unsigned(id)));
+    if(sel && usemk)sel=CheckMkCode(code[p]);
+    if(sel)sel=CheckPos(pos[p]);
+    if(sel){
+      SelIdp[nsel]=id; SelPos[nsel]=pos[p]; SelVel[nsel]=vel[p]; SelRhop[nsel]=rhop[p];
+      nsel++;
+    }
+  }
+  //-Calcula limites de particulas seleccionadas.
+  //-Computes limits of selected particles.
+  tdouble3 pmin=TDouble3(0),pmax=TDouble3(0);
+  if(nsel){
+    pmin=pmax=SelPos[0];
+    for(unsigned p=1;p<nsel;p++){
+      const tdouble3 ps=SelPos[p];
+      pmin=MinValues(pmin,ps); pmax=MaxValues(pmax,ps);
+    }
+  }
+  //-Graba datos de particulas. El array de posiciones en simple precision se libera tras grabar.
+  //-Saves particle data. The single precision position array is freed after saving.
+  DataBi4->AddPartInfo(Part,timestep,nsel,0,step,0,pmin,pmax);
+  tfloat3 *posf3=NULL;
+  if(svdouble)DataBi4->AddPartData(nsel,SelIdp,SelPos,SelVel,SelRhop);
+  else{
+    posf3=new tfloat3[nsel];
+    for(unsigned p=0;p<nsel;p++)posf3[p]=ToTFloat3(SelPos[p]);
+    DataBi4->AddPartData(nsel,SelIdp,posf3,SelVel,SelRhop);
+  }
+  DataBi4->SaveFilePart();
+  delete[] posf3;
+  Part++;
+  TimeNext=TimeOut->GetNextTime(timestep);
+  return(nsel);
+}
+
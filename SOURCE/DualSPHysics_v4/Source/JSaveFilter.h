@@ -0,0 +1,121 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JSaveFilter.h \brief Declares the class \ref JSaveFilter.
+
+#ifndef _JSaveFilter_
+#define _JSaveFilter_
+
+#include <string>
+#include <vector>
+#include "JObject.h"
+#include "Types.h"
+
+class JXml;
+class TiXmlElement;
+class JLog2;
+class JTimeOut;
+class JRangeFilter;
+class JPartDataBi4;
+
+//##############################################################################
+//# XML format.
+//##############################################################################
+//<special>
+//  <savefilters>
+//    <filter name="Impact" timeout="0.01" comment="Output in DirOut/Impact (def=Filter<num>), timeout (def=TimeOut)">
+//      <tout time="0.5" timeout="0.001" comment="Optional variable timeout as in <timeout>" />
+//      <box comment="Selects particles inside the box (several boxes are allowed)">
+//        <pointmin x="0.5" y="-1" z="0" />
+//        <pointmax x="1.0" y="1" z="0.3" />
+//      </box>
+//      <mk value="11,20-25" comment="Selects mk values (ranges are allowed)" />
+//      <mkbound value="1" comment="Selects mkbound values" />
+//      <mkfluid value="0" comment="Selects mkfluid values" />
+//      <idrange value="0-999,5000-5999" comment="Selects id values" />
+//      <stride value="10" comment="Saves only particles with id multiple of stride (def=1)" />
+//    </filter>
+//  </savefilters>
+//</special>
+
+//##############################################################################
+//# JSaveFilter
+//##############################################################################
+/// \brief Selects a subset of particles to be saved in an additional PART series.
+/// A particle is selected when it passes all the configured criteria: inside
+/// one of the boxes, belonging to one of the selected mk blocks, within the id
+/// ranges and with id multiple of stride. The mk block is taken from the code
+/// of the particle when saving, so particles created during the simulation
+/// are also selected.
+
+class JSaveFilter : protected JObject
+{
+private:
+  std::string Name;          ///<Nombre y subdirectorio de salida. Name and output subdirectory.
+  JTimeOut *TimeOut;         ///<Tiempo entre salidas. Time between outputs.
+  double TimeNext;           ///<Instante de la siguiente salida. Instant of the next output.
+  unsigned Part;             ///<Siguiente PART a grabar. Next PART to save.
+
+  std::vector<tdouble3> BoxMin,BoxMax;  ///<Cajas de seleccion (sin CellOrder). Selection boxes (without CellOrder).
+  JRangeFilter *FilterMk;        ///<Valores de mk seleccionados. Selected mk values.
+  JRangeFilter *FilterMkBound;   ///<Valores de mkbound seleccionados. Selected mkbound values.
+  JRangeFilter *FilterMkFluid;   ///<Valores de mkfluid seleccionados. Selected mkfluid values.
+  JRangeFilter *FilterId;        ///<Valores de id seleccionados. Selected id values.
+  unsigned Stride;               ///<Decimacion por id. Decimation by id.
+
+  std::vector<bool> MkCodes;     ///<Codigos (tipo y valor) de los bloques mk seleccionados. Codes (type and value) of the selected mk blocks.
+
+  JPartDataBi4 *DataBi4;         ///<Grabacion de particulas seleccionadas. Saves the selected particles.
+
+  unsigned SizeSel;              ///<Tamanho reservado de arrays de seleccion. Allocated size of selection arrays.
+  tpartid *SelIdp;
+  tdouble3 *SelPos;
+  tfloat3 *SelVel;
+  float *SelRhop;
+
+  void ReadXml(JXml *sxml,TiXmlElement* ele);
+  void ResizeSel(unsigned size);
+  bool CheckMkCode(word code)const{ return(MkCodes[CODE_GetTypeAndValue(code)]); }
+  bool CheckPos(const tdouble3 &ps)const;
+
+public:
+  JSaveFilter(unsigned num);
+  ~JSaveFilter();
+  void Reset();
+  llong GetAllocMemory()const;
+
+  void Config(JXml *sxml,TiXmlElement* ele,double timeoutdef);
+  void VisuConfig(JLog2 *log,std::string txhead,std::string txfoot)const;
+
+  std::string GetName()const{ return(Name); }
+  bool UseMk()const{ return(FilterMk||FilterMkBound||FilterMkFluid); }
+  bool CheckMk(unsigned mk,unsigned mktype,bool fluid)const;
+  void AddMkCode(word code);
+
+  JPartDataBi4* GetDataBi4(){ return(DataBi4); }
+
+  double GetTimeNext()const{ return(TimeNext); }
+  unsigned GetPart()const{ return(Part); }
+  void SetState(unsigned part,double timenext){ Part=part; TimeNext=timenext; }
+  bool CheckTime(double timestep)const{ return(timestep>=TimeNext); }
+
+  unsigned SavePart(double timestep,unsigned step,unsigned np,const tpartid *idp,const tdouble3 *pos,const tfloat3 *vel,const float *rhop,const word *code,bool svdouble);
+};
+
+#endif
+
+
@@ -18,10 +18,18 @@
 #include "JSphVisco.h"
 #include "JWaveGen.h"
 #include "JSphAccInput.h"
+#include "JSphInOut.h"
+#include "JSphSplitting.h"
 #include "JPartDataBi4.h"
 #include "JPartOutBi4Save.h"
 #include "JPartFloatBi4.h"
 #include "JPartsOut.h"
+#include "JCheckpointBi4.h"
+#include "JTimersStep.h"
+#include "JSaveFilter.h"
+#include "JTraceEvents.h"
+#include "JPartSeriesBi4.h"
+#include "JMemRegistry.h"
 #include <climits>
 
 //using namespace std;
@@ -48,6 +56,10 @@ JSph::JSph(bool cpu, bool withmpi) : Cpu(cpu), WithMpi(withmpi) {
     FtObjs = NULL;
     WaveGen = NULL;
     AccInput = NULL;
+    InOut = NULL;
+    Splitting = NULL;
+    CheckpointBi4 = NULL;
+    TimersStep = NULL;
     InitVars();
 }
 
@@ -68,6 +80,12 @@ JSph::~JSph() {
     AllocMemoryFloating(0);
     delete WaveGen;
     delete AccInput;
+    delete InOut;
+    delete Splitting;
+    delete CheckpointBi4;
+    delete TimersStep;
+    for (unsigned c = 0; c < unsigned(SaveFilters.size()); c++)delete SaveFilters[c];
+    SaveFilters.clear();
 }
 
 //==============================================================================
@@ -88,6 +106,8 @@ void JSph::InitVars() {
     RunName = "";
     TStep = STEP_None;
     VerletSteps = 40;
+    SleepSteps = 0;
+    SleepVel = SleepAce = 0;
     TKernel = KERNEL_Wendland;
     Awen = Bwen = 0;
     memset(&CubicCte, 0, sizeof(StCubicCte));
@@ -114,6 +134,17 @@ void JSph::InitVars() {
     SvData = byte(SDAT_Binx) | byte(SDAT_Info);
     SvRes = false;
     SvTimers = false;
+    SvSeries = false;
+    SvSeriesParts = 0;
+    SvTimersStep = 0;
+    SvTrace = 0;
+    SvForceStats = false;
+    SvMemory = false;
+    SvPerf = false;
+    SvRoofline = 0;
+    SvStatus = 0;
+    BenchSteps = 0;
+    BenchWarmup = 0;
     SvDomainVtk = false;
 
     H = CteB = Gamma = RhopZero = CFLnumber = 0;
@@ -139,6 +170,10 @@ void JSph::InitVars() {
     PartBegin = PartBeginFirst = 0;
     PartBeginTimeStep = 0;
     PartBeginTotalNp = 0;
+    RestartFile = "";
+    CheckpointTime = 0;
+    CheckpointKeep = 0;
+    CheckpointNext = 0;
 
     MotionTimeMod = 0;
     MotionObjCount = 0;
@@ -151,6 +186,8 @@ void JSph::InitVars() {
 
     CellOrder = ORDER_None;
     CellMode = CELLMODE_None;
+    Overlap = false;
+    TaskGraph = 0;
     Hdiv = 0;
     Scell = 0;
     MovLimit = 0;
@@ -264,9 +301,14 @@ llong JSph::GetAllocMemoryCpu() const {
     if (FtObjs)s += sizeof(StFloatingData) * FtCount;
     //-Allocated in other objects.
     if (PartsOut)s += PartsOut->GetAllocMemory();
+    if (CheckpointBi4)s += CheckpointBi4->GetAllocMemory();
+    if (TimersStep)s += TimersStep->GetAllocMemory();
+    for (unsigned c = 0; c < unsigned(SaveFilters.size()); c++)s += SaveFilters[c]->GetAllocMemory();
     if (ViscoTime)s += ViscoTime->GetAllocMemory();
     if (DtFixed)s += DtFixed->GetAllocMemory();
     if (AccInput)s += AccInput->GetAllocMemory();
+    if (InOut)s += InOut->GetAllocMemory();
+    if (Splitting)s += Splitting->GetAllocMemory();
     return (s);
 }
 
@@ -292,6 +334,9 @@ void JSph::LoadConfig(const JCfgRun *cfg) {
     PartBeginDir = cfg->PartBeginDir;
     PartBegin = cfg->PartBegin;
     PartBeginFirst = cfg->PartBeginFirst;
+    RestartFile = cfg->RestartFile;
+    CheckpointTime = cfg->CheckpointTime;
+    CheckpointKeep = cfg->CheckpointKeep;
 
     // 输出配置
     // 输出格式(0: Node, 1: bi2, 2: vtk, 4: csv, 8: info)
@@ -299,11 +344,30 @@ void JSph::LoadConfig(const JCfgRun *cfg) {
     if (cfg->Sv_Csv && !WithMpi) SvData |= byte(SDAT_Csv);
     if (cfg->Sv_Binx) SvData |= byte(SDAT_Binx);
     if (cfg->Sv_Info) SvData |= byte(SDAT_Info);
-    if (cfg->Sv_Vtk) SvData |= byte(SDAT_Vtk);
+    if (cfg->Sv_Vtk && !WithMpi) SvData |= byte(SDAT_Vtk);
 
     SvRes = cfg->SvRes;
     SvTimers = cfg->SvTimers;
-    SvDomainVtk = cfg->SvDomainVtk;
+    SvDomainVtk = cfg->SvDomainVtk && !WithMpi;
+    SvSeries = cfg->SvSeries;
+    SvSeriesParts = cfg->SvSeriesParts;
+    SvTimersStep = cfg->SvTimersStep;
+    SvTrace = cfg->SvTrace;
+    SvForceStats = cfg->SvForceStats;
+    if (SvForceStats) SvData |= byte(SDAT_Info);
+    SvMemory = cfg->SvMemory;
+    if (SvMemory) SvData |= byte(SDAT_Info);
+    SvPerf = cfg->SvPerf;
+    SvRoofline = cfg->SvRoofline;
+    SvStatus = cfg->SvStatus;
+    BenchSteps = cfg->BenchSteps;
+    BenchWarmup = cfg->BenchWarmup;
+    if (BenchSteps) {
+        // 基准模式不生成PART, 域VTK和checkpoint文件
+        SvData = byte(SDAT_None);
+        SvDomainVtk = false;
+        CheckpointTime = 0;
+    }
 
     printf("\n");
     RunTimeDate = fun::GetDateTime();
@@ -317,6 +381,11 @@ void JSph::LoadConfig(const JCfgRun *cfg) {
         Log->Print(fun::VarStr("PartBeginDir", PartBeginDir));
         Log->Print(fun::VarStr("PartBeginFirst", PartBeginFirst));
     }
+    if (!RestartFile.empty())Log->Print(fun::VarStr("RestartFile", RestartFile));
+    if (CheckpointTime > 0) {
+        Log->Print(fun::VarStr("CheckpointTime", CheckpointTime));
+        Log->Print(fun::VarStr("CheckpointKeep", CheckpointKeep));
+    }
 
     LoadCaseConfig();
 
@@ -333,6 +402,9 @@ void JSph::LoadConfig(const JCfgRun *cfg) {
     }
     if (cfg->TStep)TStep = cfg->TStep;
     if (cfg->VerletSteps >= 0)VerletSteps = cfg->VerletSteps;
+    SleepSteps = cfg->SleepSteps;
+    SleepVel = cfg->SleepVel;
+    SleepAce = cfg->SleepAce;
     if (cfg->TKernel)TKernel = cfg->TKernel;
     if (cfg->TVisco) {
         TVisco = cfg->TVisco;
@@ -380,6 +452,16 @@ void JSph::LoadConfig(const JCfgRun *cfg) {
 
     CellOrder = cfg->CellOrder;
     CellMode = cfg->CellMode;
+    Overlap = cfg->Overlap;
+    TaskGraph = cfg->TaskGraph;
+    if (TaskGraph && (Overlap || SvForceStats))
+        RunException(met, "The option -taskgraph is not supported with -overlap or -svforcestats.");
+    if (SleepSteps && (Overlap || TaskGraph || WithMpi))
+        RunException(met, "The option -sleep is not supported with -overlap, -taskgraph or MPI.");
+    if (InOut && (SleepSteps || Overlap || TaskGraph || WithMpi))
+        RunException(met, "Open boundaries (inout) are not supported with -sleep, -overlap, -taskgraph or MPI.");
+    if (Splitting && (InOut || SleepSteps || Overlap || TaskGraph || WithMpi))
+        RunException(met, "Splitting is not supported with open boundaries (inout), -sleep, -overlap, -taskgraph or MPI.");
     if (cfg->DomainMode == 1) {
         ConfigDomainParticles(cfg->DomainParticlesMin, cfg->DomainParticlesMax);
         ConfigDomainParticlesPrc(cfg->DomainParticlesPrcMin, cfg->DomainParticlesPrcMax);
@@ -627,6 +709,20 @@ void JSph::LoadCaseConfig() {
         AccInput = new JSphAccInput(Log, DirCase, &xml, "case.execution.special.accinputs");
     }
 
+    // 配置开放边界 (inlet/outlet), 粒子数量可变
+    if (xml.GetNode("case.execution.special.inout", false)) {
+        InOut = new JSphInOut(&xml, "case.execution.special.inout", RhopZero, CteB, Gamma, Gravity);
+        NpDynamic = true;
+        ReuseIds = InOut->GetReuseIds();
+    }
+
+    // 配置流体粒子的分裂与合并 (自适应分辨率), 粒子数量可变
+    if (xml.GetNode("case.execution.special.splitting", false)) {
+        Splitting = new JSphSplitting(&xml, "case.execution.special.splitting");
+        NpDynamic = true;
+        ReuseIds = Splitting->GetReuseIds();
+    }
+
     // 载入并配置 MOTION
     MotionObjCount = 0;
     for (unsigned c = 0; c < parts.CountBlocks(); c++) {
@@ -781,7 +877,7 @@ void JSph::LoadMkInfo(const JSpaceParts *parts) {
 //==============================================================================
 /// Returns the block in MkList according to a given Id.
 //==============================================================================
-unsigned JSph::GetMkBlockById(unsigned id) const {
+unsigned JSph::GetMkBlockById(tpartid id) const {
     unsigned c = 0;
     for (; c < MkListSize && id >= (MkList[c].begin + MkList[c].count); c++);
     return (c);
@@ -817,14 +913,14 @@ word JSph::CodeSetType(word code, TpParticle type, unsigned value) const {
 
 
 /// 加载粒子组 Code 并将最后一个 nout 粒子标记为排除
-void JSph::LoadCodeParticles(unsigned np, const unsigned *idp, word *code) const {
+void JSph::LoadCodeParticles(unsigned np, const tpartid *idp, word *code) const {
     const char met[] = "LoadCodeParticles";
     //-Assigns code to each group of particles (moving & floating).
     const unsigned finfixed = CaseNfixed;
     const unsigned finmoving = finfixed + CaseNmoving;
     const unsigned finfloating = finmoving + CaseNfloat;
     for (unsigned p = 0; p < np; p++) {
-        const unsigned id = idp[p];
+        const tpartid id = idp[p];
         word cod = 0;
         unsigned cmk = GetMkBlockById(id);
         if (id < finfixed) cod = CodeSetType(cod, PART_BoundFx, cmk);
@@ -936,6 +1032,7 @@ void JSph::ConfigConstants(bool simulate2d) {
         SpsSmag = float(pow((0.12 * dp_sps), 2));
         SpsBlin = float((2. / 3.) * 0.0066 * dp_sps * dp_sps);
     }
+    if (Splitting)Splitting->ConfigCtes(simulate2d, Dp, H, MassFluid);
     VisuConfig();
 }
 
@@ -947,9 +1044,24 @@ void JSph::VisuConfig() const {
     Log->Print(fun::VarStr("RunName", RunName));
     Log->Print(fun::VarStr("PosDouble", GetPosDoubleName(Psimple, SvDouble)));
     Log->Print(fun::VarStr("SvTimers", SvTimers));
+    if (SvTimersStep)Log->Print(fun::VarStr("SvTimersStep", SvTimersStep));
+    if (SvTrace)Log->Print(fun::VarStr("SvTrace", SvTrace));
+    if (SvForceStats)Log->Print(fun::VarStr("SvForceStats", SvForceStats));
+    if (SvMemory)Log->Print(fun::VarStr("SvMemory", SvMemory));
+    if (SvPerf)Log->Print(fun::VarStr("SvPerf", SvPerf));
+    if (SvRoofline)Log->Print(fun::VarStr("SvRoofline", SvRoofline));
+    if (SvStatus)Log->Print(fun::VarStr("SvStatus", SvStatus));
+    if (BenchSteps)Log->Print(fun::VarStr("BenchSteps", BenchSteps) + " " + fun::VarStr("BenchWarmup", BenchWarmup));
+    if (Overlap)Log->Print(fun::VarStr("Overlap", Overlap));
+    if (TaskGraph)Log->Print(fun::VarStr("TaskGraph", TaskGraph));
     Log->Print(fun::VarStr("StepAlgorithm", GetStepName(TStep)));
     if (TStep == STEP_None)RunException(met, "StepAlgorithm value is invalid.");
     if (TStep == STEP_Verlet)Log->Print(fun::VarStr("VerletSteps", VerletSteps));
+    if (SleepSteps) {
+        Log->Print(fun::VarStr("SleepSteps", SleepSteps));
+        Log->Print(fun::VarStr("SleepVel", SleepVel));
+        Log->Print(fun::VarStr("SleepAce", SleepAce));
+    }
     Log->Print(fun::VarStr("Kernel", GetKernelName(TKernel)));
     Log->Print(fun::VarStr("Viscosity", GetViscoName(TVisco)));
     Log->Print(fun::VarStr("Visco", Visco));
@@ -1297,7 +1409,7 @@ unsigned JSph::CalcCellCode(tuint3 ncells) {
 /// Calcula distancia maxima entre particulas y centro de cada floating.
 /// Computes maximum distance between particles and center of floating.
 //==============================================================================
-void JSph::CalcFloatingRadius(unsigned np, const tdouble3 *pos, const unsigned *idp) {
+void JSph::CalcFloatingRadius(unsigned np, const tdouble3 *pos, const tpartid *idp) {
     const char met[] = "CalcFloatingsRadius";
     const float overradius = 1.2f; //-Porcentaje de incremento de radio. Percentage of ration increase.
     unsigned *ridp = new unsigned[CaseNfloat];
@@ -1308,7 +1420,7 @@ void JSph::CalcFloatingRadius(unsigned np, const tdouble3 *pos, const unsigned *
     //-Computes position according to id assuming that all particles are not periodic.
     const unsigned idini = CaseNpb, idfin = CaseNpb + CaseNfloat;
     for (unsigned p = 0; p < np; p++) {
-        const unsigned id = idp[p];
+        const tpartid id = idp[p];
         if (idini <= id && id < idfin)ridp[id - idini] = p;
     }
     //-Comprueba que todas las particulas floating estan localizadas.
@@ -1429,27 +1541,7 @@ void JSph::ConfigSaveData(unsigned piece, unsigned pieces, std::string div) {
     //-Configures object to store particles and information.
     if (SvData & SDAT_Info || SvData & SDAT_Binx) {
         DataBi4 = new JPartDataBi4();
-        DataBi4->ConfigBasic(piece, pieces, RunCode, AppName, CaseName, Simulate2D, DirOut);
-        DataBi4->ConfigParticles(CaseNp, CaseNfixed, CaseNmoving, CaseNfloat, CaseNfluid, CasePosMin, CasePosMax,
-                                 NpDynamic, ReuseIds);
-        DataBi4->ConfigCtes(Dp, H, CteB, RhopZero, Gamma, MassBound, MassFluid);
-        DataBi4->ConfigSimMap(OrderDecode(MapRealPosMin), OrderDecode(MapRealPosMax));
-        JPartDataBi4::TpPeri tperi = JPartDataBi4::PERI_None;
-        if (PeriodicConfig.PeriActive) {
-            if (PeriodicConfig.PeriXY)tperi = JPartDataBi4::PERI_XY;
-            else if (PeriodicConfig.PeriXZ)tperi = JPartDataBi4::PERI_XZ;
-            else if (PeriodicConfig.PeriYZ)tperi = JPartDataBi4::PERI_YZ;
-            else if (PeriodicConfig.PeriX)tperi = JPartDataBi4::PERI_X;
-            else if (PeriodicConfig.PeriY)tperi = JPartDataBi4::PERI_Y;
-            else if (PeriodicConfig.PeriZ)tperi = JPartDataBi4::PERI_Z;
-            else RunException(met, "The periodic configuration is invalid.");
-        }
-        DataBi4->ConfigSimPeri(tperi, PeriodicConfig.PeriXinc, PeriodicConfig.PeriYinc, PeriodicConfig.PeriZinc);
-        if (div.empty())DataBi4->ConfigSimDiv(JPartDataBi4::DIV_None);
-        else if (div == "X")DataBi4->ConfigSimDiv(JPartDataBi4::DIV_X);
-        else if (div == "Y")DataBi4->ConfigSimDiv(JPartDataBi4::DIV_Y);
-        else if (div == "Z")DataBi4->ConfigSimDiv(JPartDataBi4::DIV_Z);
-        else RunException(met, "The division configuration is invalid.");
+        ConfigPartDataBi4(DataBi4, piece, pieces, DirOut, div);
     }
     //-Configura objeto para grabacion de particulas excluidas.
     //-Configures object to store excluded particles.
@@ -1474,6 +1566,105 @@ void JSph::ConfigSaveData(unsigned piece, unsigned pieces, std::string div) {
     //-Crea objeto para almacenar las particulas excluidas hasta su grabacion.
     //-Creates object to store excluded particles until recordering.
     PartsOut = new JPartsOut();
+    //-Configura salidas adicionales de particulas filtradas.
+    //-Configures additional outputs of filtered particles.
+    ConfigSaveFilters();
+    //-Configura objeto para grabacion de checkpoints.
+    //-Configures object to store checkpoints.
+    if (CheckpointTime > 0) {
+        CheckpointBi4 = new JCheckpointBi4Save();
+        CheckpointBi4->Config(DirOut, CheckpointKeep);
+    }
+}
+
+//==============================================================================
+/// Configura objeto para grabacion de particulas en formato bi4.
+/// Configures object to store particles in bi4 format.
+//==============================================================================
+void JSph::ConfigPartDataBi4(JPartDataBi4 *data, unsigned piece, unsigned pieces, const std::string &dir,
+                             std::string div) const {
+    const char met[] = "ConfigPartDataBi4";
+    data->ConfigBasic(piece, pieces, RunCode, AppName, CaseName, Simulate2D, dir);
+    data->ConfigParticles(CaseNp, CaseNfixed, CaseNmoving, CaseNfloat, CaseNfluid, CasePosMin, CasePosMax, NpDynamic,
+                          ReuseIds);
+    data->ConfigCtes(Dp, H, CteB, RhopZero, Gamma, MassBound, MassFluid);
+    if (Splitting)data->ConfigSplitting(true);
+    data->ConfigSimMap(OrderDecode(MapRealPosMin), OrderDecode(MapRealPosMax));
+    JPartDataBi4::TpPeri tperi = JPartDataBi4::PERI_None;
+    if (PeriodicConfig.PeriActive) {
+        if (PeriodicConfig.PeriXY)tperi = JPartDataBi4::PERI_XY;
+        else if (PeriodicConfig.PeriXZ)tperi = JPartDataBi4::PERI_XZ;
+        else if (PeriodicConfig.PeriYZ)tperi = JPartDataBi4::PERI_YZ;
+        else if (PeriodicConfig.PeriX)tperi = JPartDataBi4::PERI_X;
+        else if (PeriodicConfig.PeriY)tperi = JPartDataBi4::PERI_Y;
+        else if (PeriodicConfig.PeriZ)tperi = JPartDataBi4::PERI_Z;
+        else RunException(met, "The periodic configuration is invalid.");
+    }
+    data->ConfigSimPeri(tperi, PeriodicConfig.PeriXinc, PeriodicConfig.PeriYinc, PeriodicConfig.PeriZinc);
+    if (div.empty())data->ConfigSimDiv(JPartDataBi4::DIV_None);
+    else if (div == "X")data->ConfigSimDiv(JPartDataBi4::DIV_X);
+    else if (div == "Y")data->ConfigSimDiv(JPartDataBi4::DIV_Y);
+    else if (div == "Z")data->ConfigSimDiv(JPartDataBi4::DIV_Z);
+    else RunException(met, "The division configuration is invalid.");
+    if (SvSeries)data->ConfigSeries(SvSeriesParts);
+}
+
+//==============================================================================
+/// Carga configuracion de salidas filtradas (special.savefilters) del XML.
+/// Cada filtro graba sus PARTs en el subdirectorio DirOut/<name>.
+/// Loads configuration of filtered outputs (special.savefilters) from XML.
+/// Each filter stores its PARTs in the subdirectory DirOut/<name>.
+//==============================================================================
+void JSph::ConfigSaveFilters() {
+    const char met[] = "ConfigSaveFilters";
+    JXml xml;
+    xml.LoadFile(FileXml);
+    TiXmlNode *node = xml.GetNode("case.execution.special.savefilters", false);
+    if (!node)return;
+    if (WithMpi && node->FirstChildElement("filter"))RunException(met, "Filtered outputs are not supported with MPI.");
+    TiXmlElement *ele = node->FirstChildElement("filter");
+    while (ele) {
+        JSaveFilter *flt = new JSaveFilter(unsigned(SaveFilters.size()));
+        SaveFilters.push_back(flt);
+        flt->Config(&xml, ele, TimePart);
+        for (unsigned c = 0; c + 1 < unsigned(SaveFilters.size()); c++)
+            if (SaveFilters[c]->GetName() == flt->GetName())
+                RunException(met, string("The name of filter '") + flt->GetName() + "' is repeated.");
+        //-Selecciona bloques mk usando MkList.
+        //-Selects mk blocks using MkList.
+        if (flt->UseMk())
+            for (unsigned c = 0; c < MkListSize; c++)
+                if (flt->CheckMk(MkList[c].mk, MkList[c].mktype, c >= MkListBound))
+                    flt->AddMkCode(MkList[c].code);
+        const string dir = DirOut + flt->GetName();
+        if (fun::Mkdir(dir))RunException(met, "Cannot create the output directory.", dir);
+        ConfigPartDataBi4(flt->GetDataBi4(), 0, 1, dir, "");
+        flt->VisuConfig(Log, string("\nSave filter ") + flt->GetName() + " configuration:", " ");
+        ele = ele->NextSiblingElement("filter");
+    }
+}
+
+//==============================================================================
+/// Indica si algun filtro debe grabar datos en el instante actual.
+/// Indicates whether any filter must save data in the current instant.
+//==============================================================================
+bool JSph::CheckSaveFilters() const {
+    bool save = false;
+    for (unsigned c = 0; c < unsigned(SaveFilters.size()) && !save; c++)save = SaveFilters[c]->CheckTime(TimeStep);
+    return (save);
+}
+
+//==============================================================================
+/// Graba los PARTs de los filtros que corresponden al instante actual.
+/// Saves the PARTs of the filters corresponding to the current instant.
+//==============================================================================
+void JSph::SaveFilterData(unsigned npok, const tpartid *idp, const tdouble3 *pos, const tfloat3 *vel,
+                          const float *rhop, const word *code) {
+    for (unsigned c = 0; c < unsigned(SaveFilters.size()); c++) {
+        JSaveFilter *flt = SaveFilters[c];
+        if (flt->CheckTime(TimeStep))
+            flt->SavePart(TimeStep, unsigned(Nstep), npok, idp, pos, vel, rhop, code, SvDouble);
+    }
 }
 
 //==============================================================================
@@ -1481,7 +1672,7 @@ void JSph::ConfigSaveData(unsigned piece, unsigned pieces, std::string div) {
 /// Stores new excluded particles until recordering next PART.
 //==============================================================================
 void
-JSph::AddParticlesOut(unsigned nout, const unsigned *idp, const tdouble3 *pos, const tfloat3 *vel, const float *rhop,
+JSph::AddParticlesOut(unsigned nout, const tpartid *idp, const tdouble3 *pos, const tfloat3 *vel, const float *rhop,
                       unsigned noutrhop, unsigned noutmove) {
     PartsOut->AddParticles(nout, idp, pos, vel, rhop, noutrhop, noutmove);
 }
@@ -1497,14 +1688,16 @@ tfloat3 *JSph::GetPointerDataFloat3(unsigned n, const tdouble3 *v) const {
 }
 
 // 存储粒子数据
-void JSph::SavePartData(unsigned npok, unsigned nout, const unsigned *idp, const tdouble3 *pos, const tfloat3 *vel,
-                        const float *rhop, unsigned ndom, const tdouble3 *vdom, const StInfoPartPlus *infoplus) {
+void JSph::SavePartData(unsigned npok, unsigned nout, const tpartid *idp, const tdouble3 *pos, const tfloat3 *vel,
+                        const float *rhop, unsigned ndom, const tdouble3 *vdom, const StInfoPartPlus *infoplus,
+                        const float *mass, const float *hvar) {
     // 存储粒子信息并/或格式化为 bi4 格式
     if (DataBi4) {
         tfloat3 *posf3 = NULL;
         TimerPart.Stop();
         JBinaryData *bdpart = DataBi4->AddPartInfo(Part, TimeStep, npok, nout, Nstep,
-                                                   TimerPart.GetElapsedTimeD() / 1000., vdom[0], vdom[1], TotalNp);
+                                                   TimerPart.GetElapsedTimeD() / 1000., vdom[0], vdom[1], TotalNp,
+                                                   (NpDynamic ? IdMax : 0));
         if (infoplus && SvData & SDAT_Info) {
             bdpart->SetvDouble("dtmean", (!Nstep ? 0 : (TimeStep - TimeStepM1) / (Nstep - PartNstep)));
             bdpart->SetvDouble("dtmin", (!Nstep ? 0 : PartDtMin));
@@ -1518,6 +1711,53 @@ void JSph::SavePartData(unsigned npok, unsigned nout, const unsigned *idp, const
             bdpart->SetvUint("npbper", infoplus->npbper);
             bdpart->SetvUint("npfper", infoplus->npfper);
             bdpart->SetvLlong("cpualloc", infoplus->memorycpualloc);
+            if (NpDynamic) {
+                bdpart->SetvUint("newnpok", infoplus->newnpok);
+                bdpart->SetvUint("newnpfail", infoplus->newnpfail);
+            }
+            if (SleepSteps) {
+                bdpart->SetvUint("npfasleep", infoplus->npfasleep);
+                bdpart->SetvUint("nctasleep", infoplus->nctasleep);
+                bdpart->SetvDouble("asleepfrac", (infoplus->npf ? double(infoplus->npfasleep) / infoplus->npf : 0));
+            }
+            const StForceStats &fs = infoplus->forcestats;
+            if (fs.active) {
+                bdpart->SetvDouble("imbfluid", fs.imbfluid);
+                bdpart->SetvDouble("imbbound", fs.imbbound);
+                bdpart->SetvDouble("thmeanfluid", fs.thmeanfluid);
+                bdpart->SetvDouble("thmeanbound", fs.thmeanbound);
+                bdpart->SetvDouble("candmean", fs.candmean);
+                bdpart->SetvDouble("neighmean", fs.neighmean);
+                bdpart->SetvUint("neighmin", fs.neighmin);
+                bdpart->SetvUint("neighmax", fs.neighmax);
+                bdpart->SetvDouble("neighmeanbound", fs.neighmeanbound);
+                bdpart->SetvUint("histwidth", fs.histwidth);
+                string txcand, txneigh;
+                for (unsigned c = 0; c < FORCESTATS_BINS; c++) {
+                    txcand = txcand + (c ? "," : "") + fun::UintStr(fs.histcand[c]);
+                    txneigh = txneigh + (c ? "," : "") + fun::UintStr(fs.histneigh[c]);
+                }
+                bdpart->SetvText("histcand", txcand);
+                bdpart->SetvText("histneigh", txneigh);
+                bdpart->SetvUint("cellsfluid", fs.cellsfluid);
+                bdpart->SetvDouble("cellsempty", fs.cellsempty);
+                bdpart->SetvDouble("cellocmean", fs.cellocmean);
+                bdpart->SetvUint("cellocmax", fs.cellocmax);
+            }
+            if (JMemRegistry::Active) {
+                bdpart->SetvLlong("memtotal", JMemRegistry::GetTotal());
+                bdpart->SetvLlong("mempeak", JMemRegistry::GetTotalPeak());
+                const std::vector<JMemRegistry::StEntry> entries = JMemRegistry::GetEntries();
+                string txnames, txcur, txpeak;
+                for (unsigned c = 0; c < unsigned(entries.size()); c++) {
+                    txnames = txnames + (c ? "," : "") + entries[c].subsystem + "." + entries[c].name;
+                    txcur = txcur + (c ? "," : "") + fun::LongStr(entries[c].cur);
+                    txpeak = txpeak + (c ? "," : "") + fun::LongStr(entries[c].peak);
+                }
+                bdpart->SetvText("memnames", txnames);
+                bdpart->SetvText("memcur", txcur);
+                bdpart->SetvText("mempeakarrays", txpeak);
+            }
             if (infoplus->gpudata) {
                 bdpart->SetvLlong("nctalloc", infoplus->memorynctalloc);
                 bdpart->SetvLlong("nctused", infoplus->memorynctused);
@@ -1531,6 +1771,7 @@ void JSph::SavePartData(unsigned npok, unsigned nout, const unsigned *idp, const
                 posf3 = GetPointerDataFloat3(npok, pos);
                 DataBi4->AddPartData(npok, idp, posf3, vel, rhop);
             }
+            if (Splitting)DataBi4->AddPartDataSplitting(npok, mass, hvar);
             float *press = NULL;
             if (0) {//-Example saving a new array (Pressure) in files BI4.
                 press = new float[npok];
@@ -1553,13 +1794,21 @@ void JSph::SavePartData(unsigned npok, unsigned nout, const unsigned *idp, const
         tfloat3 *posf3 = GetPointerDataFloat3(npok, pos);
         byte *type = new byte[npok];
         for (unsigned p = 0; p < npok; p++) {
-            const unsigned id = idp[p];
+            const tpartid id = idp[p];
             type[p] = (id >= CaseNbound ? 3 : (id < CaseNfixed ? 0 : (id < CaseNpb ? 1 : 2)));
         }
         // 定义被存储的字段
         JFormatFiles2::StScalarData fields[8];
         unsigned nfields = 0;
-        if (idp) {
+        //-Los ids de 64 bits se graban como double (exactos hasta 2^53).
+        //-The 64-bit ids are saved as double (exact up to 2^53).
+        double *idpd = NULL;
+        if (idp && sizeof(tpartid) == 8) {
+            idpd = new double[npok];
+            for (unsigned p = 0; p < npok; p++)idpd[p] = double(idp[p]);
+            fields[nfields] = JFormatFiles2::DefineField("Idp", JFormatFiles2::Double64, 1, idpd);
+            nfields++;
+        } else if (idp) {
             fields[nfields] = JFormatFiles2::DefineField("Idp", JFormatFiles2::UInt32, 1, idp);
             nfields++;
         }
@@ -1575,6 +1824,14 @@ void JSph::SavePartData(unsigned npok, unsigned nout, const unsigned *idp, const
             fields[nfields] = JFormatFiles2::DefineField("Type", JFormatFiles2::UChar8, 1, type);
             nfields++;
         }
+        if (mass) {
+            fields[nfields] = JFormatFiles2::DefineField("Mass", JFormatFiles2::Float32, 1, mass);
+            nfields++;
+        }
+        if (hvar) {
+            fields[nfields] = JFormatFiles2::DefineField("Hvar", JFormatFiles2::Float32, 1, hvar);
+            nfields++;
+        }
         if (SvData & SDAT_Vtk)
             JFormatFiles2::SaveVtk(DirOut + fun::FileNameSec("PartVtk.vtk", Part), npok, posf3, nfields, fields);
         if (SvData & SDAT_Csv)
@@ -1582,6 +1839,7 @@ void JSph::SavePartData(unsigned npok, unsigned nout, const unsigned *idp, const
         // 释放内存
         delete[] posf3;
         delete[] type;
+        delete[] idpd;
     }
 
     // 存储被排除的粒子
@@ -1615,8 +1873,9 @@ void JSph::SavePartData(unsigned npok, unsigned nout, const unsigned *idp, const
 }
 
 // 输出文件
-void JSph::SaveData(unsigned npok, const unsigned *idp, const tdouble3 *pos, const tfloat3 *vel, const float *rhop,
-                    unsigned ndom, const tdouble3 *vdom, const StInfoPartPlus *infoplus) {
+void JSph::SaveData(unsigned npok, const tpartid *idp, const tdouble3 *pos, const tfloat3 *vel, const float *rhop,
+                    unsigned ndom, const tdouble3 *vdom, const StInfoPartPlus *infoplus, const float *mass,
+                    const float *hvar) {
     const char met[] = "SaveData";
     string suffixpartx = fun::PrintStr("_%04d", Part);
 
@@ -1626,7 +1885,10 @@ void JSph::SaveData(unsigned npok, const unsigned *idp, const tdouble3 *pos, con
     AddOutCount(noutpos, noutrhop, noutmove);
 
     // 存储例子数据到part文件
-    SavePartData(npok, nout, idp, pos, vel, rhop, ndom, vdom, infoplus);
+    {
+        JTraceScope trace("SU-SaveData-Write");
+        SavePartData(npok, nout, idp, pos, vel, rhop, ndom, vdom, infoplus, mass, hvar);
+    }
 
     // 重新初始化dt的限制
     PartDtMin = DBL_MAX;
@@ -1670,6 +1932,157 @@ void JSph::SaveMapCellsVtk(float scell) const {
                                 scell);
 }
 
+//==============================================================================
+/// Almacena en bd las variables de estado de la simulacion para un checkpoint.
+/// Stores in bd the state variables of the simulation for a checkpoint.
+//==============================================================================
+void JSph::SaveCheckpointState(JBinaryData *bd) const {
+    //-Configuracion que debe coincidir al reanudar.
+    //-Configuration that must match on restart.
+    bd->SetvUint("CaseNp", CaseNp);
+    bd->SetvInt("TStep", int(TStep));
+    bd->SetvInt("TVisco", int(TVisco));
+    bd->SetvInt("CellOrder", int(CellOrder));
+    bd->SetvInt("CellMode", int(CellMode));
+    bd->SetvUint("PeriActive", PeriActive);
+    //-Limites del caso (sin aplicar CellOrder).
+    //-Case limits (without CellOrder).
+    bd->SetvBool("Simulate2D", Simulate2D);
+    bd->SetvDouble3("CasePosMin", CasePosMin);
+    bd->SetvDouble3("CasePosMax", CasePosMax);
+    bd->SetvDouble3("MapRealPosMin", OrderDecode(MapRealPosMin));
+    bd->SetvDouble3("MapRealPosMax", OrderDecode(MapRealPosMax));
+    //-Variables de control de la simulacion.
+    //-Control variables of the simulation.
+    bd->SetvInt("PartNstep", PartNstep);
+    bd->SetvUint("PartOut", PartOut);
+    bd->SetvDouble("TimeStepM1", TimeStepM1);
+    bd->SetvDouble("TimePartNext", TimePartNext);
+    bd->SetvDouble("PartDtMin", PartDtMin);
+    bd->SetvDouble("PartDtMax", PartDtMax);
+    bd->SetvDouble("MotionTimeMod", MotionTimeMod);
+    bd->SetvDouble("DemDtForce", DemDtForce);
+    bd->SetvUint("DtModif", DtModif);
+    bd->SetvUint("OutPosCount", OutPosCount);
+    bd->SetvUint("OutRhopCount", OutRhopCount);
+    bd->SetvUint("OutMoveCount", OutMoveCount);
+    bd->SetvUllong("TotalNp", TotalNp);
+#ifdef PARTIDS_64BIT
+    bd->SetvUllong("IdMax", IdMax);
+#else
+    bd->SetvUint("IdMax", IdMax);
+#endif
+    bd->SetvUint("MaxParticles", MaxParticles);
+    bd->SetvUint("MaxCells", MaxCells);
+    for (unsigned c = 0; c < unsigned(SaveFilters.size()); c++) {
+        bd->SetvUint(fun::PrintStr("SaveFilter_%u_Part", c), SaveFilters[c]->GetPart());
+        bd->SetvDouble(fun::PrintStr("SaveFilter_%u_TimeNext", c), SaveFilters[c]->GetTimeNext());
+        SaveCheckpointSeries(bd, fun::PrintStr("SaveFilter_%u_", c), SaveFilters[c]->GetDataBi4());
+    }
+    SaveCheckpointSeries(bd, "", DataBi4);
+    //-Estado de los objetos floating.
+    //-State of floating objects.
+    bd->SetvUint("FtCount", FtCount);
+    for (unsigned cf = 0; cf < FtCount; cf++) {
+        JBinaryData *bdf = bd->CreateItem(fun::PrintStr("Floating_%u", cf));
+        bdf->SetvDouble3("center", FtObjs[cf].center);
+        bdf->SetvFloat3("fvel", FtObjs[cf].fvel);
+        bdf->SetvFloat3("fomega", FtObjs[cf].fomega);
+        bdf->SetvFloat("radius", FtObjs[cf].radius);
+    }
+}
+
+//==============================================================================
+/// Almacena en bd el estado de los ficheros de series de data.
+/// Stores in bd the state of the series files of data.
+//==============================================================================
+void JSph::SaveCheckpointSeries(JBinaryData *bd, const std::string &prefix, const JPartDataBi4 *data) const {
+    const JPartSeriesBi4Save *series = (data ? data->GetSeries() : NULL);
+    if (series) {
+        bd->SetvUint(prefix + "SeriesFile", series->GetFileNum());
+        bd->SetvUint(prefix + "SeriesParts", series->GetFileParts());
+    }
+}
+
+//==============================================================================
+/// Continua los ficheros de series de data en el estado del checkpoint.
+/// Los PARTs grabados despues del checkpoint se descartan.
+/// Continues the series files of data at the state of the checkpoint.
+/// PARTs saved after the checkpoint are discarded.
+//==============================================================================
+void JSph::LoadCheckpointSeries(JBinaryData *bd, const std::string &prefix, JPartDataBi4 *data) {
+    JPartSeriesBi4Save *series = (data ? data->GetSeries() : NULL);
+    if (series) {
+        if (!bd->ExistsValue(prefix + "SeriesFile"))
+            RunException("LoadCheckpointSeries", "The checkpoint does not contain the state of series files.",
+                         RestartFile);
+        series->Resume(bd->GetvUint(prefix + "SeriesFile"), bd->GetvUint(prefix + "SeriesParts"));
+    }
+}
+
+//==============================================================================
+/// Recupera de bd las variables de estado de la simulacion de un checkpoint.
+/// Restores from bd the state variables of the simulation of a checkpoint.
+//==============================================================================
+void JSph::LoadCheckpointState(JBinaryData *bd) {
+    const char met[] = "LoadCheckpointState";
+    if (bd->GetvUint("CaseNp") != CaseNp || bd->GetvUint("FtCount") != FtCount)
+        RunException(met, "The checkpoint does not match the case.", RestartFile);
+    if (bd->GetvInt("TStep") != int(TStep) || bd->GetvInt("TVisco") != int(TVisco))
+        RunException(met, "The step algorithm or viscosity of the checkpoint does not match the configuration.",
+                     RestartFile);
+    if (bd->GetvInt("CellOrder") != int(CellOrder) || bd->GetvInt("CellMode") != int(CellMode) ||
+        bd->GetvUint("PeriActive") != PeriActive)
+        RunException(met, "The cell configuration of the checkpoint does not match the configuration.", RestartFile);
+    Part = int(bd->GetvUint("Part"));
+    Nstep = bd->GetvInt("Nstep");
+    TimeStep = bd->GetvDouble("TimeStep");
+    PartNstep = bd->GetvInt("PartNstep");
+    PartOut = bd->GetvUint("PartOut");
+    TimeStepM1 = bd->GetvDouble("TimeStepM1");
+    TimePartNext = bd->GetvDouble("TimePartNext");
+    PartDtMin = bd->GetvDouble("PartDtMin");
+    PartDtMax = bd->GetvDouble("PartDtMax");
+    MotionTimeMod = bd->GetvDouble("MotionTimeMod");
+    DemDtForce = bd->GetvDouble("DemDtForce");
+    DtModif = bd->GetvUint("DtModif");
+    OutPosCount = bd->GetvUint("OutPosCount");
+    OutRhopCount = bd->GetvUint("OutRhopCount");
+    OutMoveCount = bd->GetvUint("OutMoveCount");
+    TotalNp = bd->GetvUllong("TotalNp");
+#ifdef PARTIDS_64BIT
+    IdMax = bd->GetvUllong("IdMax");
+#else
+    IdMax = bd->GetvUint("IdMax");
+#endif
+    MaxParticles = bd->GetvUint("MaxParticles");
+    MaxCells = bd->GetvUint("MaxCells");
+    for (unsigned c = 0; c < unsigned(SaveFilters.size()); c++) {
+        const string name = fun::PrintStr("SaveFilter_%u", c);
+        if (bd->ExistsValue(name + "_Part"))
+            SaveFilters[c]->SetState(bd->GetvUint(name + "_Part"), bd->GetvDouble(name + "_TimeNext"));
+        LoadCheckpointSeries(bd, name + "_", SaveFilters[c]->GetDataBi4());
+    }
+    LoadCheckpointSeries(bd, "", DataBi4);
+    //-Los nuevos checkpoints siguen la numeracion del fichero cargado y el intervalo actual.
+    //-New checkpoints follow the numbering of the loaded file and the current interval.
+    if (CheckpointBi4) {
+        CheckpointBi4->ConfigRestart(bd->GetvUint("Num", true, 0));
+        CheckpointNext = TimeStep + CheckpointTime;
+    }
+    for (unsigned cf = 0; cf < FtCount; cf++) {
+        JBinaryData *bdf = bd->GetItem(fun::PrintStr("Floating_%u", cf));
+        if (!bdf)RunException(met, "The data of floating objects is missing.", RestartFile);
+        FtObjs[cf].center = bdf->GetvDouble3("center");
+        FtObjs[cf].fvel = bdf->GetvFloat3("fvel");
+        FtObjs[cf].fomega = bdf->GetvFloat3("fomega");
+        FtObjs[cf].radius = bdf->GetvFloat("radius");
+    }
+    //-Ajusta el movimiento predefinido al instante del checkpoint.
+    //-Adjusts predefined motion to the instant of the checkpoint.
+    if (CaseNmoving)Motion->ProcesTime(0, TimeStep + MotionTimeMod);
+}
+
 // Adds basic information of resume to hinfo & dinfo
 void
 JSph::GetResInfo(float tsim, float ttot, const std::string &headplus, const std::string &detplus, std::string &hinfo,
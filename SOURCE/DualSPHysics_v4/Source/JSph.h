@@ -28,6 +28,7 @@
 #include "JTimer.h"
 #include <float.h>
 #include <string>
+#include <vector>
 #include <cmath>
 #include <ctime>
 #include <sstream>
@@ -50,6 +51,9 @@ class JWaveGen;
 
 class JSphAccInput;
 
+class JSphInOut;
+class JSphSplitting;
+
 class JSpaceParts;
 
 class JPartDataBi4;
@@ -60,6 +64,14 @@ class JPartFloatBi4Save;
 
 class JPartsOut;
 
+class JCheckpointBi4Save;
+
+class JTimersStep;
+
+class JSaveFilter;
+
+class JBinaryData;
+
 class JXml;
 
 class JTimeOut;
@@ -91,6 +103,28 @@ public:
         word code;
     } StMkInfo;
 
+#define FORCESTATS_BINS 16  ///<Number of bins of the histograms of neighbours in StForceStats.
+
+/// Structure with statistics of the force stage (neighbours, cells and threads).
+    typedef struct {
+        bool active;
+        double imbfluid;    //-Desequilibrio de hilos (max/media del tiempo) en la interaccion de fluido.              ///<Thread imbalance (max/mean time) in the fluid interaction.
+        double imbbound;    //-Desequilibrio de hilos (max/media del tiempo) en la interaccion de contorno.            ///<Thread imbalance (max/mean time) in the boundary interaction.
+        double thmeanfluid; //-Tiempo medio por hilo en la interaccion de fluido (s).                                 ///<Mean time per thread in the fluid interaction (s).
+        double thmeanbound; //-Tiempo medio por hilo en la interaccion de contorno (s).                               ///<Mean time per thread in the boundary interaction (s).
+        double candmean;    //-Media de candidatos a vecino por particula fluid.                                      ///<Mean of neighbour candidates per fluid particle.
+        double neighmean;   //-Media de vecinos aceptados (r<2h) por particula fluid.                                 ///<Mean of accepted neighbours (r<2h) per fluid particle.
+        unsigned neighmin, neighmax;
+        double neighmeanbound; //-Media de vecinos fluid por particula bound.                                         ///<Mean of fluid neighbours per boundary particle.
+        unsigned histwidth; //-Anchura de los intervalos de los histogramas.                                          ///<Width of the bins of the histograms.
+        unsigned histcand[FORCESTATS_BINS];   ///<Histogram of neighbour candidates of fluid particles.
+        unsigned histneigh[FORCESTATS_BINS];  ///<Histogram of accepted neighbours of fluid particles.
+        unsigned cellsfluid;   //-Celdas con particulas fluid.                                                        ///<Cells with fluid particles.
+        double cellsempty;     //-Fraccion de celdas del dominio sin particulas fluid.                                ///<Fraction of cells of the domain without fluid particles.
+        double cellocmean;     //-Ocupacion media de las celdas con fluid.                                            ///<Mean occupancy of cells with fluid.
+        unsigned cellocmax;    //-Ocupacion maxima de las celdas con fluid.                                           ///<Maximum occupancy of cells with fluid.
+    } StForceStats;
+
 /// Structure that saves extra information about the execution.
     typedef struct {
         double timesim;     //-Segundos desde el inicio de la simulacion (despues de cargar los datos iniciales).       ///<Seconds from the start of the simulation (after loading the initial data).
@@ -108,6 +142,9 @@ public:
         llong memorynpused;
         llong memorynctalloc;
         llong memorynctused;
+        StForceStats forcestats;  ///<Statistics of the force stage (CPU with -svforcestats).
+        unsigned npfasleep; //-Numero de particulas fluid dormidas (CPU con -sleep).                                 ///<Number of asleep fluid particles (CPU with -sleep).
+        unsigned nctasleep; //-Numero de celdas dormidas (CPU con -sleep).                                           ///<Number of asleep cells (CPU with -sleep).
     } StInfoPartPlus;
 
 /// Structure with Periodic information.
@@ -138,6 +175,7 @@ private:
     JPartOutBi4Save *DataOutBi4;     //-Para grabar particulas excluidas en formato bi4.      ///<To store excluded particles in bi4 format.
     JPartFloatBi4Save *DataFloatBi4; //-Para grabar datos de floatings en formato bi4.        ///<To store floating data in bi4 format.
     JPartsOut *PartsOut;         //-Almacena las particulas excluidas hasta su grabacion.     ///<Stores excluded particles until they are saved.
+    std::vector<JSaveFilter*> SaveFilters; //-Salidas adicionales de particulas filtradas.  ///<Additional outputs of filtered particles.
 
     //-Numero acumulado de particulas excluidas segun motivo.
     ///<Total number of excluded particles according to reason for exclusion.
@@ -161,6 +199,11 @@ private:
 
     void ConfigDomainParticlesPrc(tdouble3 vmin, tdouble3 vmax);
 
+    void ConfigPartDataBi4(JPartDataBi4 *data, unsigned piece, unsigned pieces, const std::string &dir,
+                           std::string div) const;
+
+    void ConfigSaveFilters();
+
 protected:
     const bool Cpu;
     const bool WithMpi;
@@ -182,6 +225,9 @@ protected:
     //-Execution options.
     TpStep TStep;               //-Algitmo de paso: Verlet o Symplectic.                                          ///<Step Algorithm: Verlet or Symplectic.
     int VerletSteps;            //-Number of steps to apply Eulerian equations
+    unsigned SleepSteps;        //-Pasos en reposo para que el fluido se duerma (0:desactivado).                        ///<Steps at rest before the fluid falls asleep (0:disabled).
+    float SleepVel;             //-Velocidad maxima de una particula en reposo.                                       ///<Maximum velocity of a particle at rest.
+    float SleepAce;             //-Aceleracion maxima de una particula en reposo.                                     ///<Maximum acceleration of a particle at rest.
     TpKernel TKernel;           //-Tipo de kernel: Cubic o Wendland.                                              ///<Kernel type: Cubic or Wendland.
     float Awen;                 //-Constante para kernel wendland (awen).                                         ///<Wendland kernel constant (awen).
     float Bwen;                 //-Constante para kernel wendland (bwen).                                         ///<Wendland kernel constant (bwen).
@@ -221,6 +267,18 @@ protected:
     bool SvRes;         //-Graba fichero con resumen de ejecucion.                                                ///<Creates file with execution summary.
     bool SvTimers;      //-Obtiene tiempo para cada proceso.                                                      ///<Computes the time for each process.
     bool SvDomainVtk;   //-Graba fichero vtk con el dominio de las particulas en cada Part.                       ///<Stores VTK file with the domain of particles of each PART file.
+    bool SvSeries;      //-Graba PARTs en ficheros de series con indice.                                          ///<Saves PARTs in series files with index.
+    unsigned SvSeriesParts; //-Numero maximo de PARTs por fichero de series (0:sin limite).                     ///<Maximum number of PARTs per series file (0:unlimited).
+    unsigned SvTimersStep;  //-Graba timers y valores del paso cada N pasos (0:no graba).                         ///<Saves timers and step values every N steps (0:disabled).
+    JTimersStep *TimersStep; ///<Object to write per-step timers in background.
+    unsigned SvTrace;       //-Tamanho del buffer de eventos de traza (0:no graba).                                  ///<Size of the buffer of trace events (0:disabled).
+    bool SvMemory;          //-Registra la memoria actual y maxima de cada array.                                   ///<Registers current and peak memory of each array.
+    bool SvForceStats;      //-Graba estadisticas de vecinos, celdas e hilos de la interaccion en PartInfo.         ///<Saves statistics of neighbours, cells and threads of the interaction in PartInfo.
+    double SvStatus;        //-Intervalo (s) para reescribir Status.json (0:no graba).                                ///<Interval (s) to rewrite Status.json (0:disabled).
+    unsigned SvRoofline;    //-Tamano (MB) de los arrays del test de ancho de banda del roofline (0:desactivado).   ///<Size (MB) of the arrays of the bandwidth test of the roofline (0:disabled).
+    bool SvPerf;            //-Lee contadores hardware de cada proceso.                                              ///<Reads hardware performance counters of each process.
+    unsigned BenchSteps;    //-Pasos medidos en modo benchmark (0:desactivado).                                      ///<Measured steps in benchmark mode (0:disabled).
+    unsigned BenchWarmup;   //-Pasos previos a la medida en modo benchmark.                                          ///<Steps before measuring in benchmark mode.
 
     //-Constantes para calculo.
     ///<Computation constants.
@@ -271,6 +329,14 @@ protected:
     double PartBeginTimeStep;   ///<Instante de inicio de la simulación.                                          ///<initial instant of the simulation
     ullong PartBeginTotalNp;    ///<Total number of simulated particles.
 
+    //-Vars para checkpoints de la simulacion.
+    //-Variables for simulation checkpoints.
+    std::string RestartFile;    ///<Checkpoint file used to restart the simulation (empty: no restart).
+    double CheckpointTime;      ///<Simulated time between checkpoints (0: disabled).
+    unsigned CheckpointKeep;    ///<Number of checkpoint files that are kept.
+    double CheckpointNext;      ///<Instant to store next checkpoint file.
+    JCheckpointBi4Save *CheckpointBi4; ///<Object to write checkpoint files in background.
+
     //-Vars para movimiento predefinido.
     //-Variables for predefined movement.
     JSphMotion *Motion;
@@ -294,11 +360,17 @@ protected:
 
     JSphAccInput *AccInput;     ///<Object for variable acceleration functionality.
 
+    JSphInOut *InOut;           ///<Object for open boundaries (inlet and outlet zones).
+
+    JSphSplitting *Splitting;   ///<Object for the adaptive refinement of the fluid (particle splitting and merging).
+
     TpCellOrder CellOrder;  //-Orden de ejes en ordenacion de particulas en celdas.                               ///<Defines axes' ordination of particles in cells.
 
     //-Division en celdas.
     //-Division in cells.
     TpCellMode CellMode;    //-Modo de division en celdas.                                                        ///<Cell division mode.
+    bool Overlap;           //-Crea las periodicas mientras se calcula la interaccion del resto.                   ///<Creates the periodic particles while the interaction of the rest is computed.
+    unsigned TaskGraph;     //-Particulas por bloque del grafo de tareas de la interaccion (0:desactivado).         ///<Particles per block of the task graph of the interaction (0:disabled).
     unsigned Hdiv;          //-Valor por el que se divide a DosH                                                  ///<Value to divide 2H
     float Scell;            //-Tamaño de celda: 2h o h.                                                           ///<Cell size: 2h or h.
     float MovLimit;         //-Distancia maxima que se permite recorrer a una particula en un paso (Scell*0.9).   ///<Maximum distance a particle is allowed to move in one step (Sce;;*0.9)
@@ -322,7 +394,7 @@ protected:
     bool NpDynamic;   ///<CaseNp can increase.
     bool ReuseIds;    ///<Id of particles excluded values ​​are reused.
     ullong TotalNp;   ///<Total number of simulated particles (no cuenta las particulas inlet no validas).
-    unsigned IdMax;   ///<It is the maximum Id used.
+    tpartid IdMax;    ///<It is the maximum Id used.
 
     //-Monitorizacion del dt.
     //-Monitors dt.
@@ -365,13 +437,13 @@ protected:
 
     void LoadMkInfo(const JSpaceParts *parts);
 
-    inline unsigned GetMkBlockById(unsigned id) const;
+    inline unsigned GetMkBlockById(tpartid id) const;
 
     unsigned GetMkBlockByMk(word mk) const;
 
     word CodeSetType(word code, TpParticle type, unsigned value) const;
 
-    void LoadCodeParticles(unsigned np, const unsigned *idp, word *code) const;
+    void LoadCodeParticles(unsigned np, const tpartid *idp, word *code) const;
 
     void ResizeMapLimits();
 
@@ -423,7 +495,7 @@ protected:
 
     static unsigned CalcCellCode(tuint3 ncells);
 
-    void CalcFloatingRadius(unsigned np, const tdouble3 *pos, const unsigned *idp);
+    void CalcFloatingRadius(unsigned np, const tdouble3 *pos, const tpartid *idp);
 
     tdouble3 UpdatePeriodicPos(tdouble3 ps) const;
 
@@ -433,19 +505,34 @@ protected:
 
     void ConfigSaveData(unsigned piece, unsigned pieces, std::string div);
 
-    void AddParticlesOut(unsigned nout, const unsigned *idp, const tdouble3 *pos, const tfloat3 *vel, const float *rhop,
+    void AddParticlesOut(unsigned nout, const tpartid *idp, const tdouble3 *pos, const tfloat3 *vel, const float *rhop,
                          unsigned noutrhop, unsigned noutmove);
 
     tfloat3 *GetPointerDataFloat3(unsigned n, const tdouble3 *v) const;
 
-    void SavePartData(unsigned npok, unsigned nout, const unsigned *idp, const tdouble3 *pos, const tfloat3 *vel,
-                      const float *rhop, unsigned ndom, const tdouble3 *vdom, const StInfoPartPlus *infoplus);
+    void SavePartData(unsigned npok, unsigned nout, const tpartid *idp, const tdouble3 *pos, const tfloat3 *vel,
+                      const float *rhop, unsigned ndom, const tdouble3 *vdom, const StInfoPartPlus *infoplus,
+                      const float *mass = NULL, const float *hvar = NULL);
 
-    void SaveData(unsigned npok, const unsigned *idp, const tdouble3 *pos, const tfloat3 *vel, const float *rhop,
-                  unsigned ndom, const tdouble3 *vdom, const StInfoPartPlus *infoplus);
+    void SaveData(unsigned npok, const tpartid *idp, const tdouble3 *pos, const tfloat3 *vel, const float *rhop,
+                  unsigned ndom, const tdouble3 *vdom, const StInfoPartPlus *infoplus, const float *mass = NULL,
+                  const float *hvar = NULL);
 
     void SaveDomainVtk(unsigned ndom, const tdouble3 *vdom) const;
 
+    bool CheckSaveFilters() const;
+
+    void SaveFilterData(unsigned npok, const tpartid *idp, const tdouble3 *pos, const tfloat3 *vel,
+                        const float *rhop, const word *code);
+
+    void SaveCheckpointSeries(JBinaryData *bd, const std::string &prefix, const JPartDataBi4 *data) const;
+
+    void LoadCheckpointSeries(JBinaryData *bd, const std::string &prefix, JPartDataBi4 *data);
+
+    void SaveCheckpointState(JBinaryData *bd) const;
+
+    void LoadCheckpointState(JBinaryData *bd);
+
     void SaveMapCellsVtk(float scell) const;
 
     void GetResInfo(float tsim, float ttot, const std::string &headplus, const std::string &detplus, std::string &hinfo,
@@ -11,8 +11,13 @@
 #include "JSaveDt.h"
 #include "JTimeOut.h"
 #include "JSphAccInput.h"
+#include "JSphInOut.h"
+#include "JSphSplitting.h"
+#include "JCheckpointBi4.h"
+#include "JMemRegistry.h"
 
 #include <climits>
+#include <vector>
 
 #ifdef _WITHOMP
 
@@ -21,6 +26,7 @@
 #else
                                                                                                                         #define omp_get_thread_num() 0
   #define omp_get_max_threads() 1
+  #define omp_get_wtime() 0.
 #endif
 
 #ifndef WIN32
@@ -38,6 +44,7 @@ JSphCpu::JSphCpu(bool withmpi) : JSph(true, withmpi) {
     ClassName = "JSphCpu";
     CellDiv = NULL;
     ArraysCpu = new JArraysCpu;
+    ForceThTimes = new double[MAXTHREADS_OMP * 2];
     InitVars();
     TmcCreation(Timers, false);
 }
@@ -49,6 +56,7 @@ JSphCpu::~JSphCpu() {
     FreeCpuMemoryParticles();
     FreeCpuMemoryFixed();
     delete ArraysCpu;
+    delete[] ForceThTimes;
     TmcDestruction(Timers);
 }
 
@@ -61,6 +69,7 @@ void JSphCpu::InitVars() {
 
     Np = Npb = NpbOk = 0;
     NpbPer = NpfPer = 0;
+    NpbPerM1 = NpfPerM1 = 0;
     WithFloating = false;
 
     Idpc = NULL;
@@ -71,6 +80,14 @@ void JSphCpu::InitVars() {
     VelrhopM1c = NULL;                //-Verlet
     PosPrec = NULL;
     VelrhopPrec = NULL; //-Symplectic
+    SleepCountc = NULL;
+    SleepListc = NULL;                //-Sleeping particles.
+    SleepNpActive = UINT_MAX;
+    SleepNpAsleep = 0;
+    SleepNpSkipped = SleepNpFluid = 0;
+    InOutc = NULL;                    //-Open boundaries.
+    Massc = NULL;
+    Hvarc = NULL;                     //-Splitting.
     PsPosc = NULL;                    //-Interaccion Pos-Simple.
     SpsTauc = NULL;
     SpsGradvelc = NULL; //-Laminar+SPS.
@@ -83,6 +100,7 @@ void JSphCpu::InitVars() {
     RidpMove = NULL;
     FtRidp = NULL;
     FtoForces = NULL;
+    memset(ForceThTimes, 0, sizeof(double) * MAXTHREADS_OMP * 2);
     FreeCpuMemoryParticles();
     FreeCpuMemoryFixed();
 }
@@ -99,6 +117,7 @@ void JSphCpu::FreeCpuMemoryFixed() {
     FtRidp = NULL;
     delete[] FtoForces;
     FtoForces = NULL;
+    UpdateMemRegistry();
 }
 
 //==============================================================================
@@ -123,6 +142,7 @@ void JSphCpu::AllocCpuMemoryFixed() {
     catch (const std::bad_alloc) {
         RunException("AllocMemoryFixed", "Could not allocate the requested memory.");
     }
+    UpdateMemRegistry();
 }
 
 //==============================================================================
@@ -133,6 +153,7 @@ void JSphCpu::FreeCpuMemoryParticles() {
     CpuParticlesSize = 0;
     MemCpuParticles = 0;
     ArraysCpu->Reset();
+    UpdateMemRegistry();
 }
 
 //==============================================================================
@@ -143,12 +164,19 @@ void JSphCpu::AllocCpuMemoryParticles(unsigned np, float over) {
     const char *met = "AllocCpuMemoryParticles";
     FreeCpuMemoryParticles();
     //-Calculate number of partices with reserved memory / Calcula numero de particulas para las que se reserva memoria.
-    const unsigned np2 = (over > 0 ? unsigned(over * np) : np);
+    const double np2d = (over > 0 ? double(over) * np : np);
+    if (np2d > PARTS_NPMAX)RunException(met, "The number of particles is too big.");
+    const unsigned np2 = unsigned(np2d);
     CpuParticlesSize = np2;
     //-Calculate which arrays / Calcula cuantos arrays.
     ArraysCpu->SetArraySize(np2);
     ArraysCpu->AddArrayCount(JArraysCpu::SIZE_2B, 2);  ///<-code
+#ifdef PARTIDS_64BIT
+    ArraysCpu->AddArrayCount(JArraysCpu::SIZE_8B, 2);  ///<-idp,idp of SaveData
+    ArraysCpu->AddArrayCount(JArraysCpu::SIZE_4B, 4);  ///<-ar,viscdt,dcell,prrhop
+#else
     ArraysCpu->AddArrayCount(JArraysCpu::SIZE_4B, 5);  ///<-idp,ar,viscdt,dcell,prrhop
+#endif
     if (TDeltaSph == DELTA_DynamicExt)ArraysCpu->AddArrayCount(JArraysCpu::SIZE_4B, 1);  ///<-delta
     ArraysCpu->AddArrayCount(JArraysCpu::SIZE_12B, 1); ///<-ace
     ArraysCpu->AddArrayCount(JArraysCpu::SIZE_16B, 1); ///<-velrhop
@@ -166,9 +194,27 @@ void JSphCpu::AllocCpuMemoryParticles(unsigned np, float over) {
     if (TShifting != SHIFT_None) {
         ArraysCpu->AddArrayCount(JArraysCpu::SIZE_12B, 1); ///<-shiftpos
     }
+    if (PeriActive) {
+        ArraysCpu->AddArrayCount(JArraysCpu::SIZE_1B, 1);  ///<-direction list of periodic particles
+    }
+    if (Overlap) {
+        ArraysCpu->AddArrayCount(JArraysCpu::SIZE_4B, 2);  ///<-cellpart,sortpart of periodic particles
+        ArraysCpu->AddArrayCount(JArraysCpu::SIZE_24B, 1); ///<-aux of periodic particles
+    }
+    if (SleepSteps) {
+        ArraysCpu->AddArrayCount(JArraysCpu::SIZE_2B, 1);  ///<-sleepcount
+        ArraysCpu->AddArrayCount(JArraysCpu::SIZE_4B, 1);  ///<-sleeplist
+    }
+    if (InOut) {
+        ArraysCpu->AddArrayCount(JArraysCpu::SIZE_2B, 1);  ///<-inout
+    }
+    if (Splitting) {
+        ArraysCpu->AddArrayCount(JArraysCpu::SIZE_4B, 4);  ///<-mass,hvar,mass,hvar of SaveData or splitc,pairc of RunSplitting
+    }
     //-Show reserved memory / Muestra la memoria reservada.
     MemCpuParticles = ArraysCpu->GetAllocMemoryCpu();
     PrintSizeNp(np2, MemCpuParticles);
+    UpdateMemRegistry();
 }
 
 //==============================================================================
@@ -176,7 +222,7 @@ void JSphCpu::AllocCpuMemoryParticles(unsigned np, float over) {
 //==============================================================================
 void JSphCpu::ResizeCpuMemoryParticles(unsigned npnew) {
     //-Saves current data from CPU.
-    unsigned *idp = SaveArrayCpu(Np, Idpc);
+    tpartid *idp = SaveArrayCpu(Np, Idpc);
     word *code = SaveArrayCpu(Np, Codec);
     unsigned *dcell = SaveArrayCpu(Np, Dcellc);
     tdouble3 *pos = SaveArrayCpu(Np, Posc);
@@ -185,6 +231,10 @@ void JSphCpu::ResizeCpuMemoryParticles(unsigned npnew) {
     tdouble3 *pospre = SaveArrayCpu(Np, PosPrec);
     tfloat4 *velrhoppre = SaveArrayCpu(Np, VelrhopPrec);
     tsymatrix3f *spstau = SaveArrayCpu(Np, SpsTauc);
+    word *sleepcount = SaveArrayCpu(Np, SleepCountc);
+    word *inout = SaveArrayCpu(Np, InOutc);
+    float *mass = SaveArrayCpu(Np, Massc);
+    float *hvar = SaveArrayCpu(Np, Hvarc);
     //-Frees pointers.
     ArraysCpu->Free(Idpc);
     ArraysCpu->Free(Codec);
@@ -195,12 +245,17 @@ void JSphCpu::ResizeCpuMemoryParticles(unsigned npnew) {
     ArraysCpu->Free(PosPrec);
     ArraysCpu->Free(VelrhopPrec);
     ArraysCpu->Free(SpsTauc);
+    ArraysCpu->Free(SleepCountc);
+    ArraysCpu->Free(SleepListc);
+    ArraysCpu->Free(InOutc);
+    ArraysCpu->Free(Massc);
+    ArraysCpu->Free(Hvarc);
     //-Resizes CPU memory allocation.
     const double mbparticle = (double(MemCpuParticles) / (1024 * 1024)) / CpuParticlesSize; //-MB por particula.
     Log->Printf("**JSphCpu: Requesting cpu memory for %u particles: %.1f MB.", npnew, mbparticle * npnew);
     ArraysCpu->SetArraySize(npnew);
     //-Reserve pointers.
-    Idpc = ArraysCpu->ReserveUint();
+    Idpc = ArraysCpu->ReserveIdp();
     Codec = ArraysCpu->ReserveWord();
     Dcellc = ArraysCpu->ReserveUint();
     Posc = ArraysCpu->ReserveDouble3();
@@ -209,6 +264,15 @@ void JSphCpu::ResizeCpuMemoryParticles(unsigned npnew) {
     if (pospre) PosPrec = ArraysCpu->ReserveDouble3();
     if (velrhoppre)VelrhopPrec = ArraysCpu->ReserveFloat4();
     if (spstau) SpsTauc = ArraysCpu->ReserveSymatrix3f();
+    if (sleepcount) {
+        SleepCountc = ArraysCpu->ReserveWord();
+        SleepListc = ArraysCpu->ReserveUint();
+    }
+    if (inout) InOutc = ArraysCpu->ReserveWord();
+    if (mass) {
+        Massc = ArraysCpu->ReserveFloat();
+        Hvarc = ArraysCpu->ReserveFloat();
+    }
     //-Restore data in CPU memory.
     RestoreArrayCpu(Np, idp, Idpc);
     RestoreArrayCpu(Np, code, Codec);
@@ -219,9 +283,14 @@ void JSphCpu::ResizeCpuMemoryParticles(unsigned npnew) {
     RestoreArrayCpu(Np, pospre, PosPrec);
     RestoreArrayCpu(Np, velrhoppre, VelrhopPrec);
     RestoreArrayCpu(Np, spstau, SpsTauc);
+    RestoreArrayCpu(Np, sleepcount, SleepCountc);
+    RestoreArrayCpu(Np, inout, InOutc);
+    RestoreArrayCpu(Np, mass, Massc);
+    RestoreArrayCpu(Np, hvar, Hvarc);
     //-Updates values.
     CpuParticlesSize = npnew;
     MemCpuParticles = ArraysCpu->GetAllocMemoryCpu();
+    UpdateMemRegistry();
 }
 
 //==============================================================================
@@ -262,13 +331,64 @@ void JSphCpu::RestoreArrayCpu_Uint(unsigned np, unsigned *data, unsigned *datane
 /// Arrays for basic particle data.
 //==============================================================================
 void JSphCpu::ReserveBasicArraysCpu() {
-    Idpc = ArraysCpu->ReserveUint();
+    Idpc = ArraysCpu->ReserveIdp();
     Codec = ArraysCpu->ReserveWord();
     Dcellc = ArraysCpu->ReserveUint();
     Posc = ArraysCpu->ReserveDouble3();
     Velrhopc = ArraysCpu->ReserveFloat4();
     if (TStep == STEP_Verlet)VelrhopM1c = ArraysCpu->ReserveFloat4();
     if (TVisco == VISCO_LaminarSPS)SpsTauc = ArraysCpu->ReserveSymatrix3f();
+    if (SleepSteps) {
+        SleepCountc = ArraysCpu->ReserveWord();
+        SleepListc = ArraysCpu->ReserveUint();
+    }
+    if (InOut)InOutc = ArraysCpu->ReserveWord();
+    if (Splitting) {
+        Massc = ArraysCpu->ReserveFloat();
+        Hvarc = ArraysCpu->ReserveFloat();
+    }
+}
+
+//==============================================================================
+/// Actualiza JMemRegistry con los arrays basicos de particulas (el resto de
+/// ArraysCpu se usa para arrays temporales) y los arrays de tamanho fijo.
+/// Updates JMemRegistry with the basic particle arrays (the rest of ArraysCpu
+/// is used for temporary arrays) and the arrays with fixed size.
+//==============================================================================
+void JSphCpu::UpdateMemRegistry() const {
+    if (!JMemRegistry::Active)return;
+    const llong np = CpuParticlesSize;
+    const llong szm1 = (TStep == STEP_Verlet ? sizeof(tfloat4) : 0);
+    const llong szpre = (TStep == STEP_Symplectic ? sizeof(tdouble3) + sizeof(tfloat4) : 0);
+    const llong sztau = (TVisco == VISCO_LaminarSPS ? sizeof(tsymatrix3f) : 0);
+    const llong szsleep = (SleepSteps ? sizeof(word) + sizeof(unsigned) : 0);
+    const llong szinout = (InOut ? sizeof(word) : 0);
+    const llong szsplit = (Splitting ? sizeof(float) * 2 : 0);
+    const llong basic = np * (sizeof(tpartid) + sizeof(unsigned) + sizeof(word) + sizeof(tdouble3) + sizeof(tfloat4) + szm1 + szpre + sztau + szsleep + szinout + szsplit);
+    JMemRegistry::Set("Particles", "Idpc", np * sizeof(tpartid));
+    JMemRegistry::Set("Particles", "Codec", np * sizeof(word));
+    JMemRegistry::Set("Particles", "Dcellc", np * sizeof(unsigned));
+    JMemRegistry::Set("Particles", "Posc", np * sizeof(tdouble3));
+    JMemRegistry::Set("Particles", "Velrhopc", np * sizeof(tfloat4));
+    if (szm1)JMemRegistry::Set("Particles", "VelrhopM1c", np * szm1);
+    if (szpre) {
+        JMemRegistry::Set("Particles", "PosPrec", np * sizeof(tdouble3));
+        JMemRegistry::Set("Particles", "VelrhopPrec", np * sizeof(tfloat4));
+    }
+    if (sztau)JMemRegistry::Set("Particles", "SpsTauc", np * sztau);
+    if (szsleep) {
+        JMemRegistry::Set("Particles", "SleepCountc", np * sizeof(word));
+        JMemRegistry::Set("Particles", "SleepListc", np * sizeof(unsigned));
+    }
+    if (szinout)JMemRegistry::Set("Particles", "InOutc", np * szinout);
+    if (szsplit) {
+        JMemRegistry::Set("Particles", "Massc", np * sizeof(float));
+        JMemRegistry::Set("Particles", "Hvarc", np * sizeof(float));
+    }
+    JMemRegistry::Set("Particles", "Temporary", MemCpuParticles - basic);
+    JMemRegistry::Set("Fixed", "RidpMove", (RidpMove ? sizeof(unsigned) * CaseNmoving : 0));
+    JMemRegistry::Set("Fixed", "FtRidp", (FtRidp ? sizeof(unsigned) * CaseNfloat : 0));
+    JMemRegistry::Set("Fixed", "FtoForces", (FtoForces ? sizeof(StFtoForces) * FtCount : 0));
 }
 
 //==============================================================================
@@ -303,13 +423,13 @@ void JSphCpu::PrintAllocMemory(llong mcpu) const {
 /// - cellorderdecode: Reorder components of position (pos) and velocity (vel) according to CellOrder.
 /// - onlynormal: Only keep the normal ones and eliminate the periodic particles.
 //==============================================================================
-unsigned JSphCpu::GetParticlesData(unsigned n, unsigned pini, bool cellorderdecode, bool onlynormal, unsigned *idp,
+unsigned JSphCpu::GetParticlesData(unsigned n, unsigned pini, bool cellorderdecode, bool onlynormal, tpartid *idp,
                                    tdouble3 *pos, tfloat3 *vel, float *rhop, word *code) {
     const char met[] = "GetParticlesData";
     unsigned num = n;
     //-Copy selected values / Copia datos seleccionados.
     if (code)memcpy(code, Codec + pini, sizeof(word) * n);
-    if (idp)memcpy(idp, Idpc + pini, sizeof(unsigned) * n);
+    if (idp)memcpy(idp, Idpc + pini, sizeof(tpartid) * n);
     if (pos)memcpy(pos, Posc + pini, sizeof(tdouble3) * n);
     if (vel && rhop) {
         for (unsigned p = 0; p < n; p++) {
@@ -420,7 +540,7 @@ void JSphCpu::InitRun() {
     }
 
     //-Uses Inlet information from PART read.
-    if (PartBeginTimeStep && PartBeginGetMovTotalNp) {
+    if (PartBeginTimeStep && PartBeginTotalNp) {
         TotalNp = PartBeginTotalNp;
         IdMax = unsigned(TotalNp - 1);
     }
@@ -440,6 +560,11 @@ void JSphCpu::InitRun() {
         AccInput->VisuConfig("", " ");
     }
 
+    //-Shows InOut configuration.
+    if (InOut)InOut->VisuConfig(Log, "\nInOut configuration:", " ");
+    //-Shows Splitting configuration.
+    if (Splitting)Splitting->VisuConfig(Log, "\nSplitting configuration:", " ");
+
     //-Process Special configurations in XML.
     JXml xml;
     xml.LoadFile(FileXml);
@@ -464,6 +589,71 @@ void JSphCpu::InitRun() {
     TimePartNext = TimeOut->GetNextTime(TimeStep);
 }
 
+//==============================================================================
+/// Almacena en bd los datos de particulas en el orden interno de celdas.
+/// Stores in bd the particle data in the internal cell order.
+//==============================================================================
+void JSphCpu::SaveCheckpointParticles(JBinaryData *bd) const {
+    if (ullong(Np) * 6 > UINT_MAX)RunException("SaveCheckpointParticles", "The number of particles is too big for a checkpoint.");
+    bd->SetvUint("CpuParticlesSize", CpuParticlesSize);
+    bd->SetvUint("Np", Np);
+    bd->SetvUint("Npb", Npb);
+    bd->SetvUint("NpbOk", NpbOk);
+    bd->SetvUint("NpbPer", NpbPer);
+    bd->SetvUint("NpfPer", NpfPer);
+    bd->SetvUint("NpbPerM1", NpbPerM1);
+    bd->SetvUint("NpfPerM1", NpfPerM1);
+    bd->SetvBool("BoundChanged", BoundChanged);
+    bd->CreateArray("Idp", (sizeof(tpartid) == 8 ? JBinaryDataDef::DatUllong : JBinaryDataDef::DatUint), Np, Idpc, false);
+    bd->CreateArray("Code", JBinaryDataDef::DatUshort, Np, Codec, false);
+    bd->CreateArray("Dcell", JBinaryDataDef::DatUint, Np, Dcellc, false);
+    bd->CreateArray("Pos", JBinaryDataDef::DatDouble3, Np, Posc, false);
+    bd->CreateArray("Velrhop", JBinaryDataDef::DatFloat, Np * 4, Velrhopc, false);
+    if (TStep == STEP_Verlet) {
+        bd->SetvInt("VerletStep", VerletStep);
+        bd->CreateArray("VelrhopM1", JBinaryDataDef::DatFloat, Np * 4, VelrhopM1c, false);
+    } else if (TStep == STEP_Symplectic)bd->SetvDouble("DtPre", DtPre);
+    if (TVisco == VISCO_LaminarSPS)bd->CreateArray("SpsTau", JBinaryDataDef::DatFloat, Np * 6, SpsTauc, false);
+}
+
+//==============================================================================
+/// Reserva memoria y carga datos de particulas de un checkpoint.
+/// Allocates memory and loads particle data from a checkpoint.
+//==============================================================================
+void JSphCpu::LoadCheckpointParticles(JCheckpointBi4Load *cpload) {
+    JBinaryData *bd = cpload->GetData();
+    Np = bd->GetvUint("Np");
+    Npb = bd->GetvUint("Npb");
+    NpbOk = bd->GetvUint("NpbOk");
+    NpbPer = bd->GetvUint("NpbPer");
+    NpfPer = bd->GetvUint("NpfPer");
+    NpbPerM1 = bd->GetvUint("NpbPerM1");
+    NpfPerM1 = bd->GetvUint("NpfPerM1");
+    BoundChanged = bd->GetvBool("BoundChanged");
+    AllocCpuMemoryFixed();
+    AllocCpuMemoryParticles(max(Np, bd->GetvUint("CpuParticlesSize")), 0);
+    ReserveBasicArraysCpu();
+    cpload->LoadArray(bd, "Idp", (sizeof(tpartid) == 8 ? JBinaryDataDef::DatUllong : JBinaryDataDef::DatUint), Np, Idpc);
+    cpload->LoadArray(bd, "Code", JBinaryDataDef::DatUshort, Np, Codec);
+    cpload->LoadArray(bd, "Dcell", JBinaryDataDef::DatUint, Np, Dcellc);
+    cpload->LoadArray(bd, "Pos", JBinaryDataDef::DatDouble3, Np, Posc);
+    cpload->LoadArray(bd, "Velrhop", JBinaryDataDef::DatFloat, Np * 4, Velrhopc);
+}
+
+//==============================================================================
+/// Recupera el estado del integrador y de la simulacion tras InitRun().
+/// Restores the state of the integrator and the simulation after InitRun().
+//==============================================================================
+void JSphCpu::LoadCheckpointStep(JCheckpointBi4Load *cpload) {
+    JBinaryData *bd = cpload->GetData();
+    LoadCheckpointState(bd);
+    if (TStep == STEP_Verlet) {
+        VerletStep = bd->GetvInt("VerletStep");
+        cpload->LoadArray(bd, "VelrhopM1", JBinaryDataDef::DatFloat, Np * 4, VelrhopM1c);
+    } else if (TStep == STEP_Symplectic)DtPre = bd->GetvDouble("DtPre");
+    if (TVisco == VISCO_LaminarSPS)cpload->LoadArray(bd, "SpsTau", JBinaryDataDef::DatFloat, Np * 6, SpsTauc);
+}
+
 //==============================================================================
 /// Adds variable acceleration from input files.
 //==============================================================================
@@ -475,11 +665,11 @@ void JSphCpu::AddAccInput() {
         AccInput->GetAccValues(c, TimeStep, mkfluid, acclin, accang, centre, velang, vellin, setgravity);
         const bool withaccang = (accang.x != 0 || accang.y != 0 || accang.z != 0);
         const word codesel = word(mkfluid);
-        const int npb = int(Npb), np = int(Np);
+        const llong npb = llong(Npb), np = llong(Np);
 #ifdef _WITHOMP
 #pragma omp parallel for schedule (static)
 #endif
-        for (int p = npb; p < np; p++) {//-Iterates through the fluid particles.
+        for (llong p = npb; p < np; p++) {//-Iterates through the fluid particles.
             //-Checks if the current particle is part of the particle set by its MK.
             if (CODE_GetTypeValue(Codec[p]) == codesel) {
                 tdouble3 acc = ToTDouble3(Acec[p]);
@@ -539,11 +729,11 @@ void JSphCpu::PreInteractionVars_Forces(TpInter tinter, unsigned np, unsigned np
     if (AccInput)AddAccInput();
 
     //-Prepare values of rhop for interaction / Prepara datos derivados de rhop para interaccion.
-    const int n = int(np);
+    const llong n = llong(np);
 #ifdef _WITHOMP
 #pragma omp parallel for schedule (static) if(n>LIMIT_COMPUTELIGHT_OMP)
 #endif
-    for (int p = 0; p < n; p++) {
+    for (llong p = 0; p < n; p++) {
         const float rhop = Velrhopc[p].w, rhop_r0 = rhop / RhopZero;
         Pressc[p] = CteB * (pow(rhop_r0, Gamma) - 1.0f);
     }
@@ -569,11 +759,11 @@ void JSphCpu::PreInteraction_Forces(TpInter tinter) {
     //-Prepare values for interaction  Pos-Simpe / Prepara datos para interaccion Pos-Simple.
     if (Psimple) {
         PsPosc = ArraysCpu->ReserveFloat3();
-        const int np = int(Np);
+        const llong np = llong(Np);
 #ifdef _WITHOMP
 #pragma omp parallel for schedule (static) if(np>LIMIT_COMPUTELIGHT_OMP)
 #endif
-        for (int p = 0; p < np; p++) { PsPosc[p] = ToTFloat3(Posc[p]); }
+        for (llong p = 0; p < np; p++) { PsPosc[p] = ToTFloat3(Posc[p]); }
     }
     //-Initialize Arrays / Inicializa arrays.
     PreInteractionVars_Forces(tinter, Np, Npb);
@@ -605,27 +795,28 @@ float JSphCpu::CalcVelMaxSeq(unsigned np, const tfloat4 *velrhop) const {
 /// Returns maximum velocity from an array tfloat4 using OpenMP.
 //==============================================================================
 float JSphCpu::CalcVelMaxOmp(unsigned np, const tfloat4 *velrhop) const {
-    const char met[] = "CalcVelMax";
     float velmax = 0;
 #ifdef _WITHOMP
     if (np > LIMIT_COMPUTELIGHT_OMP) {
-        const int n = int(np);
-        if (n < 0)RunException(met, "Number of values is too big.");
-        float vmax = 0;
+        const llong n = llong(np);
+        //-Maximo de cada hilo combinado en orden de hilo (no depende del orden de llegada).
+        //-Maximum of each thread combined in thread order (it does not depend on the arrival order).
+        float vmaxth[MAXTHREADS_OMP * STRIDE_OMP];
+        for (int th = 0; th < OmpThreads; th++)vmaxth[th * STRIDE_OMP] = 0;
 #pragma omp parallel
         {
+            const int th = omp_get_thread_num();
             float vmax2 = 0;
 #pragma omp for nowait
-            for (int c = 0; c < n; ++c) {
+            for (llong c = 0; c < n; ++c) {
                 const tfloat4 v = velrhop[c];
                 const float v2 = v.x * v.x + v.y * v.y + v.z * v.z;
                 if (vmax2 < v2)vmax2 = v2;
             }
-#pragma omp critical
-            {
-                if (vmax < vmax2)vmax = vmax2;
-            }
+            vmaxth[th * STRIDE_OMP] = vmax2;
         }
+        float vmax = 0;
+        for (int th = 0; th < OmpThreads; th++)if (vmax < vmaxth[th * STRIDE_OMP])vmax = vmaxth[th * STRIDE_OMP];
         //-Guarda resultado.
         velmax = sqrt(vmax);
     } else if (np)velmax = CalcVelMaxSeq(np, velrhop);
@@ -674,6 +865,27 @@ void JSphCpu::GetKernel(float rr2, float drx, float dry, float drz, float &frx,
     frz = fac * drz;
 }
 
+//==============================================================================
+/// Devuelve valores de kernel Wendland con la longitud de suavizado simetrica
+/// hij=(hi+hj)/2 de la pareja, gradients: frx, fry y frz.
+/// Return values of kernel Wendland with the symmetric smoothing length
+/// hij=(hi+hj)/2 of the pair, gradients: frx, fry and frz.
+//==============================================================================
+void JSphCpu::GetKernelHvar(float rr2, float drx, float dry, float drz, float hij, float &frx, float &fry,
+                            float &frz) const {
+    const float rad = sqrt(rr2);
+    const float qq = rad / hij;
+    //-Bwen is proportional to 1/h^(dim+1) / Bwen es proporcional a 1/h^(dim+1).
+    const float hr = H / hij;
+    const float bwen = Bwen * hr * hr * hr * (Simulate2D ? 1.f : hr);
+    //-Wendland kernel
+    const float wqq1 = 1.f - 0.5f * qq;
+    const float fac = bwen * qq * wqq1 * wqq1 * wqq1 / rad;
+    frx = fac * drx;
+    fry = fac * dry;
+    frz = fac * drz;
+}
+
 //==============================================================================
 /// Devuelve valores de kernel Cubic sin correccion tensil, gradients: frx, fry y frz.
 /// Return values of kernel Cubic without tensil correction, gradients: frx, fry and frz.
@@ -745,29 +957,39 @@ JSphCpu::GetInteractionCells(unsigned rcell, int hdiv, const tint4 &nc, const ti
 }
 
 //==============================================================================
-/// Realiza interaccion entre particulas. Bound-Fluid/Float
-/// Perform interaction between particles. Bound-Fluid/Float
+/// Realiza interaccion entre particulas. Bound-Fluid o Bound-Float segun sea
+/// cellinitial la primera celda de fluido o de floating (cellfloat).
+/// Perform interaction between particles. Bound-Fluid or Bound-Float depending
+/// on whether cellinitial is the first fluid or floating cell (cellfloat).
 //==============================================================================
 template<bool psimple, TpKernel tker, TpFtMode ftmode>
 void JSphCpu::InteractionForcesBound
-        (unsigned n, unsigned pinit, tint4 nc, int hdiv, unsigned cellinitial, const unsigned *beginendcell,
-         tint3 cellzero, const unsigned *dcell, const tdouble3 *pos, const tfloat3 *pspos, const tfloat4 *velrhop,
-         const word *code, const unsigned *idp, float &viscdt, float *ar) const {
+        (unsigned n, unsigned pinit, tint4 nc, int hdiv, unsigned cellinitial, unsigned cellfloat,
+         const unsigned *beginendcell, tint3 cellzero, const unsigned *dcell, const tdouble3 *pos,
+         const tfloat3 *pspos, const tfloat4 *velrhop, const word *code, const tpartid *idp, float &viscdt,
+         float *ar) const {
+    const bool ftp2 = (USE_FLOATING && cellinitial == cellfloat); //-Interaction with floating cells / Interaccion con celdas de floating.
     //-Initialize viscth to calculate max viscdt with OpenMP / Inicializa viscth para calcular visdt maximo con OpenMP.
     float viscth[MAXTHREADS_OMP * STRIDE_OMP];
     for (int th = 0; th < OmpThreads; th++)viscth[th * STRIDE_OMP] = 0;
     //-Inicia ejecucion con OpenMP.
-    const int pfin = int(pinit + n);
+    const llong pfin = llong(pinit + n);
 #ifdef _WITHOMP
-#pragma omp parallel for schedule (guided)
+#pragma omp parallel
 #endif
-    for (int p1 = int(pinit); p1 < pfin; p1++) {
+    {
+    const double tth = (SvForceStats ? omp_get_wtime() : 0);
+#ifdef _WITHOMP
+#pragma omp for schedule (guided) nowait
+#endif
+    for (llong p1 = llong(pinit); p1 < pfin; p1++) {
         float visc = 0, arp1 = 0;
 
         //-Load data of particle p1 / Carga datos de particula p1.
         const tfloat3 velp1 = TFloat3(velrhop[p1].x, velrhop[p1].y, velrhop[p1].z);
         const tfloat3 psposp1 = (psimple ? pspos[p1] : TFloat3(0));
         const tdouble3 posp1 = (psimple ? TDouble3(0) : pos[p1]);
+        const float hp1 = (Hvarc ? Hvarc[p1] : 0);
 
         //-Obtain limits of interaction / Obtiene limites de interaccion
         int cxini, cxfin, yini, yfin, zini, zfin;
@@ -782,38 +1004,39 @@ void JSphCpu::InteractionForcesBound
                 const unsigned pini = beginendcell[cxini + ymod];
                 const unsigned pfin = beginendcell[cxfin + ymod];
 
-                //-Interaction of boundary with type Fluid/Float / Interaccion de Bound con varias Fluid/Float.
+                //-Interaction of boundary with type Fluid or Float / Interaccion de Bound con varias Fluid o Float.
                 //----------------------------------------------
                 for (unsigned p2 = pini; p2 < pfin; p2++) {
                     const float drx = (psimple ? psposp1.x - pspos[p2].x : float(posp1.x - pos[p2].x));
                     const float dry = (psimple ? psposp1.y - pspos[p2].y : float(posp1.y - pos[p2].y));
                     const float drz = (psimple ? psposp1.z - pspos[p2].z : float(posp1.z - pos[p2].z));
                     const float rr2 = drx * drx + dry * dry + drz * drz;
-                    if (rr2 <= Fourh2 && rr2 >= ALMOSTZERO) {
+                    //-With splitting the pair uses hij=(hp1+hp2)/2 / Con splitting la pareja usa hij=(hp1+hp2)/2.
+                    const float hij = (Hvarc ? (hp1 + Hvarc[p2]) * 0.5f : H);
+                    const float fourh2 = (Hvarc ? 4.f * hij * hij : Fourh2);
+                    const float eta2 = (Hvarc ? 0.01f * hij * hij : Eta2);
+                    if (rr2 <= fourh2 && rr2 >= ALMOSTZERO) {
                         //-Wendland or Cubic Spline kernel.
                         float frx, fry, frz;
-                        if (tker == KERNEL_Wendland)GetKernel(rr2, drx, dry, drz, frx, fry, frz);
-                        else if (tker == KERNEL_Cubic)GetKernelCubic(rr2, drx, dry, drz, frx, fry, frz);
+                        if (tker == KERNEL_Wendland) {
+                            if (Hvarc)GetKernelHvar(rr2, drx, dry, drz, hij, frx, fry, frz);
+                            else GetKernel(rr2, drx, dry, drz, frx, fry, frz);
+                        } else if (tker == KERNEL_Cubic)GetKernelCubic(rr2, drx, dry, drz, frx, fry, frz);
 
                         //===== Get mass of particle p2  /  Obtiene masa de particula p2 =====
-                        float massp2 = MassFluid; //-Contains particle mass of incorrect fluid / Contiene masa de particula por defecto fluid.
-                        bool compute = true;      //-Deactivate when using DEM and/or bound-float / Se desactiva cuando se usa DEM y es bound-float.
-                        if (USE_FLOATING) {
-                            bool ftp2 = (CODE_GetType(code[p2]) == CODE_TYPE_FLOATING);
-                            if (ftp2)massp2 = FtObjs[CODE_GetTypeValue(code[p2])].massp;
-                            compute = !(USE_DEM &&
-                                        ftp2); //-Deactivate when using DEM and/or bound-float / Se desactiva cuando se usa DEM y es bound-float.
-                        }
+                        float massp2 = (Massc ? Massc[p2] : MassFluid); //-Contains particle mass of incorrect fluid / Contiene masa de particula por defecto fluid.
+                        if (ftp2)massp2 = FtObjs[CODE_GetTypeValue(code[p2])].massp;
+                        const bool compute = !(USE_DEM && ftp2); //-Deactivate when using DEM and/or bound-float / Se desactiva cuando se usa DEM y es bound-float.
 
                         if (compute) {
                             //-Density derivative
                             const float dvx = velp1.x - velrhop[p2].x, dvy = velp1.y - velrhop[p2].y, dvz =
                                     velp1.z - velrhop[p2].z;
-                            if (compute)arp1 += massp2 * (dvx * frx + dvy * fry + dvz * frz);
+                            arp1 += massp2 * (dvx * frx + dvy * fry + dvz * frz);
 
                             {//===== Viscosity =====
                                 const float dot = drx * dvx + dry * dvy + drz * dvz;
-                                const float dot_rr2 = dot / (rr2 + Eta2);
+                                const float dot_rr2 = dot / (rr2 + eta2);
                                 visc = max(dot_rr2, visc);
                             }
                         }
@@ -828,31 +1051,50 @@ void JSphCpu::InteractionForcesBound
             if (visc > viscth[th * STRIDE_OMP])viscth[th * STRIDE_OMP] = visc;
         }
     }
+    if (SvForceStats)ForceThTimes[MAXTHREADS_OMP + omp_get_thread_num()] += omp_get_wtime() - tth;
+    }
     //-Keep max value in viscdt / Guarda en viscdt el valor maximo.
     for (int th = 0; th < OmpThreads; th++)if (viscdt < viscth[th * STRIDE_OMP])viscdt = viscth[th * STRIDE_OMP];
 }
 
 //==============================================================================
-/// Realiza interaccion entre particulas: Fluid/Float-Fluid/Float or Fluid/Float-Bound
-/// Perform interaction between particles: Fluid/Float-Fluid/Float or Fluid/Float-Bound
+/// Realiza interaccion entre particulas: Fluid/Float-Fluid, Fluid/Float-Bound o
+/// Fluid/Float-Float segun sea cellinitial la primera celda de fluido, 0 o la
+/// primera celda de floating (cellfloat). Las floating van despues del fluido
+/// por lo que p1 es floating cuando p1>=beginendcell[cellfloat].
+/// Con plist las particulas p1 son plist[pini..pini+n) en lugar de pini..pini+n.
+/// Perform interaction between particles: Fluid/Float-Fluid, Fluid/Float-Bound
+/// or Fluid/Float-Float depending on whether cellinitial is the first fluid
+/// cell, 0 or the first floating cell (cellfloat). Floating particles are
+/// stored after the fluid so p1 is floating when p1>=beginendcell[cellfloat].
+/// With plist the particles p1 are plist[pini..pini+n) instead of pini..pini+n.
 //==============================================================================
 template<bool psimple, TpKernel tker, TpFtMode ftmode, bool lamsps, TpDeltaSph tdelta, bool shift>
 void JSphCpu::InteractionForcesFluid
-        (unsigned n, unsigned pinit, tint4 nc, int hdiv, unsigned cellinitial, float visco,
+        (unsigned n, unsigned pinit, tint4 nc, int hdiv, unsigned cellinitial, unsigned cellfloat, float visco,
          const unsigned *beginendcell, tint3 cellzero, const unsigned *dcell, const tsymatrix3f *tau,
          tsymatrix3f *gradvel, const tdouble3 *pos, const tfloat3 *pspos, const tfloat4 *velrhop, const word *code,
-         const unsigned *idp, const float *press, float &viscdt, float *ar, tfloat3 *ace, float *delta,
-         TpShifting tshifting, tfloat3 *shiftpos, float *shiftdetect) const {
+         const tpartid *idp, const float *press, float &viscdt, float *ar, tfloat3 *ace, float *delta,
+         TpShifting tshifting, tfloat3 *shiftpos, float *shiftdetect, const unsigned *plist) const {
     const bool boundp2 = (!cellinitial); //-Interaction with type boundary (Bound) /  Interaccion con Bound.
+    const bool ftp2 = (USE_FLOATING && cellinitial == cellfloat); //-Interaction with floating cells / Interaccion con celdas de floating.
+    const unsigned pftini = (USE_FLOATING ? beginendcell[cellfloat] : UINT_MAX); //-First floating particle / Primera particula floating.
     //-Initialize viscth to calculate viscdt maximo con OpenMP / Inicializa viscth para calcular visdt maximo con OpenMP.
     float viscth[MAXTHREADS_OMP * STRIDE_OMP];
     for (int th = 0; th < OmpThreads; th++)viscth[th * STRIDE_OMP] = 0;
     //-Initial execution with OpenMP / Inicia ejecucion con OpenMP.
-    const int pfin = int(pinit + n);
+    const llong pfin = llong(pinit + n);
 #ifdef _WITHOMP
-#pragma omp parallel for schedule (guided)
+#pragma omp parallel
 #endif
-    for (int p1 = int(pinit); p1 < pfin; p1++) {
+    {
+    JTraceScope trace(boundp2 ? "CF-ForcesFluid-Bound" : (ftp2 ? "CF-ForcesFluid-Float" : "CF-ForcesFluid"));
+    const double tth = (SvForceStats ? omp_get_wtime() : 0);
+#ifdef _WITHOMP
+#pragma omp for schedule (guided) nowait
+#endif
+    for (llong p = llong(pinit); p < pfin; p++) {
+        const unsigned p1 = (plist ? plist[p] : unsigned(p));
         float visc = 0, arp1 = 0, deltap1 = 0;
         tfloat3 acep1 = TFloat3(0);
         tsymatrix3f gradvelp1 = {0, 0, 0, 0, 0, 0};
@@ -863,7 +1105,7 @@ void JSphCpu::InteractionForcesFluid
         bool ftp1 = false;     //-Indicate if it is floating / Indica si es floating.
         float ftmassp1 = 1.f;  //-Contains floating particle mass or 1.0f if it is fluid / Contiene masa de particula floating o 1.0f si es fluid.
         if (USE_FLOATING) {
-            ftp1 = (CODE_GetType(code[p1]) == CODE_TYPE_FLOATING);
+            ftp1 = (p1 >= pftini);
             if (ftp1)ftmassp1 = FtObjs[CODE_GetTypeValue(code[p1])].massp;
             if (ftp1 && (tdelta == DELTA_Dynamic || tdelta == DELTA_DynamicExt))deltap1 = FLT_MAX;
             if (ftp1 && shift)
@@ -877,6 +1119,7 @@ void JSphCpu::InteractionForcesFluid
         const tdouble3 posp1 = (psimple ? TDouble3(0) : pos[p1]);
         const float pressp1 = press[p1];
         const tsymatrix3f taup1 = (lamsps ? tau[p1] : gradvelp1);
+        const float hp1 = (Hvarc ? Hvarc[p1] : 0);
 
         //-Obtain interaction limits / Obtiene limites de interaccion
         int cxini, cxfin, yini, yfin, zini, zfin;
@@ -891,26 +1134,30 @@ void JSphCpu::InteractionForcesFluid
                 const unsigned pini = beginendcell[cxini + ymod];
                 const unsigned pfin = beginendcell[cxfin + ymod];
 
-                //-Interaction of Fluid with type Fluid or Bound / Interaccion de Fluid con varias Fluid o Bound.
+                //-Interaction of Fluid with type Fluid, Bound or Float / Interaccion de Fluid con varias Fluid, Bound o Float.
                 //------------------------------------------------
                 for (unsigned p2 = pini; p2 < pfin; p2++) {
                     const float drx = (psimple ? psposp1.x - pspos[p2].x : float(posp1.x - pos[p2].x));
                     const float dry = (psimple ? psposp1.y - pspos[p2].y : float(posp1.y - pos[p2].y));
                     const float drz = (psimple ? psposp1.z - pspos[p2].z : float(posp1.z - pos[p2].z));
                     const float rr2 = drx * drx + dry * dry + drz * drz;
-                    if (rr2 <= Fourh2 && rr2 >= ALMOSTZERO) {
+                    //-With splitting the pair uses hij=(hp1+hp2)/2 / Con splitting la pareja usa hij=(hp1+hp2)/2.
+                    const float hij = (Hvarc ? (hp1 + Hvarc[p2]) * 0.5f : H);
+                    const float fourh2 = (Hvarc ? 4.f * hij * hij : Fourh2);
+                    const float eta2 = (Hvarc ? 0.01f * hij * hij : Eta2);
+                    if (rr2 <= fourh2 && rr2 >= ALMOSTZERO) {
                         //-Wendland or Cubic Spline kernel.
                         float frx, fry, frz;
-                        if (tker == KERNEL_Wendland)GetKernel(rr2, drx, dry, drz, frx, fry, frz);
-                        else if (tker == KERNEL_Cubic)GetKernelCubic(rr2, drx, dry, drz, frx, fry, frz);
+                        if (tker == KERNEL_Wendland) {
+                            if (Hvarc)GetKernelHvar(rr2, drx, dry, drz, hij, frx, fry, frz);
+                            else GetKernel(rr2, drx, dry, drz, frx, fry, frz);
+                        } else if (tker == KERNEL_Cubic)GetKernelCubic(rr2, drx, dry, drz, frx, fry, frz);
 
                         //===== Get mass of particle p2  /  Obtiene masa de particula p2 =====
-                        float massp2 = (boundp2 ? MassBound
-                                                : MassFluid); //-Contiene masa de particula segun sea bound o fluid.
-                        bool ftp2 = false;    //-Indicate if it is floating / Indica si es floating.
+                        float massp2 = (Massc ? Massc[p2] : (boundp2 ? MassBound
+                                                                     : MassFluid)); //-Contiene masa de particula segun sea bound o fluid.
                         bool compute = true;  //-Deactivate when using DEM and if it is of type float-float or float-bound /  Se desactiva cuando se usa DEM y es float-float o float-bound.
                         if (USE_FLOATING) {
-                            ftp2 = (CODE_GetType(code[p2]) == CODE_TYPE_FLOATING);
                             if (ftp2)massp2 = FtObjs[CODE_GetTypeValue(code[p2])].massp;
 #ifdef DELTA_HEAVYFLOATING
                             if (ftp2 && massp2 <= (MassFluid * 1.2f) &&
@@ -946,7 +1193,8 @@ void JSphCpu::InteractionForcesFluid
                         //-Density derivative (DeltaSPH Molteni)
                         if ((tdelta == DELTA_Dynamic || tdelta == DELTA_DynamicExt) && deltap1 != FLT_MAX) {
                             const float rhop1over2 = rhopp1 / velrhop[p2].w;
-                            const float visc_densi = Delta2H * cbar * (rhop1over2 - 1.f) / (rr2 + Eta2);
+                            const float delta2h = (Hvarc ? Delta2H * (hij / H) : Delta2H);
+                            const float visc_densi = delta2h * cbar * (rhop1over2 - 1.f) / (rr2 + eta2);
                             const float dot3 = (drx * frx + dry * fry + drz * frz);
                             const float delta = visc_densi * dot3 * massp2;
                             deltap1 = (boundp2 ? FLT_MAX : deltap1 + delta);
@@ -968,11 +1216,11 @@ void JSphCpu::InteractionForcesFluid
                         //===== Viscosity =====
                         if (compute) {
                             const float dot = drx * dvx + dry * dvy + drz * dvz;
-                            const float dot_rr2 = dot / (rr2 + Eta2);
+                            const float dot_rr2 = dot / (rr2 + eta2);
                             visc = max(dot_rr2, visc);
                             if (!lamsps) {//-Artificial viscosity
                                 if (dot < 0) {
-                                    const float amubar = H * dot_rr2;  //amubar=CTE.h*dot/(rr2+CTE.eta2);
+                                    const float amubar = hij * dot_rr2;  //amubar=CTE.h*dot/(rr2+CTE.eta2);
                                     const float robar = (rhopp1 + velrhop[p2].w) * 0.5f;
                                     const float pi_visc = (-visco * cbar * amubar / robar) * massp2 * ftmassp1;
                                     acep1.x -= pi_visc * frx;
@@ -982,7 +1230,7 @@ void JSphCpu::InteractionForcesFluid
                             } else {//-Laminar+SPS viscosity
                                 {//-Laminar contribution.
                                     const float robar2 = (rhopp1 + velrhop[p2].w);
-                                    const float temp = 4.f * visco / ((rr2 + Eta2) *
+                                    const float temp = 4.f * visco / ((rr2 + eta2) *
                                                                       robar2);  //-Simplification of / Simplificacion de: temp=2.0f*visco/((rr2+CTE.eta2)*robar); robar=(rhopp1+velrhop2.w)*0.5f;
                                     const float vtemp = massp2 * temp * (drx * frx + dry * fry + drz * frz);
                                     acep1.x += vtemp * dvx;
@@ -1050,19 +1298,23 @@ void JSphCpu::InteractionForcesFluid
             }
         }
     }
+    if (SvForceStats)ForceThTimes[omp_get_thread_num()] += omp_get_wtime() - tth;
+    }
     //-Keep max value in viscdt / Guarda en viscdt el valor maximo.
     for (int th = 0; th < OmpThreads; th++)if (viscdt < viscth[th * STRIDE_OMP])viscdt = viscth[th * STRIDE_OMP];
 }
 
 //==============================================================================
 /// Realiza interaccion DEM entre particulas Floating-Bound & Floating-Floating //(DEM)
+/// Solo recorre las celdas de contorno y de floating, sin las de fluido.
 /// Perform DEM interaction between particles Floating-Bound & Floating-Floating //(DEM)
+/// Only the boundary and floating cells are searched, not the fluid ones.
 //==============================================================================
 template<bool psimple>
 void JSphCpu::InteractionForcesDEM
-        (unsigned nfloat, tint4 nc, int hdiv, unsigned cellfluid, const unsigned *beginendcell, tint3 cellzero,
+        (unsigned nfloat, tint4 nc, int hdiv, unsigned cellfloat, const unsigned *beginendcell, tint3 cellzero,
          const unsigned *dcell, const unsigned *ftridp, const StDemData *demobjs, const tdouble3 *pos,
-         const tfloat3 *pspos, const tfloat4 *velrhop, const word *code, const unsigned *idp, float &viscdt,
+         const tfloat3 *pspos, const tfloat4 *velrhop, const word *code, const tpartid *idp, float &viscdt,
          tfloat3 *ace) const {
     //-Initialize demdtth to calculate max demdt with OpenMP / Inicializa demdtth para calcular demdt maximo con OpenMP.
     float demdtth[MAXTHREADS_OMP * STRIDE_OMP];
@@ -1091,8 +1343,8 @@ void JSphCpu::InteractionForcesDEM
             int cxini, cxfin, yini, yfin, zini, zfin;
             GetInteractionCells(dcell[p1], hdiv, nc, cellzero, cxini, cxfin, yini, yfin, zini, zfin);
 
-            //-Search for neighbours in adjacent cells (first bound and then fluid+floating) / Busqueda de vecinos en celdas adyacentes (primero bound y despues fluid+floating).
-            for (unsigned cellinitial = 0; cellinitial <= cellfluid; cellinitial += cellfluid) {
+            //-Search for neighbours in adjacent cells (first bound and then floating) / Busqueda de vecinos en celdas adyacentes (primero bound y despues floating).
+            for (unsigned cellinitial = 0; cellinitial <= cellfloat; cellinitial += cellfloat) {
                 for (int z = zini; z < zfin; z++) {
                     const int zmod = (nc.w) * z +
                                      cellinitial; //-Sum from start of fluid or boundary cells / Le suma donde empiezan las celdas de fluido o bound.
@@ -1101,10 +1353,10 @@ void JSphCpu::InteractionForcesDEM
                         const unsigned pini = beginendcell[cxini + ymod];
                         const unsigned pfin = beginendcell[cxfin + ymod];
 
-                        //-Interaction of Floating Object particles with type Fluid or Bound / Interaccion de Floating con varias Fluid o Bound.
+                        //-Interaction of Floating Object particles with type Floating or Bound / Interaccion de Floating con varias Floating o Bound.
                         //------------------------------------------------
                         for (unsigned p2 = pini; p2 < pfin; p2++)
-                            if (CODE_GetType(code[p2]) != CODE_TYPE_FLUID && tavp1 != CODE_GetTypeAndValue(code[p2])) {
+                            if (tavp1 != CODE_GetTypeAndValue(code[p2])) {
                                 const float drx = (psimple ? psposp1.x - pspos[p2].x : float(posp1.x - pos[p2].x));
                                 const float dry = (psimple ? psposp1.y - pspos[p2].y : float(posp1.y - pos[p2].y));
                                 const float drz = (psimple ? psposp1.z - pspos[p2].z : float(posp1.z - pos[p2].z));
@@ -1188,11 +1440,11 @@ void JSphCpu::InteractionForcesDEM
 //==============================================================================
 void JSphCpu::ComputeSpsTau(unsigned n, unsigned pini, const tfloat4 *velrhop, const tsymatrix3f *gradvel,
                             tsymatrix3f *tau) const {
-    const int pfin = int(pini + n);
+    const llong pfin = llong(pini + n);
 #ifdef _WITHOMP
 #pragma omp parallel for schedule (static)
 #endif
-    for (int p = int(pini); p < pfin; p++) {
+    for (llong p = llong(pini); p < pfin; p++) {
         const tsymatrix3f gradvel = SpsGradvelc[p];
         const float pow1 = gradvel.xx * gradvel.xx + gradvel.yy * gradvel.yy + gradvel.zz * gradvel.zz;
         const float prr = pow1 + pow1 + gradvel.xy * gradvel.xy + gradvel.xz * gradvel.xz + gradvel.yz * gradvel.yz;
@@ -1212,6 +1464,244 @@ void JSphCpu::ComputeSpsTau(unsigned n, unsigned pini, const tfloat4 *velrhop, c
     }
 }
 
+//==============================================================================
+/// Realiza la interaccion de las particulas de fluido y floating [pini,pini+n)
+/// con las celdas de fluido, contorno y floating. Sin plist las particulas de
+/// fluido interaccionan con fluido y contorno con el codigo sin floatings
+/// (FTMODE_None) y solo la interaccion con floatings y la de las floatings
+/// usan ftmode.
+/// Performs the interaction of the fluid and floating particles [pini,pini+n)
+/// with the fluid, boundary and floating cells. Without plist the fluid
+/// particles interact with fluid and boundary using the code without floating
+/// bodies (FTMODE_None) and only the interaction with floating particles and
+/// that of the floating particles use ftmode.
+//==============================================================================
+template<bool psimple, TpKernel tker, TpFtMode ftmode, bool lamsps, TpDeltaSph tdelta, bool shift>
+void JSphCpu::InteractionForcesFluidAll
+        (unsigned n, unsigned pini, tint4 nc, int hdiv, unsigned cellfluid, unsigned cellfloat,
+         const unsigned *beginendcell, tint3 cellzero, const unsigned *dcell, const tsymatrix3f *tau,
+         tsymatrix3f *gradvel, const tdouble3 *pos, const tfloat3 *pspos, const tfloat4 *velrhop, const word *code,
+         const tpartid *idp, const float *press, float &viscdt, float *ar, tfloat3 *ace, float *delta,
+         TpShifting tshifting, tfloat3 *shiftpos, float *shiftdetect, const unsigned *plist) const {
+    bool ftonly = false; //-All the particles p1 are floating / Todas las particulas p1 son floating.
+    if (USE_FLOATING && !plist) {
+        //-Fluid particles before the first floating one / Particulas de fluido antes de la primera floating.
+        const unsigned pftini = min(max(beginendcell[cellfloat], pini), pini + n);
+        const unsigned nfluid = pftini - pini;
+        if (nfluid) {
+            InteractionForcesFluidAll<psimple, tker, FTMODE_None, lamsps, tdelta, shift>(nfluid, pini, nc, hdiv,
+                                                                                        cellfluid, cellfloat,
+                                                                                        beginendcell, cellzero, dcell,
+                                                                                        tau, gradvel, pos, pspos,
+                                                                                        velrhop, code, idp, press,
+                                                                                        viscdt, ar, ace, delta,
+                                                                                        tshifting, shiftpos,
+                                                                                        shiftdetect);
+            //-Interaction Fluid-Float / Interaccion Fluid-Float
+            InteractionForcesFluid<psimple, tker, ftmode, lamsps, tdelta, shift>(nfluid, pini, nc, hdiv, cellfloat,
+                                                                                 cellfloat, Visco, beginendcell,
+                                                                                 cellzero, dcell, tau, gradvel, pos,
+                                                                                 pspos, velrhop, code, idp, press,
+                                                                                 viscdt, ar, ace, delta, tshifting,
+                                                                                 shiftpos, shiftdetect);
+        }
+        n -= nfluid;
+        pini = pftini;
+        ftonly = true;
+        if (!n)return;
+    }
+    //-Interaction Fluid-Fluid / Interaccion Fluid-Fluid
+    InteractionForcesFluid<psimple, tker, ftmode, lamsps, tdelta, shift>(n, pini, nc, hdiv, cellfluid, cellfloat, Visco,
+                                                                         beginendcell, cellzero, dcell, tau, gradvel,
+                                                                         pos, pspos, velrhop, code, idp, press, viscdt,
+                                                                         ar, ace, delta, tshifting, shiftpos,
+                                                                         shiftdetect, plist);
+    //-With DEM the floating particles interact with boundary and floating ones in InteractionForcesDEM().
+    //-Con DEM las floating interaccionan con contorno y floatings en InteractionForcesDEM().
+    if (!(USE_DEM && ftonly)) {
+        //-Interaction Fluid-Bound / Interaccion Fluid-Bound
+        InteractionForcesFluid<psimple, tker, ftmode, lamsps, tdelta, shift>(n, pini, nc, hdiv, 0, cellfloat,
+                                                                             Visco * ViscoBoundFactor, beginendcell,
+                                                                             cellzero, dcell, tau, gradvel, pos, pspos,
+                                                                             velrhop, code, idp, press, viscdt, ar,
+                                                                             ace, delta, tshifting, shiftpos,
+                                                                             shiftdetect, plist);
+        //-Interaction Fluid-Float / Interaccion Fluid-Float
+        if (USE_FLOATING)
+            InteractionForcesFluid<psimple, tker, ftmode, lamsps, tdelta, shift>(n, pini, nc, hdiv, cellfloat,
+                                                                                 cellfloat, Visco, beginendcell,
+                                                                                 cellzero, dcell, tau, gradvel, pos,
+                                                                                 pspos, velrhop, code, idp, press,
+                                                                                 viscdt, ar, ace, delta, tshifting,
+                                                                                 shiftpos, shiftdetect, plist);
+    }
+}
+
+//==============================================================================
+/// Realiza la interaccion como un grafo de tareas sobre bloques de particulas
+/// consecutivas, que son bloques espaciales por estar ordenadas en celdas. Cada
+/// tarea de fluido calcula Fluid-Fluid, Fluid-Bound, Fluid-Float y DEM de su
+/// bloque y cada tarea de contorno Bound-Fluid y Bound-Float. Con Laminar+SPS
+/// el Tau de un bloque empieza en cuanto terminan los bloques de fluido que lo
+/// leen (celdas vecinas) en lugar de esperar a toda la interaccion.
+/// Performs the interaction as a task graph over blocks of consecutive
+/// particles, which are spatial blocks since they are sorted in cells. Each
+/// fluid task computes Fluid-Fluid, Fluid-Bound, Fluid-Float and DEM of its
+/// block and each boundary task Bound-Fluid and Bound-Float. With Laminar+SPS
+/// the Tau of a block starts as soon as the fluid blocks that read it
+/// (neighbour cells) finish instead of waiting for the whole interaction.
+//==============================================================================
+template<bool psimple, TpKernel tker, TpFtMode ftmode, bool lamsps, TpDeltaSph tdelta, bool shift>
+void JSphCpu::Interaction_ForcesTasks
+        (unsigned np, unsigned npb, unsigned npbok, tint4 nc, int hdiv, unsigned cellfluid, unsigned cellfloat,
+         const unsigned *begincell, tint3 cellzero, const unsigned *dcell, const tdouble3 *pos, const tfloat3 *pspos,
+         const tfloat4 *velrhop, const word *code, const tpartid *idp, const float *press, float &viscdt, float *ar,
+         tfloat3 *ace, float *delta, tsymatrix3f *spstau, tsymatrix3f *spsgradvel, TpShifting tshifting,
+         tfloat3 *shiftpos, float *shiftdetect) const {
+    const unsigned bsize = TaskGraph;
+    const unsigned npf = np - npb;
+    const unsigned nbf = (npf + bsize - 1) / bsize, nbb = (npbok + bsize - 1) / bsize;
+    std::vector<float> viscdtb(nbf + nbb, 0);
+
+    //-Floating particles of each fluid block for DEM / Particulas floating de cada bloque de fluido para DEM.
+    std::vector<unsigned> ftbeg, ftlist;
+    if (USE_DEM) {
+        ftbeg.assign(nbf + 1, 0);
+        ftlist.resize(CaseNfloat + 1);
+        for (unsigned cf = 0; cf < CaseNfloat; cf++) {
+            const unsigned p1 = FtRidp[cf];
+            if (p1 >= npb && p1 < np)ftbeg[(p1 - npb) / bsize + 1]++;
+        }
+        for (unsigned b = 0; b < nbf; b++)ftbeg[b + 1] += ftbeg[b];
+        std::vector<unsigned> ftnext(ftbeg.begin(), ftbeg.end());
+        for (unsigned cf = 0; cf < CaseNfloat; cf++) {
+            const unsigned p1 = FtRidp[cf];
+            if (p1 >= npb && p1 < np)ftlist[ftnext[(p1 - npb) / bsize]++] = p1;
+        }
+    }
+
+    //-Con Laminar+SPS, bloques cuyo Tau espera a cada bloque de fluido (taubeg/taulist) y numero de bloques que
+    // faltan para cada Tau (taupending). El Tau del fluido lo leen el fluido [jini,jend) y las floating [kini,kend)
+    // de las celdas vecinas y el de las floating solo su propio bloque.
+    //-With Laminar+SPS, blocks whose Tau waits for each fluid block (taubeg/taulist) and number of blocks left
+    // for each Tau (taupending). The Tau of the fluid is read by the fluid [jini,jend) and the floating particles
+    // [kini,kend) of the neighbour cells and that of the floating particles only by their own block.
+    std::vector<unsigned> taubeg, taulist;
+    std::vector<int> taupending(nbf + 1, 0);
+    if (lamsps) {
+        //-Maximum distance between neighbour cells in the sorted order / Distancia maxima entre celdas vecinas en el orden de las celdas.
+        const int dcel = hdiv * (nc.w + nc.x + 1), nct = nc.w * nc.z;
+        const unsigned pftini = (USE_FLOATING ? begincell[cellfloat] : np);
+        std::vector<unsigned> jini(nbf), jend(nbf), kini(nbf, 0), kend(nbf, 0);
+        taubeg.assign(nbf + 1, 0);
+        for (unsigned t = 0; t < nbf; t++) {
+            const unsigned pini = npb + t * bsize, pfin = min(min(pini + bsize, np), pftini);
+            if (pini < pfin) {
+                const unsigned rc0 = dcell[pini], rc1 = dcell[pfin - 1];
+                const int c0 = int(PC__Cellx(DomCellCode, rc0)) - cellzero.x + (int(PC__Celly(DomCellCode, rc0)) -
+                        cellzero.y) * nc.x + (int(PC__Cellz(DomCellCode, rc0)) - cellzero.z) * nc.w;
+                const int c1 = int(PC__Cellx(DomCellCode, rc1)) - cellzero.x + (int(PC__Celly(DomCellCode, rc1)) -
+                        cellzero.y) * nc.x + (int(PC__Cellz(DomCellCode, rc1)) - cellzero.z) * nc.w;
+                const unsigned qini = begincell[cellfluid + max(c0 - dcel, 0)];
+                const unsigned qfin = begincell[cellfluid + min(c1 + dcel + 1, nct)];
+                jini[t] = (qini - npb) / bsize;
+                jend[t] = (qfin - 1 - npb) / bsize + 1;
+                if (USE_FLOATING) {
+                    const unsigned fini = begincell[cellfloat + max(c0 - dcel, 0)];
+                    const unsigned ffin = begincell[cellfloat + min(c1 + dcel + 1, nct)];
+                    if (fini < ffin) {
+                        kini[t] = max((fini - npb) / bsize, jend[t]);
+                        kend[t] = max((ffin - 1 - npb) / bsize + 1, kini[t]);
+                    }
+                }
+            } else {
+                jini[t] = t;
+                jend[t] = t + 1;
+            }
+            taupending[t] = int(jend[t] - jini[t] + kend[t] - kini[t]);
+            for (unsigned j = jini[t]; j < jend[t]; j++)taubeg[j + 1]++;
+            for (unsigned j = kini[t]; j < kend[t]; j++)taubeg[j + 1]++;
+        }
+        for (unsigned j = 0; j < nbf; j++)taubeg[j + 1] += taubeg[j];
+        taulist.resize(taubeg[nbf] + 1);
+        std::vector<unsigned> taunext(taubeg.begin(), taubeg.end());
+        for (unsigned t = 0; t < nbf; t++) {
+            for (unsigned j = jini[t]; j < jend[t]; j++)taulist[taunext[j]++] = t;
+            for (unsigned j = kini[t]; j < kend[t]; j++)taulist[taunext[j]++] = t;
+        }
+    }
+    int *pending = &taupending[0];
+
+    //-Las tareas usan un hilo en los kernels, que abren regiones paralelas anidadas inactivas.
+    //-The tasks use one thread in the kernels, which open inactive nested parallel regions.
+#ifdef _WITHOMP
+    const int maxlevels = omp_get_max_active_levels();
+    omp_set_max_active_levels(1);
+#pragma omp parallel
+#pragma omp single
+#endif
+    {
+        for (unsigned b = 0; b < nbf; b++) {
+#ifdef _WITHOMP
+#pragma omp task firstprivate(b)
+#endif
+            {
+                const unsigned pini = npb + b * bsize, n = min(bsize, np - pini);
+                float &vdt = viscdtb[b];
+                InteractionForcesFluidAll<psimple, tker, ftmode, lamsps, tdelta, shift>(n, pini, nc, hdiv, cellfluid,
+                                                                                        cellfloat, begincell, cellzero,
+                                                                                        dcell, spstau, spsgradvel, pos,
+                                                                                        pspos, velrhop, code, idp,
+                                                                                        press, vdt, ar, ace, delta,
+                                                                                        tshifting, shiftpos,
+                                                                                        shiftdetect);
+                if (USE_DEM && ftbeg[b + 1] > ftbeg[b])
+                    InteractionForcesDEM<psimple>(ftbeg[b + 1] - ftbeg[b], nc, hdiv, cellfloat, begincell, cellzero,
+                                                  dcell, &ftlist[ftbeg[b]], DemObjs, pos, pspos, velrhop, code, idp,
+                                                  vdt, ace);
+                //-Launch the Tau of the blocks that only waited for this one / Lanza el Tau de los bloques que solo esperaban a este.
+                if (lamsps)
+                    for (unsigned c = taubeg[b]; c < taubeg[b + 1]; c++) {
+                        const unsigned t = taulist[c];
+                        int left;
+#ifdef _WITHOMP
+#pragma omp atomic capture
+#endif
+                        left = --pending[t];
+                        if (!left) {
+#ifdef _WITHOMP
+#pragma omp task firstprivate(t)
+#endif
+                            {
+                                const unsigned tini = npb + t * bsize;
+                                ComputeSpsTau(min(bsize, np - tini), tini, velrhop, spsgradvel, spstau);
+                            }
+                        }
+                    }
+            }
+        }
+        for (unsigned b = 0; b < nbb; b++) {
+#ifdef _WITHOMP
+#pragma omp task firstprivate(b)
+#endif
+            {
+                const unsigned pini = b * bsize, n = min(bsize, npbok - pini);
+                InteractionForcesBound<psimple, tker, FTMODE_None>(n, pini, nc, hdiv, cellfluid, cellfloat, begincell,
+                                                                   cellzero, dcell, pos, pspos, velrhop, code, idp,
+                                                                   viscdtb[nbf + b], ar);
+                if (USE_FLOATING && !USE_DEM)
+                    InteractionForcesBound<psimple, tker, ftmode>(n, pini, nc, hdiv, cellfloat, cellfloat, begincell,
+                                                                  cellzero, dcell, pos, pspos, velrhop, code, idp,
+                                                                  viscdtb[nbf + b], ar);
+            }
+        }
+    }
+#ifdef _WITHOMP
+    omp_set_max_active_levels(maxlevels);
+#endif
+    //-Keep max value in viscdt / Guarda en viscdt el valor maximo.
+    for (unsigned b = 0; b < nbf + nbb; b++)if (viscdt < viscdtb[b])viscdt = viscdtb[b];
+}
 
 //==============================================================================
 /// Seleccion de parametros template para Interaction_ForcesFluidT.
@@ -1221,33 +1711,42 @@ template<bool psimple, TpKernel tker, TpFtMode ftmode, bool lamsps, TpDeltaSph t
 void JSphCpu::Interaction_ForcesT
         (unsigned np, unsigned npb, unsigned npbok, tuint3 ncells, const unsigned *begincell, tuint3 cellmin,
          const unsigned *dcell, const tdouble3 *pos, const tfloat3 *pspos, const tfloat4 *velrhop, const word *code,
-         const unsigned *idp, const float *press, float &viscdt, float *ar, tfloat3 *ace, float *delta,
+         const tpartid *idp, const float *press, float &viscdt, float *ar, tfloat3 *ace, float *delta,
          tsymatrix3f *spstau, tsymatrix3f *spsgradvel, TpShifting tshifting, tfloat3 *shiftpos,
          float *shiftdetect) const {
     const unsigned npf = np - npb;
     const tint4 nc = TInt4(int(ncells.x), int(ncells.y), int(ncells.z), int(ncells.x * ncells.y));
     const tint3 cellzero = TInt3(cellmin.x, cellmin.y, cellmin.z);
     const unsigned cellfluid = nc.w * nc.z + 1;
+    const unsigned cellfloat = cellfluid + nc.w * nc.z; //-Only with floating bodies / Solo con floatings.
     const int hdiv = (CellMode == CELLMODE_H ? 2 : 1);
 
+    //-Interaction as a task graph over blocks of particles / Interaccion como grafo de tareas sobre bloques de particulas.
+    if (TaskGraph) {
+        Interaction_ForcesTasks<psimple, tker, ftmode, lamsps, tdelta, shift>(np, npb, npbok, nc, hdiv, cellfluid,
+                                                                              cellfloat, begincell, cellzero, dcell,
+                                                                              pos, pspos, velrhop, code, idp, press,
+                                                                              viscdt, ar, ace, delta, spstau,
+                                                                              spsgradvel, tshifting, shiftpos,
+                                                                              shiftdetect);
+        return;
+    }
+
     if (npf) {
-        //-Interaction Fluid-Fluid / Interaccion Fluid-Fluid
-        InteractionForcesFluid<psimple, tker, ftmode, lamsps, tdelta, shift>(npf, npb, nc, hdiv, cellfluid, Visco,
-                                                                             begincell, cellzero, dcell, spstau,
-                                                                             spsgradvel, pos, pspos, velrhop, code, idp,
-                                                                             press, viscdt, ar, ace, delta, tshifting,
-                                                                             shiftpos, shiftdetect);
-        //-Interaction Fluid-Bound / Interaccion Fluid-Bound
-        InteractionForcesFluid<psimple, tker, ftmode, lamsps, tdelta, shift>(npf, npb, nc, hdiv, 0,
-                                                                             Visco * ViscoBoundFactor, begincell,
-                                                                             cellzero, dcell, spstau, spsgradvel, pos,
-                                                                             pspos, velrhop, code, idp, press, viscdt,
-                                                                             ar, ace, delta, tshifting, shiftpos,
-                                                                             shiftdetect);
+        //-With -sleep only the particles of the active cells compute their forces / Con -sleep solo calculan fuerzas las particulas de las celdas activas.
+        const unsigned *plist = (SleepNpActive != UINT_MAX ? SleepListc : NULL);
+        const unsigned n1 = (plist ? SleepNpActive : npf), pini1 = (plist ? 0 : npb);
+        //-Interaction Fluid-Fluid, Fluid-Bound and Fluid-Float / Interaccion Fluid-Fluid, Fluid-Bound y Fluid-Float
+        InteractionForcesFluidAll<psimple, tker, ftmode, lamsps, tdelta, shift>(n1, pini1, nc, hdiv, cellfluid,
+                                                                                cellfloat, begincell, cellzero, dcell,
+                                                                                spstau, spsgradvel, pos, pspos, velrhop,
+                                                                                code, idp, press, viscdt, ar, ace,
+                                                                                delta, tshifting, shiftpos,
+                                                                                shiftdetect, plist);
 
         //-Interaction of DEM Floating-Bound & Floating-Floating / Interaccion DEM Floating-Bound & Floating-Floating //(DEM)
         if (USE_DEM)
-            InteractionForcesDEM<psimple>(CaseNfloat, nc, hdiv, cellfluid, begincell, cellzero, dcell, FtRidp, DemObjs,
+            InteractionForcesDEM<psimple>(CaseNfloat, nc, hdiv, cellfloat, begincell, cellzero, dcell, FtRidp, DemObjs,
                                           pos, pspos, velrhop, code, idp, viscdt, ace);
 
         //-Computes tau for Laminar+SPS.
@@ -1255,8 +1754,13 @@ void JSphCpu::Interaction_ForcesT
     }
     if (npbok) {
         //-Interaction of type Bound-Fluid / Interaccion Bound-Fluid
-        InteractionForcesBound<psimple, tker, ftmode>(npbok, 0, nc, hdiv, cellfluid, begincell, cellzero, dcell, pos,
-                                                      pspos, velrhop, code, idp, viscdt, ar);
+        InteractionForcesBound<psimple, tker, FTMODE_None>(npbok, 0, nc, hdiv, cellfluid, cellfloat, begincell,
+                                                           cellzero, dcell, pos, pspos, velrhop, code, idp, viscdt,
+                                                           ar);
+        //-Interaction of type Bound-Float (not with DEM) / Interaccion Bound-Float (no con DEM)
+        if (USE_FLOATING && !USE_DEM)
+            InteractionForcesBound<psimple, tker, ftmode>(npbok, 0, nc, hdiv, cellfloat, cellfloat, begincell,
+                                                          cellzero, dcell, pos, pspos, velrhop, code, idp, viscdt, ar);
     }
 }
 
@@ -1266,7 +1770,7 @@ void JSphCpu::Interaction_ForcesT
 //==============================================================================
 void JSphCpu::Interaction_Forces(unsigned np, unsigned npb, unsigned npbok, tuint3 ncells, const unsigned *begincell,
                                  tuint3 cellmin, const unsigned *dcell, const tdouble3 *pos, const tfloat4 *velrhop,
-                                 const unsigned *idp, const word *code, const float *press, float &viscdt, float *ar,
+                                 const tpartid *idp, const word *code, const float *press, float &viscdt, float *ar,
                                  tfloat3 *ace, float *delta, tsymatrix3f *spstau, tsymatrix3f *spsgradvel,
                                  tfloat3 *shiftpos, float *shiftdetect) const {
     tfloat3 *pspos = NULL;
@@ -2130,7 +2634,7 @@ void JSphCpu::Interaction_Forces(unsigned np, unsigned npb, unsigned npbok, tuin
 void
 JSphCpu::InteractionSimple_Forces(unsigned np, unsigned npb, unsigned npbok, tuint3 ncells, const unsigned *begincell,
                                   tuint3 cellmin, const unsigned *dcell, const tfloat3 *pspos, const tfloat4 *velrhop,
-                                  const unsigned *idp, const word *code, const float *press, float &viscdt, float *ar,
+                                  const tpartid *idp, const word *code, const float *press, float &viscdt, float *ar,
                                   tfloat3 *ace, float *delta, tsymatrix3f *spstau, tsymatrix3f *spsgradvel,
                                   tfloat3 *shiftpos, float *shiftdetect) const {
     tdouble3 *pos = NULL;
@@ -2994,14 +3498,14 @@ JSphCpu::InteractionSimple_Forces(unsigned np, unsigned npb, unsigned npbok, tui
 /// Actualiza pos, dcell y code a partir del desplazamiento indicado.
 /// El valor de outrhop indica si esta fuera de los limites de densidad.
 /// Comprueba los limites en funcion de MapRealPosMin y MapRealSize esto es valido
-/// para single-cpu pq DomRealPos y MapRealPos son iguales. Para multi-cpu seria
-/// necesario marcar las particulas q salgan del dominio sin salir del mapa.
+/// para single-cpu pq DomRealPos y MapRealPos son iguales. Con MPI se tratan
+/// ademas las particulas q salen del dominio local sin salir del mapa.
 ///
 /// Update pos, dcell and code to move with indicated displacement.
 /// The value of outrhop indicates is it outside of the density limits.
 /// Check the limits in funcion of MapRealPosMin & MapRealSize that this is valid
-/// for single-cpu because DomRealPos & MapRealPos are equal. For multi-cpu it will be
-/// necessary to mark the particles that leave the domain without leaving the map.
+/// for single-cpu because DomRealPos & MapRealPos are equal. With MPI the particles
+/// that leave the local domain without leaving the map are also handled.
 //==============================================================================
 void JSphCpu::UpdatePos(tdouble3 rpos, double movx, double movy, double movz, bool outrhop, unsigned p, tdouble3 *pos,
                         unsigned *cell, word *code) const {
@@ -3067,18 +3571,41 @@ void JSphCpu::UpdatePos(tdouble3 rpos, double movx, double movy, double movz, bo
     //-Keep cell and check / Guarda celda y check.
     if (outrhop || outmove || out) {//-Particle out
         word rcode = code[p];
-        if (outrhop)rcode = CODE_SetOutRhop(rcode);
+        //-Con MPI las copias de halo solo se ignoran, la particula original se excluye en su proceso.
+        //-With MPI halo copies are only ignored, the original particle is excluded in its own process.
+        if (WithMpi && CODE_GetSpecialValue(rcode) == CODE_PERIODIC)rcode = CODE_SetOutIgnore(rcode);
+        else if (outrhop)rcode = CODE_SetOutRhop(rcode);
         else if (out)rcode = CODE_SetOutPos(rcode);
         else rcode = CODE_SetOutMove(rcode);
         code[p] = rcode;
         cell[p] = 0xFFFFFFFF;
     } else {//-Particle in
-        if (PeriActive) {
+        if (PeriActive || WithMpi) {
             dx = rpos.x - DomPosMin.x;
             dy = rpos.y - DomPosMin.y;
             dz = rpos.z - DomPosMin.z;
         }
+        if (WithMpi && (dx < 0 || dy < 0 || dz < 0 || dx >= DomPosMax.x - DomPosMin.x || dy >= DomPosMax.y - DomPosMin.y ||
+                        dz >= DomPosMax.z - DomPosMin.z)) {
+            //-La particula sale del dominio local sin salir del mapa: las copias de halo se ignoran y las
+            // particulas propias se asignan a la celda del borde hasta que migran en el siguiente divide.
+            //-The particle leaves the local domain without leaving the map: halo copies are ignored and own
+            // particles are assigned to the border cell until they migrate in the next divide.
+            if (CODE_GetSpecialValue(code[p]) == CODE_PERIODIC) {
+                code[p] = CODE_SetOutIgnore(code[p]);
+                cell[p] = 0xFFFFFFFF;
+                return;
+            }
+            dx = max(dx, 0.);
+            dy = max(dy, 0.);
+            dz = max(dz, 0.);
+        }
         unsigned cx = unsigned(dx / Scell), cy = unsigned(dy / Scell), cz = unsigned(dz / Scell);
+        if (WithMpi) {
+            cx = min(cx, DomCells.x - 1);
+            cy = min(cy, DomCells.y - 1);
+            cz = min(cz, DomCells.z - 1);
+        }
         cell[p] = PC__Cell(DomCellCode, cx, cy, cz);
     }
 }
@@ -3092,11 +3619,11 @@ void
 JSphCpu::ComputeVerletVarsFluid(const tfloat4 *velrhop1, const tfloat4 *velrhop2, double dt, double dt2, tdouble3 *pos,
                                 unsigned *dcell, word *code, tfloat4 *velrhopnew) const {
     const double dt205 = 0.5 * dt * dt;
-    const int pini = int(Npb), pfin = int(Np), npf = int(Np - Npb);
+    const llong pini = llong(Npb), pfin = llong(Np), npf = llong(Np - Npb);
 #ifdef _WITHOMP
 #pragma omp parallel for schedule (static) if(npf>LIMIT_COMPUTESTEP_OMP)
 #endif
-    for (int p = pini; p < pfin; p++) {
+    for (llong p = pini; p < pfin; p++) {
         //-Calculate density / Calcula densidad.
         const float rhopnew = float(double(velrhop2[p].w) + dt2 * Arc[p]);
         if (!WithFloating || CODE_GetType(code[p]) == CODE_TYPE_FLUID) {//-Fluid Particles / Particulas: Fluid
@@ -3131,11 +3658,11 @@ JSphCpu::ComputeVerletVarsFluid(const tfloat4 *velrhop1, const tfloat4 *velrhop2
 /// (fixed+moving, no floating).
 //==============================================================================
 void JSphCpu::ComputeVelrhopBound(const tfloat4 *velrhopold, double armul, tfloat4 *velrhopnew) const {
-    const int npb = int(Npb);
+    const llong npb = llong(Npb);
 #ifdef _WITHOMP
 #pragma omp parallel for schedule (static) if(npb>LIMIT_COMPUTESTEP_OMP)
 #endif
-    for (int p = 0; p < npb; p++) {
+    for (llong p = 0; p < npb; p++) {
         const float rhopnew = float(double(velrhopold[p].w) + armul * Arc[p]);
         velrhopnew[p] = TFloat4(0, 0, 0, (rhopnew < RhopZero ? RhopZero
                                                              : rhopnew));//-Avoid fluid particles being absorved by boundary ones / Evita q las boundary absorvan a las fluidas.
@@ -3188,11 +3715,11 @@ void JSphCpu::ComputeSymplecticPreT(double dt) {
     const double dt05 = dt * .5;
 
     //-Calculate new density for boundary and copy velocity / Calcula nueva densidad para el contorno y copia velocidad.
-    const int npb = int(Npb);
+    const llong npb = llong(Npb);
 #ifdef _WITHOMP
 #pragma omp parallel for schedule (static) if(npb>LIMIT_COMPUTESTEP_OMP)
 #endif
-    for (int p = 0; p < npb; p++) {
+    for (llong p = 0; p < npb; p++) {
         const tfloat4 vr = VelrhopPrec[p];
         const float rhopnew = float(double(vr.w) + dt05 * Arc[p]);
         Velrhopc[p] = TFloat4(vr.x, vr.y, vr.z, (rhopnew < RhopZero ? RhopZero
@@ -3200,11 +3727,11 @@ void JSphCpu::ComputeSymplecticPreT(double dt) {
     }
 
     //-Calculate new values of fluid / Calcula nuevos datos del fluido.
-    const int np = int(Np);
+    const llong np = llong(Np);
 #ifdef _WITHOMP
 #pragma omp parallel for schedule (static) if(np>LIMIT_COMPUTESTEP_OMP)
 #endif
-    for (int p = npb; p < np; p++) {
+    for (llong p = npb; p < np; p++) {
         //-Calculate density.
         const float rhopnew = float(double(VelrhopPrec[p].w) + dt05 * Arc[p]);
         if (!WithFloating || CODE_GetType(Codec[p]) == CODE_TYPE_FLUID) {//-Fluid Particles / Particulas: Fluid
@@ -3254,11 +3781,11 @@ void JSphCpu::ComputeSymplecticCorrT(double dt) {
     TmcStart(Timers, TMC_SuComputeStep);
 
     //-Calculate rhop of boudary and set velocity=0 / Calcula rhop de contorno y vel igual a cero.
-    const int npb = int(Npb);
+    const llong npb = llong(Npb);
 #ifdef _WITHOMP
 #pragma omp parallel for schedule (static) if(npb>LIMIT_COMPUTESTEP_OMP)
 #endif
-    for (int p = 0; p < npb; p++) {
+    for (llong p = 0; p < npb; p++) {
         const double epsilon_rdot = (-double(Arc[p]) / double(Velrhopc[p].w)) * dt;
         const float rhopnew = float(double(VelrhopPrec[p].w) * (2. - epsilon_rdot) / (2. + epsilon_rdot));
         Velrhopc[p] = TFloat4(0, 0, 0, (rhopnew < RhopZero ? RhopZero
@@ -3267,11 +3794,11 @@ void JSphCpu::ComputeSymplecticCorrT(double dt) {
 
     //-Calculate fluid values / Calcula datos de fluido.
     const double dt05 = dt * .5;
-    const int np = int(Np);
+    const llong np = llong(Np);
 #ifdef _WITHOMP
 #pragma omp parallel for schedule (static) if(np>LIMIT_COMPUTESTEP_OMP)
 #endif
-    for (int p = npb; p < np; p++) {
+    for (llong p = npb; p < np; p++) {
         const double epsilon_rdot = (-double(Arc[p]) / double(Velrhopc[p].w)) * dt;
         const float rhopnew = float(double(VelrhopPrec[p].w) * (2. - epsilon_rdot) / (2. + epsilon_rdot));
         if (!WithFloating || CODE_GetType(Codec[p]) == CODE_TYPE_FLUID) {//-Particulas: Fluid
@@ -3313,10 +3840,12 @@ void JSphCpu::ComputeSymplecticCorrT(double dt) {
 /// Calculat variable Dt.
 //==============================================================================
 double JSphCpu::DtVariable(bool final) {
+    //-With splitting the smallest smoothing length is used / Con splitting se usa la menor longitud de suavizado.
+    const double h = (Splitting ? double(Splitting->GetHMin()) : double(H));
     //-dt1 depends on force per unit mass.
-    const double dt1 = (AceMax ? (sqrt(double(H) / AceMax)) : DBL_MAX);
+    const double dt1 = (AceMax ? (sqrt(h / AceMax)) : DBL_MAX);
     //-dt2 combines the Courant and the viscous time-step controls.
-    const double dt2 = double(H) / (max(Cs0, VelMax * 10.) + double(H) * ViscDtMax);
+    const double dt2 = h / (max(Cs0, VelMax * 10.) + h * ViscDtMax);
     //-dt new value of time step.
     double dt = double(CFLnumber) * min(dt1, dt2);
     if (DtFixed)dt = DtFixed->GetDt(float(TimeStep), float(dt));
@@ -3335,15 +3864,15 @@ double JSphCpu::DtVariable(bool final) {
 void JSphCpu::RunShifting(double dt) {
     TmcStart(Timers, TMC_SuShifting);
     const double coeftfs = (Simulate2D ? 2.0 : 3.0) - ShiftTFS;
-    const int pini = int(Npb), pfin = int(Np), npf = int(Np - Npb);
+    const llong pini = llong(Npb), pfin = llong(Np), npf = llong(Np - Npb);
 #ifdef _WITHOMP
 #pragma omp parallel for schedule (static) if(npf>LIMIT_COMPUTELIGHT_OMP)
 #endif
-    for (int p = pini; p < pfin; p++) {
+    for (llong p = pini; p < pfin; p++) {
         double vx = double(Velrhopc[p].x);
         double vy = double(Velrhopc[p].y);
         double vz = double(Velrhopc[p].z);
-        double umagn = double(ShiftCoef) * double(H) * sqrt(vx * vx + vy * vy + vz * vz) * dt;
+        double umagn = double(ShiftCoef) * double(Hvarc ? Hvarc[p] : H) * sqrt(vx * vx + vy * vy + vz * vz) * dt;
         if (ShiftDetectc) {
             if (ShiftDetectc[p] < ShiftTFS)umagn = 0;
             else umagn *= (double(ShiftDetectc[p]) - ShiftTFS) / coeftfs;
@@ -3364,18 +3893,18 @@ void JSphCpu::RunShifting(double dt) {
 /// and all are set as CODE_NORMAL.
 //==============================================================================
 void JSphCpu::CalcRidp(bool periactive, unsigned np, unsigned pini, unsigned idini, unsigned idfin, const word *code,
-                       const unsigned *idp, unsigned *ridp) const {
+                       const tpartid *idp, unsigned *ridp) const {
     //-Assign values UINT_MAX / Asigna valores UINT_MAX
     const unsigned nsel = idfin - idini;
     memset(ridp, 255, sizeof(unsigned) * nsel);
     //-Calculate position according to id / Calcula posicion segun id.
-    const int pfin = int(pini + np);
+    const llong pfin = llong(pini + np);
     if (periactive) {//-Calculate position according to id checking that the particles are normal (i.e. not periodic) /Calcula posicion segun id comprobando que las particulas son normales (no periodicas).
 #ifdef _WITHOMP
 #pragma omp parallel for schedule (static) if(pfin>LIMIT_COMPUTELIGHT_OMP)
 #endif
-        for (int p = int(pini); p < pfin; p++) {
-            const unsigned id = idp[p];
+        for (llong p = llong(pini); p < pfin; p++) {
+            const tpartid id = idp[p];
             if (idini <= id && id < idfin) {
                 if (CODE_GetSpecialValue(code[p]) == CODE_NORMAL)ridp[id - idini] = p;
             }
@@ -3384,8 +3913,8 @@ void JSphCpu::CalcRidp(bool periactive, unsigned np, unsigned pini, unsigned idi
 #ifdef _WITHOMP
 #pragma omp parallel for schedule (static) if(pfin>LIMIT_COMPUTELIGHT_OMP)
 #endif
-        for (int p = int(pini); p < pfin; p++) {
-            const unsigned id = idp[p];
+        for (llong p = llong(pini); p < pfin; p++) {
+            const tpartid id = idp[p];
             if (idini <= id && id < idfin)ridp[id - idini] = p;
         }
     }
@@ -3443,7 +3972,7 @@ void JSphCpu::RunMotion(double stepdt) {
     if (Motion->ProcesTime(TimeStep + MotionTimeMod, stepdt)) {
         nmove = Motion->GetMovCount();
         if (nmove) {
-            CalcRidp(PeriActive != 0, Npb, 0, CaseNfixed, CaseNfixed + CaseNmoving, Codec, Idpc, RidpMove);
+            CalcRidp(PeriActive != 0 || WithMpi, Npb, 0, CaseNfixed, CaseNfixed + CaseNmoving, Codec, Idpc, RidpMove);
             //-Movement of  boundary particles / Movimiento de particulas boundary
             for (unsigned c = 0; c < nmove; c++) {
                 unsigned ref;
@@ -3468,7 +3997,7 @@ void JSphCpu::RunMotion(double stepdt) {
     }
     //-Process other modes of motion / Procesa otros modos de motion.
     if (WaveGen) {
-        if (!nmove)CalcRidp(PeriActive != 0, Npb, 0, CaseNfixed, CaseNfixed + CaseNmoving, Codec, Idpc, RidpMove);
+        if (!nmove)CalcRidp(PeriActive != 0 || WithMpi, Npb, 0, CaseNfixed, CaseNfixed + CaseNmoving, Codec, Idpc, RidpMove);
         BoundChanged = true;
         //-Control of WaveGeneration (WaveGen) / Gestion de WaveGen.
         if (WaveGen)
@@ -28,6 +28,8 @@
 class JPartsOut;
 class JArraysCpu;
 class JCellDivCpu;
+class JBinaryData;
+class JCheckpointBi4Load;
 
 //##############################################################################
 //# JSphCpu
@@ -41,6 +43,7 @@ private:
 
 protected:
   int OmpThreads;        ///<Max number of OpenMP threads in execution on CPU host (minimum 1) / Numero maximo de hilos OpenMP en ejecucion por host en CPU (minimo 1).
+  double *ForceThTimes;  ///<Time (s) of each thread in the fluid [0,MAXTHREADS_OMP) and boundary [MAXTHREADS_OMP,2*MAXTHREADS_OMP) interaction, only with SvForceStats.
   std::string RunMode;   ///<Overall mode of execution (symmetry, openmp, load balancing) /  Almacena modo de ejecucion (simetria,openmp,balanceo,...).
 
   //-Number of particles in domain / Numero de particulas del dominio.
@@ -66,7 +69,7 @@ protected:
   //-List of particle arrays on CPU / Lista de arrays en Cpu para particulas.
   JArraysCpu* ArraysCpu;
   //-Execution Variables for particles (size=ParticlesSize). / Variables con datos de las particulas para ejecucion (size=ParticlesSize).
-  unsigned *Idpc;    ///<Identifier of particle / Identificador de particula.
+  tpartid *Idpc;     ///<Identifier of particle / Identificador de particula.
   word *Codec;       ///<Indicator of group of particles & other special markers / Indica el grupo de las particulas y otras marcas especiales.
   unsigned *Dcellc;  ///<Cells inside DomCells coded with DomCellCode / Celda dentro de DomCells codificada con DomCellCode.
   tdouble3 *Posc;
@@ -81,6 +84,21 @@ protected:
   tfloat4 *VelrhopPrec;
   double DtPre;   
 
+  //-Variables for sleeping particles (-sleep) / Vars. para particulas dormidas (-sleep).
+  word *SleepCountc;     ///<Consecutive steps at rest of each particle (up to SleepSteps) / Pasos consecutivos en reposo de cada particula.
+  unsigned *SleepListc;  ///<Fluid particles of the active cells followed by those of the asleep cells / Particulas de fluido de celdas activas y dormidas.
+  unsigned SleepNpActive;   ///<Active particles of SleepListc (UINT_MAX:all) / Particulas activas de SleepListc.
+  unsigned SleepNpAsleep;   ///<Asleep particles of SleepListc after the active ones / Particulas dormidas de SleepListc tras las activas.
+  ullong SleepNpSkipped;    ///<Sum of fluid particles whose forces were skipped / Suma de particulas de fluido sin calculo de fuerzas.
+  ullong SleepNpFluid;      ///<Sum of fluid particles in the interactions / Suma de particulas de fluido en las interacciones.
+
+  //-Variables for open boundaries (inout) / Vars. para contornos abiertos (inout).
+  word *InOutc;          ///<Zone+1 of the buffer particles and 0 for the rest / Zona+1 de las particulas buffer y 0 para el resto.
+
+  //-Variables for particle splitting and merging / Vars. para division y union de particulas.
+  float *Massc;          ///<Mass of each particle / Masa de cada particula.
+  float *Hvarc;          ///<Smoothing length of each particle / Longitud de suavizado de cada particula.
+
   //-Variables for floating bodies.
   unsigned *FtRidp;   ///<Identifier to access to the particles of the floating object [CaseNfloat].
   StFtoForces *FtoForces; ///<Stores forces of floatings [FtCount].
@@ -118,10 +136,12 @@ protected:
 
   void ResizeCpuMemoryParticles(unsigned np);
   void ReserveBasicArraysCpu();
+  void UpdateMemRegistry()const;
 
   template<class T> T* TSaveArrayCpu(unsigned np,const T *datasrc)const;
   word*        SaveArrayCpu(unsigned np,const word        *datasrc)const{ return(TSaveArrayCpu<word>       (np,datasrc)); }
   unsigned*    SaveArrayCpu(unsigned np,const unsigned    *datasrc)const{ return(TSaveArrayCpu<unsigned>   (np,datasrc)); }
+  ullong*      SaveArrayCpu(unsigned np,const ullong      *datasrc)const{ return(TSaveArrayCpu<ullong>     (np,datasrc)); }
   float*       SaveArrayCpu(unsigned np,const float       *datasrc)const{ return(TSaveArrayCpu<float>      (np,datasrc)); }
   tfloat4*     SaveArrayCpu(unsigned np,const tfloat4     *datasrc)const{ return(TSaveArrayCpu<tfloat4>    (np,datasrc)); }
   double*      SaveArrayCpu(unsigned np,const double      *datasrc)const{ return(TSaveArrayCpu<double>     (np,datasrc)); }
@@ -130,6 +150,7 @@ protected:
   template<class T> void TRestoreArrayCpu(unsigned np,T *data,T *datanew)const;
   void RestoreArrayCpu(unsigned np,word        *data,word        *datanew)const{ TRestoreArrayCpu<word>       (np,data,datanew); }
   void RestoreArrayCpu(unsigned np,unsigned    *data,unsigned    *datanew)const{ TRestoreArrayCpu<unsigned>   (np,data,datanew); }
+  void RestoreArrayCpu(unsigned np,ullong      *data,ullong      *datanew)const{ TRestoreArrayCpu<ullong>     (np,data,datanew); }
   void RestoreArrayCpu(unsigned np,float       *data,float       *datanew)const{ TRestoreArrayCpu<float>      (np,data,datanew); }
   void RestoreArrayCpu(unsigned np,tfloat4     *data,tfloat4     *datanew)const{ TRestoreArrayCpu<tfloat4>    (np,data,datanew); }
   void RestoreArrayCpu(unsigned np,double      *data,double      *datanew)const{ TRestoreArrayCpu<double>     (np,data,datanew); }
@@ -142,7 +163,7 @@ protected:
   void PrintAllocMemory(llong mcpu)const;
 
   unsigned GetParticlesData(unsigned n,unsigned pini,bool cellorderdecode,bool onlynormal
-    ,unsigned *idp,tdouble3 *pos,tfloat3 *vel,float *rhop,word *code);
+    ,tpartid *idp,tdouble3 *pos,tfloat3 *vel,float *rhop,word *code);
   void ConfigOmp(const JCfgRun *cfg);
 
   void ConfigRunMode(const JCfgRun *cfg,std::string preinfo="");
@@ -150,6 +171,10 @@ protected:
   void InitFloating();
   void InitRun();
 
+  void SaveCheckpointParticles(JBinaryData *bd)const;
+  void LoadCheckpointParticles(JCheckpointBi4Load *cpload);
+  void LoadCheckpointStep(JCheckpointBi4Load *cpload);
+
   void AddAccInput();
 
   float CalcVelMaxSeq(unsigned np,const tfloat4* velrhop)const;
@@ -160,6 +185,7 @@ protected:
   void PosInteraction_Forces();
 
   inline void GetKernel(float rr2,float drx,float dry,float drz,float &frx,float &fry,float &frz)const;
+  inline void GetKernelHvar(float rr2,float drx,float dry,float drz,float hij,float &frx,float &fry,float &frz)const;
   inline void GetKernelCubic(float rr2,float drx,float dry,float drz,float &frx,float &fry,float &frz)const;
   inline float GetKernelCubicTensil(float rr2,float rhopp1,float pressp1,float rhopp2,float pressp2)const;
 
@@ -168,31 +194,49 @@ protected:
     ,int &cxini,int &cxfin,int &yini,int &yfin,int &zini,int &zfin)const;
 
   template<bool psimple,TpKernel tker,TpFtMode ftmode> void InteractionForcesBound
-    (unsigned n,unsigned pini,tint4 nc,int hdiv,unsigned cellinitial
+    (unsigned n,unsigned pini,tint4 nc,int hdiv,unsigned cellinitial,unsigned cellfloat
     ,const unsigned *beginendcell,tint3 cellzero,const unsigned *dcell
-    ,const tdouble3 *pos,const tfloat3 *pspos,const tfloat4 *velrhopp,const word *code,const unsigned *id
+    ,const tdouble3 *pos,const tfloat3 *pspos,const tfloat4 *velrhopp,const word *code,const tpartid *id
     ,float &viscdt,float *ar)const;
 
   template<bool psimple,TpKernel tker,TpFtMode ftmode,bool lamsps,TpDeltaSph tdelta,bool shift> void InteractionForcesFluid
-    (unsigned n,unsigned pini,tint4 nc,int hdiv,unsigned cellfluid,float visco
+    (unsigned n,unsigned pini,tint4 nc,int hdiv,unsigned cellinitial,unsigned cellfloat,float visco
     ,const unsigned *beginendcell,tint3 cellzero,const unsigned *dcell
     ,const tsymatrix3f* tau,tsymatrix3f* gradvel
-    ,const tdouble3 *pos,const tfloat3 *pspos,const tfloat4 *velrhop,const word *code,const unsigned *idp
+    ,const tdouble3 *pos,const tfloat3 *pspos,const tfloat4 *velrhop,const word *code,const tpartid *idp
     ,const float *press
     ,float &viscdt,float *ar,tfloat3 *ace,float *delta
-    ,TpShifting tshifting,tfloat3 *shiftpos,float *shiftdetect)const;
+    ,TpShifting tshifting,tfloat3 *shiftpos,float *shiftdetect,const unsigned *plist=NULL)const;
+
+  template<bool psimple,TpKernel tker,TpFtMode ftmode,bool lamsps,TpDeltaSph tdelta,bool shift> void InteractionForcesFluidAll
+    (unsigned n,unsigned pini,tint4 nc,int hdiv,unsigned cellfluid,unsigned cellfloat
+    ,const unsigned *beginendcell,tint3 cellzero,const unsigned *dcell
+    ,const tsymatrix3f* tau,tsymatrix3f* gradvel
+    ,const tdouble3 *pos,const tfloat3 *pspos,const tfloat4 *velrhop,const word *code,const tpartid *idp
+    ,const float *press
+    ,float &viscdt,float *ar,tfloat3 *ace,float *delta
+    ,TpShifting tshifting,tfloat3 *shiftpos,float *shiftdetect,const unsigned *plist=NULL)const;
 
   template<bool psimple> void InteractionForcesDEM
-    (unsigned nfloat,tint4 nc,int hdiv,unsigned cellfluid
+    (unsigned nfloat,tint4 nc,int hdiv,unsigned cellfloat
     ,const unsigned *beginendcell,tint3 cellzero,const unsigned *dcell
     ,const unsigned *ftridp,const StDemData* demobjs
-    ,const tdouble3 *pos,const tfloat3 *pspos,const tfloat4 *velrhop,const word *code,const unsigned *idp
+    ,const tdouble3 *pos,const tfloat3 *pspos,const tfloat4 *velrhop,const word *code,const tpartid *idp
     ,float &viscdt,tfloat3 *ace)const;
 
   template<bool psimple,TpKernel tker,TpFtMode ftmode,bool lamsps,TpDeltaSph tdelta,bool shift> void Interaction_ForcesT
     (unsigned np,unsigned npb,unsigned npbok
     ,tuint3 ncells,const unsigned *begincell,tuint3 cellmin,const unsigned *dcell
-    ,const tdouble3 *pos,const tfloat3 *pspos,const tfloat4 *velrhop,const word *code,const unsigned *idp
+    ,const tdouble3 *pos,const tfloat3 *pspos,const tfloat4 *velrhop,const word *code,const tpartid *idp
+    ,const float *press
+    ,float &viscdt,float* ar,tfloat3 *ace,float *delta
+    ,tsymatrix3f *spstau,tsymatrix3f *spsgradvel
+    ,TpShifting tshifting,tfloat3 *shiftpos,float *shiftdetect)const;
+
+  template<bool psimple,TpKernel tker,TpFtMode ftmode,bool lamsps,TpDeltaSph tdelta,bool shift> void Interaction_ForcesTasks
+    (unsigned np,unsigned npb,unsigned npbok,tint4 nc,int hdiv,unsigned cellfluid,unsigned cellfloat
+    ,const unsigned *begincell,tint3 cellzero,const unsigned *dcell
+    ,const tdouble3 *pos,const tfloat3 *pspos,const tfloat4 *velrhop,const word *code,const tpartid *idp
     ,const float *press
     ,float &viscdt,float* ar,tfloat3 *ace,float *delta
     ,tsymatrix3f *spstau,tsymatrix3f *spsgradvel
@@ -200,7 +244,7 @@ protected:
 
   void Interaction_Forces(unsigned np,unsigned npb,unsigned npbok
     ,tuint3 ncells,const unsigned *begincell,tuint3 cellmin,const unsigned *dcell
-    ,const tdouble3 *pos,const tfloat4 *velrhop,const unsigned *idp,const word *code
+    ,const tdouble3 *pos,const tfloat4 *velrhop,const tpartid *idp,const word *code
     ,const float *press
     ,float &viscdt,float* ar,tfloat3 *ace,float *delta
     ,tsymatrix3f *spstau,tsymatrix3f *spsgradvel
@@ -208,7 +252,7 @@ protected:
 
   void InteractionSimple_Forces(unsigned np,unsigned npb,unsigned npbok
     ,tuint3 ncells,const unsigned *begincell,tuint3 cellmin,const unsigned *dcell
-    ,const tfloat3 *pspos,const tfloat4 *velrhop,const unsigned *idp,const word *code
+    ,const tfloat3 *pspos,const tfloat4 *velrhop,const tpartid *idp,const word *code
     ,const float *press
     ,float &viscdt,float* ar,tfloat3 *ace,float *delta
     ,tsymatrix3f *spstau,tsymatrix3f *spsgradvel
@@ -230,7 +274,7 @@ protected:
 
   void RunShifting(double dt);
 
-  void CalcRidp(bool periactive,unsigned np,unsigned pini,unsigned idini,unsigned idfin,const word *code,const unsigned *idp,unsigned *ridp)const;
+  void CalcRidp(bool periactive,unsigned np,unsigned pini,unsigned idini,unsigned idfin,const word *code,const tpartid *idp,unsigned *ridp)const;
   void MoveLinBound(unsigned np,unsigned ini,const tdouble3 &mvpos,const tfloat3 &mvvel,const unsigned *ridp,tdouble3 *pos,unsigned *dcell,tfloat4 *velrhop,word *code)const;
   void MoveMatBound(unsigned np,unsigned ini,tmatrix4d m,double dt,const unsigned *ridpmv,tdouble3 *pos,unsigned *dcell,tfloat4 *velrhop,word *code)const;
   void RunMotion(double stepdt);
@@ -0,0 +1,659 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JSphCpuBench.cpp \brief Implements the class \ref JSphCpuBench.
+
+#include "JSphCpuBench.h"
+#include "JCellDivCpuSingle.h"
+#include "JArraysCpu.h"
+#include "JSpaceParts.h"
+#include "JTimer.h"
+#include "Functions.h"
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#ifdef _WITHOMP
+
+#include <omp.h>
+
+#endif
+
+using namespace std;
+
+#define BENCH_BOUNDLAYERS 2       ///<Capas de particulas de contorno. Layers of boundary particles.
+#define BENCH_FLOATRHOP 800.      ///<Densidad del objeto flotante. Density of the floating object.
+
+//==============================================================================
+/// Constructor.
+//==============================================================================
+JSphCpuBench::JSphCpuBench(JLog2 *log, int ompthreads, const std::string &dirout) {
+    ClassName = "JSphCpuBench";
+    Log = log;
+    DirOut = dirout;
+    SortIdp = NULL;
+    SortCode = NULL;
+    SortDcell = NULL;
+    SortPos = NULL;
+    SortVelrhop = NULL;
+    PairsFluid = PairsBound = 0;
+    NpNormal = 0;
+    memset(&Bc, 0, sizeof(StBenchCase));
+    memset(&Bph, 0, sizeof(StBenchPhysics));
+    //-Configuracion de OpenMP como en ConfigOmp().
+    //-OpenMP configuration as in ConfigOmp().
+#ifdef _WITHOMP
+    OmpThreads = (ompthreads > 0 ? ompthreads : max(omp_get_num_procs(), 1));
+    if (OmpThreads > MAXTHREADS_OMP)OmpThreads = MAXTHREADS_OMP;
+    omp_set_num_threads(OmpThreads);
+#else
+    OmpThreads = 1;
+#endif
+    TmcCreation(Timers, false);
+}
+
+//==============================================================================
+/// Destructor.
+//==============================================================================
+JSphCpuBench::~JSphCpuBench() {
+    FreeSortArrays();
+}
+
+//==============================================================================
+/// Devuelve el nombre del benchmark.
+/// Returns the name of the benchmark.
+//==============================================================================
+std::string JSphCpuBench::GetBenchName(TpBench test) {
+    string tx;
+    switch (test) {
+        case BENCH_ForcesFluid:
+            tx = "ForcesFluid";
+            break;
+        case BENCH_ForcesBound:
+            tx = "ForcesBound";
+            break;
+        case BENCH_Divide:
+            tx = "Divide";
+            break;
+        case BENCH_SortArray:
+            tx = "SortArray";
+            break;
+        case BENCH_SymplecticPre:
+            tx = "SymplecticPre";
+            break;
+        case BENCH_SymplecticCorr:
+            tx = "SymplecticCorr";
+            break;
+        case BENCH_Periodic:
+            tx = "RunPeriodic";
+            break;
+        default:
+            tx = "???";
+    }
+    return (tx);
+}
+
+//==============================================================================
+/// Devuelve la unidad del throughput del benchmark.
+/// Returns the throughput unit of the benchmark.
+//==============================================================================
+std::string JSphCpuBench::GetBenchUnit(TpBench test) {
+    return (test == BENCH_ForcesFluid || test == BENCH_ForcesBound ? "pairs/s" : "particles/s");
+}
+
+//==============================================================================
+/// Devuelve la descripcion de una configuracion.
+/// Returns the description of a configuration.
+//==============================================================================
+std::string JSphCpuBench::GetConfigStr(const StBenchCase &bc, const StBenchPhysics &bph) {
+    const char *ft = (bc.ftmode == FTMODE_Sph ? "SPH" : (bc.ftmode == FTMODE_Dem ? "DEM" : "None"));
+    string tx = (bc.sim2d ? "2D" : "3D");
+    if (bc.perix)tx = tx + " PeriX";
+    tx = tx + " " + GetKernelName(bph.tkernel) + " " + GetViscoName(bph.tvisco);
+    tx = tx + " Delta:" + GetDeltaSphName(bph.tdelta) + " Shift:" + GetShiftingName(bph.tshifting);
+    tx = tx + " Ft:" + ft + (bph.psimple ? " PosSimple" : " PosDouble");
+    return (tx);
+}
+
+//==============================================================================
+/// Libera los arrays auxiliares de BENCH_SortArray.
+/// Frees the auxiliary arrays of BENCH_SortArray.
+//==============================================================================
+void JSphCpuBench::FreeSortArrays() {
+    delete[] SortIdp;
+    SortIdp = NULL;
+    delete[] SortCode;
+    SortCode = NULL;
+    delete[] SortDcell;
+    SortDcell = NULL;
+    delete[] SortPos;
+    SortPos = NULL;
+    delete[] SortVelrhop;
+    SortVelrhop = NULL;
+}
+
+//==============================================================================
+/// Reserva los arrays auxiliares de BENCH_SortArray con una copia de los datos
+/// actuales para que la primera medida no incluya la asignacion de paginas.
+/// Allocates the auxiliary arrays of BENCH_SortArray with a copy of the current
+/// data so the first measurement does not include page allocation.
+//==============================================================================
+void JSphCpuBench::AllocSortArrays() {
+    FreeSortArrays();
+    const unsigned n = CpuParticlesSize;
+    SortIdp = new tpartid[n];
+    SortCode = new word[n];
+    SortDcell = new unsigned[n];
+    SortPos = new tdouble3[n];
+    SortVelrhop = new tfloat4[n];
+    memcpy(SortIdp, Idpc, sizeof(tpartid) * Np);
+    memcpy(SortCode, Codec, sizeof(word) * Np);
+    memcpy(SortDcell, Dcellc, sizeof(unsigned) * Np);
+    memcpy(SortPos, Posc, sizeof(tdouble3) * Np);
+    memcpy(SortVelrhop, Velrhopc, sizeof(tfloat4) * Np);
+}
+
+//==============================================================================
+/// Genera la malla de particulas: tanque con suelo y paredes de contorno,
+/// fluido hasta la fraccion de llenado y objeto flotante opcional dentro del
+/// fluido. Las posiciones se devuelven en orden fixed, floating y fluid.
+/// Generates the lattice of particles: tank with boundary floor and walls,
+/// fluid up to the fill fraction and optional floating object inside the
+/// fluid. Positions are returned in order fixed, floating and fluid.
+//==============================================================================
+void JSphCpuBench::CreateLattice(std::vector<tdouble3> &pos, unsigned &nfixed, unsigned &nfloat, unsigned &nfluid,
+                                 double &hswl) const {
+    const char met[] = "CreateLattice";
+    if (Bc.fill <= 0 || Bc.fill > 1)RunException(met, "The fill fraction must be in the range (0,1].");
+    if (Bc.dp <= 0)RunException(met, "The distance between particles must be greater than zero.");
+    const bool sim2d = Bc.sim2d;
+    //-Numero de posiciones interiores por lado y de fluido en altura.
+    //-Number of inner positions per side and of fluid in height.
+    const double nside = (sim2d ? sqrt(Bc.np / Bc.fill) : pow(Bc.np / Bc.fill, 1. / 3.));
+    const int ns = max(8, int(nside + 0.5));
+    const int nzf = max(2, min(ns, int(Bc.fill * ns + 0.5)));
+    const int nb = BENCH_BOUNDLAYERS;
+    const int xini = (Bc.perix ? 0 : -nb), xfin = (Bc.perix ? ns : ns + nb);
+    const int yini = (sim2d ? 0 : -nb), yfin = (sim2d ? 1 : ns + nb);
+    //-Objeto flotante centrado en el fluido. Floating object centred in the fluid.
+    const bool floating = (Bc.ftmode != FTMODE_None);
+    const int fs = min(max(2, ns / 5), nzf);
+    const int fx0 = (ns - fs) / 2, fy0 = (ns - fs) / 2, fz0 = (nzf - fs) / 2;
+    std::vector<tdouble3> vbound, vfloat, vfluid;
+    for (int z = -nb; z < ns; z++)
+        for (int y = yini; y < yfin; y++)
+            for (int x = xini; x < xfin; x++) {
+                const tdouble3 ps = TDouble3(Bc.dp * x, Bc.dp * y, Bc.dp * z);
+                const bool inside = (x >= 0 && x < ns && (sim2d || (y >= 0 && y < ns)) && z >= 0);
+                if (!inside)vbound.push_back(ps);
+                else if (z < nzf) {
+                    const bool ft = (floating && x >= fx0 && x < fx0 + fs && z >= fz0 && z < fz0 + fs &&
+                                     (sim2d || (y >= fy0 && y < fy0 + fs)));
+                    if (ft)vfloat.push_back(ps);
+                    else vfluid.push_back(ps);
+                }
+            }
+    nfixed = unsigned(vbound.size());
+    nfloat = unsigned(vfloat.size());
+    nfluid = unsigned(vfluid.size());
+    pos.clear();
+    pos.reserve(nfixed + nfloat + nfluid);
+    pos.insert(pos.end(), vbound.begin(), vbound.end());
+    pos.insert(pos.end(), vfloat.begin(), vfloat.end());
+    pos.insert(pos.end(), vfluid.begin(), vfluid.end());
+    hswl = Bc.dp * (nzf - 1);
+}
+
+//==============================================================================
+/// Configura los parametros de ejecucion y constantes fisicas sin XML.
+/// Configures the execution parameters and physical constants without XML.
+//==============================================================================
+void JSphCpuBench::ConfigPhysics(double hswl) {
+    CaseName = "Bench";
+    RunName = "Bench";
+    Simulate2D = Bc.sim2d;
+    Stable = false;
+    Psimple = Bph.psimple;
+    SvDouble = false;
+    SvData = byte(SDAT_None);
+    TStep = STEP_Symplectic;
+    TKernel = Bph.tkernel;
+    TVisco = Bph.tvisco;
+    Visco = (TVisco == VISCO_LaminarSPS ? 0.000001f : 0.01f);
+    ViscoBoundFactor = 1;
+    TDeltaSph = Bph.tdelta;
+    if (TDeltaSph == DELTA_Dynamic)
+        TDeltaSph = DELTA_DynamicExt; //-It is necessary because the interaction is divided in two steps: fluid-fluid/float and fluid-bound.
+    DeltaSph = (TDeltaSph != DELTA_None ? 0.1f : 0);
+    TShifting = Bph.tshifting;
+    ShiftCoef = (TShifting != SHIFT_None ? -2.f : 0);
+    ShiftTFS = 0;
+    CellOrder = ORDER_XYZ;
+    CellMode = CELLMODE_2H;
+    //-Constantes como en GenCase con coefh=1.2 y coefsound=20.
+    //-Constants as in GenCase with coefh=1.2 and coefsound=20.
+    Dp = Bc.dp;
+    H = float(1.2 * sqrt(Simulate2D ? 2. : 3.) * Dp);
+    Gravity = TFloat3(0, 0, -9.81f);
+    RhopZero = 1000;
+    Gamma = 7;
+    CFLnumber = 0.2f;
+    CoefDtMin = 0.05f;
+    const double cs0 = 20. * sqrt(9.81 * hswl);
+    CteB = float(cs0 * cs0 * RhopZero / Gamma);
+    MassFluid = MassBound = float(RhopZero * (Simulate2D ? Dp * Dp : Dp * Dp * Dp));
+    TimeMax = TimePart = 1;
+    PeriX = Bc.perix;
+    PeriActive = (PeriX ? 1 : 0);
+}
+
+//==============================================================================
+/// Configura los bloques Mk, el objeto flotante y los coeficientes DEM.
+/// Configures the Mk blocks, the floating object and the DEM coefficients.
+//==============================================================================
+void JSphCpuBench::ConfigParts(const std::vector<tdouble3> &pos, unsigned nfixed, unsigned nfloat, unsigned nfluid) {
+    CaseNfixed = nfixed;
+    CaseNmoving = 0;
+    CaseNfloat = nfloat;
+    CaseNfluid = nfluid;
+    CaseNbound = nfixed + nfloat;
+    CaseNpb = nfixed;
+    CaseNp = CaseNbound + nfluid;
+    //-Bloques de particulas. Blocks of particles.
+    const double massbody = BENCH_FLOATRHOP * (Simulate2D ? Dp * Dp : Dp * Dp * Dp) * nfloat;
+    tdouble3 center = TDouble3(0);
+    JSpaceParts parts;
+    parts.AddFixed(0, nfixed);
+    if (nfloat) {
+        for (unsigned p = nfixed; p < nfixed + nfloat; p++)center = center + pos[p];
+        center = center / double(nfloat);
+        parts.AddFloating(1, nfloat, massbody, center, TDouble3(0), TDouble3(0), TDouble3(0));
+    }
+    parts.AddFluid(0, nfluid);
+    LoadMkInfo(&parts);
+    //-Objeto flotante. Floating object.
+    FtCount = parts.CountBlocks(PT_Floating);
+    AllocMemoryFloating(FtCount);
+    if (FtCount) {
+        StFloatingData *fobj = FtObjs;
+        fobj->mkbound = 1;
+        fobj->begin = nfixed;
+        fobj->count = nfloat;
+        fobj->mass = float(massbody);
+        fobj->massp = fobj->mass / fobj->count;
+        fobj->radius = 0;
+        fobj->center = center;
+        fobj->fvel = TFloat3(0);
+        fobj->fomega = TFloat3(0);
+    }
+    //-Coeficientes DEM de todos los bloques de contorno.
+    //-DEM coefficients of all the boundary blocks.
+    UseDEM = (FtCount && Bc.ftmode == FTMODE_Dem);
+    if (UseDEM) {
+        memset(DemObjs, 0, sizeof(StDemData) * DemObjsSize);
+        for (unsigned c = 0; c < MkListBound; c++) {
+            const unsigned tav = CODE_GetTypeAndValue(MkList[c].code);
+            const bool ft = (CODE_GetType(MkList[c].code) == CODE_TYPE_FLOATING);
+            DemObjs[tav].mass = (ft ? float(massbody) : 0);
+            DemObjs[tav].massp = (ft ? float(massbody / nfloat) : MassBound);
+            DemObjs[tav].young = 3.e9f;
+            DemObjs[tav].poisson = 0.3f;
+            DemObjs[tav].tau = (1 - DemObjs[tav].poisson * DemObjs[tav].poisson) / DemObjs[tav].young;
+            DemObjs[tav].kfric = 0.45f;
+            DemObjs[tav].restitu = 0.8f;
+        }
+    }
+}
+
+//==============================================================================
+/// Configura el dominio y carga las particulas como en LoadCaseParticles(),
+/// ConfigDomain() e InitRun(). Ninguna particula sale del dominio en los
+/// benchmarks, por lo que no se usa ConfigSaveData().
+/// Configures the domain and loads the particles as in LoadCaseParticles(),
+/// ConfigDomain() and InitRun(). No particle leaves the domain in the
+/// benchmarks, so ConfigSaveData() is not used.
+//==============================================================================
+void JSphCpuBench::ConfigDomainBench(const std::vector<tdouble3> &pos, double hswl) {
+    //-Limites del caso y del mapa. Limits of the case and the map.
+    CasePosMin = CasePosMax = pos[0];
+    for (unsigned p = 1; p < CaseNp; p++) {
+        CasePosMin = MinValues(CasePosMin, pos[p]);
+        CasePosMax = MaxValues(CasePosMax, pos[p]);
+    }
+    tdouble3 bor = TDouble3(double(H) * BORDER_MAP);
+    if (PeriX)bor.x = Dp / 2.;
+    MapRealPosMin = CasePosMin - bor;
+    MapRealPosMax = CasePosMax + bor;
+    MapRealSize = MapRealPosMax - MapRealPosMin;
+    if (PeriX)PeriXinc.x = -MapRealSize.x;
+    Map_PosMin = MapRealPosMin;
+    Map_PosMax = MapRealPosMax;
+    if (PeriX) {
+        const double dosh = double(H) * 2;
+        Map_PosMin.x = Map_PosMin.x - dosh;
+        Map_PosMax.x = Map_PosMax.x + dosh;
+    }
+    Map_Size = Map_PosMax - Map_PosMin;
+
+    //-Reserva memoria y carga datos de particulas. Allocates memory and loads particle data.
+    Np = CaseNp;
+    Npb = CaseNpb;
+    NpbOk = Npb;
+    AllocCpuMemoryFixed();
+    AllocCpuMemoryParticles(Np, 0);
+    ReserveBasicArraysCpu();
+    const double g = fabs(Gravity.z);
+    const double vamp = 0.01 * sqrt(g * hswl);
+    for (unsigned p = 0; p < Np; p++) {
+        const tdouble3 ps = pos[p];
+        Posc[p] = ps;
+        Idpc[p] = p;
+        //-Densidad hidrostatica y pequenha perturbacion determinista de la velocidad del fluido.
+        //-Hydrostatic density and small deterministic perturbation of the fluid velocity.
+        const double depth = max(hswl - ps.z, 0.);
+        const float rhop = float(RhopZero * pow(1. + RhopZero * g * depth / CteB, 1. / Gamma));
+        tfloat3 vel = TFloat3(0);
+        if (p >= CaseNbound) {
+            vel.x = float(vamp * sin(p * 12.9898));
+            vel.y = (Simulate2D ? 0 : float(vamp * sin(p * 78.233)));
+            vel.z = float(vamp * sin(p * 37.719));
+        }
+        Velrhopc[p] = TFloat4(vel.x, vel.y, vel.z, rhop);
+    }
+    LoadCodeParticles(Np, Idpc, Codec);
+    ConfigCellOrder(CellOrder, Np, Posc, Velrhopc);
+
+    //-Division en celdas como en ConfigDomain(). Cell division as in ConfigDomain().
+    ConfigCellDivision();
+    SelecDomain(TUint3(0, 0, 0), Map_Cells);
+    LoadDcellParticles(Np, Codec, Posc, Dcellc);
+    CellDivSingle = new JCellDivCpuSingle(Stable, FtCount != 0, PeriActive, CellOrder, CellMode, Scell, Map_PosMin,
+                                          Map_PosMax, Map_Cells, CaseNbound, CaseNfixed, CaseNpb, Log, DirOut);
+    CellDivSingle->DefineDomain(DomCellCode, DomCelIni, DomCelFin, DomPosMin, DomPosMax);
+    ConfigCellDiv((JCellDivCpu *) CellDivSingle);
+
+    //-Variables de InitRun(). Variables of InitRun().
+    WithFloating = (CaseNfloat > 0);
+    DtPre = DtIni;
+    if (TVisco == VISCO_LaminarSPS)memset(SpsTauc, 0, sizeof(tsymatrix3f) * Np);
+    if (UseDEM)DemDtForce = DtIni;
+
+    BoundChanged = true;
+    RunCellDivide(true);
+    NpNormal = Np - NpbPer - NpfPer;
+}
+
+//==============================================================================
+/// Configura el caso sintetico. Solo puede llamarse una vez por objeto.
+/// Configures the synthetic case. It can only be called once per object.
+//==============================================================================
+void JSphCpuBench::Config(const StBenchCase &bc, const StBenchPhysics &bph) {
+    const char met[] = "Config";
+    if (CellDivSingle)RunException(met, "The benchmark is already configured.");
+    Bc = bc;
+    Bph = bph;
+    std::vector<tdouble3> pos;
+    unsigned nfixed, nfloat, nfluid;
+    double hswl;
+    CreateLattice(pos, nfixed, nfloat, nfluid, hswl);
+    ConfigPhysics(hswl);
+    ConfigParts(pos, nfixed, nfloat, nfluid);
+    ConfigConstants(Simulate2D);
+    ConfigDomainBench(pos, hswl);
+    //-Pares de interaccion como en Interaction_ForcesT(). Interaction pairs as in Interaction_ForcesT().
+    const tuint3 ncells = CellDivSingle->GetNcells();
+    const unsigned cellfluid = ncells.x * ncells.y * ncells.z + 1;
+    PairsFluid = CountPairs(Npb, Np, cellfluid) + CountPairs(Npb, Np, 0);
+    PairsBound = CountPairs(0, NpbOk, cellfluid);
+    if (FtCount) {
+        //-Las particulas floating estan en sus propias celdas. Floating particles are in their own cells.
+        const unsigned cellfloat = cellfluid + ncells.x * ncells.y * ncells.z;
+        PairsFluid += CountPairs(Npb, Np, cellfloat);
+        PairsBound += CountPairs(0, NpbOk, cellfloat);
+    }
+    AllocSortArrays();
+    Log->Printf("Bench case: Np=%u  Npb=%u  PairsFluid=%llu  PairsBound=%llu", Np, Npb, PairsFluid, PairsBound);
+}
+
+//==============================================================================
+/// Cuenta los pares a distancia menor de 2h de las particulas [pini,pfin) con
+/// los mismos bucles de celdas que la interaccion.
+/// Counts the pairs at distance less than 2h of the particles [pini,pfin) with
+/// the same loops of cells as the interaction.
+//==============================================================================
+ullong JSphCpuBench::CountPairs(unsigned pini, unsigned pfin, unsigned cellinitial) const {
+    const tuint3 ncells = CellDivSingle->GetNcells();
+    const tint4 nc = TInt4(int(ncells.x), int(ncells.y), int(ncells.z), int(ncells.x * ncells.y));
+    const tuint3 cellmin = CellDivSingle->GetCellDomainMin();
+    const tint3 cellzero = TInt3(cellmin.x, cellmin.y, cellmin.z);
+    const int hdiv = (CellMode == CELLMODE_H ? 2 : 1);
+    const unsigned *beginendcell = CellDivSingle->GetBeginCell();
+    llong count = 0;
+    const int ini = int(pini), fin = int(pfin);
+#ifdef _WITHOMP
+#pragma omp parallel for schedule (guided) reduction(+:count)
+#endif
+    for (int p1 = ini; p1 < fin; p1++) {
+        const unsigned rcell = Dcellc[p1];
+        const int cx = PC__Cellx(DomCellCode, rcell) - cellzero.x;
+        const int cy = PC__Celly(DomCellCode, rcell) - cellzero.y;
+        const int cz = PC__Cellz(DomCellCode, rcell) - cellzero.z;
+        const int cxini = cx - min(cx, hdiv), cxfin = cx + min(nc.x - cx - 1, hdiv) + 1;
+        const int yini = cy - min(cy, hdiv), yfin = cy + min(nc.y - cy - 1, hdiv) + 1;
+        const int zini = cz - min(cz, hdiv), zfin = cz + min(nc.z - cz - 1, hdiv) + 1;
+        const tdouble3 posp1 = Posc[p1];
+        for (int z = zini; z < zfin; z++) {
+            const int zmod = nc.w * z + cellinitial;
+            for (int y = yini; y < yfin; y++) {
+                const int ymod = zmod + nc.x * y;
+                const unsigned pini2 = beginendcell[cxini + ymod];
+                const unsigned pfin2 = beginendcell[cxfin + ymod];
+                for (unsigned p2 = pini2; p2 < pfin2; p2++) {
+                    const float drx = float(posp1.x - Posc[p2].x);
+                    const float dry = float(posp1.y - Posc[p2].y);
+                    const float drz = float(posp1.z - Posc[p2].z);
+                    const float rr2 = drx * drx + dry * dry + drz * drz;
+                    if (rr2 <= Fourh2 && rr2 >= ALMOSTZERO)count++;
+                }
+            }
+        }
+    }
+    return (ullong(count));
+}
+
+//==============================================================================
+/// Ejecuta solo la interaccion de fluido (npbok=0) o solo la de contorno
+/// (np=npb) mediante la seleccion de parametros template de Interaction_Forces().
+/// Runs only the fluid interaction (npbok=0) or only the boundary one (np=npb)
+/// through the selection of template parameters of Interaction_Forces().
+//==============================================================================
+void JSphCpuBench::RunForces(bool fluid) {
+    const unsigned np = (fluid ? Np : Npb);
+    const unsigned npbok = (fluid ? 0 : NpbOk);
+    float viscdt = 0;
+    if (Psimple) {
+        JSphCpu::InteractionSimple_Forces(np, Npb, npbok, CellDivSingle->GetNcells(), CellDivSingle->GetBeginCell(),
+                                          CellDivSingle->GetCellDomainMin(), Dcellc, PsPosc, Velrhopc, Idpc, Codec,
+                                          Pressc, viscdt, Arc, Acec, Deltac, SpsTauc, SpsGradvelc, ShiftPosc,
+                                          ShiftDetectc);
+    } else {
+        JSphCpu::Interaction_Forces(np, Npb, npbok, CellDivSingle->GetNcells(), CellDivSingle->GetBeginCell(),
+                                    CellDivSingle->GetCellDomainMin(), Dcellc, Posc, Velrhopc, Idpc, Codec, Pressc,
+                                    viscdt, Arc, Acec, Deltac, SpsTauc, SpsGradvelc, ShiftPosc, ShiftDetectc);
+    }
+    ViscDtMax = viscdt;
+}
+
+//==============================================================================
+/// Ejecuta una repeticion del benchmark y devuelve el tiempo (ms) de la parte
+/// medida. La preparacion y la limpieza no se miden. En los pasos Symplectic
+/// no se calcula la interaccion porque su coste no depende del valor de las
+/// fuerzas.
+/// Runs one repetition of the benchmark and returns the time (ms) of the
+/// measured part. Preparation and cleanup are not measured. The interaction
+/// is not computed for the Symplectic steps because their cost does not
+/// depend on the values of the forces.
+//==============================================================================
+double JSphCpuBench::RunTest(TpBench test) {
+    JTimer timer;
+    switch (test) {
+        case BENCH_ForcesFluid:
+        case BENCH_ForcesBound:
+            PreInteraction_Forces(INTER_Forces);
+            timer.Start();
+            RunForces(test == BENCH_ForcesFluid);
+            timer.Stop();
+            PosInteraction_Forces();
+            break;
+        case BENCH_Divide:
+            timer.Start();
+            CellDivSingle->Divide(Npb, Np - Npb - NpbPer - NpfPer, NpbPer, NpfPer, BoundChanged, Dcellc, Codec, Idpc,
+                                  Posc, Timers);
+            timer.Stop();
+            break;
+        case BENCH_SortArray:
+            timer.Start();
+            CellDivSingle->SortArray(SortIdp);
+            CellDivSingle->SortArray(SortCode);
+            CellDivSingle->SortArray(SortDcell);
+            CellDivSingle->SortArray(SortPos);
+            CellDivSingle->SortArray(SortVelrhop);
+            timer.Stop();
+            break;
+        case BENCH_SymplecticPre:
+            PreInteraction_Forces(INTER_Forces);
+            timer.Start();
+            ComputeSymplecticPre(DtMin);
+            timer.Stop();
+            ComputeSymplecticCorr(DtMin);
+            PosInteraction_Forces();
+            break;
+        case BENCH_SymplecticCorr:
+            PreInteraction_Forces(INTER_Forces);
+            ComputeSymplecticPre(DtMin);
+            timer.Start();
+            ComputeSymplecticCorr(DtMin);
+            timer.Stop();
+            PosInteraction_Forces();
+            break;
+        case BENCH_Periodic:
+            timer.Start();
+            RunPeriodic();
+            timer.Stop();
+            RunCellDivide(false);
+            break;
+    }
+    return (timer.GetElapsedTimeD());
+}
+
+//==============================================================================
+/// Devuelve los pares o particulas procesadas en cada repeticion.
+/// Returns the pairs or particles processed per repetition.
+//==============================================================================
+double JSphCpuBench::GetItems(TpBench test) const {
+    double n = 0;
+    switch (test) {
+        case BENCH_ForcesFluid:
+            n = double(PairsFluid);
+            break;
+        case BENCH_ForcesBound:
+            n = double(PairsBound);
+            break;
+        case BENCH_SortArray:
+            n = double(CellDivSingle->GetDivideFull() ? Np : Np - Npb);
+            break;
+        case BENCH_Periodic:
+            n = double(NpNormal);
+            break;
+        default:
+            n = double(Np);
+    }
+    return (n);
+}
+
+//==============================================================================
+/// Devuelve una estimacion de los bytes leidos y escritos en memoria en cada
+/// repeticion (0 cuando el coste es de calculo).
+/// Returns an estimation of the bytes read and written in memory per
+/// repetition (0 when the cost is computation).
+//==============================================================================
+double JSphCpuBench::GetBytes(TpBench test) const {
+    const double n = GetItems(test);
+    const double shift = (TShifting != SHIFT_None ? sizeof(tfloat3) : 0);
+    double bytes = 0;
+    switch (test) {
+        case BENCH_SortArray:
+            //-Lee sortpart y vec, escribe vsort y copia vsort en vec.
+            //-Reads sortpart and vec, writes vsort and copies vsort to vec.
+            bytes = n * (sizeof(unsigned) * 5 + 4 * (sizeof(unsigned) + sizeof(word) + sizeof(unsigned) +
+                                                     sizeof(tdouble3) + sizeof(tfloat4)));
+            break;
+        case BENCH_SymplecticPre:
+            //-Lee VelrhopPre,Ar,Ace,PosPre y escribe Velrhop,Pos,Dcell.
+            //-Reads VelrhopPre,Ar,Ace,PosPre and writes Velrhop,Pos,Dcell.
+            bytes = n * (sizeof(tfloat4) * 2 + sizeof(float) + sizeof(tfloat3) + sizeof(tdouble3) * 2 +
+                         sizeof(unsigned) + shift);
+            break;
+        case BENCH_SymplecticCorr:
+            //-Lee VelrhopPre,Velrhop,Ar,Ace,PosPre y escribe Velrhop,Pos,Dcell.
+            //-Reads VelrhopPre,Velrhop,Ar,Ace,PosPre and writes Velrhop,Pos,Dcell.
+            bytes = n * (sizeof(tfloat4) * 3 + sizeof(float) + sizeof(tfloat3) + sizeof(tdouble3) * 2 +
+                         sizeof(unsigned) + shift);
+            break;
+        case BENCH_Periodic:
+            bytes = n * (sizeof(tdouble3) + sizeof(word));
+            break;
+        default:
+            bytes = 0;
+    }
+    return (bytes);
+}
+
+//==============================================================================
+/// Ejecuta warmup repeticiones sin medir y reps repeticiones medidas, y
+/// devuelve media, desviacion estandar y minimo.
+/// Runs warmup unmeasured repetitions and reps measured repetitions, and
+/// returns mean, standard deviation and minimum.
+//==============================================================================
+JSphCpuBench::StBenchResult JSphCpuBench::Measure(TpBench test, unsigned warmup, unsigned reps) {
+    const char met[] = "Measure";
+    if (!CellDivSingle)RunException(met, "The benchmark is not configured.");
+    if (!reps)RunException(met, "The number of repetitions must be greater than zero.");
+    if (test == BENCH_Periodic && !PeriActive)RunException(met, "RunPeriodic() requires periodic conditions.");
+    for (unsigned c = 0; c < warmup; c++)RunTest(test);
+    std::vector<double> times(reps);
+    for (unsigned c = 0; c < reps; c++)times[c] = RunTest(test);
+    StBenchResult res;
+    res.test = test;
+    res.np = NpNormal;
+    res.reps = reps;
+    double sum = 0, tmin = DBL_MAX;
+    for (unsigned c = 0; c < reps; c++) {
+        sum += times[c];
+        tmin = min(tmin, times[c]);
+    }
+    const double tmean = sum / reps;
+    double var = 0;
+    for (unsigned c = 0; c < reps; c++)var += (times[c] - tmean) * (times[c] - tmean);
+    res.tmean = tmean;
+    res.tstd = (reps > 1 ? sqrt(var / (reps - 1)) : 0);
+    res.tmin = tmin;
+    res.items = GetItems(test);
+    res.bytes = GetBytes(test);
+    return (res);
+}
+
@@ -0,0 +1,120 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JSphCpuBench.h \brief Declares the class \ref JSphCpuBench.
+
+#ifndef _JSphCpuBench_
+#define _JSphCpuBench_
+
+#include "Types.h"
+#include "JSphCpuSingle.h"
+#include <string>
+#include <vector>
+
+//##############################################################################
+//# JSphCpuBench
+//##############################################################################
+/// \brief Runs the main CPU kernels in isolation on a synthetic lattice of
+/// particles (without XML case) to measure their throughput.
+
+class JSphCpuBench : public JSphCpuSingle
+{
+public:
+  ///Tipos de benchmark. Types of benchmark.
+  typedef enum{
+    BENCH_ForcesFluid=0,    ///<Interaccion de fluido (InteractionForcesFluid). Fluid interaction.
+    BENCH_ForcesBound=1,    ///<Interaccion de contorno (InteractionForcesBound). Boundary interaction.
+    BENCH_Divide=2,         ///<JCellDivCpuSingle::Divide().
+    BENCH_SortArray=3,      ///<SortArray() de los arrays basicos. SortArray() of the basic arrays.
+    BENCH_SymplecticPre=4,  ///<ComputeSymplecticPreT().
+    BENCH_SymplecticCorr=5, ///<ComputeSymplecticCorrT().
+    BENCH_Periodic=6        ///<RunPeriodic().
+  }TpBench;
+
+  ///Configuracion de la malla sintetica. Configuration of the synthetic lattice.
+  typedef struct{
+    unsigned np;    ///<Numero aproximado de particulas. Approximate number of particles.
+    bool sim2d;     ///<Simulacion 2D. 2D simulation.
+    double fill;    ///<Fraccion de la altura del tanque con fluido. Fraction of the tank height filled with fluid.
+    double dp;      ///<Distancia entre particulas. Distance between particles.
+    bool perix;     ///<Condiciones periodicas en X (sin paredes en X). Periodic conditions in X (without walls in X).
+    TpFtMode ftmode;///<Objeto flotante: None, SPH o DEM. Floating object: None, SPH or DEM.
+  }StBenchCase;
+
+  ///Opciones de fisica (parametros template). Physics options (template parameters).
+  typedef struct{
+    TpKernel tkernel;
+    TpVisco tvisco;
+    TpDeltaSph tdelta;
+    TpShifting tshifting;
+    bool psimple;
+  }StBenchPhysics;
+
+  ///Resultado de un benchmark. Result of one benchmark.
+  typedef struct{
+    TpBench test;
+    unsigned np;     ///<Numero de particulas. Number of particles.
+    unsigned reps;   ///<Numero de repeticiones medidas. Number of measured repetitions.
+    double tmean;    ///<Tiempo medio por repeticion (ms). Mean time per repetition (ms).
+    double tstd;     ///<Desviacion estandar (ms). Standard deviation (ms).
+    double tmin;     ///<Tiempo minimo (ms). Minimum time (ms).
+    double items;    ///<Pares o particulas procesadas por repeticion. Pairs or particles processed per repetition.
+    double bytes;    ///<Bytes estimados por repeticion (0:sin estimacion). Estimated bytes per repetition (0:no estimation).
+  }StBenchResult;
+
+  static std::string GetBenchName(TpBench test);
+  static std::string GetBenchUnit(TpBench test);
+  static std::string GetConfigStr(const StBenchCase &bc,const StBenchPhysics &bph);
+
+private:
+  StBenchCase Bc;
+  StBenchPhysics Bph;
+  ullong PairsFluid;    ///<Pares de interaccion de las particulas fluid. Interaction pairs of fluid particles.
+  ullong PairsBound;    ///<Pares de interaccion de las particulas bound. Interaction pairs of boundary particles.
+  unsigned NpNormal;    ///<Numero de particulas sin periodicas. Number of particles without periodic ones.
+
+  //-Arrays auxiliares para BENCH_SortArray. Auxiliary arrays for BENCH_SortArray.
+  tpartid *SortIdp;
+  word *SortCode;
+  unsigned *SortDcell;
+  tdouble3 *SortPos;
+  tfloat4 *SortVelrhop;
+
+  void FreeSortArrays();
+  void AllocSortArrays();
+  void CreateLattice(std::vector<tdouble3> &pos,unsigned &nfixed,unsigned &nfloat,unsigned &nfluid,double &hswl)const;
+  void ConfigPhysics(double hswl);
+  void ConfigParts(const std::vector<tdouble3> &pos,unsigned nfixed,unsigned nfloat,unsigned nfluid);
+  void ConfigDomainBench(const std::vector<tdouble3> &pos,double hswl);
+  ullong CountPairs(unsigned pini,unsigned pfin,unsigned cellinitial)const;
+  void RunForces(bool fluid);
+  double RunTest(TpBench test);
+  double GetItems(TpBench test)const;
+  double GetBytes(TpBench test)const;
+
+public:
+  JSphCpuBench(JLog2 *log,int ompthreads,const std::string &dirout);
+  ~JSphCpuBench();
+  void Config(const StBenchCase &bc,const StBenchPhysics &bph);
+  StBenchResult Measure(TpBench test,unsigned warmup,unsigned reps);
+  unsigned GetNp()const{ return(Np); }
+  int GetOmpThreads()const{ return(OmpThreads); }
+};
+
+#endif
+
+
@@ -0,0 +1,694 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JSphCpuMpi.cpp \brief Implements the class \ref JSphCpuMpi.
+
+#include "JSphCpuMpi.h"
+#include "JCellDivCpuSingle.h"
+#include "JArraysCpu.h"
+#include "JPartsLoad4.h"
+#include "JCfgRun.h"
+#include "Functions.h"
+#include <climits>
+#include <cstring>
+#include <mpi.h>
+
+using namespace std;
+
+#define MPIDEST_NONE 0xFFFFFFFF   ///<La particula no se envia. The particle is not sent.
+#define MPIDEST_HALOL 0x40000000  ///<Copia de halo para el slab anterior. Halo copy for the previous slab.
+#define MPIDEST_HALOR 0x20000000  ///<Copia de halo para el slab siguiente. Halo copy for the next slab.
+#define MPIDEST_MASK 0x1FFFFFFF   ///<Slab propietario. Owner slab.
+
+//==============================================================================
+/// Copia un valor en el buffer y devuelve la siguiente posicion.
+/// Copies a value in the buffer and returns the next position.
+//==============================================================================
+template<class T> inline byte *PackValue(byte *ptr, const T &v) {
+    memcpy(ptr, &v, sizeof(T));
+    return (ptr + sizeof(T));
+}
+
+//==============================================================================
+/// Lee un valor del buffer y devuelve la siguiente posicion.
+/// Reads a value from the buffer and returns the next position.
+//==============================================================================
+template<class T> inline const byte *UnpackValue(const byte *ptr, T &v) {
+    memcpy(&v, ptr, sizeof(T));
+    return (ptr + sizeof(T));
+}
+
+//==============================================================================
+/// Constructor.
+//==============================================================================
+JSphCpuMpi::JSphCpuMpi() : JSphCpuSingle(true) {
+    ClassName = "JSphCpuMpi";
+    MPI_Comm_rank(MPI_COMM_WORLD, &MpiRank);
+    MPI_Comm_size(MPI_COMM_WORLD, &MpiSize);
+    HaloCells = 0;
+    NpbHalo = NpfHalo = 0;
+    MigrateCount = HaloCount = 0;
+    ExchangeCount = 0;
+    BalanceSteps = 0;
+    BalanceTol = 0;
+    BalanceNextStep = 0;
+    BalanceTime0 = 0;
+    BalanceChecks = BalanceMoves = 0;
+    BalanceImbSum = BalanceImbMax = 0;
+    SendCount.resize(MpiSize);
+    SendDispl.resize(MpiSize);
+    RecvCount.resize(MpiSize);
+    RecvDispl.resize(MpiSize);
+}
+
+//==============================================================================
+/// Destructor.
+//==============================================================================
+JSphCpuMpi::~JSphCpuMpi() {
+}
+
+//==============================================================================
+/// Carga la configuracion de ejecucion y comprueba las opciones que no estan
+/// disponibles con MPI.
+/// Loads the execution configuration and checks the options that are not
+/// available with MPI.
+//==============================================================================
+void JSphCpuMpi::LoadConfig(JCfgRun *cfg) {
+    const char met[] = "LoadConfig";
+    JSphCpuSingle::LoadConfig(cfg);
+    if (!RestartFile.empty() || CheckpointTime > 0)RunException(met, "Checkpoints are not supported with MPI.");
+    if (cfg->SvTimersStep || cfg->SvTrace || cfg->SvStatus || cfg->SvMemory || cfg->BenchSteps)
+        RunException(met, "The options -svtimersstep, -svtrace, -svstatus, -svmemory and -bench are not supported with MPI.");
+    //-Solo el proceso 0 graba Run.csv.
+    //-Only process 0 stores Run.csv.
+    if (MpiRank)SvRes = false;
+    Log->Print(fun::VarStr("MpiProcesses", MpiSize));
+    //-Cada proceso graba su pieza del PART (Part_pXX_NNNN.bi4).
+    //-Each process saves its piece of PART (Part_pXX_NNNN.bi4).
+    if (MpiSize > 1)Log->Print("*** PARTs are saved in one piece per process. ToVtk4 and PartDiff merge the pieces, other bundled tools only read piece p00.");
+    //-El equilibrado de carga necesita el tiempo de CfForces.
+    //-The load balancing needs the time of CfForces.
+    BalanceSteps = (MpiSize > 1 ? cfg->MpiBalanceSteps : 0);
+    BalanceTol = cfg->MpiBalanceTol;
+    BalanceNextStep = int(BalanceSteps);
+    if (BalanceSteps) {
+        TmcActive(Timers, TMC_CfForces, true);
+        Log->Print(fun::VarStr("MpiBalanceSteps", BalanceSteps) + " " + fun::VarStr("MpiBalanceTol", BalanceTol));
+    }
+}
+
+//==============================================================================
+/// Solo el proceso 0 carga las particulas del caso y envia los limites del
+/// dominio al resto. Cada proceso recibe las particulas de su slab en
+/// ConfigDomain().
+/// Only process 0 loads the particles of the case and sends the limits of the
+/// domain to the others. Each process receives the particles of its slab in
+/// ConfigDomain().
+//==============================================================================
+void JSphCpuMpi::LoadCaseParticles() {
+    if (!MpiRank)JSphCpuSingle::LoadCaseParticles();
+    int sim2d = (Simulate2D ? 1 : 0);
+    MPI_Bcast(&sim2d, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&CasePosMin, 3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&CasePosMax, 3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&MapRealPosMin, 3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&MapRealPosMax, 3, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&PartBeginTimeStep, 1, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(&PartBeginTotalNp, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+    if (MpiRank) {
+        Simulate2D = (sim2d != 0);
+        ConfigMapLimits();
+    }
+}
+
+//==============================================================================
+/// Devuelve la columna de celdas del mapa (eje X ordenado) de una posicion.
+/// Returns the column of map cells (ordered X axis) of a position.
+//==============================================================================
+unsigned JSphCpuMpi::GetMapCellX(const tdouble3 &ps) const {
+    const double dx = ps.x - Map_PosMin.x;
+    const unsigned cx = (dx > 0 ? unsigned(dx / Scell) : 0);
+    return (cx < Map_Cells.x ? cx : Map_Cells.x - 1);
+}
+
+//==============================================================================
+/// Calcula los limites de los slabs con el mismo coste acumulado por columna de
+/// celdas y una anchura minima de HaloCells+1 celdas, de forma que las copias
+/// de halo siempre proceden de los slabs vecinos.
+/// Computes the slab limits with the same accumulated cost per column of cells
+/// and a minimum width of HaloCells+1 cells, so halo copies always come from
+/// the neighbour slabs.
+//==============================================================================
+void JSphCpuMpi::ComputeSlabCuts(const std::vector<double> &colcost, std::vector<unsigned> &slabcel) const {
+    const unsigned ncx = Map_Cells.x;
+    const unsigned nslab = unsigned(MpiSize);
+    const unsigned wmin = HaloCells + 1;
+    double total = 0;
+    for (unsigned c = 0; c < ncx; c++)total += colcost[c];
+    //-Limites de slab por coste acumulado.
+    //-Slab limits by accumulated cost.
+    slabcel.assign(nslab + 1, 0);
+    slabcel[nslab] = ncx;
+    double acc = 0;
+    unsigned cx = 0;
+    for (unsigned cs = 1; cs < nslab; cs++) {
+        const double target = (total * cs) / nslab;
+        while (cx < ncx && acc + colcost[cx] <= target)acc += colcost[cx++];
+        slabcel[cs] = cx;
+    }
+    //-Aplica la anchura minima.
+    //-Applies the minimum width.
+    for (unsigned cs = 1; cs < nslab; cs++) {
+        slabcel[cs] = max(slabcel[cs], slabcel[cs - 1] + wmin);
+        slabcel[cs] = min(slabcel[cs], ncx - (nslab - cs) * wmin);
+    }
+}
+
+//==============================================================================
+/// Asigna el slab de cada columna de celdas segun SlabCel.
+/// Assigns the slab of each column of cells according to SlabCel.
+//==============================================================================
+void JSphCpuMpi::UpdateCellSlab() {
+    CellSlab.resize(Map_Cells.x);
+    for (unsigned cs = 0; cs < unsigned(MpiSize); cs++)
+        for (unsigned c = SlabCel[cs]; c < SlabCel[cs + 1]; c++)CellSlab[c] = cs;
+}
+
+//==============================================================================
+/// Divide las columnas de celdas en slabs con el mismo numero de particulas.
+/// Solo el proceso 0 tiene las particulas y envia la cuenta por columna.
+/// Splits the columns of cells in slabs with the same number of particles.
+/// Only process 0 has the particles and sends the count per column.
+//==============================================================================
+void JSphCpuMpi::ConfigSlabs(unsigned np, const tdouble3 *pos) {
+    const char met[] = "ConfigSlabs";
+    const unsigned ncx = Map_Cells.x;
+    const unsigned nslab = unsigned(MpiSize);
+    if (ncx < nslab * (HaloCells + 1))
+        RunException(met, fun::PrintStr("The domain has %u cells along the division axis, %u processes need at least %u.",
+                                        ncx, nslab, nslab * (HaloCells + 1)));
+    //-Particulas por columna de celdas (el caso esta en el sistema del caso, no ordenado).
+    //-Particles per column of cells (the case is in the case system, not ordered).
+    vector<double> ncol(ncx, 0);
+    for (unsigned p = 0; p < np; p++)ncol[GetMapCellX(OrderCode(pos[p]))]++;
+    MPI_Bcast(&ncol[0], int(ncx), MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    ComputeSlabCuts(ncol, SlabCel);
+    UpdateCellSlab();
+    //-Muestra configuracion.
+    //-Shows configuration.
+    string tx;
+    for (unsigned cs = 0; cs < nslab; cs++) {
+        double n = 0;
+        for (unsigned c = SlabCel[cs]; c < SlabCel[cs + 1]; c++)n += ncol[c];
+        tx = tx + fun::PrintStr("%s%u-%u(%.0f)", (cs ? " " : ""), SlabCel[cs], SlabCel[cs + 1], n);
+    }
+    Log->Print(string("MpiSlabs (cells and particles): ") + tx);
+}
+
+//==============================================================================
+/// Calcula los pares candidatos de la interaccion en cada columna de celdas del
+/// slab propio (cero en el resto) con las celdas del ultimo divide. Cada
+/// particula fluid interactua con bound y fluid y cada bound con fluid.
+/// Computes the candidate pairs of the interaction in each column of cells of
+/// the own slab (zero for the rest) with the cells of the last divide. Each
+/// fluid particle interacts with bound and fluid and each bound with fluid.
+//==============================================================================
+void JSphCpuMpi::ComputeColumnPairs(std::vector<double> &colpairs) {
+    colpairs.assign(Map_Cells.x, 0);
+    const tuint3 ncells = CellDivSingle->GetNcells();
+    const int ncx = int(ncells.x), ncy = int(ncells.y), ncz = int(ncells.z);
+    const unsigned nsheet = ncells.x * ncells.y;
+    const unsigned cellfluid = nsheet * ncells.z + 1;
+    const unsigned gx0 = DomCelIni.x + CellDivSingle->GetCellDomainMin().x;
+    const int hdiv = (CellMode == CELLMODE_H ? 2 : 1);
+    const unsigned *begincell = CellDivSingle->GetBeginCell();
+    for (int z = 0; z < ncz; z++)for (int y = 0; y < ncy; y++)for (int x = 0; x < ncx; x++) {
+        const unsigned c = unsigned(x) + ncells.x * y + nsheet * z;
+        const unsigned nb = begincell[c + 1] - begincell[c];
+        const unsigned nf = begincell[cellfluid + c + 1] - begincell[cellfluid + c];
+        const unsigned gx = gx0 + unsigned(x);
+        if ((!nb && !nf) || gx >= Map_Cells.x || CellSlab[gx] != unsigned(MpiRank))continue;
+        ullong nbn = 0, nfn = 0;
+        for (int z2 = max(z - hdiv, 0); z2 < min(z + hdiv + 1, ncz); z2++)
+            for (int y2 = max(y - hdiv, 0); y2 < min(y + hdiv + 1, ncy); y2++) {
+                const unsigned c2ini = unsigned(max(x - hdiv, 0)) + ncells.x * y2 + nsheet * z2;
+                const unsigned c2fin = unsigned(min(x + hdiv + 1, ncx)) + ncells.x * y2 + nsheet * z2;
+                nbn += begincell[c2fin] - begincell[c2ini];
+                nfn += begincell[cellfluid + c2fin] - begincell[cellfluid + c2ini];
+            }
+        colpairs[gx] += double(nf) * double(nbn + nfn) + double(nb) * double(nfn);
+    }
+}
+
+//==============================================================================
+/// Comprueba el desequilibrio del calculo de fuerzas entre procesos desde la
+/// ultima comprobacion y, si supera BalanceTol, mueve los limites de los slabs
+/// segun el coste de cada columna de celdas: los pares candidatos de la columna
+/// por el tiempo medido por par del proceso propietario. Cada limite se mueve
+/// como mucho HaloCells+1 celdas por comprobacion para amortiguar el ruido de
+/// la medida. Devuelve true cuando cambia el dominio local.
+/// Checks the imbalance of the force computation among processes since the
+/// last check and, when it exceeds BalanceTol, moves the slab limits according
+/// to the cost of each column of cells: the candidate pairs of the column times
+/// the measured time per pair of the owner process. Each limit moves at most
+/// HaloCells+1 cells per check to damp the noise of the measurement. Returns
+/// true when the local domain changes.
+//==============================================================================
+bool JSphCpuMpi::RunBalance() {
+    const unsigned nslab = unsigned(MpiSize);
+    BalanceNextStep = Nstep + int(BalanceSteps);
+    //-Tiempo de fuerzas de cada proceso desde la ultima comprobacion.
+    //-Force time of each process since the last check.
+    const double tforces = TmcGetValue(Timers, TMC_CfForces);
+    double tlocal = tforces - BalanceTime0;
+    BalanceTime0 = tforces;
+    vector<double> tproc(nslab);
+    MPI_Allgather(&tlocal, 1, MPI_DOUBLE, &tproc[0], 1, MPI_DOUBLE, MPI_COMM_WORLD);
+    double tmax = 0, tsum = 0;
+    for (unsigned cs = 0; cs < nslab; cs++) {
+        tmax = max(tmax, tproc[cs]);
+        tsum += tproc[cs];
+    }
+    const double imb = (tsum > 0 ? tmax * nslab / tsum : 1);
+    BalanceChecks++;
+    BalanceImbSum += imb;
+    BalanceImbMax = max(BalanceImbMax, imb);
+    if (imb < 1. + BalanceTol)return (false);
+    //-Coste de cada columna de celdas.
+    //-Cost of each column of cells.
+    vector<double> colcost, colcostg(Map_Cells.x);
+    ComputeColumnPairs(colcost);
+    double npairs = 0;
+    for (unsigned c = 0; c < Map_Cells.x; c++)npairs += colcost[c];
+    const double tpair = (npairs > 0 ? tlocal / npairs : 0);
+    for (unsigned c = 0; c < Map_Cells.x; c++)colcost[c] *= tpair;
+    MPI_Allreduce(&colcost[0], &colcostg[0], int(Map_Cells.x), MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+    //-Nuevos limites con desplazamiento limitado.
+    //-New limits with limited displacement.
+    vector<unsigned> slabcel;
+    ComputeSlabCuts(colcostg, slabcel);
+    const unsigned wmin = HaloCells + 1;
+    for (unsigned cs = 1; cs < nslab; cs++) {
+        slabcel[cs] = max(min(slabcel[cs], SlabCel[cs] + wmin), SlabCel[cs] - min(SlabCel[cs], wmin));
+        slabcel[cs] = max(slabcel[cs], slabcel[cs - 1] + wmin);
+    }
+    for (unsigned cs = nslab - 1; cs > 0; cs--)slabcel[cs] = min(slabcel[cs], slabcel[cs + 1] - wmin);
+    if (slabcel == SlabCel)return (false);
+    BalanceMoves++;
+    string tx;
+    for (unsigned cs = 0; cs < nslab; cs++)tx = tx + fun::PrintStr("%s%u-%u", (cs ? " " : ""), slabcel[cs], slabcel[cs + 1]);
+    Log->Printf("MpiBalance  Step:%d  Imbalance:%.3f  Slabs: %s", Nstep, imb, tx.c_str());
+    const bool domchanged = (slabcel[MpiRank] != SlabCel[MpiRank] || slabcel[MpiRank + 1] != SlabCel[MpiRank + 1]);
+    SlabCel = slabcel;
+    UpdateCellSlab();
+    if (domchanged) {
+        SelecSlabDomain();
+        CellDivSingle->DefineDomain(DomCellCode, DomCelIni, DomCelFin, DomPosMin, DomPosMax);
+    }
+    return (domchanged);
+}
+
+//==============================================================================
+/// Selecciona el dominio local: el slab del proceso mas HaloCells+1 celdas a
+/// cada lado para las copias de halo y las particulas que salen del slab.
+/// Selects the local domain: the slab of the process plus HaloCells+1 cells at
+/// each side for halo copies and particles leaving the slab.
+//==============================================================================
+void JSphCpuMpi::SelecSlabDomain() {
+    const unsigned c0 = SlabCel[MpiRank], c1 = SlabCel[MpiRank + 1];
+    const unsigned celini = c0 - min(c0, HaloCells + 1);
+    const unsigned celfin = min(c1 + HaloCells + 1, Map_Cells.x);
+    SelecDomain(TUint3(celini, 0, 0), TUint3(celfin, Map_Cells.y, Map_Cells.z));
+}
+
+//==============================================================================
+/// Configura el dominio local. El proceso 0 envia a cada proceso solo las
+/// particulas de su slab y las copias de halo se crean en el primer divide.
+/// Configures the local domain. Process 0 sends each process only the particles
+/// of its slab and the halo copies are created in the first divide.
+//==============================================================================
+void JSphCpuMpi::ConfigDomain() {
+    const char met[] = "ConfigDomain";
+    if (PeriActive)RunException(met, "Periodic conditions are not supported with MPI.");
+    if (CaseNfloat)RunException(met, "Floating bodies are not supported with MPI.");
+    //-Aplica CellOrder a las constantes y configura la division en celdas.
+    //-Applies CellOrder to the constants and configures the cell division.
+    ConfigCellOrder(CellOrder, 0, NULL, NULL);
+    ConfigCellDivision();
+    HaloCells = Hdiv;
+    const unsigned nslab = unsigned(MpiSize);
+    const unsigned npcase = (PartsLoaded ? PartsLoaded->GetCount() : 0);
+    const tpartid *idp = (PartsLoaded ? PartsLoaded->GetIdp() : NULL);
+    const tdouble3 *pos = (PartsLoaded ? PartsLoaded->GetPos() : NULL);
+    const tfloat4 *velrhop = (PartsLoaded ? PartsLoaded->GetVelRhop() : NULL);
+    ConfigSlabs(npcase, pos);
+    //-Cuenta las particulas de cada slab (bound y fluid) y las envia a cada proceso.
+    //-Counts the particles of each slab (bound and fluid) and sends them to each process.
+    vector<unsigned> nslabp(nslab * 2, 0);
+    for (unsigned p = 0; p < npcase; p++)
+        nslabp[CellSlab[GetMapCellX(OrderCode(pos[p]))] * 2 + (idp[p] < CaseNpb ? 0 : 1)]++;
+    unsigned npl[2];
+    MPI_Scatter(&nslabp[0], 2, MPI_UNSIGNED, npl, 2, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+    const unsigned npb = npl[0], npf = npl[1];
+    Np = npb + npf;
+    Npb = npb;
+    NpbOk = Npb;
+    //-Empaqueta las particulas de cada slab (primero bound y despues fluid).
+    //-Packs the particles of each slab (first bound and then fluid).
+    const unsigned rsize = unsigned(sizeof(tpartid) + sizeof(tdouble3) + sizeof(tfloat4));
+    if (ullong(npcase) * rsize > INT_MAX || ullong(Np) * rsize > INT_MAX)
+        RunException(met, "The size of the particles of the case is too big to be sent.");
+    if (!MpiRank) {
+        ullong nsend = 0;
+        for (unsigned cs = 0; cs < nslab; cs++) {
+            SendCount[cs] = int((nslabp[cs * 2] + nslabp[cs * 2 + 1]) * rsize);
+            SendDispl[cs] = int(nsend);
+            nsend += SendCount[cs];
+        }
+        SendBuf.resize(size_t(nsend) + 1);
+        vector<byte *> sendptr(nslab * 2);
+        for (unsigned cs = 0; cs < nslab; cs++) {
+            sendptr[cs * 2] = &SendBuf[0] + SendDispl[cs];
+            sendptr[cs * 2 + 1] = sendptr[cs * 2] + nslabp[cs * 2] * rsize;
+        }
+        for (unsigned p = 0; p < npcase; p++) {
+            byte *&ptr = sendptr[CellSlab[GetMapCellX(OrderCode(pos[p]))] * 2 + (idp[p] < CaseNpb ? 0 : 1)];
+            ptr = PackValue(ptr, idp[p]);
+            ptr = PackValue(ptr, pos[p]);
+            ptr = PackValue(ptr, velrhop[p]);
+        }
+        delete PartsLoaded;
+        PartsLoaded = NULL;
+    }
+    RecvBuf.resize(size_t(Np) * rsize + 1);
+    MPI_Scatterv((SendBuf.empty() ? NULL : &SendBuf[0]), &SendCount[0], &SendDispl[0], MPI_BYTE, &RecvBuf[0],
+                 int(Np * rsize), MPI_BYTE, 0, MPI_COMM_WORLD);
+    //-Reserva memoria y copia las particulas del slab.
+    //-Allocates memory and copies the particles of the slab.
+    AllocCpuMemoryFixed();
+    AllocCpuMemoryParticles(Np + unsigned(MPIHALO_OVERMEMORYNP * Np), 0);
+    ReserveBasicArraysCpu();
+    const byte *ptr = &RecvBuf[0];
+    for (unsigned p = 0; p < Np; p++) {
+        ptr = UnpackValue(ptr, Idpc[p]);
+        ptr = UnpackValue(ptr, Posc[p]);
+        ptr = UnpackValue(ptr, Velrhopc[p]);
+    }
+    LoadCodeParticles(Np, Idpc, Codec);
+    if (CellOrder != ORDER_XYZ) {
+        OrderCodeData(CellOrder, Np, Posc);
+        OrderCodeData(CellOrder, Np, Velrhopc);
+    }
+    Log->Printf("Particles of the slab: %u (%u bound + %u fluid)", Np, Npb, Np - Npb);
+
+    //-Dominio local del slab.
+    //-Local domain of the slab.
+    SelecSlabDomain();
+    LoadDcellParticles(Np, Codec, Posc, Dcellc);
+
+    CellDivSingle = new JCellDivCpuSingle(Stable, FtCount != 0, PeriActive, CellOrder, CellMode, Scell, Map_PosMin,
+                                          Map_PosMax, Map_Cells, CaseNbound, CaseNfixed, CaseNpb, Log, DirOut);
+    CellDivSingle->DefineDomain(DomCellCode, DomCelIni, DomCelFin, DomPosMin, DomPosMax);
+    ConfigCellDiv((JCellDivCpu *) CellDivSingle);
+
+    //-Cada proceso graba su parte de los PARTs.
+    //-Each process stores its piece of the PARTs.
+    const tuint3 ax = OrderDecode(TUint3(1, 0, 0));
+    ConfigSaveData(unsigned(MpiRank), unsigned(MpiSize), (ax.x ? "X" : (ax.y ? "Y" : "Z")));
+
+    //-Crea las copias de halo y reordena las particulas en celdas.
+    //-Creates the halo copies and sorts the particles in cells.
+    BoundChanged = true;
+    RunCellDivide(true);
+}
+
+//==============================================================================
+/// Devuelve los bytes por particula en los intercambios segun los arrays
+/// activos (igual en todos los procesos).
+/// Returns the bytes per particle in the exchanges according to the active
+/// arrays (the same in all processes).
+//==============================================================================
+unsigned JSphCpuMpi::GetRecordSize() const {
+    unsigned s = sizeof(tpartid) + sizeof(word) + sizeof(tdouble3) + sizeof(tfloat4);
+    if (VelrhopM1c)s += sizeof(tfloat4);
+    if (PosPrec)s += sizeof(tdouble3);
+    if (VelrhopPrec)s += sizeof(tfloat4);
+    if (SpsTauc)s += sizeof(tsymatrix3f);
+    return (s);
+}
+
+//==============================================================================
+/// Copia los datos de la particula p en el buffer con el code indicado.
+/// Copies the data of particle p in the buffer with the given code.
+//==============================================================================
+byte *JSphCpuMpi::PackParticle(unsigned p, word code, byte *ptr) const {
+    ptr = PackValue(ptr, Idpc[p]);
+    ptr = PackValue(ptr, code);
+    ptr = PackValue(ptr, Posc[p]);
+    ptr = PackValue(ptr, Velrhopc[p]);
+    if (VelrhopM1c)ptr = PackValue(ptr, VelrhopM1c[p]);
+    if (PosPrec)ptr = PackValue(ptr, PosPrec[p]);
+    if (VelrhopPrec)ptr = PackValue(ptr, VelrhopPrec[p]);
+    if (SpsTauc)ptr = PackValue(ptr, SpsTauc[p]);
+    return (ptr);
+}
+
+//==============================================================================
+/// Copia los datos de una particula del buffer en la posicion p.
+/// Copies the data of one particle from the buffer in position p.
+//==============================================================================
+const byte *JSphCpuMpi::UnpackParticle(const byte *ptr, unsigned p) {
+    ptr = UnpackValue(ptr, Idpc[p]);
+    ptr = UnpackValue(ptr, Codec[p]);
+    ptr = UnpackValue(ptr, Posc[p]);
+    ptr = UnpackValue(ptr, Velrhopc[p]);
+    if (VelrhopM1c)ptr = UnpackValue(ptr, VelrhopM1c[p]);
+    if (PosPrec)ptr = UnpackValue(ptr, PosPrec[p]);
+    if (VelrhopPrec)ptr = UnpackValue(ptr, VelrhopPrec[p]);
+    if (SpsTauc)ptr = UnpackValue(ptr, SpsTauc[p]);
+    return (ptr);
+}
+
+//==============================================================================
+/// Intercambia particulas con los otros procesos antes del divide:
+/// - Las copias de halo anteriores se marcan para ignorar.
+/// - Las particulas que salen del slab se envian a su nuevo proceso.
+/// - Las particulas a menos de HaloCells celdas del borde de su slab se envian
+///   como copias de halo (CODE_PERIODIC) al slab vecino.
+/// Las particulas recibidas se anyaden al final, primero bound y despues fluid,
+/// y se indican en NpbPer y NpfPer para el divide.
+/// Exchanges particles with the other processes before the divide:
+/// - The previous halo copies are marked to be ignored.
+/// - The particles leaving the slab are sent to their new process.
+/// - The particles within HaloCells cells of the border of their slab are sent
+///   as halo copies (CODE_PERIODIC) to the neighbour slab.
+/// The received particles are appended at the end, first bound and then fluid,
+/// and they are indicated in NpbPer and NpfPer for the divide.
+//==============================================================================
+void JSphCpuMpi::MpiExchange() {
+    const char met[] = "MpiExchange";
+    const unsigned rank = unsigned(MpiRank);
+    const unsigned nslab = unsigned(MpiSize);
+    const unsigned np = Np;
+    //-Calcula el destino de cada particula.
+    //-Computes the destination of each particle.
+    unsigned *dest = ArraysCpu->ReserveUint();
+    const llong n = llong(np);
+#ifdef _WITHOMP
+#pragma omp parallel for schedule (static) if(n>LIMIT_COMPUTELIGHT_OMP)
+#endif
+    for (llong p = 0; p < n; p++) {
+        const word rcode = Codec[p];
+        const word rcodsp = CODE_GetSpecialValue(rcode);
+        unsigned d = MPIDEST_NONE;
+        if (rcodsp == CODE_PERIODIC)Codec[p] = CODE_SetOutIgnore(rcode);
+        else if (rcodsp == CODE_NORMAL) {
+            const unsigned cx = GetMapCellX(Posc[p]);
+            const unsigned cs = CellSlab[cx];
+            d = cs;
+            if (cs > 0 && cx < SlabCel[cs] + HaloCells)d |= MPIDEST_HALOL;
+            if (cs + 1 < nslab && cx >= SlabCel[cs + 1] - HaloCells)d |= MPIDEST_HALOR;
+        }
+        dest[p] = d;
+    }
+    //-Cuenta particulas por proceso destino.
+    //-Counts particles per destination process.
+    for (unsigned cs = 0; cs < nslab; cs++)SendCount[cs] = 0;
+    for (unsigned p = 0; p < np; p++) {
+        const unsigned d = dest[p];
+        if (d == rank || d == MPIDEST_NONE)continue;
+        const unsigned cs = (d & MPIDEST_MASK);
+        if (cs != rank)SendCount[cs]++;
+        if ((d & MPIDEST_HALOL) && cs - 1 != rank)SendCount[cs - 1]++;
+        if ((d & MPIDEST_HALOR) && cs + 1 != rank)SendCount[cs + 1]++;
+    }
+    //-Empaqueta las particulas y actualiza el code de las que salen del slab.
+    //-Packs the particles and updates the code of the ones leaving the slab.
+    const unsigned rsize = GetRecordSize();
+    ullong nsend = 0;
+    for (unsigned cs = 0; cs < nslab; cs++) {
+        SendDispl[cs] = int(nsend * rsize);
+        nsend += SendCount[cs];
+    }
+    if (nsend * rsize > INT_MAX)RunException(met, "The size of the exchange is too big.");
+    SendBuf.resize(size_t(nsend * rsize) + 1);
+    vector<byte *> sendptr(nslab);
+    for (unsigned cs = 0; cs < nslab; cs++)sendptr[cs] = &SendBuf[0] + SendDispl[cs];
+    unsigned nhalob = 0, nhalof = 0;
+    for (unsigned p = 0; p < np; p++) {
+        const unsigned d = dest[p];
+        if (d == rank || d == MPIDEST_NONE)continue;
+        const unsigned cs = (d & MPIDEST_MASK);
+        const word rcode = Codec[p];
+        bool localhalo = false;
+        if (cs != rank)sendptr[cs] = PackParticle(p, rcode, sendptr[cs]);
+        if (d & MPIDEST_HALOL) {
+            if (cs - 1 != rank)sendptr[cs - 1] = PackParticle(p, CODE_SetPeriodic(rcode), sendptr[cs - 1]);
+            else localhalo = true;
+        }
+        if (d & MPIDEST_HALOR) {
+            if (cs + 1 != rank)sendptr[cs + 1] = PackParticle(p, CODE_SetPeriodic(rcode), sendptr[cs + 1]);
+            else localhalo = true;
+        }
+        //-La particula que sale del slab queda como copia de halo si esta cerca del borde.
+        //-The particle leaving the slab remains as halo copy when it is near the border.
+        if (cs != rank) {
+            Codec[p] = (localhalo ? CODE_SetPeriodic(rcode) : CODE_SetOutIgnore(rcode));
+            if (localhalo) {
+                if (CODE_GetType(rcode) < CODE_TYPE_FLOATING)nhalob++;
+                else nhalof++;
+            }
+        }
+    }
+    ArraysCpu->Free(dest);
+    dest = NULL;
+    //-Intercambia numeros de particulas y datos.
+    //-Exchanges numbers of particles and data.
+    MPI_Alltoall(&SendCount[0], 1, MPI_INT, &RecvCount[0], 1, MPI_INT, MPI_COMM_WORLD);
+    ullong nrecv = 0;
+    for (unsigned cs = 0; cs < nslab; cs++) {
+        RecvDispl[cs] = int(nrecv * rsize);
+        nrecv += RecvCount[cs];
+    }
+    if (nrecv * rsize > INT_MAX)RunException(met, "The size of the exchange is too big.");
+    RecvBuf.resize(size_t(nrecv * rsize) + 1);
+    for (unsigned cs = 0; cs < nslab; cs++) {
+        SendCount[cs] *= int(rsize);
+        RecvCount[cs] *= int(rsize);
+    }
+    MPI_Alltoallv(&SendBuf[0], &SendCount[0], &SendDispl[0], MPI_BYTE, &RecvBuf[0], &RecvCount[0], &RecvDispl[0],
+                  MPI_BYTE, MPI_COMM_WORLD);
+    //-Anyade las particulas recibidas, primero bound y despues fluid.
+    //-Appends the received particles, first bound and then fluid.
+    if (np + nrecv > CpuParticlesSize)ResizeParticlesSize(unsigned(np + nrecv), MPIHALO_OVERMEMORYNP, false);
+    unsigned pnew = np, nrecvb = 0, nmigrate = 0;
+    for (unsigned cbound = 0; cbound < 2; cbound++) {
+        const byte *ptr = &RecvBuf[0];
+        for (unsigned c = 0; c < nrecv; c++, ptr += rsize) {
+            word rcode;
+            UnpackValue(ptr + sizeof(tpartid), rcode);
+            const bool bound = (CODE_GetType(rcode) < CODE_TYPE_FLOATING);
+            if (bound == (cbound == 0)) {
+                UnpackParticle(ptr, pnew++);
+                if (bound)nrecvb++;
+                if (CODE_GetSpecialValue(rcode) == CODE_PERIODIC) {
+                    if (bound)nhalob++;
+                    else nhalof++;
+                } else nmigrate++;
+            }
+        }
+    }
+    LoadDcellParticles(unsigned(nrecv), Codec + np, Posc + np, Dcellc + np);
+    Np = unsigned(np + nrecv);
+    NpbPer = nrecvb;
+    NpfPer = unsigned(nrecv) - nrecvb;
+    NpbHalo = nhalob;
+    NpfHalo = nhalof;
+    MigrateCount += nmigrate;
+    HaloCount += nrecv - nmigrate;
+    ExchangeCount++;
+}
+
+//==============================================================================
+/// Intercambia particulas con los otros procesos y ejecuta el divide. Las copias
+/// de halo hacen el papel de las periodicas, por lo que solo se pueden crear con
+/// updateperiodic=true (el divide sin actualizar las periodicas solo se usa con
+/// -overlap, que no esta disponible con MPI).
+/// Exchanges particles with the other processes and runs the divide. The halo
+/// copies play the role of the periodic particles, so they can only be created
+/// with updateperiodic=true (the divide without updating the periodic particles
+/// is only used with -overlap, which is not available with MPI).
+//==============================================================================
+void JSphCpuMpi::RunCellDivide(bool updateperiodic) {
+    const char met[] = "RunCellDivide";
+    if (!updateperiodic)RunException(met, "The halo copies must be updated in every divide with MPI.");
+    TmcStart(Timers, TMC_SuMpiExchange);
+    const bool domchanged = (BalanceSteps && Nstep >= BalanceNextStep && RunBalance());
+    MpiExchange();
+    //-Con el nuevo dominio las celdas de las particulas que quedan cambian.
+    //-With the new domain the cells of the remaining particles change.
+    if (domchanged)LoadDcellParticles(Np, Codec, Posc, Dcellc);
+    TmcStop(Timers, TMC_SuMpiExchange);
+    //-Las copias de halo cambian en cada paso.
+    //-The halo copies change in every step.
+    BoundChanged = true;
+    JSphCpuSingle::RunCellDivide(false);
+    NpbPer = NpbHalo;
+    NpfPer = NpfHalo;
+}
+
+//==============================================================================
+/// Interaccion para el calculo de fuerzas. Los maximos para el calculo de dt se
+/// combinan entre todos los procesos para que usen el mismo dt.
+/// Interaction for the force computation. The maxima for the computation of dt
+/// are combined among all processes so that they use the same dt.
+//==============================================================================
+void JSphCpuMpi::Interaction_Forces(TpInter tinter) {
+    JSphCpuSingle::Interaction_Forces(tinter);
+    TmcStart(Timers, TMC_SuMpiExchange);
+    double vmax[3] = {AceMax, double(ViscDtMax), VelMax}, gmax[3];
+    MPI_Allreduce(vmax, gmax, 3, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    AceMax = gmax[0];
+    ViscDtMax = float(gmax[1]);
+    VelMax = gmax[2];
+    TmcStop(Timers, TMC_SuMpiExchange);
+}
+
+//==============================================================================
+/// Comprueba el numero total de particulas de todos los procesos.
+/// Checks the total number of particles of all processes.
+//==============================================================================
+bool JSphCpuMpi::CheckPartOutStop() {
+    ullong npl = Np - NpbPer - NpfPer, npg = 0;
+    MPI_Allreduce(&npl, &npg, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+    return (npg < NpMinimum || !npg);
+}
+
+//==============================================================================
+/// Muestra las estadisticas de intercambio y finaliza la ejecucion.
+/// Shows the exchange statistics and finishes the execution.
+//==============================================================================
+void JSphCpuMpi::FinishRun(bool stop) {
+    Log->Print(" ");
+    Log->Printf("MPI process %d of %d: slab cells %u-%u", MpiRank, MpiSize, SlabCel[MpiRank], SlabCel[MpiRank + 1]);
+    Log->Printf("  Exchanges: %u  Migrated particles: %s  Halo copies per exchange: %.0f", ExchangeCount,
+                fun::UlongStr(MigrateCount).c_str(), (ExchangeCount ? double(HaloCount) / ExchangeCount : 0.));
+    if (BalanceSteps)
+        Log->Printf("  Balance checks: %u  Moves: %u  Imbalance mean: %.3f  max: %.3f", BalanceChecks, BalanceMoves,
+                    (BalanceChecks ? BalanceImbSum / BalanceChecks : 0.), BalanceImbMax);
+    JSphCpuSingle::FinishRun(stop);
+}
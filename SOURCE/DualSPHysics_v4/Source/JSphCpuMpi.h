@@ -0,0 +1,93 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JSphCpuMpi.h \brief Declares the class \ref JSphCpuMpi.
+
+#ifndef _JSphCpuMpi_
+#define _JSphCpuMpi_
+
+#include "Types.h"
+#include "JSphCpuSingle.h"
+#include <string>
+#include <vector>
+
+//##############################################################################
+//# JSphCpuMpi
+//##############################################################################
+/// \brief Distributed CPU solver with MPI. The domain is split in slabs of cells
+/// along the leading CellOrder axis and each process computes the particles of
+/// its slab. Before every divide the particles that left the slab migrate to
+/// their new process and the neighbour processes receive copies (halo) of the
+/// particles within the interaction distance of their slab.
+/// With -mpibalance the slab limits move during the run according to the
+/// measured cost of the force computation of each process.
+
+class JSphCpuMpi : public JSphCpuSingle
+{
+protected:
+  int MpiRank;                    ///<Rango del proceso. Rank of the process.
+  int MpiSize;                    ///<Numero de procesos. Number of processes.
+  unsigned HaloCells;             ///<Celdas de halo a cada lado del slab (Hdiv). Halo cells at each side of the slab (Hdiv).
+  std::vector<unsigned> SlabCel;  ///<Celda inicial de cada slab en el eje X ordenado (MpiSize+1 valores). Initial cell of each slab along ordered X (MpiSize+1 values).
+  std::vector<unsigned> CellSlab; ///<Slab de cada columna de celdas (Map_Cells.x valores). Slab of each column of cells (Map_Cells.x values).
+
+  unsigned NpbHalo;               ///<Copias de halo bound tras el ultimo divide. Bound halo copies after the last divide.
+  unsigned NpfHalo;               ///<Copias de halo fluid tras el ultimo divide. Fluid halo copies after the last divide.
+  ullong MigrateCount;            ///<Particulas recibidas de otros slabs. Particles received from other slabs.
+  ullong HaloCount;               ///<Copias de halo recibidas. Received halo copies.
+  unsigned ExchangeCount;         ///<Numero de intercambios. Number of exchanges.
+
+  unsigned BalanceSteps;          ///<Pasos entre comprobaciones del equilibrado (0:desactivado). Steps between balancing checks (0:disabled).
+  float BalanceTol;               ///<Desequilibrio (max/media-1) que mueve los slabs. Imbalance (max/mean-1) that moves the slabs.
+  int BalanceNextStep;            ///<Paso de la siguiente comprobacion. Step of the next check.
+  double BalanceTime0;            ///<Tiempo de CfForces en la ultima comprobacion. CfForces time at the last check.
+  unsigned BalanceChecks;         ///<Numero de comprobaciones. Number of checks.
+  unsigned BalanceMoves;          ///<Numero de comprobaciones que movieron los slabs. Number of checks that moved the slabs.
+  double BalanceImbSum;           ///<Suma del desequilibrio medido. Sum of the measured imbalance.
+  double BalanceImbMax;           ///<Desequilibrio maximo medido. Maximum measured imbalance.
+
+  std::vector<byte> SendBuf;      ///<Buffer de envio. Send buffer.
+  std::vector<byte> RecvBuf;      ///<Buffer de recepcion. Receive buffer.
+  std::vector<int> SendCount,SendDispl,RecvCount,RecvDispl; ///<Particulas y desplazamientos (bytes) por proceso. Particles and displacements (bytes) per process.
+
+  void LoadConfig(JCfgRun *cfg);
+  void LoadCaseParticles();
+  void ConfigDomain();
+  void ComputeSlabCuts(const std::vector<double> &colcost,std::vector<unsigned> &slabcel)const;
+  void UpdateCellSlab();
+  void ConfigSlabs(unsigned np,const tdouble3 *pos);
+  void ComputeColumnPairs(std::vector<double> &colpairs);
+  bool RunBalance();
+  void SelecSlabDomain();
+  unsigned GetMapCellX(const tdouble3 &ps)const;
+  unsigned GetRecordSize()const;
+  byte* PackParticle(unsigned p,word code,byte *ptr)const;
+  const byte* UnpackParticle(const byte *ptr,unsigned p);
+  void MpiExchange();
+  void RunCellDivide(bool updateperiodic);
+  void Interaction_Forces(TpInter tinter);
+  bool CheckPartOutStop();
+  void FinishRun(bool stop);
+
+public:
+  JSphCpuMpi();
+  ~JSphCpuMpi();
+};
+
+#endif
+
+
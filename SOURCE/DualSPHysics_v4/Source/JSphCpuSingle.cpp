@@ -12,8 +12,25 @@
 #include "JSphVisco.h"
 #include "JWaveGen.h"
 #include "JTimeOut.h"
+#include "JCheckpointBi4.h"
+#include "JTimersStep.h"
+#include "JTraceEvents.h"
+#include "JPerfCounters.h"
+#include "JRoofline.h"
+#include "JMemRegistry.h"
+#include "JSphInOut.h"
+#include "JSphSplitting.h"
 
 #include <climits>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+
+#ifdef _WITHOMP
+  #include <omp.h>
+#else
+  #define omp_get_thread_num() 0
+#endif
 
 using namespace std;
 
@@ -21,10 +38,22 @@ using namespace std;
 /*
  * @desc 构造器
  */
-JSphCpuSingle::JSphCpuSingle() : JSphCpu(false) {
+JSphCpuSingle::JSphCpuSingle(bool withmpi) : JSphCpu(withmpi) {
     ClassName = "JSphCpuSingle";
     CellDivSingle = NULL;
     PartsLoaded = NULL;
+    RestartData = NULL;
+    BenchCount = 0;
+    BenchNpSteps = 0;
+    PerfNpSteps = 0;
+    Roofline = NULL;
+    RoofNpSteps = RoofNpfSteps = RoofNpbOkSteps = 0;
+    memset(BenchTimers0, 0, sizeof(double) * TMC_COUNT);
+    StatusNstep = 0;
+    StatusNpSteps = 0;
+    memset(StatusTimers0, 0, sizeof(double) * TMC_COUNT);
+    PeriodicPending = false;
+    HaloNcells = HaloCellMin = TUint3(0);
 }
 
 /*
@@ -35,6 +64,10 @@ JSphCpuSingle::~JSphCpuSingle() {
     CellDivSingle = NULL;
     delete PartsLoaded;
     PartsLoaded = NULL;
+    delete RestartData;
+    RestartData = NULL;
+    delete Roofline;
+    Roofline = NULL;
 }
 
 /*
@@ -45,6 +78,7 @@ llong JSphCpuSingle::GetAllocMemoryCpu() const {
     // Reservada en otros objetos
     if (CellDivSingle)s += CellDivSingle->GetAllocMemory();
     if (PartsLoaded)s += PartsLoaded->GetAllocMemory();
+    if (RestartData)s += RestartData->GetAllocMemory();
     return (s);
 }
 
@@ -76,28 +110,55 @@ void JSphCpuSingle::LoadConfig(JCfgRun *cfg) {
  * @desc 加载case和process的粒子
  */
 void JSphCpuSingle::LoadCaseParticles() {
-    Log->Print("Loading initial state of particles...");
-    PartsLoaded = new JPartsLoad4;
-    PartsLoaded->LoadParticles(DirCase, CaseName, PartBegin, PartBeginDir);
-    PartsLoaded->CheckConfig(CaseNp, CaseNfixed, CaseNmoving, CaseNfloat, CaseNfluid, PeriX, PeriY, PeriZ);
-    Log->Printf("Loaded particles: %u", PartsLoaded->GetCount());
-    // 收集载入的粒子信息
-    Simulate2D = PartsLoaded->GetSimulate2D();
-    if (Simulate2D && PeriY)
-        RunException("LoadCaseParticles", "Cannot use periodic conditions in Y with 2D simulations");
-    CasePosMin = PartsLoaded->GetCasePosMin();
-    CasePosMax = PartsLoaded->GetCasePosMax();
+    if (!RestartFile.empty()) {
+        // 从checkpoint载入粒子和模拟限制
+        if (PartBegin)RunException("LoadCaseParticles", "Cannot use -restart together with -partbegin.");
+        Log->Print("Loading checkpoint state of particles...");
+        RestartData = new JCheckpointBi4Load;
+        RestartData->LoadFile(RestartFile);
+        JBinaryData *bd = RestartData->GetData();
+        Log->Printf("Loaded particles: %u (Part=%u TimeStep=%g)", bd->GetvUint("Np"), bd->GetvUint("Part"),
+                    bd->GetvDouble("TimeStep"));
+        Simulate2D = bd->GetvBool("Simulate2D");
+        CasePosMin = bd->GetvDouble3("CasePosMin");
+        CasePosMax = bd->GetvDouble3("CasePosMax");
+        MapRealPosMin = bd->GetvDouble3("MapRealPosMin");
+        MapRealPosMax = bd->GetvDouble3("MapRealPosMax");
+        PartBeginFirst = bd->GetvUint("Part");
+        PartBeginTimeStep = bd->GetvDouble("TimeStep");
+        PartBeginTotalNp = bd->GetvUllong("TotalNp");
+    } else {
+        Log->Print("Loading initial state of particles...");
+        PartsLoaded = new JPartsLoad4;
+        PartsLoaded->LoadParticles(DirCase, CaseName, PartBegin, PartBeginDir);
+        PartsLoaded->CheckConfig(CaseNp, CaseNfixed, CaseNmoving, CaseNfloat, CaseNfluid, PeriX, PeriY, PeriZ);
+        Log->Printf("Loaded particles: %u", PartsLoaded->GetCount());
+        // 收集载入的粒子信息
+        Simulate2D = PartsLoaded->GetSimulate2D();
+        CasePosMin = PartsLoaded->GetCasePosMin();
+        CasePosMax = PartsLoaded->GetCasePosMax();
 
-    // 计算模拟的实际限制
-    if (PartsLoaded->MapSizeLoaded())PartsLoaded->GetMapSize(MapRealPosMin, MapRealPosMax);
-    else {
-        PartsLoaded->CalculeLimits(double(H) * BORDER_MAP, Dp / 2., PeriX, PeriY, PeriZ, MapRealPosMin, MapRealPosMax);
-        ResizeMapLimits();
+        // 计算模拟的实际限制
+        if (PartsLoaded->MapSizeLoaded())PartsLoaded->GetMapSize(MapRealPosMin, MapRealPosMax);
+        else {
+            PartsLoaded->CalculeLimits(double(H) * BORDER_MAP, Dp / 2., PeriX, PeriY, PeriZ, MapRealPosMin,
+                                       MapRealPosMax);
+            ResizeMapLimits();
+        }
     }
+    if (Simulate2D && PeriY)
+        RunException("LoadCaseParticles", "Cannot use periodic conditions in Y with 2D simulations");
     if (PartBegin) {
         PartBeginTimeStep = PartsLoaded->GetPartBeginTimeStep();
         PartBeginTotalNp = PartsLoaded->GetPartBeginTotalNp();
     }
+    ConfigMapLimits();
+}
+
+/*
+ * @desc 根据 MapRealPosMin 和 MapRealPosMax 配置周期边界和模拟的限制 (Map_PosMin, Map_PosMax)
+ */
+void JSphCpuSingle::ConfigMapLimits() {
     Log->Print(string("MapRealPos(final)=") + fun::Double3gRangeStr(MapRealPosMin, MapRealPosMax));
     MapRealSize = MapRealPosMax - MapRealPosMin;
     Log->Print("**Initial state of particles is loaded");
@@ -130,6 +191,30 @@ void JSphCpuSingle::LoadCaseParticles() {
  */
 void JSphCpuSingle::ConfigDomain() {
     const char *met = "ConfigDomain";
+    // -overlap 只用于周期条件
+    if (Overlap && !PeriActive) {
+        Log->Print("**Overlap is ignored without periodic conditions.");
+        Overlap = false;
+    }
+    if (Overlap) {
+        if (RestartData || CheckpointTime > 0)RunException(met, "The option -overlap is not supported with checkpoints.");
+        if (TVisco == VISCO_LaminarSPS)RunException(met, "The option -overlap is not supported with Laminar+SPS viscosity.");
+        if (CaseNfloat)RunException(met, "The option -overlap is not supported with floating bodies.");
+    }
+    if (SleepSteps && (RestartData || CheckpointTime > 0))
+        RunException(met, "The option -sleep is not supported with checkpoints.");
+    if (InOut && (RestartData || CheckpointTime > 0))
+        RunException(met, "Open boundaries (inout) are not supported with checkpoints.");
+    if (Splitting) {
+        if (RestartData || CheckpointTime > 0)RunException(met, "Splitting is not supported with checkpoints.");
+        if (TKernel != KERNEL_Wendland)RunException(met, "Splitting is only supported with the Wendland kernel.");
+        if (TVisco == VISCO_LaminarSPS)RunException(met, "Splitting is not supported with Laminar+SPS viscosity.");
+        if (PeriActive)RunException(met, "Splitting is not supported with periodic conditions.");
+    }
+    if (RestartData) {
+        ConfigDomainRestart();
+        return;
+    }
     // 计算粒子数量
     Np = PartsLoaded->GetCount();
     Npb = CaseNpb;
@@ -142,8 +227,9 @@ void JSphCpuSingle::ConfigDomain() {
     // 复制粒子值
     ReserveBasicArraysCpu();
     memcpy(Posc, PartsLoaded->GetPos(), sizeof(tdouble3) * Np);
-    memcpy(Idpc, PartsLoaded->GetIdp(), sizeof(unsigned) * Np);
+    memcpy(Idpc, PartsLoaded->GetIdp(), sizeof(tpartid) * Np);
     memcpy(Velrhopc, PartsLoaded->GetVelRhop(), sizeof(tfloat4) * Np);
+    if (SleepSteps)memset(SleepCountc, 0, sizeof(word) * Np);
 
     // 计算浮动半径
     if (CaseNfloat && PeriActive != 0 && !PartBegin) {
@@ -158,6 +244,10 @@ void JSphCpuSingle::ConfigDomain() {
     PartsLoaded = NULL;
     // 应用CellOrder的配置
     ConfigCellOrder(CellOrder, Np, Posc, Velrhopc);
+    // 标记开放边界区域内的buffer粒子
+    if (InOut)InOutInit();
+    // 初始化粒子的质量和光滑长度
+    if (Splitting)SplitInit();
 
     // 配置 cells division
     ConfigCellDivision();
@@ -179,12 +269,43 @@ void JSphCpuSingle::ConfigDomain() {
     RunCellDivide(true);
 }
 
+/*
+ * @desc 从checkpoint配置当前域, 粒子已按cell排序, 不需要重新划分
+ */
+void JSphCpuSingle::ConfigDomainRestart() {
+    // 载入按cell排序的粒子数据
+    LoadCheckpointParticles(RestartData);
+    // 应用CellOrder的配置 (粒子数据已经转换)
+    ConfigCellOrder(CellOrder, 0, NULL, NULL);
+    ConfigCellDivision();
+    SelecDomain(TUint3(0, 0, 0), Map_Cells);
+
+    // 创建划分对象并恢复划分状态
+    CellDivSingle = new JCellDivCpuSingle(Stable, FtCount != 0, PeriActive, CellOrder, CellMode, Scell, Map_PosMin,
+                                          Map_PosMax, Map_Cells, CaseNbound, CaseNfixed, CaseNpb, Log, DirOut);
+    CellDivSingle->DefineDomain(DomCellCode, DomCelIni, DomCelFin, DomPosMin, DomPosMax);
+    ConfigCellDiv((JCellDivCpu *) CellDivSingle);
+    JBinaryData *bdcell = RestartData->GetData()->GetItem("CellDiv");
+    if (!bdcell)RunException("ConfigDomainRestart", "The cell division data is missing.", RestartFile);
+    CellDivSingle->LoadCheckpoint(bdcell);
+    if (CaseNfloat)CalcRidp(PeriActive != 0, Np - Npb, Npb, CaseNpb, CaseNpb + CaseNfloat, Codec, Idpc, FtRidp);
+    // 恢复浮体半径 (用于floating数据文件的头部)
+    for (unsigned cf = 0; cf < FtCount; cf++) {
+        JBinaryData *bdf = RestartData->GetData()->GetItem(fun::PrintStr("Floating_%u", cf));
+        if (bdf)FtObjs[cf].radius = bdf->GetvFloat("radius");
+    }
+
+    ConfigSaveData(0, 1, "");
+}
+
 /*
  * @desc 为CPU中的粒子保留的Redimension空间，测量使用TMC_SuResizeNp消耗的时间。完成后，更新划分。
  */
 void JSphCpuSingle::ResizeParticlesSize(unsigned newsize, float oversize, bool updatedivide) {
     TmcStart(Timers, TMC_SuResizeNp);
-    newsize += (oversize > 0 ? unsigned(oversize * newsize) : 0);
+    const double size = newsize + (oversize > 0 ? double(oversize) * newsize : 0);
+    if (size > PARTS_NPMAX)RunException("ResizeParticlesSize", "The number of particles is too big.");
+    newsize = unsigned(size);
     ResizeCpuMemoryParticles(newsize);
     TmcStop(Timers, TMC_SuResizeNp);
     if (updatedivide)RunCellDivide(true);
@@ -194,9 +315,10 @@ void JSphCpuSingle::ResizeParticlesSize(unsigned newsize, float oversize, bool u
  * @desc
  * 创建要复制的新的周期性粒子列表
  * 具有稳定的激活重新排序的周期性粒子列表
+ * listd[] 记录复制的方向 (0:+perinc, 1:-perinc), 使索引可以使用全部 32 位
  */
 unsigned JSphCpuSingle::PeriodicMakeList(unsigned n, unsigned pini, bool stable, unsigned nmax, tdouble3 perinc,
-                                         const tdouble3 *pos, const word *code, unsigned *listp) const {
+                                         const tdouble3 *pos, const word *code, unsigned *listp, byte *listd) const {
     unsigned count = 0;
     if (n) {
         //-Initialize size of list lsph to zero / Inicializa tama�o de lista lspg a cero.
@@ -211,13 +333,19 @@ unsigned JSphCpuSingle::PeriodicMakeList(unsigned n, unsigned pini, bool stable,
                 if (Map_PosMin <= ps2 && ps2 < Map_PosMax) {
                     unsigned cp = listp[nmax];
                     listp[nmax]++;
-                    if (cp < nmax)listp[cp] = p2;
+                    if (cp < nmax) {
+                        listp[cp] = p2;
+                        listd[cp] = 0;
+                    }
                 }
                 ps2 = ps - perinc;
                 if (Map_PosMin <= ps2 && ps2 < Map_PosMax) {
                     unsigned cp = listp[nmax];
                     listp[nmax]++;
-                    if (cp < nmax)listp[cp] = (p2 | 0x80000000);
+                    if (cp < nmax) {
+                        listp[cp] = p2;
+                        listd[cp] = 1;
+                    }
                 }
             }
         }
@@ -265,25 +393,30 @@ void JSphCpuSingle::PeriodicDuplicatePos(unsigned pnew, unsigned pcopy, bool inv
  * 此内核适用于单CPU和多CPU，因为它使用 domposmin
  */
 void JSphCpuSingle::PeriodicDuplicateVerlet(unsigned np, unsigned pini, tuint3 cellmax, tdouble3 perinc,
-                                            const unsigned *listp, unsigned *idp, word *code, unsigned *dcell,
+                                            const unsigned *listp, const byte *listd, tpartid *idp, word *code, unsigned *dcell,
                                             tdouble3 *pos, tfloat4 *velrhop, tsymatrix3f *spstau,
                                             tfloat4 *velrhopm1) const {
-    const int n = int(np);
+    const llong n = llong(np);
 #ifdef _WITHOMP
-#pragma omp parallel for schedule (static) if(n>LIMIT_COMPUTELIGHT_OMP)
+#pragma omp parallel if(n>LIMIT_COMPUTELIGHT_OMP)
 #endif
-    for (int p = 0; p < n; p++) {
-        const unsigned pnew = unsigned(p) + pini;
-        const unsigned rp = listp[p];
-        const unsigned pcopy = (rp & 0x7FFFFFFF);
-        //-Adjust position and cell of new particle / Ajusta posicion y celda de nueva particula.
-        PeriodicDuplicatePos(pnew, pcopy, (rp >= 0x80000000), perinc.x, perinc.y, perinc.z, cellmax, pos, dcell);
-        //-Copy the rest of the values / Copia el resto de datos.
-        idp[pnew] = idp[pcopy];
-        code[pnew] = CODE_SetPeriodic(code[pcopy]);
-        velrhop[pnew] = velrhop[pcopy];
-        velrhopm1[pnew] = velrhopm1[pcopy];
-        if (spstau)spstau[pnew] = spstau[pcopy];
+    {
+        JTraceScope trace("SU-PeriodicDuplicate");
+#ifdef _WITHOMP
+#pragma omp for schedule (static)
+#endif
+        for (llong p = 0; p < n; p++) {
+            const unsigned pnew = unsigned(p) + pini;
+            const unsigned pcopy = listp[p];
+            //-Adjust position and cell of new particle / Ajusta posicion y celda de nueva particula.
+            PeriodicDuplicatePos(pnew, pcopy, (listd[p] != 0), perinc.x, perinc.y, perinc.z, cellmax, pos, dcell);
+            //-Copy the rest of the values / Copia el resto de datos.
+            idp[pnew] = idp[pcopy];
+            code[pnew] = CODE_SetPeriodic(code[pcopy]);
+            velrhop[pnew] = velrhop[pcopy];
+            velrhopm1[pnew] = velrhopm1[pcopy];
+            if (spstau)spstau[pnew] = spstau[pcopy];
+        }
     }
 }
 
@@ -294,26 +427,31 @@ void JSphCpuSingle::PeriodicDuplicateVerlet(unsigned np, unsigned pini, tuint3 c
  * 此内核适用于单CPU和多CPU，因为它使用 domposmin
  */
 void JSphCpuSingle::PeriodicDuplicateSymplectic(unsigned np, unsigned pini, tuint3 cellmax, tdouble3 perinc,
-                                                const unsigned *listp, unsigned *idp, word *code, unsigned *dcell,
+                                                const unsigned *listp, const byte *listd, tpartid *idp, word *code, unsigned *dcell,
                                                 tdouble3 *pos, tfloat4 *velrhop, tsymatrix3f *spstau, tdouble3 *pospre,
                                                 tfloat4 *velrhoppre) const {
-    const int n = int(np);
+    const llong n = llong(np);
 #ifdef _WITHOMP
-#pragma omp parallel for schedule (static) if(n>LIMIT_COMPUTELIGHT_OMP)
+#pragma omp parallel if(n>LIMIT_COMPUTELIGHT_OMP)
 #endif
-    for (int p = 0; p < n; p++) {
-        const unsigned pnew = unsigned(p) + pini;
-        const unsigned rp = listp[p];
-        const unsigned pcopy = (rp & 0x7FFFFFFF);
-        //-Adjust position and cell of new particle / Ajusta posicion y celda de nueva particula.
-        PeriodicDuplicatePos(pnew, pcopy, (rp >= 0x80000000), perinc.x, perinc.y, perinc.z, cellmax, pos, dcell);
-        //-Copy the rest of the values / Copia el resto de datos.
-        idp[pnew] = idp[pcopy];
-        code[pnew] = CODE_SetPeriodic(code[pcopy]);
-        velrhop[pnew] = velrhop[pcopy];
-        if (pospre)pospre[pnew] = pospre[pcopy];
-        if (velrhoppre)velrhoppre[pnew] = velrhoppre[pcopy];
-        if (spstau)spstau[pnew] = spstau[pcopy];
+    {
+        JTraceScope trace("SU-PeriodicDuplicate");
+#ifdef _WITHOMP
+#pragma omp for schedule (static)
+#endif
+        for (llong p = 0; p < n; p++) {
+            const unsigned pnew = unsigned(p) + pini;
+            const unsigned pcopy = listp[p];
+            //-Adjust position and cell of new particle / Ajusta posicion y celda de nueva particula.
+            PeriodicDuplicatePos(pnew, pcopy, (listd[p] != 0), perinc.x, perinc.y, perinc.z, cellmax, pos, dcell);
+            //-Copy the rest of the values / Copia el resto de datos.
+            idp[pnew] = idp[pcopy];
+            code[pnew] = CODE_SetPeriodic(code[pcopy]);
+            velrhop[pnew] = velrhop[pcopy];
+            if (pospre)pospre[pnew] = pospre[pcopy];
+            if (velrhoppre)velrhoppre[pnew] = velrhoppre[pcopy];
+            if (spstau)spstau[pnew] = spstau[pcopy];
+        }
     }
 }
 
@@ -325,8 +463,9 @@ void JSphCpuSingle::PeriodicDuplicateSymplectic(unsigned np, unsigned pini, tuin
  * 首先是NpbPer边界
  * 然后是NpfPer流体
  * 那些离开的粒子的Np也包含了新的周期性的粒子
+ * resize=false 时内存不足返回 false (-overlap)
  */
-void JSphCpuSingle::RunPeriodic() {
+bool JSphCpuSingle::RunPeriodic(bool resize) {
     const char met[] = "RunPeriodic";
     TmcStart(Timers, TMC_SuPeriodic);
     //-Keep number of present periodic / Guarda numero de periodicas actuales.
@@ -364,19 +503,21 @@ void JSphCpuSingle::RunPeriodic() {
                     while (run && num2) {
                         //-Reserve memory to create list of periodic particles / Reserva memoria para crear lista de particulas periodicas.
                         unsigned *listp = ArraysCpu->ReserveUint();
+                        byte *listd = ArraysCpu->ReserveByte();
                         unsigned nmax = CpuParticlesSize -
                                         1; //-Maximmum number of particles that fit in the list / Numero maximo de particulas que caben en la lista.
                         //-Generate list of new periodic particles / Genera lista de nuevas periodicas.
-                        if (Np >= 0x80000000)
-                            RunException(met,
-                                         "The number of particles is too big.");//-Because the last bit is used to mark the direction in which a new periodic particle is created / Pq el ultimo bit se usa para marcar el sentido en que se crea la nueva periodica.
-                        unsigned count = PeriodicMakeList(num2, pini2, Stable, nmax, perinc, Posc, Codec, listp);
+                        unsigned count = PeriodicMakeList(num2, pini2, Stable, nmax, perinc, Posc, Codec, listp, listd);
                         //-Redimensiona memoria para particulas si no hay espacio suficiente y repite el proceso de busqueda.
                         //-Redimension memory for particles if there is insufficient space and repeat the search process.
-                        if (count > nmax || count + Np > CpuParticlesSize) {
+                        if (count > nmax || ullong(count) + Np > CpuParticlesSize) {
                             ArraysCpu->Free(listp);
+                            ArraysCpu->Free(listd);
                             listp = NULL;
+                            listd = NULL;
+                            if (ullong(count) + Np > PARTS_NPMAX)RunException(met, "The number of particles is too big.");
                             TmcStop(Timers, TMC_SuPeriodic);
+                            if (!resize)return (false);
                             ResizeParticlesSize(Np + count, PERIODIC_OVERMEMORYNP, false);
                             TmcStart(Timers, TMC_SuPeriodic);
                         } else {
@@ -384,18 +525,20 @@ void JSphCpuSingle::RunPeriodic() {
                             //-Crea nuevas particulas periodicas duplicando las particulas de la lista.
                             //-Create new duplicate periodic particles in the list
                             if (TStep == STEP_Verlet)
-                                PeriodicDuplicateVerlet(count, Np, DomCells, perinc, listp, Idpc, Codec, Dcellc, Posc,
+                                PeriodicDuplicateVerlet(count, Np, DomCells, perinc, listp, listd, Idpc, Codec, Dcellc, Posc,
                                                         Velrhopc, SpsTauc, VelrhopM1c);
                             if (TStep == STEP_Symplectic) {
                                 if ((PosPrec || VelrhopPrec) && (!PosPrec || !VelrhopPrec))
                                     RunException(met, "Symplectic data is invalid.");
-                                PeriodicDuplicateSymplectic(count, Np, DomCells, perinc, listp, Idpc, Codec, Dcellc,
+                                PeriodicDuplicateSymplectic(count, Np, DomCells, perinc, listp, listd, Idpc, Codec, Dcellc,
                                                             Posc, Velrhopc, SpsTauc, PosPrec, VelrhopPrec);
                             }
 
                             //-Free the list and update the number of particles / Libera lista y actualiza numero de particulas.
                             ArraysCpu->Free(listp);
+                            ArraysCpu->Free(listd);
                             listp = NULL;
+                            listd = NULL;
                             Np += count;
                             //-Update number of new periodic particles / Actualiza numero de periodicas nuevas.
                             if (!ctype)NpbPer += count;
@@ -406,6 +549,7 @@ void JSphCpuSingle::RunPeriodic() {
             }
     }
     TmcStop(Timers, TMC_SuPeriodic);
+    return (true);
 }
 
 /*
@@ -414,7 +558,18 @@ void JSphCpuSingle::RunPeriodic() {
 void JSphCpuSingle::RunCellDivide(bool updateperiodic) {
     const char met[] = "RunCellDivide";
     //-Create new periodic particles & mark the old ones to be ignored / Crea nuevas particulas periodicas y marca las viejas para ignorarlas.
-    if (updateperiodic && PeriActive)RunPeriodic();
+    if (updateperiodic && PeriActive) {
+        if (Overlap) {
+            //-With -overlap the new periodic particles are created in Interaction_Forces() / Con -overlap las nuevas periodicas se crean en Interaction_Forces().
+            for (unsigned p = 0; p < Np; p++) {
+                const word rcode = Codec[p];
+                if (CODE_GetSpecialValue(rcode) == CODE_PERIODIC)Codec[p] = CODE_SetOutIgnore(rcode);
+            }
+            if (NpbPer)BoundChanged = true;
+            NpbPer = NpfPer = 0;
+            PeriodicPending = true;
+        } else RunPeriodic();
+    }
 
     //-Initial Divide / Inicia Divide.
     CellDivSingle->Divide(Npb, Np - Npb - NpbPer - NpfPer, NpbPer, NpfPer, BoundChanged, Dcellc, Codec, Idpc, Posc,
@@ -436,6 +591,12 @@ void JSphCpuSingle::RunCellDivide(bool updateperiodic) {
         CellDivSingle->SortArray(VelrhopPrec);
     }
     if (TVisco == VISCO_LaminarSPS)CellDivSingle->SortArray(SpsTauc);
+    if (SleepSteps)CellDivSingle->SortArray(SleepCountc);
+    if (InOut)CellDivSingle->SortArray(InOutc);
+    if (Splitting) {
+        CellDivSingle->SortArray(Massc);
+        CellDivSingle->SortArray(Hvarc);
+    }
 
     //-Collect divide data / Recupera datos del divide.
     Np = CellDivSingle->GetNpFinal();
@@ -450,21 +611,463 @@ void JSphCpuSingle::RunCellDivide(bool updateperiodic) {
     TmcStart(Timers, TMC_NlOutCheck);
     unsigned npfout = CellDivSingle->GetNpOut();
     if (npfout) {
-        unsigned *idp = ArraysCpu->ReserveUint();
+        tpartid *idp = ArraysCpu->ReserveIdp();
         tdouble3 *pos = ArraysCpu->ReserveDouble3();
         tfloat3 *vel = ArraysCpu->ReserveFloat3();
         float *rhop = ArraysCpu->ReserveFloat();
         unsigned num = GetParticlesData(npfout, Np, true, false, idp, pos, vel, rhop, NULL);
         AddParticlesOut(npfout, idp, pos, vel, rhop, CellDivSingle->GetNpfOutRhop(), CellDivSingle->GetNpfOutMove());
+        if (Splitting)Splitting->AddMassOut(SplitFluidMass(Np, Np + npfout));
         ArraysCpu->Free(idp);
         ArraysCpu->Free(pos);
         ArraysCpu->Free(vel);
         ArraysCpu->Free(rhop);
     }
     TmcStop(Timers, TMC_NlOutCheck);
+    if (SleepSteps)SleepPrepareCells();
     BoundChanged = false;
 }
 
+/*
+ * @desc 使用 -sleep 时标记休眠的cell并按活动cell和休眠cell列出流体粒子, 没有休眠粒子时计算全部粒子
+ */
+void JSphCpuSingle::SleepPrepareCells() {
+    unsigned npfasleep = 0;
+    const unsigned npfactive = CellDivSingle->MarkSleepCells(SleepSteps, SleepCountc, Codec, SleepListc, npfasleep);
+    SleepNpAsleep = npfasleep;
+    SleepNpActive = (npfasleep ? npfactive : UINT_MAX);
+}
+
+/*
+ * @desc 使用 -sleep 时休眠粒子使用静水力 (Ace=0, Ar=0) 且速度为零 (不再移动), 并在步骤的最后一次相互作用后更新计算粒子的静止步数
+ */
+void JSphCpuSingle::SleepUpdate(TpInter tinter) {
+    //-Hydrostatic forces for the asleep particles / Fuerzas hidrostaticas para las particulas dormidas.
+    if (SleepNpActive != UINT_MAX) {
+        const llong ini = llong(SleepNpActive), fin = llong(SleepNpActive + SleepNpAsleep);
+#ifdef _WITHOMP
+#pragma omp parallel for schedule (static) if(fin-ini>LIMIT_COMPUTELIGHT_OMP)
+#endif
+        for (llong c = ini; c < fin; c++) {
+            const unsigned p = SleepListc[c];
+            Acec[p] = TFloat3(0);
+            Arc[p] = 0;
+            //-Asleep particles do not move / Las particulas dormidas no se mueven.
+            Velrhopc[p] = TFloat4(0, 0, 0, Velrhopc[p].w);
+            if (VelrhopM1c)VelrhopM1c[p] = TFloat4(0, 0, 0, VelrhopM1c[p].w);
+        }
+        SleepNpSkipped += SleepNpAsleep;
+    }
+    SleepNpFluid += Np - Npb;
+    //-Steps at rest of the computed particles / Pasos en reposo de las particulas calculadas.
+    if (TStep == STEP_Verlet || tinter == INTER_ForcesCorr) {
+        const bool all = (SleepNpActive == UINT_MAX);
+        const float vel2 = SleepVel * SleepVel, ace2 = SleepAce * SleepAce;
+        const unsigned nmax = SleepSteps;
+        const llong n = llong(all ? Np - Npb : SleepNpActive);
+#ifdef _WITHOMP
+#pragma omp parallel for schedule (static) if(n>LIMIT_COMPUTELIGHT_OMP)
+#endif
+        for (llong c = 0; c < n; c++) {
+            const unsigned p = (all ? Npb + unsigned(c) : SleepListc[c]);
+            unsigned count = 0;
+            //-Floating particles never fall asleep / Las particulas floating nunca se duermen.
+            if (!WithFloating || CODE_GetType(Codec[p]) == CODE_TYPE_FLUID) {
+                const tfloat4 v = Velrhopc[p];
+                const tfloat3 a = Acec[p];
+                if (v.x * v.x + v.y * v.y + v.z * v.z <= vel2 && a.x * a.x + a.y * a.y + a.z * a.z <= ace2)
+                    count = min(unsigned(SleepCountc[p]) + 1, nmax);
+            }
+            SleepCountc[p] = word(count);
+        }
+    }
+}
+
+/*
+ * @desc 标记开放边界区域内的流体粒子为buffer粒子, inlet区域的粒子使用给定的速度和密度
+ */
+void JSphCpuSingle::InOutInit() {
+    // 区域超出模拟域时, 粒子在删除之前就会被排除
+    const tdouble3 dmin = OrderDecode(Map_PosMin), dmax = OrderDecode(Map_PosMax);
+    for (unsigned cz = 0; cz < InOut->GetCount(); cz++) {
+        const StInOutZone &zo = InOut->GetZone(cz);
+        const unsigned a = zo.axis;
+        const double zmin = (a == 0 ? zo.boxmin.x : (a == 1 ? zo.boxmin.y : zo.boxmin.z));
+        const double zmax = (a == 0 ? zo.boxmax.x : (a == 1 ? zo.boxmax.y : zo.boxmax.z));
+        const double lmin = (a == 0 ? dmin.x : (a == 1 ? dmin.y : dmin.z));
+        const double lmax = (a == 0 ? dmax.x : (a == 1 ? dmax.y : dmax.z));
+        if (zmin < lmin || zmax > lmax)
+            Log->Printf("**The inout zone %u exceeds the domain of simulation along the flow direction.", cz);
+    }
+    memset(InOutc, 0, sizeof(word) * Np);
+    for (unsigned p = Npb; p < Np; p++)
+        if (CODE_GetType(Codec[p]) == CODE_TYPE_FLUID) {
+            const tdouble3 ps = OrderDecode(Posc[p]);
+            const int cz = InOut->InZone(ps);
+            if (cz >= 0) {
+                InOutc[p] = word(cz + 1);
+                const float rhop = InOut->GetRhop(unsigned(cz), ps.z, Velrhopc[p].w);
+                if (InOut->GetZone(unsigned(cz)).type == INOUT_Inlet) {
+                    const tfloat3 v = OrderCode(InOut->GetVelocity(unsigned(cz)));
+                    Velrhopc[p] = TFloat4(v.x, v.y, v.z, rhop);
+                } else Velrhopc[p].w = rhop;
+            }
+        }
+}
+
+/*
+ * @desc inlet区域的buffer粒子不计算力 (Ace=0, Ar=0), 按给定的速度移动; outlet区域给定压力时密度不变 (Ar=0)
+ */
+void JSphCpuSingle::InOutForces() {
+    const llong ini = llong(Npb), fin = llong(Np), npf = llong(Np - Npb);
+#ifdef _WITHOMP
+#pragma omp parallel for schedule (static) if(npf>LIMIT_COMPUTELIGHT_OMP)
+#endif
+    for (llong p = ini; p < fin; p++)
+        if (InOutc[p] && CODE_GetSpecialValue(Codec[p]) == CODE_NORMAL) {
+            const StInOutZone &zo = InOut->GetZone(InOutc[p] - 1);
+            if (zo.type == INOUT_Inlet) {
+                Acec[p] = TFloat3(0);
+                Arc[p] = 0;
+                if (ShiftPosc)ShiftPosc[p] = TFloat3(0);
+            } else if (zo.usepress)Arc[p] = 0;
+        }
+}
+
+/*
+ * @desc
+ * 开放边界的处理, 在每一步之后和 RunCellDivide() 之前执行
+ * 越过inlet区域内表面的buffer粒子变为流体粒子, 并在上游一个区域长度处创建新的buffer粒子
+ * 穿过外表面离开区域 (outlet下游面, inlet上游面) 或者回流进入inlet区域的粒子被删除 (CODE_OUTIGNORE), 它们的id可以重复使用
+ * 从其他面离开区域的buffer粒子 (例如回流离开outlet区域) 重新变为流体粒子
+ * 新粒子添加在数组末尾, 内存不足或过多时使用 ResizeParticlesSize() 调整
+ */
+void JSphCpuSingle::RunInOut() {
+    TmcStart(Timers, TMC_SuInOut);
+    const unsigned np0 = Np;
+    //-Count the new particles of the inlet zones / Cuenta las nuevas particulas de las zonas inlet.
+    unsigned ncross = 0;
+    for (unsigned p = Npb; p < np0; p++) {
+        const unsigned z = InOutc[p];
+        if (z && CODE_GetSpecialValue(Codec[p]) == CODE_NORMAL && InOut->GetZone(z - 1).type == INOUT_Inlet)
+            if (InOut->GetCoord(z - 1, OrderDecode(Posc[p])) > InOut->GetCoordOut(z - 1))ncross++;
+    }
+    //-Grows or shrinks the memory of particles / Aumenta o reduce la memoria de particulas.
+    const unsigned npmax = np0 + ncross;
+    if (npmax > CpuParticlesSize || npmax < CpuParticlesSize / 2) {
+        TmcStop(Timers, TMC_SuInOut);
+        ResizeParticlesSize(npmax, INOUT_OVERMEMORYNP, false);
+        TmcStart(Timers, TMC_SuInOut);
+    }
+    //-Update buffer particles, delete and create particles / Actualiza particulas buffer, elimina y crea particulas.
+    unsigned pnew = np0, nfail = 0, ndel = 0;
+    for (unsigned p = Npb; p < np0; p++) {
+        const word rcode = Codec[p];
+        if (CODE_GetSpecialValue(rcode) != CODE_NORMAL || CODE_GetType(rcode) != CODE_TYPE_FLUID)continue;
+        const tdouble3 ps = OrderDecode(Posc[p]);
+        unsigned z = InOutc[p];
+        bool del = false;
+        if (!z) {
+            //-Fluid particle that enters an outlet zone or flows back into an inlet zone / Particula que entra en una zona outlet o vuelve a una zona inlet.
+            const int cz = InOut->InZone(ps);
+            if (cz >= 0) {
+                if (InOut->GetZone(unsigned(cz)).type == INOUT_Outlet)InOutc[p] = word(z = unsigned(cz + 1));
+                else del = true;
+            }
+        }
+        if (z) {
+            const unsigned cz = z - 1;
+            const bool inlet = (InOut->GetZone(cz).type == INOUT_Inlet);
+            if (inlet && InOut->GetCoord(cz, ps) > InOut->GetCoordOut(cz)) {
+                //-Buffer particle becomes fluid and a new buffer particle is created upstream / La particula buffer pasa a fluido y se crea una nueva aguas arriba.
+                InOutc[p] = 0;
+                const tdouble3 ps2 = ps + InOut->GetInletShift(cz);
+                const tdouble3 psc = OrderCode(ps2);
+                if (Map_PosMin <= psc && psc < Map_PosMax) {
+                    unsigned cx = unsigned((psc.x - DomPosMin.x) / Scell);
+                    unsigned cy = unsigned((psc.y - DomPosMin.y) / Scell);
+                    unsigned cz2 = unsigned((psc.z - DomPosMin.z) / Scell);
+                    cx = (cx <= DomCells.x ? cx : DomCells.x);
+                    cy = (cy <= DomCells.y ? cy : DomCells.y);
+                    cz2 = (cz2 <= DomCells.z ? cz2 : DomCells.z);
+                    const tfloat3 v = OrderCode(InOut->GetVelocity(cz));
+                    const tfloat4 vr = TFloat4(v.x, v.y, v.z, InOut->GetRhop(cz, ps2.z, RhopZero));
+                    Idpc[pnew] = InOut->NewId(IdMax);
+                    Codec[pnew] = rcode;
+                    Dcellc[pnew] = PC__Cell(DomCellCode, cx, cy, cz2);
+                    Posc[pnew] = psc;
+                    Velrhopc[pnew] = vr;
+                    if (VelrhopM1c)VelrhopM1c[pnew] = vr;
+                    if (SpsTauc)memset(SpsTauc + pnew, 0, sizeof(tsymatrix3f));
+                    InOutc[pnew] = word(z);
+                    pnew++;
+                } else nfail++;
+            } else if (!InOut->Inside(cz, ps)) {
+                //-Only the particles that leave through the outer face are deleted, the rest become fluid again / Solo se eliminan las particulas que salen por la cara exterior, el resto vuelven a ser fluido.
+                const double coord = InOut->GetCoord(cz, ps);
+                if (inlet ? coord < InOut->GetCoordIn(cz) : coord > InOut->GetCoordOut(cz))del = true;
+                else InOutc[p] = 0;
+            } else {
+                //-Prescribed velocity and density of the buffer particles / Velocidad y densidad impuestas de las particulas buffer.
+                tfloat4 vr = Velrhopc[p];
+                if (inlet) {
+                    const tfloat3 v = OrderCode(InOut->GetVelocity(cz));
+                    vr = TFloat4(v.x, v.y, v.z, vr.w);
+                }
+                vr.w = InOut->GetRhop(cz, ps.z, vr.w);
+                Velrhopc[p] = vr;
+                if (VelrhopM1c)VelrhopM1c[p] = vr;
+            }
+        }
+        if (del) {
+            Codec[p] = CODE_SetOutIgnore(rcode);
+            InOut->FreeId(Idpc[p]);
+            ndel++;
+        }
+    }
+    Np = pnew;
+    TotalNp += (pnew - np0);
+    InOut->AddNew(pnew - np0, nfail);
+    InOut->AddDeleted(ndel);
+    TmcStop(Timers, TMC_SuInOut);
+}
+
+/*
+ * @desc 使用 splitting 时初始化每个粒子的质量和光滑长度 (边界为 MassBound, 其余为 MassFluid, 全部为 H)
+ */
+void JSphCpuSingle::SplitInit() {
+    for (unsigned p = 0; p < Np; p++) {
+        const word type = CODE_GetType(Codec[p]);
+        Massc[p] = (type == CODE_TYPE_FIXED || type == CODE_TYPE_MOVING ? MassBound : MassFluid);
+        Hvarc[p] = H;
+    }
+    Splitting->SetMassIni(SplitFluidMass(Npb, Np));
+}
+
+/*
+ * @desc 返回 pini 到 pfin-1 之间流体粒子的总质量 (double 累加)
+ */
+double JSphCpuSingle::SplitFluidMass(unsigned pini, unsigned pfin) const {
+    double mass = 0;
+    for (unsigned p = pini; p < pfin; p++)if (CODE_GetType(Codec[p]) == CODE_TYPE_FLUID)mass += Massc[p];
+    return (mass);
+}
+
+/*
+ * @desc 返回位置所在的单元格 (位置必须在 Map_PosMin 和 Map_PosMax 之间)
+ */
+unsigned JSphCpuSingle::GetCellPos(const tdouble3 &ps) const {
+    unsigned cx = unsigned((ps.x - DomPosMin.x) / Scell);
+    unsigned cy = unsigned((ps.y - DomPosMin.y) / Scell);
+    unsigned cz = unsigned((ps.z - DomPosMin.z) / Scell);
+    cx = (cx <= DomCells.x ? cx : DomCells.x);
+    cy = (cy <= DomCells.y ? cy : DomCells.y);
+    cz = (cz <= DomCells.z ? cz : DomCells.z);
+    return (PC__Cell(DomCellCode, cx, cy, cz));
+}
+
+/*
+ * @desc
+ * 流体粒子的分裂与合并 (自适应分辨率), 每 Splitting->GetSteps() 步在 RunCellDivide() 之前执行
+ * 细化区域 (box, 靠近边界, 自由表面) 内的粒子分裂为 4 (2D) 或 8 (3D) 个子粒子, 间距和光滑长度减半
+ * 细化区域外 (加上 H 的余量) 质量相同的两个最近的细粒子合并为一个, 质量不超过初始流体粒子的质量
+ * 邻居搜索使用上一次 divide 的单元格, 单元格大小对应最大的光滑长度 H
+ * 合并后被删除的粒子标记为 CODE_OUTIGNORE, 子粒子添加在数组末尾
+ */
+void JSphCpuSingle::RunSplitting() {
+    TmcStart(Timers, TMC_SuSplitting);
+    const unsigned np0 = Np;
+    const unsigned nchild = Splitting->GetNumChildren();
+    const tint4 nc = TInt4(int(CellDivSingle->GetNcells().x), int(CellDivSingle->GetNcells().y),
+                           int(CellDivSingle->GetNcells().z),
+                           int(CellDivSingle->GetNcells().x * CellDivSingle->GetNcells().y));
+    const unsigned cellfluid = unsigned(nc.w * nc.z) + 1;
+    const unsigned cellfloat = cellfluid + unsigned(nc.w * nc.z);
+    const tint3 cellzero = TInt3(CellDivSingle->GetCellDomainMin().x, CellDivSingle->GetCellDomainMin().y,
+                                 CellDivSingle->GetCellDomainMin().z);
+    const int hdiv = (CellMode == CELLMODE_H ? 2 : 1);
+    const unsigned *begincell = CellDivSingle->GetBeginCell();
+    // 合并需要离开细化区域一个 H 的余量, 避免反复分裂与合并
+    const double margin = H;
+    const double bdist = Splitting->GetBoundDist();
+    const int hdivb = (bdist ? max(hdiv, int(ceil((bdist + margin) / Scell))) : 0);
+    const bool fsurf = Splitting->GetFreeSurface();
+    const float dim = (Simulate2D ? 2.f : 3.f);
+    const float divrefine = dim - Splitting->GetDivRefine(), divmerge = dim - Splitting->GetDivMerge();
+    unsigned *splitc = ArraysCpu->ReserveUint();
+    unsigned *pairc = ArraysCpu->ReserveUint();
+    const llong pini = llong(Npb), pfin = llong(np0);
+    //-Refinement criteria of each fluid particle / Criterios de refinamiento de cada particula de fluido.
+#ifdef _WITHOMP
+#pragma omp parallel for schedule (guided)
+#endif
+    for (llong p1 = pini; p1 < pfin; p1++) {
+        unsigned flag = SPLIT_Keep;
+        const word rcode = Codec[p1];
+        if (CODE_GetSpecialValue(rcode) == CODE_NORMAL && CODE_GetType(rcode) == CODE_TYPE_FLUID) {
+            const tdouble3 posp1 = Posc[p1];
+            const tdouble3 ps = OrderDecode(posp1);
+            bool refine = Splitting->InBox(ps, 0);
+            bool coarse = !Splitting->InBox(ps, margin);
+            int cxini, cxfin, yini, yfin, zini, zfin;
+            // 到最近边界粒子的距离
+            if (bdist) {
+                GetInteractionCells(Dcellc[p1], hdivb, nc, cellzero, cxini, cxfin, yini, yfin, zini, zfin);
+                double dmin2 = DBL_MAX;
+                for (int z = zini; z < zfin; z++) {
+                    const int zmod = nc.w * z;
+                    for (int y = yini; y < yfin; y++) {
+                        const int ymod = zmod + nc.x * y;
+                        const unsigned p2fin = begincell[cxfin + ymod];
+                        for (unsigned p2 = begincell[cxini + ymod]; p2 < p2fin; p2++) {
+                            const double dx = posp1.x - Posc[p2].x, dy = posp1.y - Posc[p2].y, dz = posp1.z - Posc[p2].z;
+                            dmin2 = min(dmin2, dx * dx + dy * dy + dz * dz);
+                        }
+                    }
+                }
+                const double dmin = sqrt(dmin2);
+                refine = refine || dmin < bdist;
+                coarse = coarse && dmin > bdist + margin;
+            }
+            // 使用初始分辨率的 kernel 计算位置的散度, 自由表面附近小于维数
+            if (fsurf) {
+                GetInteractionCells(Dcellc[p1], hdiv, nc, cellzero, cxini, cxfin, yini, yfin, zini, zfin);
+                float div = 0;
+                for (unsigned cb = 0; cb < (WithFloating ? 3u : 2u); cb++) {
+                    const unsigned cellinitial = (!cb ? 0 : (cb == 1 ? cellfluid : cellfloat));
+                    for (int z = zini; z < zfin; z++) {
+                        const int zmod = nc.w * z + cellinitial;
+                        for (int y = yini; y < yfin; y++) {
+                            const int ymod = zmod + nc.x * y;
+                            const unsigned p2fin = begincell[cxfin + ymod];
+                            for (unsigned p2 = begincell[cxini + ymod]; p2 < p2fin; p2++) {
+                                const float drx = float(posp1.x - Posc[p2].x);
+                                const float dry = float(posp1.y - Posc[p2].y);
+                                const float drz = float(posp1.z - Posc[p2].z);
+                                const float rr2 = drx * drx + dry * dry + drz * drz;
+                                if (rr2 <= Fourh2 && rr2 >= ALMOSTZERO) {
+                                    //-Wendland kernel, dr*gradW=fac*rr2.
+                                    const float rad = sqrt(rr2), qq = rad / H;
+                                    const float wqq1 = 1.f - 0.5f * qq;
+                                    const float fac = Bwen * qq * wqq1 * wqq1 * wqq1 / rad;
+                                    div -= Massc[p2] / Velrhopc[p2].w * fac * rr2;
+                                }
+                            }
+                        }
+                    }
+                }
+                refine = refine || div < divrefine;
+                coarse = coarse && div > divmerge;
+            }
+            flag = (refine ? SPLIT_Refine : (coarse ? SPLIT_Coarse : SPLIT_Keep));
+        }
+        splitc[p1] = flag;
+    }
+    //-Nearest fine particle to be merged with / Particula fina mas cercana con la que unirse.
+#ifdef _WITHOMP
+#pragma omp parallel for schedule (guided)
+#endif
+    for (llong p1 = pini; p1 < pfin; p1++) {
+        unsigned pair = UINT_MAX;
+        const float massp1 = Massc[p1];
+        if (splitc[p1] == SPLIT_Coarse && Splitting->CanMerge(massp1, massp1)) {
+            const tdouble3 posp1 = Posc[p1];
+            double rmin2 = double(Hvarc[p1]) * Hvarc[p1];
+            int cxini, cxfin, yini, yfin, zini, zfin;
+            GetInteractionCells(Dcellc[p1], hdiv, nc, cellzero, cxini, cxfin, yini, yfin, zini, zfin);
+            for (int z = zini; z < zfin; z++) {
+                const int zmod = nc.w * z + cellfluid;
+                for (int y = yini; y < yfin; y++) {
+                    const int ymod = zmod + nc.x * y;
+                    const unsigned p2fin = begincell[cxfin + ymod];
+                    for (unsigned p2 = begincell[cxini + ymod]; p2 < p2fin; p2++)
+                        if (p2 != unsigned(p1) && splitc[p2] == SPLIT_Coarse && Splitting->CanMerge(massp1, Massc[p2])) {
+                            const double dx = posp1.x - Posc[p2].x, dy = posp1.y - Posc[p2].y, dz = posp1.z - Posc[p2].z;
+                            const double rr2 = dx * dx + dy * dy + dz * dz;
+                            if (rr2 < rmin2) {
+                                rmin2 = rr2;
+                                pair = p2;
+                            }
+                        }
+                }
+            }
+        }
+        pairc[p1] = pair;
+    }
+    //-Particles to split and mutual nearest pairs to merge / Particulas a dividir y parejas mutuas a unir.
+    std::vector<unsigned> splitlist, mergelist;
+    for (unsigned p = Npb; p < np0; p++) {
+        if (splitc[p] == SPLIT_Refine && Splitting->CanSplit(Massc[p]))splitlist.push_back(p);
+        const unsigned q = pairc[p];
+        if (q != UINT_MAX && q > p && pairc[q] == p) {
+            mergelist.push_back(p);
+            mergelist.push_back(q);
+        }
+    }
+    ArraysCpu->Free(splitc);
+    ArraysCpu->Free(pairc);
+    //-Grows or shrinks the memory of particles / Aumenta o reduce la memoria de particulas.
+    const unsigned npmax = np0 + unsigned(splitlist.size()) * (nchild - 1);
+    if (npmax > CpuParticlesSize || npmax < CpuParticlesSize / 2) {
+        TmcStop(Timers, TMC_SuSplitting);
+        ResizeParticlesSize(npmax, SPLIT_OVERMEMORYNP, false);
+        TmcStart(Timers, TMC_SuSplitting);
+    }
+    //-Merges the pairs keeping mass and momentum / Une las parejas conservando masa y momento.
+    const unsigned nmerge = unsigned(mergelist.size() / 2);
+    for (unsigned c = 0; c < nmerge; c++) {
+        const unsigned p = mergelist[c * 2], q = mergelist[c * 2 + 1];
+        const float m1 = Massc[p], m2 = Massc[q], m = m1 + m2;
+        const float w1 = m1 / m, w2 = m2 / m;
+        const tdouble3 ps = Posc[p] * double(w1) + Posc[q] * double(w2);
+        Posc[p] = ps;
+        Dcellc[p] = GetCellPos(ps);
+        Velrhopc[p] = Velrhopc[p] * TFloat4(w1) + Velrhopc[q] * TFloat4(w2);
+        if (VelrhopM1c)VelrhopM1c[p] = VelrhopM1c[p] * TFloat4(w1) + VelrhopM1c[q] * TFloat4(w2);
+        Massc[p] = m;
+        Hvarc[p] = Splitting->GetHvar(m);
+        Codec[q] = CODE_SetOutIgnore(Codec[q]);
+        Splitting->FreeId(Idpc[q]);
+    }
+    //-Splits the particles, the first child replaces the particle / Divide las particulas, la primera hija reemplaza a la particula.
+    unsigned pnew = np0, nsplit = 0, nfail = 0;
+    tdouble3 psc[8];
+    for (unsigned c = 0; c < unsigned(splitlist.size()); c++) {
+        const unsigned p = splitlist[c];
+        const float mass = Massc[p];
+        const tdouble3 ps = OrderDecode(Posc[p]);
+        bool ok = true;
+        for (unsigned cc = 0; cc < nchild && ok; cc++) {
+            psc[cc] = OrderCode(ps + Splitting->GetChildOffset(cc, mass));
+            ok = (Map_PosMin <= psc[cc] && psc[cc] < Map_PosMax);
+        }
+        if (!ok) {
+            nfail++;
+            continue;
+        }
+        const float massc = mass / nchild, hc = Splitting->GetHvar(massc);
+        for (unsigned cc = 0; cc < nchild; cc++) {
+            const unsigned pc = (cc ? pnew++ : p);
+            if (cc) {
+                Idpc[pc] = Splitting->NewId(IdMax);
+                Codec[pc] = Codec[p];
+                Velrhopc[pc] = Velrhopc[p];
+                if (VelrhopM1c)VelrhopM1c[pc] = VelrhopM1c[p];
+            }
+            Posc[pc] = psc[cc];
+            Dcellc[pc] = GetCellPos(psc[cc]);
+            Massc[pc] = massc;
+            Hvarc[pc] = hc;
+        }
+        nsplit++;
+    }
+    Np = pnew;
+    TotalNp += (pnew - np0);
+    Splitting->AddSplit(nsplit, nfail);
+    Splitting->AddMerged(nmerge);
+    TmcStop(Timers, TMC_SuSplitting);
+}
+
 /*
  * @desc 返回相互作用的cell限制
  */
@@ -484,48 +1087,230 @@ void JSphCpuSingle::GetInteractionCells(unsigned rcell, int hdiv, const tint4 &n
 }
 
 /*
- * @desc 计算相互作用受力
+ * @desc 按原顺序重排周期粒子的数组 (vec[sortpart[p]] -> vec[p])
  */
-void JSphCpuSingle::Interaction_Forces(TpInter tinter) {
-    const char met[] = "Interaction_Forces";
+template<class T>
+static void SortHaloArray(unsigned n, const unsigned *sortpart, T *aux, T *vec) {
+    for (unsigned p = 0; p < n; p++)aux[p] = vec[sortpart[p]];
+    memcpy(vec, aux, sizeof(T) * n);
+}
+
+/*
+ * @desc
+ * 按cell对 [np0,Np) 中的周期粒子排序并创建 HaloBeginCell (-overlap)
+ * 网格覆盖 CellDivSingle 的网格、周期粒子和被忽略的边界粒子
+ * HaloBeginCell 与 BeginCell 的布局相同: 边界cell, 忽略, 流体cell
+ * 计算周期粒子的 Pressc 和 PsPosc
+ */
+void JSphCpuSingle::PrepareHaloCells(unsigned np0) {
+    const unsigned ncopy = Np - np0;
+    const unsigned pfluid = np0 + NpbPer;
+    //-Cell limits of the structure / Limites de celdas de la estructura.
+    tuint3 cmin = CellDivSingle->GetCellDomainMin();
+    tuint3 cmax = cmin + CellDivSingle->GetNcells() - TUint3(1);
+    for (unsigned c = 0; c < 2; c++) {
+        const unsigned pini = (c ? np0 : NpbOk), pfin = (c ? Np : Npb);
+        for (unsigned p = pini; p < pfin; p++) {
+            const unsigned rcell = Dcellc[p];
+            const unsigned cx = PC__Cellx(DomCellCode, rcell), cy = PC__Celly(DomCellCode, rcell), cz = PC__Cellz(
+                    DomCellCode, rcell);
+            cmin = TUint3(min(cmin.x, cx), min(cmin.y, cy), min(cmin.z, cz));
+            cmax = TUint3(max(cmax.x, cx), max(cmax.y, cy), max(cmax.z, cz));
+        }
+    }
+    HaloCellMin = cmin;
+    HaloNcells = cmax - cmin + TUint3(1);
+    const unsigned nsheet = HaloNcells.x * HaloNcells.y, nct = nsheet * HaloNcells.z, cellfluid = nct + 1;
+    const unsigned nctt = nct * 2 + 2;
+    if (HaloBeginCell.size() < nctt)HaloBeginCell.resize(nctt);
+    if (JMemRegistry::Active)JMemRegistry::Set("CellDiv", "HaloBeginCell", llong(sizeof(unsigned)) * HaloBeginCell.size());
+    unsigned *begincell = &HaloBeginCell[0];
+
+    //-Counting sort of the periodic particles by cell / Ordena las periodicas por celda contando.
+    unsigned *cellpart = ArraysCpu->ReserveUint();
+    unsigned *sortpart = ArraysCpu->ReserveUint();
+    memset(begincell, 0, sizeof(unsigned) * nctt);
+    for (unsigned p = np0; p < Np; p++) {
+        const unsigned rcell = Dcellc[p];
+        const unsigned cx = PC__Cellx(DomCellCode, rcell) - cmin.x, cy = PC__Celly(DomCellCode, rcell) - cmin.y;
+        const unsigned cz = PC__Cellz(DomCellCode, rcell) - cmin.z;
+        const unsigned box = cx + cy * HaloNcells.x + cz * nsheet + (p < pfluid ? 0 : cellfluid);
+        cellpart[p - np0] = box;
+        begincell[box + 1]++;
+    }
+    begincell[0] = np0;
+    for (unsigned box = 0; box < nctt - 1; box++)begincell[box + 1] += begincell[box];
+    for (unsigned p = 0; p < ncopy; p++)sortpart[(begincell[cellpart[p]]++) - np0] = p;
+    for (unsigned box = nctt - 1; box > 0; box--)begincell[box] = begincell[box - 1];
+    begincell[0] = np0;
+    ArraysCpu->Free(cellpart);
+    cellpart = NULL;
+
+    //-Reorder the data of the periodic particles using an auxiliary array of 24 bytes / Reordena los datos de las periodicas con un array auxiliar de 24 bytes.
+    tdouble3 *aux = ArraysCpu->ReserveDouble3();
+    SortHaloArray(ncopy, sortpart, (tpartid *) aux, Idpc + np0);
+    SortHaloArray(ncopy, sortpart, (unsigned *) aux, Dcellc + np0);
+    SortHaloArray(ncopy, sortpart, (word *) aux, Codec + np0);
+    SortHaloArray(ncopy, sortpart, aux, Posc + np0);
+    SortHaloArray(ncopy, sortpart, (tfloat4 *) aux, Velrhopc + np0);
+    if (VelrhopM1c)SortHaloArray(ncopy, sortpart, (tfloat4 *) aux, VelrhopM1c + np0);
+    if (PosPrec)SortHaloArray(ncopy, sortpart, aux, PosPrec + np0);
+    if (VelrhopPrec)SortHaloArray(ncopy, sortpart, (tfloat4 *) aux, VelrhopPrec + np0);
+    ArraysCpu->Free(aux);
+    ArraysCpu->Free(sortpart);
+
+    //-Prepare values of rhop for interaction / Prepara datos derivados de rhop para interaccion.
+    for (unsigned p = np0; p < Np; p++) {
+        const float rhop = Velrhopc[p].w, rhop_r0 = rhop / RhopZero;
+        Pressc[p] = CteB * (pow(rhop_r0, Gamma) - 1.0f);
+        if (Psimple)PsPosc[p] = ToTFloat3(Posc[p]);
+    }
+}
+
+/*
+ * @desc
+ * 计算相互作用受力并同时创建周期粒子 (-overlap)
+ * 一个线程创建周期粒子, 其余线程计算不含周期粒子的相互作用
+ * 然后只计算与周期粒子的相互作用并丢弃周期粒子
+ * 内存不足时返回 false, 不保留结果
+ */
+bool JSphCpuSingle::Interaction_ForcesOverlap(TpInter tinter, float &viscdt) {
+    const unsigned np0 = Np;
+    //-Reserve memory for the periodic particles before the arrays of the interaction / Reserva memoria para las periodicas antes que los arrays de la interaccion.
+    const unsigned npmin = np0 + NpbPerM1 + NpfPerM1;
+    if (npmin > CpuParticlesSize)ResizeParticlesSize(npmin, PERIODIC_OVERMEMORYNP, false);
     PreInteraction_Forces(tinter);
     TmcStart(Timers, TMC_CfForces);
 
-    // 流体/束缚和束缚流体（力和DEM）的相互作用
-    float viscdt = 0;
+    //-Interaction without periodic particles while they are created / Interaccion sin periodicas mientras se crean.
+    bool periok = true;
+#ifdef _WITHOMP
+    const int maxlevels = omp_get_max_active_levels();
+    omp_set_max_active_levels(2);
+#pragma omp parallel sections num_threads(2) if(OmpThreads>1)
+#endif
+    {
+#ifdef _WITHOMP
+#pragma omp section
+#endif
+        {
+#ifdef _WITHOMP
+            omp_set_num_threads(max(OmpThreads - 1, 1));
+#endif
+            if (Psimple) {
+                JSphCpu::InteractionSimple_Forces(np0, Npb, NpbOk, CellDivSingle->GetNcells(),
+                                                  CellDivSingle->GetBeginCell(), CellDivSingle->GetCellDomainMin(),
+                                                  Dcellc, PsPosc, Velrhopc, Idpc, Codec, Pressc, viscdt, Arc, Acec,
+                                                  Deltac, SpsTauc, SpsGradvelc, ShiftPosc, ShiftDetectc);
+            } else {
+                JSphCpu::Interaction_Forces(np0, Npb, NpbOk, CellDivSingle->GetNcells(), CellDivSingle->GetBeginCell(),
+                                            CellDivSingle->GetCellDomainMin(), Dcellc, Posc, Velrhopc, Idpc, Codec,
+                                            Pressc, viscdt, Arc, Acec, Deltac, SpsTauc, SpsGradvelc, ShiftPosc,
+                                            ShiftDetectc);
+            }
+        }
+#ifdef _WITHOMP
+#pragma omp section
+#endif
+        {
+#ifdef _WITHOMP
+            omp_set_num_threads(1);
+#endif
+            periok = RunPeriodic(false);
+            if (periok)PrepareHaloCells(np0);
+        }
+    }
+#ifdef _WITHOMP
+    omp_set_max_active_levels(maxlevels);
+#endif
+    if (!periok) {
+        TmcStop(Timers, TMC_CfForces);
+        PosInteraction_Forces();
+        Np = np0;
+        NpbPer = NpfPer = 0;
+        return (false);
+    }
+
+    //-Interaction with the periodic particles, ignored bound included / Interaccion con las periodicas, incluidas las bound ignoradas.
+    float viscdt2 = 0;
     if (Psimple) {
-        JSphCpu::InteractionSimple_Forces(Np, Npb, NpbOk, CellDivSingle->GetNcells(), CellDivSingle->GetBeginCell(),
-                                          CellDivSingle->GetCellDomainMin(), Dcellc, PsPosc, Velrhopc, Idpc, Codec,
-                                          Pressc, viscdt, Arc, Acec, Deltac, SpsTauc, SpsGradvelc, ShiftPosc,
-                                          ShiftDetectc);
+        JSphCpu::InteractionSimple_Forces(np0, Npb, Npb, HaloNcells, &HaloBeginCell[0], HaloCellMin, Dcellc, PsPosc,
+                                          Velrhopc, Idpc, Codec, Pressc, viscdt2, Arc, Acec, Deltac, SpsTauc,
+                                          SpsGradvelc, ShiftPosc, ShiftDetectc);
     } else {
-        JSphCpu::Interaction_Forces(Np, Npb, NpbOk, CellDivSingle->GetNcells(), CellDivSingle->GetBeginCell(),
-                                    CellDivSingle->GetCellDomainMin(), Dcellc, Posc, Velrhopc, Idpc, Codec, Pressc,
-                                    viscdt, Arc, Acec, Deltac, SpsTauc, SpsGradvelc, ShiftPosc, ShiftDetectc);
+        JSphCpu::Interaction_Forces(np0, Npb, Npb, HaloNcells, &HaloBeginCell[0], HaloCellMin, Dcellc, Posc, Velrhopc,
+                                    Idpc, Codec, Pressc, viscdt2, Arc, Acec, Deltac, SpsTauc, SpsGradvelc, ShiftPosc,
+                                    ShiftDetectc);
+    }
+    viscdt = max(viscdt, viscdt2);
+
+    //-The periodic particles are discarded after the interaction / Las periodicas se descartan tras la interaccion.
+    NpbPerM1 = NpbPer;
+    NpfPerM1 = NpfPer;
+    Np = np0;
+    NpbPer = NpfPer = 0;
+    return (true);
+}
+
+/*
+ * @desc 计算相互作用受力
+ */
+void JSphCpuSingle::Interaction_Forces(TpInter tinter) {
+    float viscdt = 0;
+    bool done = false;
+    // 使用 -overlap 时在相互作用期间创建周期粒子, 内存不足时按原顺序创建
+    if (PeriodicPending) {
+        PeriodicPending = false;
+        done = Interaction_ForcesOverlap(tinter, viscdt);
+        if (!done) {
+            RunPeriodic();
+            RunCellDivide(false);
+        }
+    }
+    if (!done) {
+        PreInteraction_Forces(tinter);
+        TmcStart(Timers, TMC_CfForces);
+
+        // 流体/束缚和束缚流体（力和DEM）的相互作用
+        if (Psimple) {
+            JSphCpu::InteractionSimple_Forces(Np, Npb, NpbOk, CellDivSingle->GetNcells(), CellDivSingle->GetBeginCell(),
+                                              CellDivSingle->GetCellDomainMin(), Dcellc, PsPosc, Velrhopc, Idpc, Codec,
+                                              Pressc, viscdt, Arc, Acec, Deltac, SpsTauc, SpsGradvelc, ShiftPosc,
+                                              ShiftDetectc);
+        } else {
+            JSphCpu::Interaction_Forces(Np, Npb, NpbOk, CellDivSingle->GetNcells(), CellDivSingle->GetBeginCell(),
+                                        CellDivSingle->GetCellDomainMin(), Dcellc, Posc, Velrhopc, Idpc, Codec, Pressc,
+                                        viscdt, Arc, Acec, Deltac, SpsTauc, SpsGradvelc, ShiftPosc, ShiftDetectc);
+        }
     }
 
     // 对于二维模拟，将第二个分量归零
     if (Simulate2D) {
-        const int ini = int(Npb), fin = int(Np), npf = int(Np - Npb);
+        const llong ini = llong(Npb), fin = llong(Np), npf = llong(Np - Npb);
 #ifdef _WITHOMP
 #pragma omp parallel for schedule (static) if(npf>LIMIT_COMPUTELIGHT_OMP)
 #endif
-        for (int p = ini; p < fin; p++)Acec[p].y = 0;
+        for (llong p = ini; p < fin; p++)Acec[p].y = 0;
     }
 
     // 将Delta-SPH更正添加到Arg []
     if (Deltac) {
-        const int ini = int(Npb), fin = int(Np), npf = int(Np - Npb);
+        const llong ini = llong(Npb), fin = llong(Np), npf = llong(Np - Npb);
 #ifdef _WITHOMP
 #pragma omp parallel for schedule (static) if(npf>LIMIT_COMPUTELIGHT_OMP)
 #endif
-        for (int p = ini; p < fin; p++)if (Deltac[p] != FLT_MAX)Arc[p] += Deltac[p];
+        for (llong p = ini; p < fin; p++)if (Deltac[p] != FLT_MAX)Arc[p] += Deltac[p];
     }
 
+    // 使用 -sleep 时休眠粒子使用静水力
+    if (SleepSteps)SleepUpdate(tinter);
+    // 开放边界的buffer粒子不计算力
+    if (InOut)InOutForces();
+
     // 计算 ViscDt 的最大值
     ViscDtMax = viscdt;
     // 计算 Ace 的最大值
-    AceMax = ComputeAceMaxOmp(PeriActive != 0, Np - Npb, Acec + Npb, Codec + Npb);
+    AceMax = ComputeAceMaxOmp(PeriActive != 0 || WithMpi, Np - Npb, Acec + Npb, Codec + Npb);
 
     TmcStop(Timers, TMC_CfForces);
 }
@@ -536,9 +1321,9 @@ void JSphCpuSingle::Interaction_Forces(TpInter tinter) {
 double
 JSphCpuSingle::ComputeAceMaxSeq(const bool checkcodenormal, unsigned np, const tfloat3 *ace, const word *code) const {
     float acemax = 0;
-    const int n = int(np);
+    const llong n = llong(np);
     //-With periodic conditions ignore periodic particles / Con condiciones periodicas ignora las particulas periodicas.
-    for (int p = 0; p < n; p++)
+    for (llong p = 0; p < n; p++)
         if (!checkcodenormal || CODE_GetSpecialValue(code[p]) == CODE_NORMAL) {
             const tfloat3 a = ace[p];
             const float a2 = a.x * a.x + a.y * a.y + a.z * a.z;
@@ -552,18 +1337,20 @@ JSphCpuSingle::ComputeAceMaxSeq(const bool checkcodenormal, unsigned np, const t
  */
 double
 JSphCpuSingle::ComputeAceMaxOmp(const bool checkcodenormal, unsigned np, const tfloat3 *ace, const word *code) const {
-    const char met[] = "ComputeAceMaxOmp";
     double acemax = 0;
 #ifdef _WITHOMP
     if (np > LIMIT_COMPUTELIGHT_OMP) {
-        const int n = int(np);
-        if (n < 0)RunException(met, "Number of values is too big.");
-        float amax = 0;
+        const llong n = llong(np);
+        //-Maximo de cada hilo combinado en orden de hilo (no depende del orden de llegada).
+        //-Maximum of each thread combined in thread order (it does not depend on the arrival order).
+        float amaxth[MAXTHREADS_OMP * STRIDE_OMP];
+        for (int th = 0; th < OmpThreads; th++)amaxth[th * STRIDE_OMP] = 0;
 #pragma omp parallel
         {
+            const int th = omp_get_thread_num();
             float amax2 = 0;
 #pragma omp for nowait
-            for (int p = 0; p < n; ++p) {
+            for (llong p = 0; p < n; ++p) {
                 //-With periodic conditions ignore periodic particles / Con condiciones periodicas ignora las particulas periodicas.
                 if (!checkcodenormal || CODE_GetSpecialValue(code[p]) == CODE_NORMAL) {
                     const tfloat3 a = ace[p];
@@ -571,11 +1358,10 @@ JSphCpuSingle::ComputeAceMaxOmp(const bool checkcodenormal, unsigned np, const t
                     if (amax2 < a2)amax2 = a2;
                 }
             }
-#pragma omp critical
-            {
-                if (amax < amax2)amax = amax2;
-            }
+            amaxth[th * STRIDE_OMP] = amax2;
         }
+        float amax = 0;
+        for (int th = 0; th < OmpThreads; th++)if (amax < amaxth[th * STRIDE_OMP])amax = amaxth[th * STRIDE_OMP];
         //-Guarda resultado.
         acemax = sqrt(double(amax));
     } else if (np)acemax = ComputeAceMaxSeq(checkcodenormal, np, ace, code);
@@ -818,8 +1604,15 @@ void JSphCpuSingle::Run(std::string appname, JCfgRun *cfg, JLog2 *log) {
     AppName = appname;
     Log = log;
 
+    // 创建事件跟踪缓冲区 (计时器开始前)
+    if (cfg->SvTrace)JTraceEvents::Config(cfg->SvTrace);
+    // 激活内存登记 (在分配内存之前)
+    if (cfg->SvMemory)JMemRegistry::Config();
     // 创建计时器来测量时间间隔
-    TmcCreation(Timers, cfg->SvTimers);
+    TmcCreation(Timers, cfg->SvTimers || cfg->SvTimersStep || cfg->SvTrace || cfg->SvPerf || cfg->SvRoofline || cfg->SvStatus || cfg->BenchSteps);
+    if (!WithMpi)TmcActive(Timers, TMC_SuMpiExchange, false);
+    if (!InOut)TmcActive(Timers, TMC_SuInOut, false);
+    if (!Splitting)TmcActive(Timers, TMC_SuSplitting, false);
     // 开始运行计时器
     TmcStart(Timers, TMC_Init);
 
@@ -834,13 +1627,29 @@ void JSphCpuSingle::Run(std::string appname, JCfgRun *cfg, JLog2 *log) {
 
     // 初始化执行变量
     InitRun();
-    UpdateMaxValues();
-    PrintAllocMemory(GetAllocMemoryCpu());
-    SaveData();
-    TmcResetValues(Timers);
-    TmcStop(Timers, TMC_Init);
-    PartNstep = -1;
-    Part++;
+    if (RestartData) {
+        // 恢复checkpoint的模拟状态 (不重新保存初始PART)
+        LoadCheckpointStep(RestartData);
+        delete RestartData;
+        RestartData = NULL;
+        UpdateMaxValues();
+        PrintAllocMemory(GetAllocMemoryCpu());
+        TmcResetValues(Timers);
+        TmcStop(Timers, TMC_Init);
+    } else {
+        UpdateMaxValues();
+        PrintAllocMemory(GetAllocMemoryCpu());
+        SaveData();
+        if (CheckSaveFilters())SaveFilterData();
+        TmcResetValues(Timers);
+        TmcStop(Timers, TMC_Init);
+        PartNstep = -1;
+        Part++;
+        if (CheckpointBi4)CheckpointNext = TimeStep + CheckpointTime;
+    }
+    if (SvTimersStep)ConfigTimersStep();
+    if (SvPerf)ConfigPerfCounters();
+    if (SvRoofline)ConfigRoofline();
 
     // 主循环
     bool partoutstop = false;
@@ -848,16 +1657,33 @@ void JSphCpuSingle::Run(std::string appname, JCfgRun *cfg, JLog2 *log) {
     TimerPart.Start();
     Log->Print(string("\n[Initialising simulation (") + RunCode + ")  " + fun::GetDateTime() + "]");
     PrintHeadPart();
-    while (TimeStep < TimeMax) {
+    if (SvStatus)SaveStatus("running", 0);
+    // 基准模式: 固定步数, 忽略TimeMax
+    while (BenchSteps ? BenchCount < BenchWarmup + BenchSteps && !partoutstop : TimeStep < TimeMax) {
+        if (BenchSteps) {
+            if (BenchCount == BenchWarmup)BenchBegin();
+            BenchCount++;
+            if (BenchCount > BenchWarmup)BenchNpSteps += Np;
+        }
+        if (JPerfCounters::Active)PerfNpSteps += Np;
+        if (SvStatus)StatusNpSteps += Np;
+        if (JMemRegistry::Active)JMemRegistry::SetTimeStep(TimeStep);
+        if (Roofline) {
+            RoofNpSteps += Np;
+            RoofNpfSteps += Np - Npb;
+            RoofNpbOkSteps += NpbOk;
+        }
         if (ViscoTime) Visco = ViscoTime->GetVisco(float(TimeStep));
         double stepdt = ComputeStep();
         if (PartDtMin > stepdt) PartDtMin = stepdt;
         if (PartDtMax < stepdt) PartDtMax = stepdt;
         if (CaseNmoving) RunMotion(stepdt);
+        if (InOut) RunInOut();
+        if (Splitting && Nstep % Splitting->GetSteps() == 0) RunSplitting();
         RunCellDivide(true);
         TimeStep += stepdt;
-        partoutstop = (Np < NpMinimum || !Np);
-        if (TimeStep >= TimePartNext || partoutstop) {
+        partoutstop = CheckPartOutStop();
+        if ((TimeStep >= TimePartNext && !BenchSteps) || partoutstop) {
             if (partoutstop) {
                 Log->Print("\n**** Particles OUT limit reached...\n");
                 TimeMax = TimeStep;
@@ -868,39 +1694,70 @@ void JSphCpuSingle::Run(std::string appname, JCfgRun *cfg, JLog2 *log) {
             TimeStepM1 = TimeStep;
             TimePartNext = TimeOut->GetNextTime(TimeStep);
             TimerPart.Start();
+            if (CheckpointBi4 && TimeStep >= CheckpointNext && TimeStep < TimeMax)SaveCheckpoint();
         }
+        if (!BenchSteps && CheckSaveFilters())SaveFilterData();
         UpdateMaxValues();
+        if (TimersStep)SaveTimersStep(stepdt);
         Nstep++;
-        //if(Nstep>=3) break;
+        if (SvStatus) {
+            TimerStatus.Stop();
+            if (TimerStatus.GetElapsedTimeD() >= SvStatus * 1000.)SaveStatus("running", stepdt);
+        }
     }
     TimerSim.Stop();
     TimerTot.Stop();
+    if (BenchSteps)TimerBench.Stop();
 
     // 结束模拟计算
     FinishRun(partoutstop);
 }
 
+/*
+ * @desc 检查剩余粒子数是否低于允许的最小值
+ */
+bool JSphCpuSingle::CheckPartOutStop() {
+    return (Np < NpMinimum || !Np);
+}
+
 /*
  * @desc 生成输出文件
  */
 void JSphCpuSingle::SaveData() {
     const bool save = (SvData != SDAT_None && SvData != SDAT_Info);
+    // 到期的过滤输出复用同一次收集的数据
+    const bool svfilters = CheckSaveFilters();
     // 保持周期性粒子 如果存在
     const unsigned npsave = Np - NpbPer - NpfPer;
     TmcStart(Timers, TMC_SuSavePart);
+    // 相互作用统计 (在保留保存用的数组之前计算)
+    StForceStats forcestats;
+    memset(&forcestats, 0, sizeof(StForceStats));
+    if (SvForceStats && (SvData & SDAT_Info))ComputeForceStats(forcestats);
     // 按原始顺序收集粒子值
-    unsigned *idp = NULL;
+    tpartid *idp = NULL;
     tdouble3 *pos = NULL;
     tfloat3 *vel = NULL;
     float *rhop = NULL;
-    if (save) {
+    float *mass = NULL, *hvar = NULL;
+    word *code = NULL;
+    if (save || svfilters) {
         // 分配内存并收集粒子数据
-        idp = ArraysCpu->ReserveUint();
+        idp = ArraysCpu->ReserveIdp();
         pos = ArraysCpu->ReserveDouble3();
         vel = ArraysCpu->ReserveFloat3();
         rhop = ArraysCpu->ReserveFloat();
-        unsigned npnormal = GetParticlesData(Np, 0, true, PeriActive != 0, idp, pos, vel, rhop, NULL);
+        if (svfilters)code = ArraysCpu->ReserveWord();
+        JTraceScope trace("SU-SaveData-Gather");
+        unsigned npnormal = GetParticlesData(Np, 0, true, PeriActive != 0 || WithMpi, idp, pos, vel, rhop, code);
         if (npnormal != npsave) RunException("SaveData", "The number of particles is invalid.");
+        // 分裂粒子的质量和光滑长度 (不支持周期性条件, 因此顺序相同)
+        if (Splitting && save) {
+            mass = ArraysCpu->ReserveFloat();
+            hvar = ArraysCpu->ReserveFloat();
+            memcpy(mass, Massc, sizeof(float) * npsave);
+            memcpy(hvar, Hvarc, sizeof(float) * npsave);
+        }
     }
     // 收集额外的信息
     StInfoPartPlus infoplus;
@@ -916,32 +1773,520 @@ void JSphCpuSingle::SaveData() {
         infoplus.gpudata = false;
         TimerSim.Stop();
         infoplus.timesim = TimerSim.GetElapsedTimeD() / 1000.;
+        infoplus.forcestats = forcestats;
+        if (SleepSteps) {
+            infoplus.npfasleep = (SleepNpActive != UINT_MAX ? SleepNpAsleep : 0);
+            infoplus.nctasleep = CellDivSingle->GetNctAsleep();
+        }
+        if (InOut) {
+            infoplus.newnpok = InOut->GetNewNpOk();
+            infoplus.newnpfail = InOut->GetNewNpFail();
+        }
+        if (Splitting) {
+            infoplus.newnpok = Splitting->GetNewNpOk();
+            infoplus.newnpfail = Splitting->GetNewNpFail();
+        }
     }
     // 记录粒子值
     const tdouble3 vdom[2] = {
             OrderDecode(CellDivSingle->GetDomainLimits(true)),
             OrderDecode(CellDivSingle->GetDomainLimits(false))
     };
-    JSph::SaveData(npsave, idp, pos, vel, rhop, 1, vdom, &infoplus);
+    JSph::SaveData(npsave, idp, pos, vel, rhop, 1, vdom, &infoplus, mass, hvar);
+    if (svfilters)JSph::SaveFilterData(npsave, idp, pos, vel, rhop, code);
+    if (InOut)InOut->ResetNewNp();
+    if (Splitting)Splitting->ResetNewNp();
     // 释放用于粒子数据的内存
     ArraysCpu->Free(idp);
     ArraysCpu->Free(pos);
     ArraysCpu->Free(vel);
     ArraysCpu->Free(rhop);
+    ArraysCpu->Free(mass);
+    ArraysCpu->Free(hvar);
+    ArraysCpu->Free(code);
     TmcStop(Timers, TMC_SuSavePart);
 }
 
+/*
+ * @desc 计算相互作用阶段的统计: 每个流体粒子的候选邻居和实际邻居(r<2h)直方图, 流体单元占用率,
+ *       以及自上一个PART以来每个线程时间的不平衡度(max/mean), 然后重置线程时间
+ * @params fs 返回的统计结果
+ */
+void JSphCpuSingle::ComputeForceStats(StForceStats &fs) {
+    memset(&fs, 0, sizeof(StForceStats));
+    fs.active = true;
+    // 线程不平衡度
+    for (unsigned cf = 0; cf < 2; cf++) {
+        const double *tth = ForceThTimes + (cf ? MAXTHREADS_OMP : 0);
+        double tmax = 0, tsum = 0;
+        for (int th = 0; th < OmpThreads; th++) {
+            tsum += tth[th];
+            tmax = max(tmax, tth[th]);
+        }
+        const double tmean = tsum / OmpThreads;
+        (cf ? fs.thmeanbound : fs.thmeanfluid) = tmean;
+        (cf ? fs.imbbound : fs.imbfluid) = (tmean > 0 ? tmax / tmean : 0);
+    }
+    const tint4 nc = TInt4(int(CellDivSingle->GetNcells().x), int(CellDivSingle->GetNcells().y),
+                           int(CellDivSingle->GetNcells().z),
+                           int(CellDivSingle->GetNcells().x * CellDivSingle->GetNcells().y));
+    const unsigned nct = unsigned(nc.w * nc.z);
+    const unsigned cellfluid = nct + 1;
+    const unsigned cellfloat = cellfluid + nct;
+    const tint3 cellzero = TInt3(CellDivSingle->GetCellDomainMin().x, CellDivSingle->GetCellDomainMin().y,
+                                 CellDivSingle->GetCellDomainMin().z);
+    const int hdiv = (CellMode == CELLMODE_H ? 2 : 1);
+    const unsigned *begincell = CellDivSingle->GetBeginCell();
+    // 流体单元占用率 (浮体粒子存放在单独的单元中)
+    ullong nocc = 0;
+    for (unsigned c = 0; c < nct; c++) {
+        unsigned n = begincell[cellfluid + c + 1] - begincell[cellfluid + c];
+        if (WithFloating)n += begincell[cellfloat + c + 1] - begincell[cellfloat + c];
+        if (n) {
+            fs.cellsfluid++;
+            nocc += n;
+            fs.cellocmax = max(fs.cellocmax, n);
+        }
+    }
+    fs.cellsempty = (nct ? double(nct - fs.cellsfluid) / nct : 0);
+    fs.cellocmean = (fs.cellsfluid ? double(nocc) / fs.cellsfluid : 0);
+    // 每个粒子的候选邻居和实际邻居
+    const unsigned npf = Np - Npb;
+    unsigned *ncand = ArraysCpu->ReserveUint();
+    unsigned *nneigh = ArraysCpu->ReserveUint();
+    const llong pini = llong(Npb), pfin = llong(Np);
+#ifdef _WITHOMP
+#pragma omp parallel for schedule (guided)
+#endif
+    for (llong p1 = 0; p1 < pfin; p1++)if (p1 >= pini || unsigned(p1) < NpbOk) {
+        const tdouble3 posp1 = Posc[p1];
+        int cxini, cxfin, yini, yfin, zini, zfin;
+        GetInteractionCells(Dcellc[p1], hdiv, nc, cellzero, cxini, cxfin, yini, yfin, zini, zfin);
+        unsigned nc1 = 0, nn1 = 0;
+        // 流体粒子与流体和边界交互, 边界粒子只与流体交互
+        for (unsigned cb = (p1 >= pini ? 0 : 1); cb < (WithFloating ? 3u : 2u); cb++) {
+            const unsigned cellinitial = (!cb ? 0 : (cb == 1 ? cellfluid : cellfloat));
+            for (int z = zini; z < zfin; z++) {
+                const int zmod = nc.w * z + cellinitial;
+                for (int y = yini; y < yfin; y++) {
+                    const int ymod = zmod + nc.x * y;
+                    const unsigned p2ini = begincell[cxini + ymod];
+                    const unsigned p2fin = begincell[cxfin + ymod];
+                    nc1 += p2fin - p2ini;
+                    for (unsigned p2 = p2ini; p2 < p2fin; p2++) {
+                        const float drx = float(posp1.x - Posc[p2].x);
+                        const float dry = float(posp1.y - Posc[p2].y);
+                        const float drz = float(posp1.z - Posc[p2].z);
+                        const float rr2 = drx * drx + dry * dry + drz * drz;
+                        if (rr2 <= Fourh2 && rr2 >= ALMOSTZERO)nn1++;
+                    }
+                }
+            }
+        }
+        ncand[p1] = nc1;
+        nneigh[p1] = nn1;
+    }
+    // 直方图
+    unsigned cmax = 0;
+    ullong sumcand = 0, sumneigh = 0, sumbound = 0;
+    fs.neighmin = (npf ? UINT_MAX : 0);
+    for (unsigned p = Npb; p < Np; p++) {
+        cmax = max(cmax, ncand[p]);
+        sumcand += ncand[p];
+        sumneigh += nneigh[p];
+        fs.neighmin = min(fs.neighmin, nneigh[p]);
+        fs.neighmax = max(fs.neighmax, nneigh[p]);
+    }
+    for (unsigned p = 0; p < NpbOk; p++)sumbound += nneigh[p];
+    fs.histwidth = cmax / FORCESTATS_BINS + 1;
+    for (unsigned p = Npb; p < Np; p++) {
+        fs.histcand[ncand[p] / fs.histwidth]++;
+        fs.histneigh[nneigh[p] / fs.histwidth]++;
+    }
+    fs.candmean = (npf ? double(sumcand) / npf : 0);
+    fs.neighmean = (npf ? double(sumneigh) / npf : 0);
+    fs.neighmeanbound = (NpbOk ? double(sumbound) / NpbOk : 0);
+    ArraysCpu->Free(ncand);
+    ArraysCpu->Free(nneigh);
+    memset(ForceThTimes, 0, sizeof(double) * MAXTHREADS_OMP * 2);
+}
+
+/*
+ * @desc 生成过滤后的输出文件 (只保存选定的粒子), 用于没有调用 SaveData() 的步骤
+ */
+void JSphCpuSingle::SaveFilterData() {
+    const unsigned npsave = Np - NpbPer - NpfPer;
+    TmcStart(Timers, TMC_SuSavePart);
+    tpartid *idp = ArraysCpu->ReserveIdp();
+    tdouble3 *pos = ArraysCpu->ReserveDouble3();
+    tfloat3 *vel = ArraysCpu->ReserveFloat3();
+    float *rhop = ArraysCpu->ReserveFloat();
+    word *code = ArraysCpu->ReserveWord();
+    unsigned npnormal = GetParticlesData(Np, 0, true, PeriActive != 0, idp, pos, vel, rhop, code);
+    if (npnormal != npsave) RunException("SaveFilterData", "The number of particles is invalid.");
+    JSph::SaveFilterData(npsave, idp, pos, vel, rhop, code);
+    ArraysCpu->Free(idp);
+    ArraysCpu->Free(pos);
+    ArraysCpu->Free(vel);
+    ArraysCpu->Free(rhop);
+    ArraysCpu->Free(code);
+    TmcStop(Timers, TMC_SuSavePart);
+}
+
+/*
+ * @desc 生成checkpoint文件, 数据复制后在后台写入
+ */
+void JSphCpuSingle::SaveCheckpoint() {
+    TmcStart(Timers, TMC_SuSavePart);
+    while (CheckpointNext <= TimeStep)CheckpointNext += CheckpointTime;
+    // Nstep尚未递增, 保存恢复后下一步的值
+    JBinaryData *bd = CheckpointBi4->InitData(unsigned(Part), TimeStep, Nstep + 1);
+    SaveCheckpointState(bd);
+    SaveCheckpointParticles(bd);
+    CellDivSingle->SaveCheckpoint(bd->CreateItem("CellDiv"));
+    CheckpointBi4->SaveData();
+    Log->Printf("  Checkpoint %s (Part=%u)", JCheckpointBi4Save::GetFileName(CheckpointBi4->GetCount() - 1).c_str(),
+                unsigned(Part));
+    TmcStop(Timers, TMC_SuSavePart);
+}
+
+/*
+ * @desc 创建每步计时器输出, 初始化时间(VA-Init)不计入第一行; 从checkpoint重启时续写已有文件
+ */
+void JSphCpuSingle::ConfigTimersStep() {
+    vector<string> names;
+    double timers[TMC_COUNT];
+    for (unsigned c = 0; c < TMC_COUNT; c++) {
+        names.push_back(TmcGetName(CsTypeTimerCPU(c)));
+        timers[c] = TmcGetValueD(Timers, CsTypeTimerCPU(c));
+    }
+    TimersStep = new JTimersStep();
+    TimersStep->Config(DirOut, SvTimersStep, names, timers, (RestartFile.empty() ? -1 : Nstep));
+    Log->Printf("TimersStep: %s every %u steps", (DirOut + "TimersStep.csv").c_str(), SvTimersStep);
+}
+
+/*
+ * @desc 记录当前步的计时器和粒子数, 由后台线程写入TimersStep.csv
+ */
+void JSphCpuSingle::SaveTimersStep(double stepdt) {
+    JTimersStep::StStep st;
+    st.nstep = Nstep;
+    st.timestep = TimeStep;
+    st.dt = stepdt;
+    st.np = Np;
+    st.npb = Npb;
+    st.npbok = NpbOk;
+    st.nct = CellDivSingle->GetNct();
+    st.acemax = AceMax;
+    st.viscdtmax = ViscDtMax;
+    st.velmax = VelMax;
+    double timers[TMC_COUNT];
+    for (unsigned c = 0; c < TMC_COUNT; c++)timers[c] = TmcGetValueD(Timers, CsTypeTimerCPU(c));
+    TimersStep->AddStep(st, timers);
+}
+
+/*
+ * @desc 保存事件跟踪 Trace.json, 所有后台写入线程必须已经结束
+ */
+void JSphCpuSingle::SaveTrace() {
+    const string file = DirOut + "Trace.json";
+    const ullong nev = JTraceEvents::GetCount();
+    const bool lost = (nev > JTraceEvents::GetCapacity());
+    try {
+        JTraceEvents::SaveJson(file);
+    }
+    catch (const string &e) {
+        RunException("SaveTrace", e);
+    }
+    JTraceEvents::Free();
+    Log->Printf("Trace: %s (%llu events%s)", file.c_str(), nev,
+                (lost ? ", oldest events were overwritten" : ""));
+}
+
+/*
+ * @desc 显示每个数组的内存(当前, 最大, 总量最大时)并保存增长事件 MemoryEvents.csv
+ */
+void JSphCpuSingle::SaveMemRegistry() {
+    const string file = DirOut + "MemoryEvents.csv";
+    JMemRegistry::Print(Log);
+    try {
+        JMemRegistry::SaveCsv(file);
+    }
+    catch (const string &e) {
+        RunException("SaveMemRegistry", e);
+    }
+    JMemRegistry::Free();
+    Log->Printf("Memory events: %s", file.c_str());
+}
+
+/*
+ * @desc 在每个OpenMP线程中打开硬件计数器, 不可用时只显示原因
+ */
+void JSphCpuSingle::ConfigPerfCounters() {
+    PerfNpSteps = 0;
+    if (JPerfCounters::Config(OmpThreads)) {
+        string tx;
+        for (unsigned c = 0; c < JPerfCounters::CountersNum; c++) {
+            const JPerfCounters::TpCounter ct = JPerfCounters::TpCounter(c);
+            if (JPerfCounters::IsAvailable(ct))tx = tx + (tx.empty() ? "" : ", ") + JPerfCounters::GetCounterName(ct);
+        }
+        Log->Printf("PerfCounters: %s (%d threads)", tx.c_str(), JPerfCounters::GetNumThreads());
+    } else Log->Printf("PerfCounters: not available, %s", JPerfCounters::GetError().c_str());
+}
+
+/*
+ * @desc 显示每个计时器的IPC和每个粒子每步的缓存/TLB失效, 带宽由LLC失效估算(64字节/失效)
+ */
+void JSphCpuSingle::ShowPerfCounters() {
+    Log->Print("\n[CPU Performance counters]");
+    if (!JPerfCounters::Active) {
+        Log->Print(string("not available, ") + JPerfCounters::GetError());
+        return;
+    }
+    const bool cyc = JPerfCounters::IsAvailable(JPerfCounters::PCNT_Cycles);
+    const bool ins = JPerfCounters::IsAvailable(JPerfCounters::PCNT_Instructions);
+    const bool llc = JPerfCounters::IsAvailable(JPerfCounters::PCNT_LlcMisses);
+    const bool tlb = JPerfCounters::IsAvailable(JPerfCounters::PCNT_DtlbMisses);
+    const double nps = double(PerfNpSteps);
+    Log->Printf("User space counters of %d threads, values per particle and step (%.0f particle-steps)",
+                JPerfCounters::GetNumThreads(), nps);
+    Log->Printf("%-16s %10s %12s %8s %11s %11s %11s %9s", "Process", "Calls", "Gcycles", "IPC", "Instr/part",
+                "LLC/part", "dTLB/part", "LLC-GB/s");
+    for (unsigned c = 0; c < TMC_COUNT; c++)if (JPerfCounters::GetCalls(c)) {
+        const double vcyc = JPerfCounters::GetValue(c, JPerfCounters::PCNT_Cycles);
+        const double vins = JPerfCounters::GetValue(c, JPerfCounters::PCNT_Instructions);
+        const double vllc = JPerfCounters::GetValue(c, JPerfCounters::PCNT_LlcMisses);
+        const double vtlb = JPerfCounters::GetValue(c, JPerfCounters::PCNT_DtlbMisses);
+        const double t = TmcGetValueD(Timers, CsTypeTimerCPU(c)) / 1000.;
+        Log->Printf("%-16s %10llu %12s %8s %11s %11s %11s %9s", TmcGetName(CsTypeTimerCPU(c)), JPerfCounters::GetCalls(c),
+                    (cyc ? fun::PrintStr("%.4f", vcyc / 1e9).c_str() : "-"),
+                    (cyc && ins && vcyc > 0 ? fun::PrintStr("%.3f", vins / vcyc).c_str() : "-"),
+                    (ins && nps > 0 ? fun::PrintStr("%.1f", vins / nps).c_str() : "-"),
+                    (llc && nps > 0 ? fun::PrintStr("%.4f", vllc / nps).c_str() : "-"),
+                    (tlb && nps > 0 ? fun::PrintStr("%.4f", vtlb / nps).c_str() : "-"),
+                    (llc && t > 0 ? fun::PrintStr("%.3f", vllc * 64. / t / 1e9).c_str() : "-"));
+    }
+}
+
+/*
+ * @desc 测量内存带宽(triad)和浮点峰值, 作为roofline报告的上限
+ */
+void JSphCpuSingle::ConfigRoofline() {
+    delete Roofline;
+    Roofline = new JRoofline;
+    RoofNpSteps = RoofNpfSteps = RoofNpbOkSteps = 0;
+    Roofline->MeasurePeaks(OmpThreads, SvRoofline);
+    Log->Printf("Roofline: triad %.2f GB/s, float %.2f GFLOP/s (%d threads)", Roofline->GetPeakBw(),
+                Roofline->GetPeakFlops(), OmpThreads);
+}
+
+/*
+ * @desc 估算每个阶段的数据量和浮点运算量并显示roofline报告.
+ *       字节数为粒子数组的必要访问量, 浮点运算量由最后状态的平均邻居数估算.
+ */
+void JSphCpuSingle::ShowRoofline() {
+    const double tfor = TmcGetValueD(Timers, TMC_CfForces) / 1000.;
+    const double tsort = TmcGetValueD(Timers, TMC_NlSortData) / 1000.;
+    const double tstep = TmcGetValueD(Timers, TMC_SuComputeStep) / 1000.;
+    const double tperi = TmcGetValueD(Timers, TMC_SuPeriodic) / 1000.;
+    const bool sps = (TVisco == VISCO_LaminarSPS);
+    const bool delta = (TDeltaSph != DELTA_None);
+    const bool shift = (TShifting != SHIFT_None);
+    const double szpos = (Psimple ? sizeof(tfloat3) : sizeof(tdouble3));
+    const double sztau = sizeof(tsymatrix3f);
+    // 相互作用: 平均邻居数
+    StForceStats fs;
+    memset(&fs, 0, sizeof(StForceStats));
+    if (CellDivSingle && Np)ComputeForceStats(fs);
+    const double npf = double(RoofNpfSteps), npb = double(RoofNpbOkSteps), np = double(RoofNpSteps);
+    // 每个粒子读取pos,velrhop,press,code,dcell, 读写ar和ace
+    double bytesf = szpos + sizeof(tfloat4) + sizeof(float) + sizeof(word) + sizeof(unsigned) +
+                    2 * (sizeof(float) + sizeof(tfloat3));
+    if (delta)bytesf += 2 * sizeof(float);
+    if (sps)bytesf += sztau + 2 * sztau;
+    if (shift)bytesf += 2 * (sizeof(tfloat3) + sizeof(float));
+    const double bytesb = szpos + sizeof(tfloat4) + sizeof(word) + sizeof(unsigned) + 2 * sizeof(float);
+    // 每个fluid对的浮点运算: 核函数+压力+人工粘性约70, SPS约130; 每个候选距离测试约8
+    double flopsf = (sps ? 130 : 70);
+    if (delta)flopsf += 12;
+    if (shift)flopsf += 12;
+    const double pairsf = npf * fs.neighmean, candf = npf * fs.candmean, pairsb = npb * fs.neighmeanbound;
+    Roofline->AddPhase("Forces", tfor, npf * bytesf + npb * bytesb,
+                       pairsf * flopsf + max(candf - pairsf, 0.) * 8 + pairsb * 37);
+    // 排序: 读sortpart, 每个数组读写两次(排序和复制)
+    unsigned narrays = 5;
+    double szarrays = sizeof(unsigned) + sizeof(word) + sizeof(unsigned) + sizeof(tdouble3) + sizeof(tfloat4);
+    if (TStep == STEP_Verlet) {
+        narrays++;
+        szarrays += sizeof(tfloat4);
+    }
+    if (sps) {
+        narrays++;
+        szarrays += sztau;
+    }
+    Roofline->AddPhase("SortData", tsort, np * (sizeof(unsigned) * narrays + 4 * szarrays), 0);
+    // 积分: Symplectic的Pre+Corr, 与JSphCpuBench相同的估算
+    const double szshift = (shift ? sizeof(tfloat3) : 0);
+    const double bytespre = sizeof(tfloat4) * 2 + sizeof(float) + sizeof(tfloat3) + sizeof(tdouble3) * 2 +
+                            sizeof(unsigned) + szshift;
+    const double bytesstep = (TStep == STEP_Symplectic ? bytespre * 2 + sizeof(tfloat4) : bytespre + sizeof(tfloat4));
+    const double flopsstep = (TStep == STEP_Symplectic ? 50 : 25);
+    Roofline->AddPhase("ComputeStep", tstep, np * bytesstep, np * flopsstep);
+    if (PeriActive)Roofline->AddPhase("Periodic", tperi, np * (sizeof(tdouble3) + sizeof(word)), 0);
+    Roofline->Print(Log);
+    if (CpuParticlesSize)Log->Printf("Particle arrays: %.0f bytes/particle allocated (%u particles)",
+                                     double(MemCpuParticles) / CpuParticlesSize, CpuParticlesSize);
+}
+
+/*
+ * @desc 基准模式预热结束, 记录计时器初始值并开始测量
+ */
+void JSphCpuSingle::BenchBegin() {
+    for (unsigned c = 0; c < TMC_COUNT; c++)BenchTimers0[c] = TmcGetValueD(Timers, CsTypeTimerCPU(c));
+    BenchNpSteps = 0;
+    if (JPerfCounters::Active) {
+        JPerfCounters::Reset();
+        PerfNpSteps = 0;
+    }
+    TimerBench.Start();
+}
+
+/*
+ * @desc 保存基准模式结果 Bench.json: 每个计时器的时间, steps/s 和 particle-steps/s
+ */
+void JSphCpuSingle::SaveBench() {
+    const string file = DirOut + "Bench.json";
+    const unsigned nsteps = (BenchCount > BenchWarmup ? BenchCount - BenchWarmup : 0);
+    const double tbench = (nsteps ? TimerBench.GetElapsedTimeD() / 1000. : 0.);
+    const double npsteps = double(BenchNpSteps);
+    ofstream pf;
+    pf.open(file.c_str());
+    if (!pf)RunException("SaveBench", "File could not be opened.", file);
+    pf << "{\n";
+    pf << fun::PrintStr("  \"case\": \"%s\",\n", CaseName.c_str());
+    pf << fun::PrintStr("  \"runcode\": \"%s\",\n", RunCode.c_str());
+    pf << fun::PrintStr("  \"ompthreads\": %d,\n", OmpThreads);
+    pf << fun::PrintStr("  \"np\": %u,\n", CaseNp);
+    pf << fun::PrintStr("  \"npmean\": %.1f,\n", (nsteps ? npsteps / nsteps : 0.));
+    pf << fun::PrintStr("  \"warmup\": %u,\n", BenchWarmup);
+    pf << fun::PrintStr("  \"steps\": %u,\n", nsteps);
+    pf << fun::PrintStr("  \"time\": %.6f,\n", tbench);
+    pf << fun::PrintStr("  \"steps_s\": %.6g,\n", (tbench > 0 ? nsteps / tbench : 0.));
+    pf << fun::PrintStr("  \"particlesteps_s\": %.6g,\n", (tbench > 0 ? npsteps / tbench : 0.));
+    pf << "  \"timers\": {";
+    bool first = true;
+    for (unsigned c = 0; c < TMC_COUNT; c++)if (c != TMC_Init && TmcIsActive(Timers, CsTypeTimerCPU(c))) {
+        const double t = (TmcGetValueD(Timers, CsTypeTimerCPU(c)) - BenchTimers0[c]) / 1000.;
+        pf << (first ? "\n" : ",\n");
+        pf << fun::PrintStr("    \"%s\": {\"time\": %.6f, \"percent\": %.3f, \"steps_s\": %.6g, \"particlesteps_s\": %.6g}",
+                            TmcGetName(CsTypeTimerCPU(c)), t, (tbench > 0 ? t / tbench * 100. : 0.),
+                            (t > 0 ? nsteps / t : 0.), (t > 0 ? npsteps / t : 0.));
+        first = false;
+    }
+    pf << "\n  }\n}\n";
+    if (pf.fail())RunException("SaveBench", "Failed writing to file.", file);
+    pf.close();
+    Log->Printf("Bench: %u steps in %.3f s, %.3f steps/s, %.4e particle-steps/s (%s)", nsteps, tbench,
+                (tbench > 0 ? nsteps / tbench : 0.), (tbench > 0 ? npsteps / tbench : 0.), file.c_str());
+}
+
+/*
+ * @desc 原子地重写 Status.json (先写临时文件再重命名), 速率按上次写入以来的区间计算
+ */
+void JSphCpuSingle::SaveStatus(const char *state, double stepdt) {
+    const string file = DirOut + "Status.json";
+    const string filetmp = file + ".tmp";
+    TimerStatus.Stop();
+    if (string(state) == "running")TimerSim.Stop();  // 结束时TimerSim已停止
+    const double tint = TimerStatus.GetElapsedTimeD() / 1000.;
+    const double tsim = TimerSim.GetElapsedTimeD() / 1000.;
+    const unsigned nsteps = unsigned(Nstep) - StatusNstep;
+    const double npsteps = double(StatusNpSteps);
+    const double tleft = (TimeStep > TimeStepIni && TimeMax > TimeStep ?
+                          (tsim / (TimeStep - TimeStepIni)) * (TimeMax - TimeStep) : 0.);
+    ofstream pf;
+    pf.open(filetmp.c_str());
+    if (!pf)RunException("SaveStatus", "File could not be opened.", filetmp);
+    pf << "{\n";
+    pf << fun::PrintStr("  \"case\": \"%s\",\n", CaseName.c_str());
+    pf << fun::PrintStr("  \"runcode\": \"%s\",\n", RunCode.c_str());
+    pf << fun::PrintStr("  \"state\": \"%s\",\n", state);
+    pf << fun::PrintStr("  \"updated\": \"%s\",\n", fun::GetDateTime().c_str());
+    pf << fun::PrintStr("  \"updated_epoch\": %lld,\n", (long long)(time(NULL)));
+    pf << fun::PrintStr("  \"timestep\": %.9g,\n", TimeStep);
+    pf << fun::PrintStr("  \"timemax\": %.9g,\n", TimeMax);
+    pf << fun::PrintStr("  \"part\": %d,\n", Part);
+    pf << fun::PrintStr("  \"nstep\": %d,\n", Nstep);
+    pf << fun::PrintStr("  \"np\": %u,\n", Np);
+    pf << fun::PrintStr("  \"npout\": %u,\n", GetOutPosCount() + GetOutRhopCount() + GetOutMoveCount());
+    pf << fun::PrintStr("  \"memory_mb\": %.3f,\n", double(GetAllocMemoryCpu()) / (1024 * 1024));
+    pf << fun::PrintStr("  \"dt\": %.9g,\n", stepdt);
+    pf << fun::PrintStr("  \"elapsed\": %.3f,\n", tsim);
+    pf << fun::PrintStr("  \"eta\": %.3f,\n", tleft);
+    pf << fun::PrintStr("  \"finish\": \"%s\",\n", fun::GetDateTimeAfter(int(tleft)).c_str());
+    pf << fun::PrintStr("  \"interval\": %.3f,\n", tint);
+    pf << fun::PrintStr("  \"steps_s\": %.6g,\n", (tint > 0 ? nsteps / tint : 0.));
+    pf << fun::PrintStr("  \"particlesteps_s\": %.6g,\n", (tint > 0 ? npsteps / tint : 0.));
+    pf << "  \"timers\": {";
+    bool first = true;
+    for (unsigned c = 0; c < TMC_COUNT; c++)if (c != TMC_Init && TmcIsActive(Timers, CsTypeTimerCPU(c))) {
+        const double tc = TmcGetValueD(Timers, CsTypeTimerCPU(c));
+        const double t = (tc - StatusTimers0[c]) / 1000.;
+        StatusTimers0[c] = tc;
+        pf << (first ? "\n" : ",\n");
+        pf << fun::PrintStr("    \"%s\": {\"time\": %.6f, \"percent\": %.3f, \"steps_s\": %.6g, \"particlesteps_s\": %.6g}",
+                            TmcGetName(CsTypeTimerCPU(c)), t, (tint > 0 ? t / tint * 100. : 0.),
+                            (t > 0 ? nsteps / t : 0.), (t > 0 ? npsteps / t : 0.));
+        first = false;
+    }
+    pf << "\n  }\n}\n";
+    if (pf.fail())RunException("SaveStatus", "Failed writing to file.", filetmp);
+    pf.close();
+#ifdef WIN32
+    remove(file.c_str());
+#endif
+    if (rename(filetmp.c_str(), file.c_str()))RunException("SaveStatus", "File could not be renamed.", file);
+    StatusNstep = unsigned(Nstep);
+    StatusNpSteps = 0;
+    TimerStatus.Start();
+}
+
 /*
  * @desc 模拟计算完成, 打印总览信息
  */
 void JSphCpuSingle::FinishRun(bool stop) {
+    if (CheckpointBi4)CheckpointBi4->WaitSave();
+    if (TimersStep)TimersStep->SaveBuffer();
+    if (SvTrace)SaveTrace();
+    if (BenchSteps)SaveBench();
+    if (SvStatus)SaveStatus((stop ? "stopped" : "finished"), 0);
     float tsim = TimerSim.GetElapsedTimeF() / 1000.f, ttot = TimerTot.GetElapsedTimeF() / 1000.f;
     JSph::ShowResume(stop, tsim, ttot, true, "");
+    if (SleepSteps && SleepNpFluid)
+        Log->Printf("Sleeping particles: %.1f%% of the fluid forces were skipped.",
+                    100. * double(SleepNpSkipped) / double(SleepNpFluid));
+    if (InOut)
+        Log->Printf("Open boundaries: %llu particles were created and %llu were deleted.",
+                    InOut->GetTotalNew(), InOut->GetTotalDeleted());
+    if (Splitting) {
+        Log->Printf("Splitting: %llu particles were split and %llu pairs were merged.", Splitting->GetTotalSplit(),
+                    Splitting->GetTotalMerged());
+        const double massini = Splitting->GetMassIni(), massout = Splitting->GetMassOut();
+        const double massfin = SplitFluidMass(Npb, Np);
+        Log->Printf("Splitting: fluid mass %.9g at start and %.9g at end plus %.9g excluded (relative error: %g).",
+                    massini, massfin, massout, (massini ? (massfin + massout - massini) / massini : 0));
+    }
     string hinfo = ";RunMode", dinfo = string(";") + RunMode;
     if (SvTimers) {
         ShowTimers();
         GetTimersInfo(hinfo, dinfo);
     }
+    if (SvPerf) {
+        ShowPerfCounters();
+        JPerfCounters::Free();
+    }
+    if (Roofline)ShowRoofline();
+    if (SvMemory)SaveMemRegistry();
     Log->Print(" ");
     if (SvRes)SaveRes(tsim, ttot, hinfo, dinfo);
 }
@@ -5,9 +5,12 @@
 #include "Types.h"
 #include "JSphCpu.h"
 #include <string>
+#include <vector>
 
 class JCellDivCpuSingle;
 class JPartsLoad4;
+class JCheckpointBi4Load;
+class JRoofline;
 
 //##############################################################################
 //# JSphCpuSingle
@@ -19,29 +22,69 @@ class JSphCpuSingle : public JSphCpu
 protected:
   JCellDivCpuSingle* CellDivSingle;
   JPartsLoad4* PartsLoaded;
+  JCheckpointBi4Load* RestartData;  ///<Checkpoint used to restart the simulation.
+
+  //-Variables for benchmark mode.
+  unsigned BenchCount;              ///<Steps computed in benchmark mode (warm-up included).
+  ullong BenchNpSteps;              ///<Sum of Np of the measured steps.
+  double BenchTimers0[TMC_COUNT];   ///<Timer values at the start of the measurement (ms).
+  JTimer TimerBench;                ///<Wall time of the measured steps.
+  ullong PerfNpSteps;               ///<Sum of Np of the steps measured with performance counters.
+
+  //-Variables for the roofline report.
+  JRoofline *Roofline;
+  ullong RoofNpSteps;               ///<Sum of Np of the computed steps.
+  ullong RoofNpfSteps;              ///<Sum of fluid particles (Np-Npb) of the computed steps.
+  ullong RoofNpbOkSteps;            ///<Sum of NpbOk of the computed steps.
+
+  //-Variables for the status file.
+  JTimer TimerStatus;               ///<Wall time since the last status file.
+  unsigned StatusNstep;             ///<Nstep of the last status file.
+  ullong StatusNpSteps;             ///<Sum of Np of the steps since the last status file.
+  double StatusTimers0[TMC_COUNT];  ///<Timer values of the last status file (ms).
+
+  //-Variables to create the periodic particles during the interaction (-overlap).
+  bool PeriodicPending;             ///<The periodic particles of the next interaction are not created yet.
+  tuint3 HaloNcells;                ///<Number of cells of the structure of the periodic particles.
+  tuint3 HaloCellMin;               ///<First cell of the structure of the periodic particles.
+  std::vector<unsigned> HaloBeginCell; ///<First periodic particle of each cell (bound cells, ignored, fluid cells).
 
   llong GetAllocMemoryCpu() const;
   void UpdateMaxValues();
-  void LoadConfig(JCfgRun *cfg);
-  void LoadCaseParticles();
-  void ConfigDomain();
+  virtual void LoadConfig(JCfgRun *cfg);
+  virtual void LoadCaseParticles();
+  void ConfigMapLimits();
+  virtual void ConfigDomain();
+  void ConfigDomainRestart();
 
   void ResizeParticlesSize(unsigned newsize,float oversize,bool updatedivide);
-  unsigned PeriodicMakeList(unsigned n,unsigned pini,bool stable,unsigned nmax,tdouble3 perinc,const tdouble3 *pos,const word *code,unsigned *listp)const;
+  unsigned PeriodicMakeList(unsigned n,unsigned pini,bool stable,unsigned nmax,tdouble3 perinc,const tdouble3 *pos,const word *code,unsigned *listp,byte *listd)const;
   void PeriodicDuplicatePos(unsigned pnew,unsigned pcopy,bool inverse,double dx,double dy,double dz,tuint3 cellmax,tdouble3 *pos,unsigned *dcell)const;
-  void PeriodicDuplicateVerlet(unsigned n,unsigned pini,tuint3 cellmax,tdouble3 perinc,const unsigned *listp
-    ,unsigned *idp,word *code,unsigned *dcell,tdouble3 *pos,tfloat4 *velrhop,tsymatrix3f *spstau,tfloat4 *velrhopm1)const;
-  void PeriodicDuplicateSymplectic(unsigned n,unsigned pini,tuint3 cellmax,tdouble3 perinc,const unsigned *listp
-    ,unsigned *idp,word *code,unsigned *dcell,tdouble3 *pos,tfloat4 *velrhop,tsymatrix3f *spstau,tdouble3 *pospre,tfloat4 *velrhoppre)const;
-  void RunPeriodic();
+  void PeriodicDuplicateVerlet(unsigned n,unsigned pini,tuint3 cellmax,tdouble3 perinc,const unsigned *listp,const byte *listd
+    ,tpartid *idp,word *code,unsigned *dcell,tdouble3 *pos,tfloat4 *velrhop,tsymatrix3f *spstau,tfloat4 *velrhopm1)const;
+  void PeriodicDuplicateSymplectic(unsigned n,unsigned pini,tuint3 cellmax,tdouble3 perinc,const unsigned *listp,const byte *listd
+    ,tpartid *idp,word *code,unsigned *dcell,tdouble3 *pos,tfloat4 *velrhop,tsymatrix3f *spstau,tdouble3 *pospre,tfloat4 *velrhoppre)const;
+  bool RunPeriodic(bool resize=true);
+  void PrepareHaloCells(unsigned np0);
 
-  void RunCellDivide(bool updateperiodic);
+  virtual void RunCellDivide(bool updateperiodic);
 
   inline void GetInteractionCells(unsigned rcell
     ,int hdiv,const tint4 &nc,const tint3 &cellzero
     ,int &cxini,int &cxfin,int &yini,int &yfin,int &zini,int &zfin)const;
 
-  void Interaction_Forces(TpInter tinter);
+  void SleepPrepareCells();
+  void SleepUpdate(TpInter tinter);
+  void InOutInit();
+  void InOutForces();
+  void RunInOut();
+  void SplitInit();
+  double SplitFluidMass(unsigned pini,unsigned pfin)const;
+  unsigned GetCellPos(const tdouble3 &ps)const;
+  void RunSplitting();
+
+  bool Interaction_ForcesOverlap(TpInter tinter,float &viscdt);
+  virtual void Interaction_Forces(TpInter tinter);
   
   double ComputeAceMaxSeq(const bool checkcodenormal,unsigned np,const tfloat3* ace,const word* code)const;
   double ComputeAceMaxOmp(const bool checkcodenormal,unsigned np,const tfloat3* ace,const word* code)const;
@@ -55,10 +98,25 @@ protected:
   void RunFloating(double dt,bool predictor);
   
   void SaveData();
-  void FinishRun(bool stop);
+  void SaveCheckpoint();
+  void SaveFilterData();
+  void ComputeForceStats(StForceStats &fs);
+  void ConfigTimersStep();
+  void SaveTimersStep(double stepdt);
+  void SaveTrace();
+  void SaveMemRegistry();
+  void ConfigPerfCounters();
+  void ShowPerfCounters();
+  void ConfigRoofline();
+  void SaveStatus(const char *state,double stepdt);
+  void ShowRoofline();
+  void BenchBegin();
+  void SaveBench();
+  virtual bool CheckPartOutStop();
+  virtual void FinishRun(bool stop);
 
 public:
-  JSphCpuSingle();
+  JSphCpuSingle(bool withmpi=false);
   ~JSphCpuSingle();
   void Run(std::string appname,JCfgRun *cfg,JLog2 *log);
 
@@ -0,0 +1,63 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JSphFreeIds.cpp \brief Implements the class \ref JSphFreeIds.
+
+#include "JSphFreeIds.h"
+
+using namespace std;
+
+//##############################################################################
+//# JSphFreeIds
+//##############################################################################
+//==============================================================================
+/// Constructor.
+//==============================================================================
+JSphFreeIds::JSphFreeIds(){
+  ClassName="JSphFreeIds";
+  Reset();
+}
+
+//==============================================================================
+/// Destructor.
+//==============================================================================
+JSphFreeIds::~JSphFreeIds(){
+  Reset();
+}
+
+//==============================================================================
+/// Initialisation of variables.
+//==============================================================================
+void JSphFreeIds::Reset(){
+  ReuseIds=false;
+  FreeIds.clear();
+}
+
+//==============================================================================
+/// Devuelve un id para una nueva particula, reutilizando ids libres cuando
+/// ReuseIds esta activado.
+/// Returns an id for a new particle, reusing free ids when ReuseIds is enabled.
+//==============================================================================
+tpartid JSphFreeIds::NewId(tpartid &idmax){
+  if(!FreeIds.empty()){
+    const tpartid id=FreeIds.back();
+    FreeIds.pop_back();
+    return(id);
+  }
+  if(idmax>=PARTID_MAX-1)RunException("NewId","The maximum id of particles was reached.");
+  return(++idmax);
+}
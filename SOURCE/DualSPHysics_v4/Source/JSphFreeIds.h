@@ -0,0 +1,54 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JSphFreeIds.h \brief Declares the class \ref JSphFreeIds.
+
+#ifndef _JSphFreeIds_
+#define _JSphFreeIds_
+
+#include <vector>
+#include "JObject.h"
+#include "Types.h"
+
+//##############################################################################
+//# JSphFreeIds
+//##############################################################################
+/// \brief Provides the ids of the particles created during the simulation.
+/// New particles take IdMax+1 or, when ReuseIds is enabled, the id of a particle
+/// deleted before. Used by the open boundaries (JSphInOut) and the particle
+/// splitting (JSphSplitting).
+
+class JSphFreeIds : protected JObject
+{
+private:
+  bool ReuseIds;                  ///<Reutiliza ids de particulas eliminadas. Reuses ids of deleted particles.
+  std::vector<tpartid> FreeIds;   ///<Ids libres para reutilizar. Free ids to be reused.
+
+public:
+  JSphFreeIds();
+  ~JSphFreeIds();
+  void Reset();
+  llong GetAllocMemory()const{ return(llong(sizeof(tpartid))*FreeIds.capacity()); }
+
+  void SetReuseIds(bool reuseids){ ReuseIds=reuseids; }
+  bool GetReuseIds()const{ return(ReuseIds); }
+
+  tpartid NewId(tpartid &idmax);
+  void FreeId(tpartid id){ if(ReuseIds)FreeIds.push_back(id); }
+};
+
+#endif
@@ -25,6 +25,10 @@
 #include "JSph.h"
 #include <string>
 
+#ifdef PARTIDS_64BIT
+  #error The 64-bit particle ids (PARTIDS_64BIT) are only available in the CPU code.
+#endif
+
 class JPartsOut;
 class JArraysGpu;
 class JCellDivGpu;
@@ -594,6 +594,7 @@ void JSphGpuSingle::Run(std::string appname,JCfgRun *cfg,JLog2 *log){
   UpdateMaxValues();
   PrintAllocMemory(GetAllocMemoryCpu(),GetAllocMemoryGpu());
   SaveData(); 
+  if(CheckSaveFilters())SaveFilterData();
   TmgResetValues(Timers);
   TmgStop(Timers,TMG_Init);
   PartNstep=-1; Part++;
@@ -626,6 +627,7 @@ void JSphGpuSingle::Run(std::string appname,JCfgRun *cfg,JLog2 *log){
       TimePartNext=TimeOut->GetNextTime(TimeStep);
       TimerPart.Start();
     }
+    if(CheckSaveFilters())SaveFilterData();
     UpdateMaxValues();
     Nstep++;
     //if(Nstep>=2)break;
@@ -692,6 +694,21 @@ void JSphGpuSingle::SaveData(){
   TmgStop(Timers,TMG_SuSavePart);
 }
 
+//==============================================================================
+/// Genera los ficheros de salida de los filtros de particulas.
+/// Generates output files of the particle filters.
+//==============================================================================
+void JSphGpuSingle::SaveFilterData(){
+  const unsigned npsave=Np-NpbPer-NpfPer; //-Resta las periodicas si las hubiera. //-Subtracts periodic particles if any.
+  TmgStart(Timers,TMG_SuDownData);
+  unsigned npnormal=ParticlesDataDown(Np,0,false,true,PeriActive!=0);
+  if(npnormal!=npsave)RunException("SaveFilterData","The number of particles is invalid.");
+  TmgStop(Timers,TMG_SuDownData);
+  TmgStart(Timers,TMG_SuSavePart);
+  JSph::SaveFilterData(npsave,Idp,AuxPos,AuxVel,AuxRhop,Code);
+  TmgStop(Timers,TMG_SuSavePart);
+}
+
 //==============================================================================
 /// Muestra y graba resumen final de ejecucion.
 /// Displays and stores final summary of the execution.
@@ -63,6 +63,7 @@ protected:
   void RunFloating(double dt,bool predictor);
 
   void SaveData();
+  void SaveFilterData();
   void FinishRun(bool stop);
 
 public:
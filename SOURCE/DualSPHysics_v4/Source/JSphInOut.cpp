@@ -0,0 +1,174 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JSphInOut.cpp \brief Implements the class \ref JSphInOut.
+
+#include "JSphInOut.h"
+#include "JLog2.h"
+#include "JXml.h"
+#include "Functions.h"
+#include <cstring>
+#include <climits>
+#include <cmath>
+
+using namespace std;
+
+//##############################################################################
+//# JSphInOut
+//##############################################################################
+//==============================================================================
+/// Constructor.
+//==============================================================================
+JSphInOut::JSphInOut(JXml *sxml,const std::string &place,float rhopzero,float cteb,float gamma,tfloat3 gravity){
+  ClassName="JSphInOut";
+  Reset();
+  RhopZero=rhopzero; CteB=cteb; Gamma=gamma;
+  GravityZ=fabs(gravity.z);
+  LoadXml(sxml,place);
+}
+
+//==============================================================================
+/// Destructor.
+//==============================================================================
+JSphInOut::~JSphInOut(){
+  Reset();
+}
+
+//==============================================================================
+/// Initialisation of variables.
+//==============================================================================
+void JSphInOut::Reset(){
+  Zones.clear();
+  Ids.Reset();
+  RhopZero=CteB=Gamma=GravityZ=0;
+  NewNpOk=NewNpFail=0;
+  TotalNew=TotalDeleted=0;
+}
+
+//==============================================================================
+/// Loads configuration from the XML node.
+//==============================================================================
+void JSphInOut::LoadXml(JXml *sxml,const std::string &place){
+  TiXmlNode* node=sxml->GetNode(place,false);
+  if(!node)RunException("LoadXml",std::string("Cannot find the element \'")+place+"\'.");
+  ReadXml(sxml,node->ToElement());
+}
+
+//==============================================================================
+/// Reads list of zones in the XML node.
+//==============================================================================
+void JSphInOut::ReadXml(JXml *sxml,TiXmlElement* lis){
+  const char met[]="ReadXml";
+  Ids.SetReuseIds(sxml->GetAttributeBool(lis,"reuseids",true,false));
+  TiXmlElement* ele=lis->FirstChildElement("zone");
+  while(ele){
+    StInOutZone zo;
+    memset(&zo,0,sizeof(StInOutZone));
+    const string tx=fun::StrLower(sxml->GetAttributeStr(ele,"type"));
+    if(tx=="inlet")zo.type=INOUT_Inlet;
+    else if(tx=="outlet")zo.type=INOUT_Outlet;
+    else sxml->ErrReadAtrib(ele,"type",false);
+    zo.boxmin=sxml->ReadElementDouble3(ele,"pointmin");
+    zo.boxmax=sxml->ReadElementDouble3(ele,"pointmax");
+    if(!(zo.boxmin<zo.boxmax))sxml->ErrReadElement(ele,"pointmax",false);
+    const string dir=fun::StrLower(sxml->ReadElementStr(ele,"direction","value"));
+    if(dir.size()!=2 || (dir[0]!='+' && dir[0]!='-') || dir[1]<'x' || dir[1]>'z')sxml->ErrReadElement(ele,"direction",false);
+    zo.sign=(dir[0]=='+'? 1: -1);
+    zo.axis=unsigned(dir[1]-'x');
+    if(zo.type==INOUT_Inlet)zo.velocity=sxml->ReadElementFloat(ele,"velocity","value");
+    zo.usepress=(zo.type==INOUT_Inlet || sxml->ExistsElement(ele,"pressure"));
+    zo.press=sxml->ReadElementFloat(ele,"pressure","value",true,0);
+    TiXmlElement* elep=ele->FirstChildElement("pressure");
+    zo.hydrostatic=(elep && elep->Attribute("zsurf")!=NULL);
+    if(zo.hydrostatic)zo.zsurf=sxml->GetAttributeDouble(elep,"zsurf");
+    Zones.push_back(zo);
+    ele=ele->NextSiblingElement("zone");
+  }
+  if(Zones.empty())RunException(met,"There are no zones in the inout configuration.");
+  //-Comprueba que las zonas no se solapan.
+  //-Checks that the zones do not overlap.
+  for(unsigned c=0;c<GetCount();c++)for(unsigned c2=c+1;c2<GetCount();c2++){
+    const StInOutZone &z1=Zones[c],&z2=Zones[c2];
+    if(z1.boxmin.x<z2.boxmax.x && z2.boxmin.x<z1.boxmax.x && z1.boxmin.y<z2.boxmax.y && z2.boxmin.y<z1.boxmax.y && z1.boxmin.z<z2.boxmax.z && z2.boxmin.z<z1.boxmax.z)
+      RunException(met,fun::PrintStr("The inout zones %u and %u overlap.",c,c2));
+  }
+}
+
+//==============================================================================
+/// Shows object configuration using Log.
+//==============================================================================
+void JSphInOut::VisuConfig(JLog2 *log,std::string txhead,std::string txfoot)const{
+  if(!txhead.empty())log->Print(txhead);
+  for(unsigned c=0;c<GetCount();c++){
+    const StInOutZone &zo=Zones[c];
+    log->Printf("Zone_%u (%s)",c,(zo.type==INOUT_Inlet? "inlet": "outlet"));
+    log->Printf("  Box       : %s",fun::Double3gRangeStr(zo.boxmin,zo.boxmax).c_str());
+    log->Printf("  Direction : %c%c",(zo.sign>0? '+': '-'),char('x'+zo.axis));
+    if(zo.type==INOUT_Inlet)log->Printf("  Velocity  : %g",zo.velocity);
+    if(zo.usepress){
+      if(zo.hydrostatic)log->Printf("  Pressure  : %g (hydrostatic below z=%g)",zo.press,zo.zsurf);
+      else log->Printf("  Pressure  : %g",zo.press);
+    }
+  }
+  log->Printf("ReuseIds: %s",(Ids.GetReuseIds()? "True": "False"));
+  if(!txfoot.empty())log->Print(txfoot);
+}
+
+//==============================================================================
+/// Devuelve la zona que contiene la posicion (-1:ninguna).
+/// Returns the zone that contains the position (-1:none).
+//==============================================================================
+int JSphInOut::InZone(const tdouble3 &ps)const{
+  for(unsigned c=0;c<GetCount();c++)if(Inside(c,ps))return(int(c));
+  return(-1);
+}
+
+//==============================================================================
+/// Devuelve la velocidad impuesta en la zona (sin CellOrder).
+/// Returns the prescribed velocity of the zone (without CellOrder).
+//==============================================================================
+tfloat3 JSphInOut::GetVelocity(unsigned cz)const{
+  const StInOutZone &zo=Zones[cz];
+  const float v=zo.velocity*zo.sign;
+  return(TFloat3((zo.axis==0? v: 0),(zo.axis==1? v: 0),(zo.axis==2? v: 0)));
+}
+
+//==============================================================================
+/// Devuelve el desplazamiento de las nuevas particulas de la zona inlet, una
+/// longitud de la zona aguas arriba (sin CellOrder).
+/// Returns the displacement of the new particles of the inlet zone, one length
+/// of the zone upstream (without CellOrder).
+//==============================================================================
+tdouble3 JSphInOut::GetInletShift(unsigned cz)const{
+  const StInOutZone &zo=Zones[cz];
+  const tdouble3 size=zo.boxmax-zo.boxmin;
+  return(TDouble3((zo.axis==0? -size.x*zo.sign: 0),(zo.axis==1? -size.y*zo.sign: 0),(zo.axis==2? -size.z*zo.sign: 0)));
+}
+
+//==============================================================================
+/// Devuelve la densidad correspondiente a la presion impuesta en la cota z
+/// o rhopdef cuando la zona no impone presion.
+/// Returns the density of the prescribed pressure at level z or rhopdef when
+/// the zone does not prescribe the pressure.
+//==============================================================================
+float JSphInOut::GetRhop(unsigned cz,double z,float rhopdef)const{
+  const StInOutZone &zo=Zones[cz];
+  if(!zo.usepress)return(rhopdef);
+  double press=zo.press;
+  if(zo.hydrostatic && z<zo.zsurf)press+=double(RhopZero)*GravityZ*(zo.zsurf-z);
+  return(float(RhopZero*pow(press/CteB+1.,1./Gamma)));
+}
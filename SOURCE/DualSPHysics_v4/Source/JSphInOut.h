@@ -0,0 +1,133 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JSphInOut.h \brief Declares the class \ref JSphInOut.
+
+#ifndef _JSphInOut_
+#define _JSphInOut_
+
+#include <string>
+#include <vector>
+#include "JObject.h"
+#include "JSphFreeIds.h"
+#include "Types.h"
+
+class JXml;
+class TiXmlElement;
+class JLog2;
+
+//##############################################################################
+//# XML format.
+//##############################################################################
+//<special>
+//  <inout reuseids="1" comment="Reuses the ids of the deleted particles (def=0)">
+//    <zone type="inlet" comment="Type of zone: inlet or outlet">
+//      <pointmin x="0" y="0" z="0" comment="Limits of the buffer zone" />
+//      <pointmax x="0.08" y="1" z="0.5" />
+//      <direction value="+x" comment="Flow direction: +x, -x, +y, -y, +z or -z" />
+//      <velocity value="0.5" comment="Prescribed velocity along direction (only inlet)" />
+//      <pressure value="0" zsurf="0.5" comment="Prescribed pressure, hydrostatic below zsurf when it is given (def: inlet=0, outlet=computed)" />
+//    </zone>
+//    <zone type="outlet">
+//      <pointmin x="1.92" y="0" z="0" />
+//      <pointmax x="2" y="1" z="0.5" />
+//      <direction value="+x" />
+//    </zone>
+//  </inout>
+//</special>
+
+///Tipos de zona abierta. Types of open zone.
+typedef enum{ INOUT_Inlet=1,INOUT_Outlet=2 }TpInOutZone;
+
+///Configuracion de una zona abierta (sin CellOrder). Configuration of an open zone (without CellOrder).
+typedef struct{
+  TpInOutZone type;
+  tdouble3 boxmin,boxmax;  ///<Limites de la zona buffer. Limits of the buffer zone.
+  unsigned axis;           ///<Eje del flujo (0:x, 1:y, 2:z). Axis of the flow.
+  int sign;                ///<Sentido del flujo en el eje (+1 o -1). Sense of the flow along the axis.
+  float velocity;          ///<Velocidad impuesta (inlet). Prescribed velocity (inlet).
+  bool usepress;           ///<Presion impuesta. Prescribed pressure.
+  float press;             ///<Presion impuesta en la superficie. Prescribed pressure at the surface.
+  bool hydrostatic;        ///<Presion hidrostatica bajo zsurf. Hydrostatic pressure below zsurf.
+  double zsurf;            ///<Cota de la superficie libre. Level of the free surface.
+}StInOutZone;
+
+//##############################################################################
+//# JSphInOut
+//##############################################################################
+/// \brief Manages the open-boundary zones (inlets and outlets).
+/// Fluid particles inside a zone are buffer particles without computed forces.
+/// Inlet buffer particles move with the prescribed velocity and, when they cross
+/// the inner face, they become fluid particles and a new buffer particle is
+/// created one buffer length upstream. Outlet buffer particles are computed as
+/// fluid with the prescribed pressure (when it is given) and they are deleted
+/// when they leave through the outer face. Buffer particles that leave the zone
+/// through any other face become fluid particles again.
+
+class JSphInOut : protected JObject
+{
+private:
+  std::vector<StInOutZone> Zones;
+  JSphFreeIds Ids;                ///<Ids de las nuevas particulas. Ids of the new particles.
+
+  float RhopZero,CteB,Gamma,GravityZ;  ///<Constantes de la ecuacion de estado. Constants of the equation of state.
+
+  unsigned NewNpOk;     ///<Particulas creadas desde el ultimo PART. Particles created since the last PART.
+  unsigned NewNpFail;   ///<Particulas descartadas desde el ultimo PART. Discarded particles since the last PART.
+  ullong TotalNew;      ///<Total de particulas creadas. Total of created particles.
+  ullong TotalDeleted;  ///<Total de particulas eliminadas. Total of deleted particles.
+
+  void LoadXml(JXml *sxml,const std::string &place);
+  void ReadXml(JXml *sxml,TiXmlElement* lis);
+
+public:
+  JSphInOut(JXml *sxml,const std::string &place,float rhopzero,float cteb,float gamma,tfloat3 gravity);
+  ~JSphInOut();
+  void Reset();
+  llong GetAllocMemory()const{ return(Ids.GetAllocMemory()); }
+
+  void VisuConfig(JLog2 *log,std::string txhead,std::string txfoot)const;
+
+  unsigned GetCount()const{ return(unsigned(Zones.size())); }
+  const StInOutZone& GetZone(unsigned cz)const{ return(Zones[cz]); }
+  bool GetReuseIds()const{ return(Ids.GetReuseIds()); }
+
+  int InZone(const tdouble3 &ps)const;
+  bool Inside(unsigned cz,const tdouble3 &ps)const{
+    const StInOutZone &zo=Zones[cz];
+    return(zo.boxmin.x<=ps.x && ps.x<=zo.boxmax.x && zo.boxmin.y<=ps.y && ps.y<=zo.boxmax.y && zo.boxmin.z<=ps.z && ps.z<=zo.boxmax.z);
+  }
+  double GetCoord(unsigned cz,const tdouble3 &ps)const{ const StInOutZone &zo=Zones[cz]; return(zo.axis==0? ps.x*zo.sign: (zo.axis==1? ps.y*zo.sign: ps.z*zo.sign)); }
+  double GetCoordIn(unsigned cz)const{ return(GetCoord(cz,(Zones[cz].sign>0? Zones[cz].boxmin: Zones[cz].boxmax))); }
+  double GetCoordOut(unsigned cz)const{ return(GetCoord(cz,(Zones[cz].sign>0? Zones[cz].boxmax: Zones[cz].boxmin))); }
+  tfloat3 GetVelocity(unsigned cz)const;
+  tdouble3 GetInletShift(unsigned cz)const;
+  float GetRhop(unsigned cz,double z,float rhopdef)const;
+
+  tpartid NewId(tpartid &idmax){ return(Ids.NewId(idmax)); }
+  void FreeId(tpartid id){ Ids.FreeId(id); }
+
+  void AddNew(unsigned nok,unsigned nfail){ NewNpOk+=nok; NewNpFail+=nfail; TotalNew+=nok; }
+  void AddDeleted(unsigned n){ TotalDeleted+=n; }
+  unsigned GetNewNpOk()const{ return(NewNpOk); }
+  unsigned GetNewNpFail()const{ return(NewNpFail); }
+  void ResetNewNp(){ NewNpOk=NewNpFail=0; }
+  ullong GetTotalNew()const{ return(TotalNew); }
+  ullong GetTotalDeleted()const{ return(TotalDeleted); }
+};
+
+#endif
@@ -0,0 +1,165 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JSphSplitting.cpp \brief Implements the class \ref JSphSplitting.
+
+#include "JSphSplitting.h"
+#include "JLog2.h"
+#include "JXml.h"
+#include "Functions.h"
+#include <cstring>
+#include <climits>
+#include <cmath>
+
+using namespace std;
+
+//##############################################################################
+//# JSphSplitting
+//##############################################################################
+//==============================================================================
+/// Constructor.
+//==============================================================================
+JSphSplitting::JSphSplitting(JXml *sxml,const std::string &place){
+  ClassName="JSphSplitting";
+  Reset();
+  LoadXml(sxml,place);
+}
+
+//==============================================================================
+/// Destructor.
+//==============================================================================
+JSphSplitting::~JSphSplitting(){
+  Reset();
+}
+
+//==============================================================================
+/// Initialisation of variables.
+//==============================================================================
+void JSphSplitting::Reset(){
+  Levels=Steps=0;
+  Ids.Reset();
+  BoxMin.clear(); BoxMax.clear();
+  BoundDist=0;
+  FreeSurface=false;
+  DivRefine=DivMerge=0;
+  Simulate2D=false;
+  NumChildren=0;
+  Dp=H=0;
+  MassFluid=MassMin=HMin=0;
+  NewNpOk=NewNpFail=0;
+  TotalSplit=TotalMerged=0;
+  MassIni=MassOut=0;
+}
+
+//==============================================================================
+/// Loads configuration from the XML node.
+//==============================================================================
+void JSphSplitting::LoadXml(JXml *sxml,const std::string &place){
+  TiXmlNode* node=sxml->GetNode(place,false);
+  if(!node)RunException("LoadXml",std::string("Cannot find the element \'")+place+"\'.");
+  ReadXml(sxml,node->ToElement());
+}
+
+//==============================================================================
+/// Reads the configuration in the XML node.
+//==============================================================================
+void JSphSplitting::ReadXml(JXml *sxml,TiXmlElement* ele){
+  const char met[]="ReadXml";
+  Levels=sxml->GetAttributeUnsigned(ele,"levels",true,1);
+  Steps=sxml->GetAttributeUnsigned(ele,"steps",true,10);
+  Ids.SetReuseIds(sxml->GetAttributeBool(ele,"reuseids",true,false));
+  if(Levels<1 || Levels>4)sxml->ErrReadAtrib(ele,"levels",false);
+  if(!Steps)sxml->ErrReadAtrib(ele,"steps",false);
+  TiXmlElement* elebox=ele->FirstChildElement("box");
+  while(elebox){
+    const tdouble3 pmin=sxml->ReadElementDouble3(elebox,"pointmin");
+    const tdouble3 pmax=sxml->ReadElementDouble3(elebox,"pointmax");
+    if(!(pmin<pmax))sxml->ErrReadElement(elebox,"pointmax",false);
+    BoxMin.push_back(pmin); BoxMax.push_back(pmax);
+    elebox=elebox->NextSiblingElement("box");
+  }
+  BoundDist=sxml->ReadElementDouble(ele,"nearbound","distance",true,0);
+  if(BoundDist<0)sxml->ErrReadElement(ele,"nearbound",false);
+  DivRefine=0.5f; DivMerge=0.1f;
+  TiXmlElement* elefs=ele->FirstChildElement("freesurface");
+  if(elefs){
+    FreeSurface=sxml->GetAttributeBool(elefs,"value",true,true);
+    DivRefine=sxml->GetAttributeFloat(elefs,"divrefine",true,DivRefine);
+    DivMerge=sxml->GetAttributeFloat(elefs,"divmerge",true,DivMerge);
+    if(!(0<DivMerge && DivMerge<DivRefine))sxml->ErrReadElement(ele,"freesurface",false);
+  }
+  if(BoxMin.empty() && !BoundDist && !FreeSurface)RunException(met,"There are no refinement criteria in the splitting configuration.");
+}
+
+//==============================================================================
+/// Configures the constants of the resolution of the case.
+//==============================================================================
+void JSphSplitting::ConfigCtes(bool simulate2d,double dp,double h,float massfluid){
+  Simulate2D=simulate2d;
+  NumChildren=(Simulate2D? 4: 8);
+  Dp=dp; H=h; MassFluid=massfluid;
+  MassMin=float(MassFluid/pow(double(NumChildren),double(Levels)));
+  HMin=float(H/pow(2.,double(Levels)));
+}
+
+//==============================================================================
+/// Shows object configuration using Log.
+//==============================================================================
+void JSphSplitting::VisuConfig(JLog2 *log,std::string txhead,std::string txfoot)const{
+  if(!txhead.empty())log->Print(txhead);
+  log->Printf("Levels: %u  (dp min: %g  h min: %g)",Levels,Dp/pow(2.,double(Levels)),HMin);
+  log->Printf("Steps: %u",Steps);
+  for(unsigned c=0;c<unsigned(BoxMin.size());c++)log->Printf("Box_%u: %s",c,fun::Double3gRangeStr(BoxMin[c],BoxMax[c]).c_str());
+  if(BoundDist)log->Printf("NearBound: %g",BoundDist);
+  if(FreeSurface)log->Printf("FreeSurface: divrefine=%g divmerge=%g",DivRefine,DivMerge);
+  log->Printf("ReuseIds: %s",(Ids.GetReuseIds()? "True": "False"));
+  if(!txfoot.empty())log->Print(txfoot);
+}
+
+//==============================================================================
+/// Indica si la posicion esta en alguna caja de refinamiento ampliada con margin
+/// (sin CellOrder).
+/// Returns true when the position is inside a refinement box enlarged by margin
+/// (without CellOrder).
+//==============================================================================
+bool JSphSplitting::InBox(const tdouble3 &ps,double margin)const{
+  for(unsigned c=0;c<unsigned(BoxMin.size());c++){
+    const tdouble3 &b0=BoxMin[c],&b1=BoxMax[c];
+    if(b0.x-margin<=ps.x && ps.x<=b1.x+margin && b0.y-margin<=ps.y && ps.y<=b1.y+margin && b0.z-margin<=ps.z && ps.z<=b1.z+margin)return(true);
+  }
+  return(false);
+}
+
+//==============================================================================
+/// Devuelve la longitud de suavizado de una particula de fluido segun su masa.
+/// Returns the smoothing length of a fluid particle according to its mass.
+//==============================================================================
+float JSphSplitting::GetHvar(float mass)const{
+  return(float(H*pow(double(mass)/MassFluid,(Simulate2D? 1./2.: 1./3.))));
+}
+
+//==============================================================================
+/// Devuelve el desplazamiento de la hija c respecto a la particula dividida, en
+/// el centro de cada cuadrante u octante de la particula (sin CellOrder).
+/// Returns the displacement of the child c from the split particle, at the
+/// centre of each quadrant or octant of the particle (without CellOrder).
+//==============================================================================
+tdouble3 JSphSplitting::GetChildOffset(unsigned c,float mass)const{
+  const double a=Dp*pow(double(mass)/MassFluid,(Simulate2D? 1./2.: 1./3.))/4;
+  if(Simulate2D)return(TDouble3((c&1? a: -a),0,(c&2? a: -a)));
+  return(TDouble3((c&1? a: -a),(c&2? a: -a),(c&4? a: -a)));
+}
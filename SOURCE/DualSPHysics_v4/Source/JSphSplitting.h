@@ -0,0 +1,132 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JSphSplitting.h \brief Declares the class \ref JSphSplitting.
+
+#ifndef _JSphSplitting_
+#define _JSphSplitting_
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include "JObject.h"
+#include "JSphFreeIds.h"
+#include "Types.h"
+
+class JXml;
+class TiXmlElement;
+class JLog2;
+
+//##############################################################################
+//# XML format.
+//##############################################################################
+//<special>
+//  <splitting levels="1" steps="10" reuseids="1" comment="Levels of refinement (def=1), steps between checks (def=10) and reuse of ids (def=0)">
+//    <box comment="Region where the fluid is refined">
+//      <pointmin x="0.5" y="0" z="0" />
+//      <pointmax x="1" y="1" z="0.3" />
+//    </box>
+//    <nearbound distance="0.02" comment="Refines the fluid closer than distance to the boundary particles (def=0:disabled)" />
+//    <freesurface value="true" divrefine="0.5" divmerge="0.1" comment="Refines the fluid where the divergence of position is below dim-divrefine and coarsens it above dim-divmerge (def=false)" />
+//  </splitting>
+//</special>
+
+///Criterio de refinamiento de una particula de fluido. Refinement criterion of a fluid particle.
+typedef enum{ SPLIT_Keep=0,SPLIT_Refine=1,SPLIT_Coarse=2 }TpSplitFlag;
+
+//##############################################################################
+//# JSphSplitting
+//##############################################################################
+/// \brief Manages the adaptive refinement of the fluid (particle splitting and merging).
+/// A fluid particle in a refinement region is split into 4 (2D) or 8 (3D) children
+/// with half the spacing and smoothing length and 1/4 or 1/8 of the mass. Two
+/// near fine particles with the same mass outside the refinement regions are
+/// merged into one, up to the mass of the initial fluid particles. The
+/// smoothing length of each particle follows its mass, h=H*(mass/MassFluid)^(1/dim).
+
+class JSphSplitting : protected JObject
+{
+private:
+  unsigned Levels;                ///<Niveles de refinamiento. Levels of refinement (each level halves dp and h).
+  unsigned Steps;                 ///<Pasos entre comprobaciones. Steps between checks of the refinement.
+  JSphFreeIds Ids;                ///<Ids de las nuevas particulas. Ids of the new particles.
+
+  std::vector<tdouble3> BoxMin,BoxMax;  ///<Cajas de refinamiento (sin CellOrder). Refinement boxes (without CellOrder).
+  double BoundDist;    ///<Distancia de refinamiento junto al contorno (0:desactivado). Refinement distance to the boundary (0:disabled).
+  bool FreeSurface;    ///<Refina la superficie libre. Refines the free surface.
+  float DivRefine;     ///<Deficit de divergencia para refinar. Deficit of divergence to refine.
+  float DivMerge;      ///<Deficit de divergencia para unir. Deficit of divergence to merge.
+
+  bool Simulate2D;
+  unsigned NumChildren;  ///<Hijas de cada particula (4 en 2D, 8 en 3D). Children of each particle.
+  double Dp,H;
+  float MassFluid;
+  float MassMin;         ///<Masa del nivel mas fino. Mass of the finest level.
+  float HMin;            ///<Longitud de suavizado del nivel mas fino. Smoothing length of the finest level.
+
+  unsigned NewNpOk;     ///<Particulas creadas desde el ultimo PART. Particles created since the last PART.
+  unsigned NewNpFail;   ///<Divisiones descartadas desde el ultimo PART. Discarded splits since the last PART.
+  ullong TotalSplit;    ///<Total de particulas divididas. Total of split particles.
+  ullong TotalMerged;   ///<Total de parejas unidas. Total of merged pairs.
+  double MassIni;       ///<Masa total de fluido inicial. Initial total mass of fluid.
+  double MassOut;       ///<Masa de fluido excluida. Mass of excluded fluid.
+
+  void LoadXml(JXml *sxml,const std::string &place);
+  void ReadXml(JXml *sxml,TiXmlElement* ele);
+
+public:
+  JSphSplitting(JXml *sxml,const std::string &place);
+  ~JSphSplitting();
+  void Reset();
+  llong GetAllocMemory()const{ return(Ids.GetAllocMemory()); }
+
+  void ConfigCtes(bool simulate2d,double dp,double h,float massfluid);
+  void VisuConfig(JLog2 *log,std::string txhead,std::string txfoot)const;
+
+  unsigned GetSteps()const{ return(Steps); }
+  bool GetReuseIds()const{ return(Ids.GetReuseIds()); }
+  unsigned GetNumChildren()const{ return(NumChildren); }
+  float GetHMin()const{ return(HMin); }
+  double GetBoundDist()const{ return(BoundDist); }
+  bool GetFreeSurface()const{ return(FreeSurface); }
+  float GetDivRefine()const{ return(DivRefine); }
+  float GetDivMerge()const{ return(DivMerge); }
+
+  bool InBox(const tdouble3 &ps,double margin)const;
+  float GetHvar(float mass)const;
+  bool CanSplit(float mass)const{ return(mass>=MassMin*NumChildren*0.999f); }
+  bool CanMerge(float mass1,float mass2)const{ return(mass1+mass2<=MassFluid*1.001f && fabs(mass1-mass2)<=mass1*0.01f); }
+  tdouble3 GetChildOffset(unsigned c,float mass)const;
+
+  tpartid NewId(tpartid &idmax){ return(Ids.NewId(idmax)); }
+  void FreeId(tpartid id){ Ids.FreeId(id); }
+
+  void AddSplit(unsigned nsplit,unsigned nfail){ NewNpOk+=nsplit*(NumChildren-1); NewNpFail+=nfail; TotalSplit+=nsplit; }
+  void AddMerged(unsigned n){ TotalMerged+=n; }
+  unsigned GetNewNpOk()const{ return(NewNpOk); }
+  unsigned GetNewNpFail()const{ return(NewNpFail); }
+  void ResetNewNp(){ NewNpOk=NewNpFail=0; }
+  ullong GetTotalSplit()const{ return(TotalSplit); }
+  ullong GetTotalMerged()const{ return(TotalMerged); }
+
+  void SetMassIni(double mass){ MassIni=mass; }
+  void AddMassOut(double mass){ MassOut+=mass; }
+  double GetMassIni()const{ return(MassIni); }
+  double GetMassOut()const{ return(MassOut); }
+};
+
+#endif
@@ -29,12 +29,15 @@
 #endif
 
 #include "JTimer.h" //"JTimerClock.h"
+#include "JTraceEvents.h"
+#include "JPerfCounters.h"
 
 /// Structure with information of the timer and time value in CPU.
 typedef struct {
     JTimer timer; //JTimerClock timer;
     bool active;
     double time;
+    double tracets; ///<Start in microseconds of the trace event (JTraceEvents).
 } StSphTimerCpu;
 
 typedef enum {
@@ -51,9 +54,12 @@ typedef enum {
     TMC_SuMotion = 10,
     TMC_SuPeriodic = 11,
     TMC_SuResizeNp = 12,
-    TMC_SuSavePart = 13
+    TMC_SuSavePart = 13,
+    TMC_SuMpiExchange = 14,
+    TMC_SuInOut = 15,
+    TMC_SuSplitting = 16
 } CsTypeTimerCPU;
-#define TMC_COUNT 14
+#define TMC_COUNT 17
 
 typedef StSphTimerCpu TimersCpu[TMC_COUNT];
 
@@ -90,6 +96,12 @@ inline const char *TmcGetName(CsTypeTimerCPU ct) {
             return ("SU-ResizeNp");
         case TMC_SuSavePart:
             return ("SU-SavePart");
+        case TMC_SuMpiExchange:
+            return ("SU-MpiExchange");
+        case TMC_SuInOut:
+            return ("SU-InOut");
+        case TMC_SuSplitting:
+            return ("SU-Splitting");
     }
     return ("???");
 }
@@ -106,6 +118,7 @@ inline void TmcCreation(TimersCpu vtimer, bool active) {
         t->timer.Reset();
         t->active = active;
         t->time = 0;
+        t->tracets = 0;
     }
 }
 
@@ -117,7 +130,13 @@ inline void TmcDestruction(TimersCpu vtimer) { TmcCreation(vtimer, false); }
 //==============================================================================
 /// Marks start of timer.
 //==============================================================================
-inline void _TmcStart(TimersCpu vtimer, CsTypeTimerCPU ct) { if (vtimer[ct].active)vtimer[ct].timer.Start(); }
+inline void _TmcStart(TimersCpu vtimer, CsTypeTimerCPU ct) {
+    if (vtimer[ct].active) {
+        if (JTraceEvents::Active)vtimer[ct].tracets = JTraceEvents::Now();
+        if (JPerfCounters::Active)JPerfCounters::Start(unsigned(ct));
+        vtimer[ct].timer.Start();
+    }
+}
 
 //==============================================================================
 /// Marks end of timer and accumulates time.
@@ -127,6 +146,8 @@ inline void _TmcStop(TimersCpu vtimer, CsTypeTimerCPU ct) {
     if (t->active) {
         t->timer.Stop();
         t->time += t->timer.GetElapsedTimeD();
+        if (JPerfCounters::Active)JPerfCounters::Stop(unsigned(ct));
+        if (JTraceEvents::Active)JTraceEvents::AddEvent(TmcGetName(ct), t->tracets, JTraceEvents::Now() - t->tracets);
     }
 }
 
@@ -72,6 +72,16 @@ void JTimeOut::Config(std::string filexml,const std::string &place,double timeou
   else SpecialConfig=true;
 }
 
+//==============================================================================
+/// Configures object using the tout elements of an XML node.
+//==============================================================================
+void JTimeOut::Config(JXml *sxml,TiXmlElement* ele,double timeoutdef){
+  Reset();
+  ReadXml(sxml,ele);
+  if(!GetCount())Config(timeoutdef);
+  else SpecialConfig=true;
+}
+
 //==============================================================================
 /// Checks and adds new value of timeout. (returns true if it is wrong).
 //==============================================================================
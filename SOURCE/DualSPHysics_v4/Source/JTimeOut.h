@@ -71,6 +71,7 @@ public:
   void Reset();
   void Config(double timeoutdef);
   void Config(std::string filexml,const std::string &place,double timeoutdef);
+  void Config(JXml *sxml,TiXmlElement* ele,double timeoutdef);
   bool UseSpecialConfig()const{ return(SpecialConfig); }
   void VisuConfig(JLog2 *log,std::string txhead,std::string txfoot);
   double GetNextTime(double t);
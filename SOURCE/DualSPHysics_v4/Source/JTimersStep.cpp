@@ -0,0 +1,238 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JTimersStep.cpp \brief Implements the class \ref JTimersStep.
+
+#include "JTimersStep.h"
+#include "Functions.h"
+#include "JException.h"
+#include "JTraceEvents.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+using namespace std;
+
+//==============================================================================
+/// Constructor.
+//==============================================================================
+JTimersStep::JTimersStep(){
+  ClassName="JTimersStep";
+  Writer=NULL;
+  Reset();
+}
+
+//==============================================================================
+/// Destructor.
+//==============================================================================
+JTimersStep::~JTimersStep(){
+  //-Graba las filas pendientes cuando no se llamo a SaveBuffer() (p.ej. tras una excepcion).
+  //-Writes the pending rows when SaveBuffer() was not called (e.g. after an exception).
+  try{ if(!File.empty())SaveBuffer(); }
+  catch(...){}
+  Reset();
+}
+
+//==============================================================================
+/// Initialisation of variables.
+//==============================================================================
+void JTimersStep::Reset(){
+  if(Writer){ Writer->join(); delete Writer; Writer=NULL; }
+  WriterError=false; WriterErrorText="";
+  File="";
+  StepsRow=1;
+  TimerNames.clear();
+  TimersLast.clear();
+  StepsCount=0;
+  memset(&StepLast,0,sizeof(StStep));
+  TimersStep.clear();
+  Rows.clear(); RowsSteps.clear(); RowsTimers.clear();
+  SaveRows.clear(); SaveRowsSteps.clear(); SaveRowsTimers.clear();
+}
+
+//==============================================================================
+/// Devuelve la memoria reservada.
+/// Returns allocated memory.
+//==============================================================================
+llong JTimersStep::GetAllocMemory()const{
+  llong s=0;
+  s+=llong(sizeof(StStep))*(Rows.capacity()+SaveRows.capacity());
+  s+=llong(sizeof(unsigned))*(RowsSteps.capacity()+SaveRowsSteps.capacity());
+  s+=llong(sizeof(float))*(RowsTimers.capacity()+SaveRowsTimers.capacity());
+  return(s);
+}
+
+//==============================================================================
+/// Configura objeto y crea el fichero con la cabecera. Los valores iniciales
+/// de los timers (en ms) se descuentan de la primera fila.
+/// Configures object and creates the file with the header. The initial values
+/// of the timers (in ms) are subtracted from the first row.
+/// With restartnstep>=0 (restart from checkpoint) the rows of the existing file
+/// up to that step are kept and the new rows are appended.
+//==============================================================================
+void JTimersStep::Config(const std::string &dir,unsigned stepsrow,const std::vector<std::string> &timernames,const double *timers,int restartnstep){
+  const char met[]="Config";
+  Reset();
+  File=fun::GetDirWithSlash(dir)+"TimersStep.csv";
+  StepsRow=(stepsrow? stepsrow: 1);
+  TimerNames=timernames;
+  const unsigned nt=unsigned(TimerNames.size());
+  TimersLast.resize(nt);
+  TimersStep.resize(nt);
+  for(unsigned ct=0;ct<nt;ct++)TimersLast[ct]=TimersStep[ct]=timers[ct];
+  Rows.reserve(SizeRows); RowsSteps.reserve(SizeRows); RowsTimers.reserve(SizeRows*nt);
+  if(restartnstep>=0 && KeepRows(restartnstep))return;
+  ofstream pf;
+  pf.open(File.c_str());
+  if(pf){
+    pf << "Nstep;Steps;Time;Dt;Np;Npb;NpbOk;Nct;AceMax;ViscDtMax;VelMax";
+    for(unsigned ct=0;ct<nt;ct++)pf << ";" << TimerNames[ct] << " [s]";
+    pf << endl;
+    if(pf.fail())RunException(met,"Failed writing to file.",File);
+    pf.close();
+  }
+  else RunException(met,"File could not be opened.",File);
+}
+
+//==============================================================================
+/// Conserva las filas del fichero existente hasta el paso nstep. Devuelve false
+/// cuando el fichero no existe o su cabecera no coincide.
+/// Keeps the rows of the existing file up to step nstep. Returns false when
+/// the file does not exist or its header does not match.
+//==============================================================================
+bool JTimersStep::KeepRows(int nstep)const{
+  const char met[]="KeepRows";
+  string head="Nstep;Steps;Time;Dt;Np;Npb;NpbOk;Nct;AceMax;ViscDtMax;VelMax";
+  for(unsigned ct=0;ct<unsigned(TimerNames.size());ct++)head=head+";"+TimerNames[ct]+" [s]";
+  ifstream pfin;
+  pfin.open(File.c_str());
+  if(!pfin)return(false);
+  string line;
+  if(!getline(pfin,line) || line!=head)return(false);
+  //-Filas grabadas tras el checkpoint se descartan. Rows saved after the checkpoint are discarded.
+  string txt=line+"\n";
+  while(getline(pfin,line))if(!line.empty() && atoi(line.c_str())<=nstep)txt=txt+line+"\n";
+  pfin.close();
+  ofstream pf;
+  pf.open(File.c_str());
+  if(!pf)RunException(met,"File could not be opened.",File);
+  pf << txt;
+  if(pf.fail())RunException(met,"Failed writing to file.",File);
+  pf.close();
+  return(true);
+}
+
+//==============================================================================
+/// Anhade los valores de un paso. Cada StepsRow pasos se anhade una fila con el
+/// tiempo de cada timer (en ms) desde la fila anterior.
+/// Adds the values of one step. Every StepsRow steps a row is added with the
+/// time of each timer (in ms) since the previous row.
+//==============================================================================
+void JTimersStep::AddStep(const StStep &step,const double *timers){
+  StepsCount++;
+  if(StepsCount>=StepsRow)AddRow(step,timers);
+  else{
+    //-Guarda el ultimo paso para grabar la fila incompleta al final.
+    //-Stores the last step to write the incomplete row at the end.
+    StepLast=step;
+    for(unsigned ct=0;ct<unsigned(TimersStep.size());ct++)TimersStep[ct]=timers[ct];
+  }
+}
+
+//==============================================================================
+/// Anhade una fila con los pasos acumulados.
+/// Adds a row with the accumulated steps.
+//==============================================================================
+void JTimersStep::AddRow(const StStep &step,const double *timers){
+  const unsigned nt=unsigned(TimerNames.size());
+  Rows.push_back(step);
+  RowsSteps.push_back(StepsCount);
+  for(unsigned ct=0;ct<nt;ct++){
+    RowsTimers.push_back(float((timers[ct]-TimersLast[ct])/1000.));
+    TimersLast[ct]=timers[ct];
+  }
+  StepsCount=0;
+  if(Rows.size()>=SizeRows)SaveRowsBuffer();
+}
+
+//==============================================================================
+/// Graba filas del buffer (ejecutado en el hilo de grabacion).
+/// Writes the rows of the buffer (executed in the writer thread).
+//==============================================================================
+void JTimersStep::WriteRows(JTimersStep *obj){
+  JTraceEvents::SetThreadTrack("TimersStepWriter");
+  JTraceScope trace("WR-TimersStep");
+  try{
+    ofstream pf;
+    pf.open(obj->File.c_str(),ios::app);
+    if(!pf)throw string("File could not be opened.");
+    const unsigned nt=unsigned(obj->TimerNames.size());
+    const unsigned nr=unsigned(obj->SaveRows.size());
+    for(unsigned r=0;r<nr;r++){
+      const StStep &st=obj->SaveRows[r];
+      pf << fun::PrintStr("%d;%u;%.15g;%.15g;%u;%u;%u;%u;%.9g;%.9g;%.9g",st.nstep,obj->SaveRowsSteps[r],st.timestep,st.dt,st.np,st.npb,st.npbok,st.nct,st.acemax,st.viscdtmax,st.velmax);
+      const float *ts=&(obj->SaveRowsTimers[r*nt]);
+      for(unsigned ct=0;ct<nt;ct++)pf << fun::PrintStr(";%.6g",ts[ct]);
+      pf << "\n";
+    }
+    pf.flush();
+    if(pf.fail())throw string("Failed writing to file.");
+    pf.close();
+  }
+  catch(const string &e){
+    obj->WriterError=true; obj->WriterErrorText=e+" File: "+obj->File;
+  }
+}
+
+//==============================================================================
+/// Lanza la grabacion en segundo plano de las filas pendientes.
+/// Launches the background write of the pending rows.
+//==============================================================================
+void JTimersStep::SaveRowsBuffer(){
+  WaitSave();
+  SaveRows.swap(Rows);             Rows.clear();
+  SaveRowsSteps.swap(RowsSteps);   RowsSteps.clear();
+  SaveRowsTimers.swap(RowsTimers); RowsTimers.clear();
+  WriterError=false; WriterErrorText="";
+  Writer=new std::thread(WriteRows,this);
+}
+
+//==============================================================================
+/// Graba las filas pendientes (incluida la fila incompleta) y espera a que
+/// termine la grabacion.
+/// Writes the pending rows (including the incomplete row) and waits until the
+/// write finishes.
+//==============================================================================
+void JTimersStep::SaveBuffer(){
+  if(StepsCount)AddRow(StepLast,TimersStep.data());
+  if(!Rows.empty())SaveRowsBuffer();
+  WaitSave();
+}
+
+//==============================================================================
+/// Espera a que termine la grabacion pendiente y comprueba errores.
+/// Waits for the pending write and checks for errors.
+//==============================================================================
+void JTimersStep::WaitSave(){
+  if(Writer){
+    Writer->join();
+    delete Writer; Writer=NULL;
+    if(WriterError)RunException("WaitSave",string("Error writing timers file. ")+WriterErrorText);
+  }
+}
+
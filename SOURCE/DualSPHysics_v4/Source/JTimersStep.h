@@ -0,0 +1,106 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JTimersStep.h \brief Declares the class \ref JTimersStep.
+
+#ifndef _JTimersStep_
+#define _JTimersStep_
+
+#include "JObject.h"
+#include "TypesDef.h"
+#include <string>
+#include <vector>
+#include <thread>
+
+//##############################################################################
+//# File format.
+//##############################################################################
+// TimersStep.csv (one row every N steps)
+//   Nstep;Steps;Time;Dt;Np;Npb;NpbOk;Nct;AceMax;ViscDtMax;VelMax;<timer 1> [s];...
+// Steps is the number of steps accumulated in the row and the timer columns
+// are the time of each section during those steps. The other values are those
+// of the last step of the row.
+
+//##############################################################################
+//# JTimersStep
+//##############################################################################
+/// \brief Saves the time of each timer section and the main values of the
+/// step every N steps. The rows are stored in a buffer that is written to disk
+/// in a background thread, so the simulation only waits when the previous
+/// buffer is still being written.
+
+class JTimersStep : protected JObject
+{
+ public:
+  ///Structure with the values of one step.
+  typedef struct{
+    int nstep;          ///<Numero de paso. Number of step.
+    double timestep;    ///<Instante de simulacion tras el paso. Simulation instant after the step.
+    double dt;          ///<Dt del paso. Dt of the step.
+    unsigned np;        ///<Numero de particulas. Number of particles.
+    unsigned npb;       ///<Numero de particulas contorno. Number of boundary particles.
+    unsigned npbok;     ///<Numero de particulas contorno cerca del fluido. Number of boundary particles near fluid.
+    unsigned nct;       ///<Numero de celdas. Number of cells.
+    double acemax;      ///<Valor maximo de ace (limita dt1). Maximum value of ace (limits dt1).
+    double viscdtmax;   ///<Valor maximo de ViscDt (limita dt2). Maximum value of ViscDt (limits dt2).
+    double velmax;      ///<Valor maximo de vel (limita dt2). Maximum value of vel (limits dt2).
+  }StStep;
+
+ private:
+  static const unsigned SizeRows=1024;  ///<Numero de filas por buffer. Number of rows per buffer.
+
+  std::string File;        ///<Fichero de salida. Output file.
+  unsigned StepsRow;       ///<Numero de pasos por fila. Number of steps per row.
+  std::vector<std::string> TimerNames;
+  std::vector<double> TimersLast;  ///<Valor de los timers en la ultima fila (ms). Value of timers in the last row (ms).
+
+  unsigned StepsCount;     ///<Pasos acumulados para la siguiente fila. Steps accumulated for the next row.
+  StStep StepLast;         ///<Valores del ultimo paso anhadido. Values of the last added step.
+  std::vector<double> TimersStep;  ///<Valor de los timers en el ultimo paso (ms). Value of timers in the last step (ms).
+  std::vector<StStep> Rows;         ///<Filas pendientes de grabar. Rows pending to be saved.
+  std::vector<unsigned> RowsSteps;  ///<Pasos de cada fila. Steps of each row.
+  std::vector<float> RowsTimers;    ///<Tiempo de cada timer en cada fila (s). Time of each timer in each row (s).
+
+  std::vector<StStep> SaveRows;     ///<Filas en grabacion. Rows being written.
+  std::vector<unsigned> SaveRowsSteps;
+  std::vector<float> SaveRowsTimers;
+  std::thread *Writer;     ///<Hilo de grabacion. Writer thread.
+  bool WriterError;        ///<Indica error en la ultima grabacion. Indicates an error in the last write.
+  std::string WriterErrorText;
+
+  static void WriteRows(JTimersStep *obj);
+  void SaveRowsBuffer();
+  void AddRow(const StStep &step,const double *timers);
+  bool KeepRows(int nstep)const;
+
+ public:
+  JTimersStep();
+  ~JTimersStep();
+  void Reset();
+  llong GetAllocMemory()const;
+
+  void Config(const std::string &dir,unsigned stepsrow,const std::vector<std::string> &timernames,const double *timers,int restartnstep=-1);
+  unsigned GetStepsRow()const{ return(StepsRow); }
+
+  void AddStep(const StStep &step,const double *timers);
+  void SaveBuffer();
+  void WaitSave();
+};
+
+#endif
+
+
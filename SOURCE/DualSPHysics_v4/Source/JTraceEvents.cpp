@@ -0,0 +1,122 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JTraceEvents.cpp \brief Implements the class \ref JTraceEvents.
+
+#include "JTraceEvents.h"
+#include "Functions.h"
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+using namespace std;
+
+JTraceEvents::StEvent* JTraceEvents::Events=NULL;
+unsigned JTraceEvents::Capacity=0;
+std::atomic<ullong> JTraceEvents::Count(0);
+std::atomic<int> JTraceEvents::TrackCount(0);
+const char* JTraceEvents::TrackNames[JTraceEvents::MaxTracks];
+std::chrono::steady_clock::time_point JTraceEvents::TimeStart;
+bool JTraceEvents::Active=false;
+
+static std::mutex TrackMutex;
+
+//==============================================================================
+/// Reserva el buffer de eventos y activa el registro. El hilo que llama usa
+/// la pista 0.
+/// Allocates the buffer of events and activates the recording. The calling
+/// thread uses track 0.
+//==============================================================================
+void JTraceEvents::Config(unsigned capacity){
+  Free();
+  Capacity=(capacity? capacity: 1);
+  Events=new StEvent[Capacity];
+  Count=0;
+  TrackCount=0;
+  memset(TrackNames,0,sizeof(TrackNames));
+  TimeStart=std::chrono::steady_clock::now();
+  ThreadTrack()=NewTrack("Main");
+  Active=true;
+}
+
+//==============================================================================
+/// Desactiva el registro y libera el buffer. Los hilos que registran eventos
+/// deben haber terminado.
+/// Deactivates the recording and frees the buffer. The threads that record
+/// events must have finished.
+//==============================================================================
+void JTraceEvents::Free(){
+  Active=false;
+  delete[] Events; Events=NULL;
+  Capacity=0;
+  Count=0;
+}
+
+//==============================================================================
+/// Asigna una nueva pista con el nombre indicado (NULL: "Thread <n>").
+/// Assigns a new track with the given name (NULL: "Thread <n>").
+//==============================================================================
+int JTraceEvents::NewTrack(const char *name){
+  const int tid=TrackCount.fetch_add(1);
+  if(tid<int(MaxTracks))TrackNames[tid]=name;
+  return(tid);
+}
+
+//==============================================================================
+/// Asigna al hilo que llama la pista con el nombre indicado, compartida por
+/// todos los hilos que usan ese nombre (ej: hilos de grabacion consecutivos).
+/// Assigns to the calling thread the track with the given name, shared by all
+/// threads using that name (eg: consecutive writer threads).
+//==============================================================================
+void JTraceEvents::SetThreadTrack(const char *name){
+  if(!Active)return;
+  std::lock_guard<std::mutex> lock(TrackMutex);
+  const int nt=min(TrackCount.load(),int(MaxTracks));
+  int tid=-1;
+  for(int c=0;c<nt && tid<0;c++)if(TrackNames[c] && !strcmp(TrackNames[c],name))tid=c;
+  ThreadTrack()=(tid>=0? tid: NewTrack(name));
+}
+
+//==============================================================================
+/// Graba los eventos registrados en formato JSON de trace-event. Los hilos
+/// que registran eventos deben haber terminado.
+/// Saves the recorded events in trace-event JSON format. The threads that
+/// record events must have finished.
+//==============================================================================
+void JTraceEvents::SaveJson(const std::string &file){
+  ofstream pf;
+  pf.open(file.c_str());
+  if(!pf)throw string("JTraceEvents::SaveJson: File could not be opened. File: ")+file;
+  const ullong count=Count.load();
+  const ullong n=min(count,ullong(Capacity));
+  pf << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  const int nt=min(TrackCount.load(),int(MaxTracks));
+  for(int c=0;c<nt;c++){
+    const string name=(TrackNames[c]? string(TrackNames[c]): fun::PrintStr("Thread %d",c));
+    pf << fun::PrintStr("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"%s\"}},\n",c,name.c_str());
+    pf << fun::PrintStr("{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"sort_index\":%d}},\n",c,c);
+  }
+  for(ullong c=count-n;c<count;c++){
+    const StEvent &ev=Events[c%Capacity];
+    pf << fun::PrintStr("{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f},\n",ev.name,ev.tid,ev.ts,ev.dur);
+  }
+  pf << fun::PrintStr("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"DualSPHysics (%llu events, %llu lost)\"}}\n",n,count-n);
+  pf << "]}\n";
+  if(pf.fail())throw string("JTraceEvents::SaveJson: Failed writing to file. File: ")+file;
+  pf.close();
+}
+
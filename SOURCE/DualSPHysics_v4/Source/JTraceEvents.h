@@ -0,0 +1,104 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file JTraceEvents.h \brief Declares the classes \ref JTraceEvents and \ref JTraceScope.
+
+#ifndef _JTraceEvents_
+#define _JTraceEvents_
+
+#include "TypesDef.h"
+#include <string>
+#include <atomic>
+#include <chrono>
+
+//##############################################################################
+//# JTraceEvents
+//##############################################################################
+/// \brief Records timed events of every thread in a lock-free ring buffer and
+/// saves them in trace-event JSON format (chrome://tracing or Perfetto).
+/// The state is static so it can be used from the inline timer functions
+/// (TmcStart/TmcStop) and from any thread without passing an object.
+/// When the buffer is full the oldest events are overwritten.
+
+class JTraceEvents
+{
+ public:
+  ///Structure with a complete event (begin and duration).
+  typedef struct{
+    const char *name;  ///<Nombre del evento (cadena estatica). Name of event (static string).
+    double ts;         ///<Inicio en microsegundos. Begin in microseconds.
+    double dur;        ///<Duracion en microsegundos. Duration in microseconds.
+    int tid;           ///<Pista del hilo. Track of the thread.
+  }StEvent;
+
+  static const unsigned MaxTracks=256;  ///<Numero maximo de pistas con nombre. Maximum number of named tracks.
+
+ private:
+  static StEvent *Events;                ///<Buffer circular de eventos [Capacity]. Ring buffer of events [Capacity].
+  static unsigned Capacity;              ///<Tamanho del buffer. Size of the buffer.
+  static std::atomic<ullong> Count;      ///<Numero de eventos registrados. Number of recorded events.
+  static std::atomic<int> TrackCount;    ///<Numero de pistas asignadas. Number of assigned tracks.
+  static const char* TrackNames[MaxTracks];
+  static std::chrono::steady_clock::time_point TimeStart;
+
+  static int& ThreadTrack(){ static thread_local int tid=-1; return(tid); }
+  static int NewTrack(const char *name);
+
+ public:
+  static bool Active;  ///<Indica si se registran eventos. Indicates whether events are recorded.
+
+  static void Config(unsigned capacity);
+  static void Free();
+  static void SaveJson(const std::string &file);
+  static ullong GetCount(){ return(Count.load()); }
+  static unsigned GetCapacity(){ return(Capacity); }
+
+  static void SetThreadTrack(const char *name);
+
+  /// Returns the microseconds since Config().
+  static double Now(){ return(std::chrono::duration<double,std::micro>(std::chrono::steady_clock::now()-TimeStart).count()); }
+
+  /// Returns the track of the calling thread (assigned the first time).
+  static int GetThreadTrack(){ int &tid=ThreadTrack(); if(tid<0)tid=NewTrack(NULL); return(tid); }
+
+  /// Records a complete event. Lock-free: each event takes its own slot.
+  static void AddEvent(const char *name,double ts,double dur){
+    const ullong c=Count.fetch_add(1,std::memory_order_relaxed);
+    StEvent &ev=Events[c%Capacity];
+    ev.name=name; ev.ts=ts; ev.dur=dur; ev.tid=GetThreadTrack();
+  }
+};
+
+//##############################################################################
+//# JTraceScope
+//##############################################################################
+/// \brief Records an event with the lifetime of the object in the track of
+/// the calling thread. It does nothing when JTraceEvents is not active.
+
+class JTraceScope
+{
+ private:
+  const char *Name;
+  double Ts;
+ public:
+  JTraceScope(const char *name):Name(name),Ts(JTraceEvents::Active? JTraceEvents::Now(): 0){}
+  ~JTraceScope(){ if(JTraceEvents::Active)JTraceEvents::AddEvent(Name,Ts,JTraceEvents::Now()-Ts); }
+};
+
+#endif
+
+
@@ -27,9 +27,14 @@
 
 //#define DISABLE_TIMERS           //-Compilado sin timers. //-Compiles without timers
 
+//#define PARTIDS_64BIT            //-Compilado con ids de particula de 64 bits (solo CPU). //-Compiles with 64-bit particle ids (CPU only).
+
 #define CELLDIV_OVERMEMORYNP 0.05f  //-Memoria que se reserva de mas para la gestion de particulas en JCellDivGpu. //-Memory that is reserved for the particle management in JCellDivGpu.
 #define CELLDIV_OVERMEMORYCELLS 1   //-Numero celdas que se incrementa en cada dimension al reservar memoria para celdas en JCellDivGpu. //-Number of cells in each dimension is increased to allocate memory for JCellDivGpu cells.
 #define PERIODIC_OVERMEMORYNP 0.05f //-Mermoria que se reserva de mas para la creacion de particulas periodicas en JSphGpuSingle::RunPeriodic(). //-Memory reserved for the creation of periodic particles in JSphGpuSingle::RunPeriodic().
+#define INOUT_OVERMEMORYNP 0.10f    //-Memoria que se reserva de mas para las nuevas particulas de las zonas inlet en JSphCpuSingle::RunInOut(). //-Memory reserved for the new particles of the inlet zones in JSphCpuSingle::RunInOut().
+#define SPLIT_OVERMEMORYNP 0.10f    //-Memoria que se reserva de mas para las particulas hijas creadas en JSphCpuSingle::RunSplitting(). //-Memory reserved for the child particles created in JSphCpuSingle::RunSplitting().
+#define MPIHALO_OVERMEMORYNP 0.10f  //-Memoria que se reserva de mas para copias de halo y particulas migradas en JSphCpuMpi. //-Memory reserved for halo copies and migrated particles in JSphCpuMpi.
 
 #define _WITHOMP        ///<Enables/Disables OpenMP.               
 //-Activar/desactivar en Props config -> C/C++ -> Lenguaje -> OpenMp //-Enables/Disables in Props config-> C/C++ -> Language -> OpenMP
@@ -47,6 +52,22 @@
 
 #define ALMOSTZERO 1e-18f
 
+//-Tipo de los ids de particula. Con PARTIDS_64BIT se pueden superar 2^32 ids
+// (por ejemplo con inlet/outlet o splitting durante mucho tiempo).
+//-Type of the particle ids. With PARTIDS_64BIT more than 2^32 ids can be used
+// (for example with inlet/outlet or splitting during long runs).
+#ifdef PARTIDS_64BIT
+  typedef ullong tpartid;
+  #define PARTID_MAX 0xFFFFFFFFFFFFFFFFull
+#else
+  typedef unsigned tpartid;
+  #define PARTID_MAX 0xFFFFFFFFu
+#endif
+
+//-Numero maximo de particulas (los indices son de 32 bits y el ultimo valor se reserva).
+//-Maximum number of particles (the indices are 32-bit and the last value is reserved).
+#define PARTS_NPMAX 0xFFFFFFFEu
+
 
 //-Codigos para particulas:
 //-Code of the particles:
@@ -12,6 +12,10 @@
 #ifdef _WITHGPU
   #include "JSphGpuSingle.h"
 #endif
+#ifdef _WITHMPI
+  #include "JSphCpuMpi.h"
+  #include <mpi.h>
+#endif
 
 #pragma warning(disable : 4996) //Cancels sprintf() deprecated.
 
@@ -46,14 +50,22 @@ std::string getlicense_gpl(const std::string &name){
 
 int main(int argc, char** argv){
   int errcode=1;
+  #ifdef _WITHMPI
+    int mpirank=0,mpisize=1;
+    MPI_Init(&argc,&argv);
+    MPI_Comm_rank(MPI_COMM_WORLD,&mpirank);
+    MPI_Comm_size(MPI_COMM_WORLD,&mpisize);
+  #else
+    const int mpirank=0;
+  #endif
   std::string progname="DualSPHysics4";
   std::string proginfo;
   std::string license=getlicense_gpl(progname);
-  printf("%s",license.c_str());
+  if(!mpirank)printf("%s",license.c_str());
   char appname[256],appnamesub[256];
   sprintf(appname,"%s v4.0.056 (18-05-2016)%s",progname.c_str(),proginfo.c_str());
   for(unsigned c=0;c<=strlen(appname);c++)appnamesub[c]='='; appnamesub[strlen(appname)+1]='\0';
-  printf("\n%s\n%s\n",appname,appnamesub);
+  if(!mpirank)printf("\n%s\n%s\n",appname,appnamesub);
 
   JCfgRun cfg;
   JLog2 log;
@@ -61,7 +73,11 @@ int main(int argc, char** argv){
     cfg.LoadArgv(argc,argv);
     // cfg.VisuConfig();
     if(!cfg.PrintInfo){
-      log.Init(cfg.DirOut+"/Run.out");
+      #ifdef _WITHMPI
+        log.Init(cfg.DirOut+"/Run.out",true,mpirank,mpisize);
+      #else
+        log.Init(cfg.DirOut+"/Run.out");
+      #endif
       log.Print(license,JLog2::Out_File);
       log.Print(appname,JLog2::Out_File);
       log.Print(appnamesub,JLog2::Out_File);
@@ -71,7 +87,11 @@ int main(int argc, char** argv){
       #endif
       if(cfg.Cpu) {
         // 声明 SPH 类型
-        JSphCpuSingle sph;
+        #ifdef _WITHMPI
+          JSphCpuMpi sph;
+        #else
+          JSphCpuSingle sph;
+        #endif
         // 调用 CPU 计算
         sph.Run(appname,&cfg,&log);
       }
@@ -99,5 +119,10 @@ int main(int argc, char** argv){
   catch(...) {
     printf("\n*** Attention: Unknown exception...\n");
   }
+  #ifdef _WITHMPI
+    //-Un proceso con error no puede sincronizar con el resto. A failed process cannot synchronise with the others.
+    if(errcode && mpisize>1)MPI_Abort(MPI_COMM_WORLD,errcode);
+    MPI_Finalize();
+  #endif
   return(errcode);
 }
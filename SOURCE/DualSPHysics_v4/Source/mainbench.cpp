@@ -0,0 +1,282 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file mainbench.cpp \brief Main file of the CPU benchmark of DualSPHysics kernels.
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include "Functions.h"
+#include "JLog2.h"
+#include "JSphCpuBench.h"
+
+using namespace std;
+
+//==============================================================================
+/// Shows the available options.
+//==============================================================================
+void PrintHelp(){
+  printf("Usage: DualSPHysics4CPUBench [options]\n");
+  printf("  Runs the main CPU kernels in isolation on synthetic lattices of particles.\n\n");
+  printf("  Case:\n");
+  printf("    -np:<n>            Approximate number of fluid particles (def=20000)\n");
+  printf("    -dim:<2|3>         2D or 3D lattice (def=3)\n");
+  printf("    -fill:<f>          Fraction of the tank height filled with fluid (def=0.5)\n");
+  printf("    -dp:<dp>           Distance between particles (def=0.01)\n\n");
+  printf("  Template combinations (comma separated lists):\n");
+  printf("    -kernel:<list>     wendland,cubic (def=all)\n");
+  printf("    -visco:<list>      artificial,laminarsps (def=all)\n");
+  printf("    -deltasph:<list>   none,dynamic (def=all)\n");
+  printf("    -shifting:<list>   none,nobound,nofixed,full (def=none,full)\n");
+  printf("    -floating:<list>   none,sph,dem (def=all)\n");
+  printf("    -posdouble:<list>  0,1 (def=all)\n\n");
+  printf("  Execution:\n");
+  printf("    -tests:<list>      forces,divide,sort,step,periodic (def=all)\n");
+  printf("    -reps:<n>          Measured repetitions (def=10)\n");
+  printf("    -warmup:<n>        Repetitions before measuring (def=2)\n");
+  printf("    -ompthreads:<n>    Number of OpenMP threads (def=0, all cores)\n");
+  printf("    -dirout:<dir>      Directory for Bench.out and Bench.csv (def=.)\n\n");
+  printf("  ForcesFluid/ForcesBound run for every combination. SymplecticPre/Corr\n");
+  printf("  run for the first kernel, viscosity, DeltaSPH and posdouble of the lists.\n");
+  printf("  Divide and SortArray run for the first combination and RunPeriodic with\n");
+  printf("  periodic conditions in X and the first combination without floatings.\n\n");
+}
+
+//==============================================================================
+/// Splits a list of values separated by commas.
+//==============================================================================
+std::vector<std::string> SplitList(std::string tx){
+  std::vector<std::string> vlist;
+  while(!tx.empty()){
+    const string v=fun::StrLower(fun::StrSplit(",",tx));
+    if(!v.empty())vlist.push_back(v);
+  }
+  return(vlist);
+}
+
+//==============================================================================
+/// Throws an exception for an invalid option.
+//==============================================================================
+void ErrorOpt(const std::string &opt){
+  throw string("Invalid option or value: ")+opt;
+}
+
+//==============================================================================
+/// Prints one result on screen and log and writes it in the CSV file.
+//==============================================================================
+void SaveResult(JLog2 &log,std::ofstream &pf,const std::string &config,int threads,unsigned warmup
+  ,const JSphCpuBench::StBenchResult &r)
+{
+  const double sec=r.tmean/1000.;
+  const double thr=(sec>0? r.items/sec: 0);
+  const double gbs=(sec>0 && r.bytes>0? r.bytes/sec/1.e9: 0);
+  const double cv=(r.tmean>0? r.tstd/r.tmean*100.: 0);
+  const string name=JSphCpuBench::GetBenchName(r.test);
+  const string unit=JSphCpuBench::GetBenchUnit(r.test);
+  log.Print(fun::PrintStr("%-14s %-64s %9u %4u %10.3f %6.2f%% %10.3f %11.4e %-11s %7s",name.c_str(),config.c_str()
+    ,r.np,r.reps,r.tmean,cv,r.tmin,thr,unit.c_str(),(gbs? fun::PrintStr("%.2f",gbs).c_str(): "-")),JLog2::Out_ScrFile);
+  pf << fun::PrintStr("%s;%s;%u;%d;%u;%u;%f;%f;%f;%f;%.0f;%e;%s;%f",name.c_str(),config.c_str(),r.np,threads,r.reps,warmup
+    ,r.tmean,r.tstd,cv,r.tmin,r.items,thr,unit.c_str(),gbs) << endl;
+}
+
+int main(int argc, char** argv){
+  int errcode=1;
+  char appname[256];
+  sprintf(appname,"DualSPHysics4CPUBench v4.0.056 (18-05-2016)");
+  printf("\n%s\n\n",appname);
+
+  JLog2 log(JLog2::Out_File);
+  try{
+    //-Default configuration.
+    JSphCpuBench::StBenchCase bc;
+    bc.np=20000; bc.sim2d=false; bc.fill=0.5; bc.dp=0.01; bc.perix=false; bc.ftmode=FTMODE_None;
+    unsigned reps=10,warmup=2;
+    int ompthreads=0;
+    string dirout=".";
+    string lkernel="wendland,cubic",lvisco="artificial,laminarsps",ldelta="none,dynamic";
+    string lshift="none,full",lfloat="none,sph,dem",lposdouble="0,1",ltests="forces,divide,sort,step,periodic";
+    //-Loads options.
+    for(int c=1;c<argc;c++){
+      const string opt=argv[c];
+      if(opt.size()<2 || opt[0]!='-')ErrorOpt(opt);
+      const int pos=int(opt.find(":"));
+      const string txword=fun::StrLower(pos>0? opt.substr(1,pos-1): opt.substr(1));
+      const string txopt=(pos>0? opt.substr(pos+1): "");
+      if(txword=="h" || txword=="help" || txword=="?"){ PrintHelp(); return(0); }
+      if(txopt.empty())ErrorOpt(opt);
+      if(txword=="np")bc.np=fun::StrToUint(txopt);
+      else if(txword=="dim"){
+        if(txopt=="2")bc.sim2d=true;
+        else if(txopt=="3")bc.sim2d=false;
+        else ErrorOpt(opt);
+      }
+      else if(txword=="fill")bc.fill=fun::StrToDouble(txopt);
+      else if(txword=="dp")bc.dp=fun::StrToDouble(txopt);
+      else if(txword=="kernel")lkernel=txopt;
+      else if(txword=="visco")lvisco=txopt;
+      else if(txword=="deltasph")ldelta=txopt;
+      else if(txword=="shifting")lshift=txopt;
+      else if(txword=="floating")lfloat=txopt;
+      else if(txword=="posdouble")lposdouble=txopt;
+      else if(txword=="tests")ltests=txopt;
+      else if(txword=="reps")reps=fun::StrToUint(txopt);
+      else if(txword=="warmup")warmup=fun::StrToUint(txopt);
+      else if(txword=="ompthreads")ompthreads=fun::StrToInt(txopt);
+      else if(txword=="dirout")dirout=txopt;
+      else ErrorOpt(opt);
+    }
+    if(bc.np<100)ErrorOpt("-np (minimum 100)");
+    if(!reps)ErrorOpt("-reps (minimum 1)");
+
+    //-Loads lists of template parameters.
+    std::vector<TpKernel> kernels;
+    std::vector<TpVisco> viscos;
+    std::vector<TpDeltaSph> deltas;
+    std::vector<TpShifting> shifts;
+    std::vector<TpFtMode> ftmodes;
+    std::vector<bool> psimples;
+    bool tforces=false,tdivide=false,tsort=false,tstep=false,tperiodic=false;
+    std::vector<std::string> vl;
+    vl=SplitList(lkernel);
+    for(unsigned c=0;c<vl.size();c++){
+      if(vl[c]=="wendland")kernels.push_back(KERNEL_Wendland);
+      else if(vl[c]=="cubic")kernels.push_back(KERNEL_Cubic);
+      else ErrorOpt(string("-kernel:")+vl[c]);
+    }
+    vl=SplitList(lvisco);
+    for(unsigned c=0;c<vl.size();c++){
+      if(vl[c]=="artificial")viscos.push_back(VISCO_Artificial);
+      else if(vl[c]=="laminarsps")viscos.push_back(VISCO_LaminarSPS);
+      else ErrorOpt(string("-visco:")+vl[c]);
+    }
+    vl=SplitList(ldelta);
+    for(unsigned c=0;c<vl.size();c++){
+      if(vl[c]=="none")deltas.push_back(DELTA_None);
+      else if(vl[c]=="dynamic")deltas.push_back(DELTA_Dynamic);
+      else ErrorOpt(string("-deltasph:")+vl[c]);
+    }
+    vl=SplitList(lshift);
+    for(unsigned c=0;c<vl.size();c++){
+      if(vl[c]=="none")shifts.push_back(SHIFT_None);
+      else if(vl[c]=="nobound")shifts.push_back(SHIFT_NoBound);
+      else if(vl[c]=="nofixed")shifts.push_back(SHIFT_NoFixed);
+      else if(vl[c]=="full")shifts.push_back(SHIFT_Full);
+      else ErrorOpt(string("-shifting:")+vl[c]);
+    }
+    vl=SplitList(lfloat);
+    for(unsigned c=0;c<vl.size();c++){
+      if(vl[c]=="none")ftmodes.push_back(FTMODE_None);
+      else if(vl[c]=="sph")ftmodes.push_back(FTMODE_Sph);
+      else if(vl[c]=="dem")ftmodes.push_back(FTMODE_Dem);
+      else ErrorOpt(string("-floating:")+vl[c]);
+    }
+    vl=SplitList(lposdouble);
+    for(unsigned c=0;c<vl.size();c++){
+      if(vl[c]=="0")psimples.push_back(true);
+      else if(vl[c]=="1")psimples.push_back(false);
+      else ErrorOpt(string("-posdouble:")+vl[c]);
+    }
+    vl=SplitList(ltests);
+    for(unsigned c=0;c<vl.size();c++){
+      if(vl[c]=="all")tforces=tdivide=tsort=tstep=tperiodic=true;
+      else if(vl[c]=="forces")tforces=true;
+      else if(vl[c]=="divide")tdivide=true;
+      else if(vl[c]=="sort")tsort=true;
+      else if(vl[c]=="step")tstep=true;
+      else if(vl[c]=="periodic")tperiodic=true;
+      else ErrorOpt(string("-tests:")+vl[c]);
+    }
+    if(kernels.empty()||viscos.empty()||deltas.empty()||shifts.empty()||ftmodes.empty()||psimples.empty())
+      ErrorOpt("empty list of values");
+
+    //-Output files.
+    if(fun::Mkdir(dirout))throw string("Cannot create the output directory: ")+dirout;
+    log.Init(dirout+"/Bench.out");
+    log.Print(appname,JLog2::Out_File);
+    const string filecsv=dirout+"/Bench.csv";
+    ofstream pf;
+    pf.open(filecsv.c_str());
+    if(!pf)throw string("Cannot open the file: ")+filecsv;
+    pf << "Test;Config;Np;Threads;Reps;Warmup;TimeMean[ms];TimeStd[ms];TimeCV[%];TimeMin[ms];Items;Throughput;Unit;GBs" << endl;
+    log.Print(fun::PrintStr("%-14s %-64s %9s %4s %10s %7s %10s %11s %-11s %7s","Test","Config","Np","Reps"
+      ,"Mean[ms]","CV","Min[ms]","Throughput","Unit","GB/s"),JLog2::Out_ScrFile);
+
+    //-Runs the combinations.
+    int threads=0;
+    for(unsigned cft=0;cft<ftmodes.size();cft++)for(unsigned ck=0;ck<kernels.size();ck++)
+    for(unsigned cv=0;cv<viscos.size();cv++)for(unsigned cd=0;cd<deltas.size();cd++)
+    for(unsigned cs=0;cs<shifts.size();cs++)for(unsigned cp=0;cp<psimples.size();cp++){
+      const bool basestep=(!ck && !cv && !cd && !cp);
+      const bool basecase=(basestep && !cs && !cft);
+      if(!tforces && !(tstep && basestep) && !((tdivide||tsort) && basecase))continue;
+      bc.ftmode=ftmodes[cft];
+      JSphCpuBench::StBenchPhysics bph;
+      bph.tkernel=kernels[ck]; bph.tvisco=viscos[cv]; bph.tdelta=deltas[cd];
+      bph.tshifting=shifts[cs]; bph.psimple=psimples[cp];
+      const string config=JSphCpuBench::GetConfigStr(bc,bph);
+      log.Print(string("\n**Configuration: ")+config,JLog2::Out_File);
+      JSphCpuBench sph(&log,ompthreads,dirout);
+      sph.Config(bc,bph);
+      threads=sph.GetOmpThreads();
+      if(tforces){
+        SaveResult(log,pf,config,threads,warmup,sph.Measure(JSphCpuBench::BENCH_ForcesFluid,warmup,reps));
+        SaveResult(log,pf,config,threads,warmup,sph.Measure(JSphCpuBench::BENCH_ForcesBound,warmup,reps));
+      }
+      if(basecase && tdivide)SaveResult(log,pf,config,threads,warmup,sph.Measure(JSphCpuBench::BENCH_Divide,warmup,reps));
+      if(basecase && tsort)SaveResult(log,pf,config,threads,warmup,sph.Measure(JSphCpuBench::BENCH_SortArray,warmup,reps));
+      if(basestep && tstep){
+        SaveResult(log,pf,config,threads,warmup,sph.Measure(JSphCpuBench::BENCH_SymplecticPre,warmup,reps));
+        SaveResult(log,pf,config,threads,warmup,sph.Measure(JSphCpuBench::BENCH_SymplecticCorr,warmup,reps));
+      }
+    }
+    if(tperiodic){
+      JSphCpuBench::StBenchCase bcp=bc;
+      bcp.perix=true; bcp.ftmode=FTMODE_None;
+      JSphCpuBench::StBenchPhysics bph;
+      bph.tkernel=kernels[0]; bph.tvisco=viscos[0]; bph.tdelta=deltas[0];
+      bph.tshifting=shifts[0]; bph.psimple=psimples[0];
+      const string config=JSphCpuBench::GetConfigStr(bcp,bph);
+      log.Print(string("\n**Configuration: ")+config,JLog2::Out_File);
+      JSphCpuBench sph(&log,ompthreads,dirout);
+      sph.Config(bcp,bph);
+      threads=sph.GetOmpThreads();
+      SaveResult(log,pf,config,threads,warmup,sph.Measure(JSphCpuBench::BENCH_Periodic,warmup,reps));
+    }
+    pf.close();
+    log.Print(fun::PrintStr("\nThreads: %d  Warmup: %u  Reps: %u",threads,warmup,reps),JLog2::Out_ScrFile);
+    log.Print(string("Results saved in ")+filecsv,JLog2::Out_ScrFile);
+    errcode=0;
+  }
+  catch(const char *cad){
+    string tx=string("\n*** Exception: ")+cad+"\n";
+    if(log.IsOk())log.Print(tx,JLog2::Out_ScrFile); else printf("%s",tx.c_str());
+  }
+  catch(const string &e){
+    string tx=string("\n*** Exception: ")+e+"\n";
+    if(log.IsOk())log.Print(tx,JLog2::Out_ScrFile); else printf("%s",tx.c_str());
+  }
+  catch (const exception &e){
+    string tx=string("\n*** ")+e.what()+"\n";
+    if(log.IsOk())log.Print(tx,JLog2::Out_ScrFile); else printf("%s",tx.c_str());
+  }
+  catch(...) {
+    printf("\n*** Attention: Unknown exception...\n");
+  }
+  return(errcode);
+}
@@ -0,0 +1,231 @@
+/*
+ <DUALSPHYSICS>  Copyright (c) 2016, Dr Jose M. Dominguez et al. (see http://dual.sphysics.org/index.php/developers/).
+
+ EPHYSLAB Environmental Physics Laboratory, Universidade de Vigo, Ourense, Spain.
+ School of Mechanical, Aerospace and Civil Engineering, University of Manchester, Manchester, U.K.
+
+ This file is part of DualSPHysics.
+
+ DualSPHysics is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+
+ DualSPHysics is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License, along with DualSPHysics. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/// \file mainpartdiff.cpp \brief Main file of the tool that compares bitwise two series of PART files.
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <climits>
+#include "Functions.h"
+#include "JException.h"
+#include "JPartDataBi4.h"
+#include "JPartSeriesBi4.h"
+#include "JBinaryData.h"
+
+using namespace std;
+
+//==============================================================================
+/// Shows the available options.
+//==============================================================================
+void PrintHelp(){
+  printf("Usage: DualSPHysics4PartDiff <dir1> <dir2> [options]\n");
+  printf("  Compares bitwise the PARTs of two output directories. The PARTs can be\n");
+  printf("  stored in Part_XXXX.bi4 files, in the pieces of MPI runs (Part_pXX_XXXX.bi4,\n");
+  printf("  compared piece by piece) or in PartSeries_XXXX.bi4s files.\n");
+  printf("  The values TimeStep, Step, Npok and Nout and all the arrays of each PART\n");
+  printf("  must be identical, RunCode, Date and RunTime are ignored.\n\n");
+  printf("  Options:\n");
+  printf("    -first:<n>   First PART to compare (def=0)\n");
+  printf("    -last:<n>    Last PART to compare (def=last PART of both directories)\n");
+  printf("    -quiet       Only shows the PARTs with differences and the summary\n\n");
+  printf("  Exit code: 0 identical, 1 differences found, 2 error.\n\n");
+}
+
+//==============================================================================
+/// Compara dos valores bit a bit. Compares bitwise two values.
+//==============================================================================
+template<class T> bool SameBits(T v1,T v2){ return(!memcmp(&v1,&v2,sizeof(T))); }
+
+//==============================================================================
+/// Devuelve el numero de componentes reales de un tipo (0: no real).
+/// Returns the number of real components of a type (0: not real).
+//==============================================================================
+unsigned RealComponents(JBinaryDataDef::TpData type,bool &isdouble){
+  isdouble=(type==JBinaryDataDef::DatDouble || type==JBinaryDataDef::DatDouble3);
+  switch(type){
+    case JBinaryDataDef::DatFloat:  case JBinaryDataDef::DatDouble:   return(1);
+    case JBinaryDataDef::DatFloat3: case JBinaryDataDef::DatDouble3:  return(3);
+    default: break;
+  }
+  return(0);
+}
+
+//==============================================================================
+/// Compara un array de dos PARTs. Devuelve el numero de elementos diferentes
+/// y la diferencia maxima de los arrays reales.
+/// Compares one array of two PARTs. Returns the number of different elements
+/// and the maximum difference of the real arrays.
+//==============================================================================
+unsigned CompareArray(JBinaryDataArray *ar1,JBinaryDataArray *ar2,unsigned &first,double &maxdif,string &error){
+  first=UINT_MAX; maxdif=0; error="";
+  if(ar1->GetType()!=ar2->GetType()){ error="different type"; return(1); }
+  const size_t stype=JBinaryDataDef::SizeOfType(ar1->GetType());
+  if(!stype){ error="type not comparable"; return(0); }
+  const unsigned n1=(ar1->DataInPointer()? ar1->GetCount(): ar1->GetFileDataCount());
+  const unsigned n2=(ar2->DataInPointer()? ar2->GetCount(): ar2->GetFileDataCount());
+  if(n1!=n2){ error=fun::PrintStr("different size (%u and %u)",n1,n2); return(max(n1,n2)); }
+  vector<char> d1(stype*n1+1),d2(stype*n2+1);
+  ar1->GetDataCopy(n1,&d1[0]);
+  ar2->GetDataCopy(n2,&d2[0]);
+  bool isdouble;
+  const unsigned ncomp=RealComponents(ar1->GetType(),isdouble);
+  unsigned ndif=0;
+  for(unsigned p=0;p<n1;p++)if(memcmp(&d1[stype*p],&d2[stype*p],stype)){
+    if(!ndif)first=p;
+    ndif++;
+    for(unsigned c=0;c<ncomp;c++){
+      const double v1=(isdouble? ((const double*)&d1[stype*p])[c]: ((const float*)&d1[stype*p])[c]);
+      const double v2=(isdouble? ((const double*)&d2[stype*p])[c]: ((const float*)&d2[stype*p])[c]);
+      maxdif=max(maxdif,fabs(v1-v2));
+    }
+  }
+  return(ndif);
+}
+
+//==============================================================================
+/// Devuelve el numero de piezas del PART (0:no existe).
+/// Returns the number of pieces of the PART (0:missing).
+//==============================================================================
+unsigned PartPieces(const string &dir,const JPartSeriesBi4Load *series,unsigned cpart){
+  if(series)return(series->PartExists(cpart)? 1: 0);
+  if(fun::FileExists(dir+JPartDataBi4::GetFileNamePart(cpart)))return(1);
+  const string file=dir+JPartDataBi4::GetFileNamePart(cpart,0,2);
+  if(!fun::FileExists(file))return(0);
+  JBinaryData dat("JPartDataBi4");
+  dat.OpenFileStructure(file,"JPartDataBi4");
+  return(dat.GetvUint("Npiece"));
+}
+
+//==============================================================================
+/// Carga una pieza de un PART del fichero de series o de su fichero.
+/// Loads one piece of a PART from the series file or from its file.
+//==============================================================================
+void LoadPart(JPartDataBi4 &pd,const string &dir,const JPartSeriesBi4Load *series,unsigned cpart,unsigned piece,unsigned npiece){
+  if(series)pd.LoadFileSeries(series,cpart);
+  else pd.LoadFilePart(dir,cpart,piece,npiece);
+}
+
+//==============================================================================
+/// Compara una pieza de un PART de los dos directorios y devuelve true si son
+/// identicas.
+/// Compares one piece of a PART of both directories and returns true when
+/// identical.
+//==============================================================================
+bool ComparePart(const string &dir1,const string &dir2,const JPartSeriesBi4Load *series1,const JPartSeriesBi4Load *series2,unsigned cpart,unsigned piece,unsigned npiece,bool quiet){
+  JPartDataBi4 pd1,pd2;
+  LoadPart(pd1,dir1,series1,cpart,piece,npiece);
+  LoadPart(pd2,dir2,series2,cpart,piece,npiece);
+  const string name=fun::GetWithoutExtension(JPartDataBi4::GetFileNamePart(cpart,piece,npiece));
+  vector<string> difs;
+  if(!SameBits(pd1.Get_TimeStep(),pd2.Get_TimeStep()))difs.push_back(fun::PrintStr("TimeStep: %.15g / %.15g",pd1.Get_TimeStep(),pd2.Get_TimeStep()));
+  if(pd1.Get_Step()!=pd2.Get_Step())difs.push_back(fun::PrintStr("Step: %u / %u",pd1.Get_Step(),pd2.Get_Step()));
+  if(pd1.Get_Npok()!=pd2.Get_Npok())difs.push_back(fun::PrintStr("Npok: %u / %u",pd1.Get_Npok(),pd2.Get_Npok()));
+  if(pd1.Get_Nout()!=pd2.Get_Nout())difs.push_back(fun::PrintStr("Nout: %u / %u",pd1.Get_Nout(),pd2.Get_Nout()));
+  JBinaryData *part1=pd1.GetPart(),*part2=pd2.GetPart();
+  const unsigned na=part1->GetArraysCount();
+  unsigned ncomp=0;
+  for(unsigned c=0;c<na;c++){
+    JBinaryDataArray *ar1=part1->GetArray(c);
+    JBinaryDataArray *ar2=part2->GetArray(ar1->GetName());
+    if(!ar2){ difs.push_back(ar1->GetName()+": missing in "+dir2); continue; }
+    unsigned first; double maxdif; string error;
+    const unsigned ndif=CompareArray(ar1,ar2,first,maxdif,error);
+    if(error.empty())ncomp++;
+    if(!error.empty() && ndif)difs.push_back(ar1->GetName()+": "+error);
+    else if(ndif){
+      bool isdouble;
+      const string txdif=(RealComponents(ar1->GetType(),isdouble)? fun::PrintStr(", maximum difference %g",maxdif): string(""));
+      difs.push_back(fun::PrintStr("%s: %u different elements, first %u",ar1->GetName().c_str(),ndif,first)+txdif);
+    }
+  }
+  for(unsigned c=0;c<part2->GetArraysCount();c++){
+    const string name=part2->GetArray(c)->GetName();
+    if(!part1->GetArray(name))difs.push_back(name+": missing in "+dir1);
+  }
+  if(!difs.empty()){
+    printf("%s: DIFFERENT\n",name.c_str());
+    for(unsigned c=0;c<unsigned(difs.size());c++)printf("  %s\n",difs[c].c_str());
+  }
+  else if(!quiet)printf("%s: identical (TimeStep=%g, Npok=%u, %u arrays)\n",name.c_str(),pd1.Get_TimeStep(),pd1.Get_Npok(),ncomp);
+  return(difs.empty());
+}
+
+//==============================================================================
+/// Main function.
+//==============================================================================
+int main(int argc,char** argv){
+  vector<string> dirs;
+  unsigned first=0,last=UINT_MAX;
+  bool quiet=false;
+  for(int c=1;c<argc;c++){
+    const string opt=argv[c];
+    if(opt=="-h" || opt=="-help" || opt=="--help"){ PrintHelp(); return(0); }
+    else if(opt.substr(0,7)=="-first:")first=unsigned(atoi(opt.substr(7).c_str()));
+    else if(opt.substr(0,6)=="-last:")last=unsigned(atoi(opt.substr(6).c_str()));
+    else if(opt=="-quiet")quiet=true;
+    else if(opt[0]!='-')dirs.push_back(fun::GetDirWithSlash(opt));
+    else{ printf("Option %s is invalid.\n",opt.c_str()); return(2); }
+  }
+  if(dirs.size()!=2){ PrintHelp(); return(2); }
+  unsigned nparts=0,ndif=0;
+  JPartSeriesBi4Load *series[2]={NULL,NULL};
+  try{
+    //-Directorios con ficheros de series. Directories with series files.
+    for(unsigned c=0;c<2;c++)if(JPartSeriesBi4Load::Exists(dirs[c])){
+      series[c]=new JPartSeriesBi4Load();
+      series[c]->Config(dirs[c]);
+    }
+    for(unsigned cpart=first;cpart<=last;cpart++){
+      const unsigned np1=PartPieces(dirs[0],series[0],cpart);
+      const unsigned np2=PartPieces(dirs[1],series[1],cpart);
+      if(!np1 && !np2)break;
+      const string file=JPartDataBi4::GetFileNamePart(cpart);
+      if(!np1 || !np2){
+        printf("%s: missing in %s\n",file.c_str(),(np1? dirs[1]: dirs[0]).c_str());
+        ndif++; nparts++;
+        break;
+      }
+      if(np1!=np2){
+        printf("%s: different number of pieces (%u and %u)\n",file.c_str(),np1,np2);
+        ndif++; nparts++;
+        continue;
+      }
+      bool ok=true;
+      for(unsigned piece=0;piece<np1;piece++)ok=(ComparePart(dirs[0],dirs[1],series[0],series[1],cpart,piece,np1,quiet) && ok);
+      if(!ok)ndif++;
+      nparts++;
+    }
+  }
+  catch(const JException &e){
+    printf("%s\n",e.ToStr().c_str());
+    delete series[0]; delete series[1];
+    return(2);
+  }
+  catch(...){
+    printf("Unknown error.\n");
+    delete series[0]; delete series[1];
+    return(2);
+  }
+  delete series[0]; delete series[1];
+  if(!nparts){ printf("No PART files found.\n"); return(2); }
+  printf("\n%u PARTs compared: %s\n",nparts,(ndif? fun::PrintStr("%u with differences",ndif).c_str(): "all identical"));
+  return(ndif? 1: 0);
+}
+
@@ -120,6 +120,8 @@ void PrintVar(const std::string &name,unsigned value,const std::string &post="")
 int FileType(const std::string &name);
 inline bool FileExists(const std::string &name){ return(FileType(name)==2); }
 inline bool DirExists(const std::string &name){ return(FileType(name)==1); }
+int Mkdir(const std::string &dirname);
+int FileTruncate(const std::string &file,llong size);
 
 std::string GetDirParent(const std::string &ruta);
 std::string GetFile(const std::string &ruta);
@@ -27,6 +27,10 @@
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#ifndef WIN32
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
 
 using namespace std;
 
@@ -355,12 +359,22 @@ void JBinaryDataArray::ReadFileData(bool resize){
   //printf("ReadFileData Parent_name:[%s] p:%p\n",Parent->GetName().c_str(),Parent);
   //printf("ReadFileData Parent2_name:[%s] p:%p\n",(Parent->GetParent()? Parent->GetParent()->GetName().c_str(): "none"),Parent->GetParent());
   //printf("ReadFileData root_name:[%s] p:%p\n",Parent->GetItemRoot()->GetName().c_str(),Parent->GetItemRoot());
-  ifstream *pf=Parent->GetItemRoot()->GetFileStructure();
+  const JBinaryData *root=Parent->GetItemRoot();
+  ifstream *pf=root->GetFileStructure();
   if(!pf||!pf->is_open())RunException(met,"The file with data is not available.");
   //printf("ReadFileData[%s]> fpos:%llu count:%u size:%u\n",Name.c_str(),FileDataPos,FileDataCount,FileDataSize);
   if(FileDataPos<0)RunException(met,"The access information to data file is not available.");
-  pf->seekg(FileDataPos,ios::beg);
-  ReadData(FileDataCount,FileDataSize,pf,resize);
+  if(Type==JBinaryDataDef::DatText){
+    pf->clear();
+    pf->seekg(FileDataPos,ios::beg);
+    ReadData(FileDataCount,FileDataSize,pf,resize);
+  }
+  else if(FileDataCount){
+    CheckMemory(FileDataCount,resize);
+    const unsigned stype=(unsigned)JBinaryDataDef::SizeOfType(Type);
+    root->ReadFileStructureData(FileDataPos,llong(stype)*FileDataCount,((byte*)Pointer)+size_t(stype)*Count);
+    Count+=FileDataCount;
+  }
 }
 
 //==============================================================================
@@ -493,18 +507,34 @@ unsigned JBinaryDataArray::GetDataCopy(unsigned size,void* pointer)const{
   }
   else{
     count=FileDataCount;
-    if(size>=count){
-      ifstream *pf=Parent->GetItemRoot()->GetFileStructure();
-      if(!pf||!pf->is_open())RunException(met,"The file with data is not available.");
-      pf->seekg(FileDataPos,ios::beg);
-      count=FileDataCount;
-      pf->read((char*)pointer,stype*count);
-    }
+    if(size>=count)Parent->GetItemRoot()->ReadFileStructureData(FileDataPos,llong(stype)*count,pointer);
   }
   if(size<count)RunException(met,"Size of array is not enough to store all data.");
   return(count);
 }
 
+//==============================================================================
+/// Copia count elementos desde first de Pointer o FileData al puntero indicado
+/// y devuelve el numero de elementos. Con FileData solo se lee el intervalo
+/// pedido.
+/// Copies count elements from first of Pointer or FileData to the indicated
+/// pointer and returns the number of elements. With FileData only the requested
+/// interval is read.
+//==============================================================================
+unsigned JBinaryDataArray::GetDataRange(unsigned first,unsigned count,void* pointer)const{
+  const char met[]="GetDataRange";
+  if(!DataInPointer()&&!DataInFile())RunException(met,"There are not available data in Pointer or FileData.");
+  const size_t stype=JBinaryDataDef::SizeOfType(GetType());
+  if(!stype)RunException(met,"Type of array is invalid for this function.");
+  const unsigned total=(DataInPointer()? GetCount(): FileDataCount);
+  if(first>total||count>total-first)RunException(met,"The requested interval is out of the array.");
+  if(count){
+    if(DataInPointer())memcpy(pointer,((const byte*)Pointer)+stype*first,stype*count);
+    else Parent->GetItemRoot()->ReadFileStructureData(FileDataPos+llong(stype)*first,llong(stype)*count,pointer);
+  }
+  return(count);
+}
+
 
 //##############################################################################
 //# JBinaryData
@@ -516,6 +546,7 @@ JBinaryData::JBinaryData(std::string name):Name(name){
   ClassName="JBinaryData";
   Parent=NULL;
   FileStructure=NULL;
+  FileStructureFd=-1;
   ValuesData=NULL;
   ValuesCacheReset();
   HideAll=HideValues=false;
@@ -531,6 +562,7 @@ JBinaryData::JBinaryData(const JBinaryData &src){
   ClassName="JBinaryData";
   Parent=NULL;
   FileStructure=NULL;
+  FileStructureFd=-1;
   ValuesData=NULL;
   ValuesCacheReset();
   *this=src;
@@ -1028,7 +1060,7 @@ void JBinaryData::WriteArrayData(std::fstream *pf,const JBinaryDataArray *ar)con
 /// Graba Array en fichero.
 /// Saves the Array in the file. 
 //==============================================================================
-void JBinaryData::WriteArray(std::fstream *pf,unsigned sbuf,byte *buf,const JBinaryDataArray *ar)const{
+void JBinaryData::WriteArray(std::fstream *pf,unsigned sbuf,byte *buf,const JBinaryDataArray *ar,std::vector<StFileArray> *farrays,const std::string &path)const{
   //-Calcula size de la definicion del array.
   unsigned sizearray=0;
   InArrayBase(sizearray,0,NULL,ar);
@@ -1038,14 +1070,25 @@ void JBinaryData::WriteArray(std::fstream *pf,unsigned sbuf,byte *buf,const JBin
   InArrayBase(cbuf,sbuf,buf,ar);
   pf->write((char*)buf,cbuf);
   //-Graba contenido del array. Saves contents of array.
+  const llong pos=(farrays? (llong)pf->tellp(): 0);
   WriteArrayData(pf,ar);
+  //-Anota posicion de los datos. Records position of the data.
+  if(farrays){
+    StFileArray fa;
+    fa.name=path+ar->GetName();
+    fa.type=ar->GetType();
+    fa.count=ar->GetCount();
+    fa.size=unsigned((llong)pf->tellp()-pos);
+    fa.pos=pos;
+    farrays->push_back(fa);
+  }
 }
 
 //==============================================================================
 /// Graba Item en fichero.
 /// Saves items to file.
 //==============================================================================
-void JBinaryData::WriteItem(std::fstream *pf,unsigned sbuf,byte *buf,bool all)const{
+void JBinaryData::WriteItem(std::fstream *pf,unsigned sbuf,byte *buf,bool all,std::vector<StFileArray> *farrays,const std::string &path)const{
   //-Calcula size de la definicion del item.
   //-Calculates the size of the item's definition.
   unsigned sizeitem=0;
@@ -1063,10 +1106,10 @@ void JBinaryData::WriteItem(std::fstream *pf,unsigned sbuf,byte *buf,bool all)co
   if(all||!GetHideValues())pf->write((char*)ValuesData,ValuesSize);
   //-Graba arrays.
   //-Save arrays.
-  for(unsigned c=0;c<Arrays.size();c++)if(all||!Arrays[c]->GetHide())WriteArray(pf,sbuf,buf,Arrays[c]);
+  for(unsigned c=0;c<Arrays.size();c++)if(all||!Arrays[c]->GetHide())WriteArray(pf,sbuf,buf,Arrays[c],farrays,path);
   //-Graba items.
   //-Save items.
-  for(unsigned c=0;c<Items.size();c++)if(all||!Items[c]->GetHide())Items[c]->WriteItem(pf,sbuf,buf,all);
+  for(unsigned c=0;c<Items.size();c++)if(all||!Items[c]->GetHide())Items[c]->WriteItem(pf,sbuf,buf,all,farrays,(farrays? path+Items[c]->GetName()+"/": path));
 }
 
 
@@ -1634,6 +1677,9 @@ void JBinaryData::OpenFileStructure(const std::string &file,const std::string &f
     const unsigned sbuf=1024;
     byte buf[sbuf];
     ReadItem(FileStructure,sbuf,buf,false,false);
+  #ifndef WIN32
+    FileStructureFd=open(file.c_str(),O_RDONLY);
+  #endif
   }
   else{
     CloseFileStructure();
@@ -1648,6 +1694,10 @@ void JBinaryData::OpenFileStructure(const std::string &file,const std::string &f
 void JBinaryData::CloseFileStructure(){
   if(FileStructure&&FileStructure->is_open())FileStructure->close();
   delete FileStructure; FileStructure=NULL;
+#ifndef WIN32
+  if(FileStructureFd>=0)close(FileStructureFd);
+#endif
+  FileStructureFd=-1;
 }
 
 //==============================================================================
@@ -1659,6 +1709,134 @@ std::ifstream* JBinaryData::GetFileStructure()const{
   return(FileStructure);
 }
 
+//==============================================================================
+/// Lee size bytes desde la posicion pos del fichero abierto con
+/// OpenFileStructure() u OpenFileSeries(). Con pread no se modifica la posicion
+/// del fichero, de modo que varios hilos pueden leer arrays a la vez.
+/// Reads size bytes from position pos of the file opened with
+/// OpenFileStructure() or OpenFileSeries(). With pread the file position is not
+/// modified, so several threads can read arrays at the same time.
+//==============================================================================
+void JBinaryData::ReadFileStructureData(llong pos,llong size,void *ptr)const{
+  const char met[]="ReadFileStructureData";
+  if(Parent)RunException(met,"Item is not root.");
+  if(!FileStructure||!FileStructure->is_open())RunException(met,"The file with data is not available.");
+  if(FileStructureFd>=0){
+  #ifndef WIN32
+    char *dat=(char*)ptr;
+    while(size>0){
+      const ssize_t n=pread(FileStructureFd,dat,size_t(size),off_t(pos));
+      if(n<=0)RunException(met,"File reading failure.");
+      dat+=n; pos+=n; size-=n;
+    }
+  #endif
+  }
+  else{
+    FileStructure->clear();
+    FileStructure->seekg(pos,ios::beg);
+    FileStructure->read((char*)ptr,size);
+    if(FileStructure->fail())RunException(met,"File reading failure.");
+  }
+}
+
+//==============================================================================
+/// Anhade a toc la tabla de contenidos de los arrays del item y subitems con
+/// la ruta de items en el nombre (ej: "PART_0000/Pos"). Para arrays sin datos
+/// en fichero pos es -1. Devuelve el numero de arrays anhadidos.
+/// Adds to toc the table of contents of the arrays of the item and subitems
+/// with the path of items in the name (eg: "PART_0000/Pos"). For arrays without
+/// data in file pos is -1. Returns the number of added arrays.
+//==============================================================================
+unsigned JBinaryData::GetFileToc(std::vector<StFileArray> &toc,const std::string &path)const{
+  const unsigned n0=unsigned(toc.size());
+  for(unsigned c=0;c<unsigned(Arrays.size());c++){
+    const JBinaryDataArray *ar=Arrays[c];
+    StFileArray fa;
+    fa.name=path+ar->GetName();
+    fa.type=ar->GetType();
+    fa.count=(ar->DataInFile()? ar->GetFileDataCount(): ar->GetCount());
+    fa.size=(ar->DataInFile()? ar->GetFileDataSize(): unsigned(JBinaryDataDef::SizeOfType(fa.type)*fa.count));
+    fa.pos=ar->GetFileDataPos();
+    toc.push_back(fa);
+  }
+  for(unsigned c=0;c<unsigned(Items.size());c++)Items[c]->GetFileToc(toc,path+Items[c]->GetName()+"/");
+  return(unsigned(toc.size())-n0);
+}
+
+//==============================================================================
+/// Graba cabecera de fichero de series en la posicion actual.
+/// Writes header of series file at the current position.
+//==============================================================================
+void JBinaryData::SaveFileSeriesHead(std::fstream *pf,const std::string &filecode)const{
+  StHeadFmtBin head=MakeFileHead(filecode); 
+  pf->write((char*)&head,sizeof(StHeadFmtBin));
+}
+
+//==============================================================================
+/// Graba item en la posicion actual de un fichero de series y devuelve su
+/// posicion. Con farrays anota la posicion de los datos de cada array.
+/// Writes item at the current position of a series file and returns its
+/// position. With farrays records the position of the data of each array.
+//==============================================================================
+llong JBinaryData::SaveFileSeriesItem(std::fstream *pf,bool all,std::vector<StFileArray> *farrays){
+  ValuesCachePrepare(true);
+  const llong pos=(llong)pf->tellp();
+  const unsigned sbuf=1024;
+  byte buf[sbuf];
+  WriteItem(pf,sbuf,buf,all,farrays,"");
+  if(pf->fail())RunException("SaveFileSeriesItem","File writing failure.");
+  return(pos);
+}
+
+//==============================================================================
+/// Abre fichero de series y comprueba cabecera pero sin cargar ningun item.
+/// Los items se cargan despues con LoadFileSeriesItem().
+/// Opens series file and checks header but without loading any item.
+/// Items are loaded later using LoadFileSeriesItem().
+//==============================================================================
+void JBinaryData::OpenFileSeries(const std::string &file,const std::string &filecode){
+  const char met[]="OpenFileSeries";
+  if(Parent)RunException(met,"Item is not root.");
+  Clear(); //-Limpia contenido de objeto. Clean object content.
+  FileStructure=new ifstream;
+  FileStructure->open(file.c_str(),ios::binary|ios::in);
+  if(*FileStructure){
+    StHeadFmtBin head;
+    FileStructure->read((char*)&head,sizeof(StHeadFmtBin));
+    if(FileStructure->fail())memset(&head,0,sizeof(StHeadFmtBin));
+    CheckHead(file,head,filecode);
+  #ifndef WIN32
+    FileStructureFd=open(file.c_str(),O_RDONLY);
+  #endif
+  }
+  else{
+    CloseFileStructure();
+    RunException(met,"Cannot open the file.",file);
+  }
+}
+
+//==============================================================================
+/// Carga item en la posicion indicada del fichero abierto con OpenFileSeries().
+/// Con create el item se anhade como nuevo subitem y en otro caso se carga sobre
+/// el propio objeto. Sin loadarraysdata los datos de arrays se leen bajo demanda.
+/// Loads item at the given position of the file opened with OpenFileSeries().
+/// With create the item is added as a new subitem, otherwise it is loaded on
+/// the object itself. Without loadarraysdata the array data is read on demand.
+//==============================================================================
+JBinaryData* JBinaryData::LoadFileSeriesItem(llong pos,bool create,bool loadarraysdata){
+  const char met[]="LoadFileSeriesItem";
+  if(Parent)RunException(met,"Item is not root.");
+  if(!FileStructure||!FileStructure->is_open())RunException(met,"The file with data is not available.");
+  FileStructure->clear();
+  FileStructure->seekg(pos,ios::beg);
+  const unsigned nitems=GetItemsCount();
+  const unsigned sbuf=1024;
+  byte buf[sbuf];
+  ReadItem(FileStructure,sbuf,buf,create,loadarraysdata);
+  if(FileStructure->fail())RunException(met,"File reading failure.");
+  return(create? GetItem(nitems): this);
+}
+
 //==============================================================================
 /// Graba contenido en fichero XML.
 /// Record XML file content.
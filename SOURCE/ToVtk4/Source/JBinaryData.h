@@ -110,6 +110,7 @@ class JBinaryDataArray : protected JObject
 
   const void* GetDataPointer()const;
   unsigned GetDataCopy(unsigned size,void* pointer)const;
+  unsigned GetDataRange(unsigned first,unsigned count,void* pointer)const;
 
   void AddText(const std::string &str,bool resize);
   void AddTexts(unsigned count,const std::string *strs,bool resize);
@@ -118,6 +119,7 @@ class JBinaryDataArray : protected JObject
   void ClearFileData();
   unsigned GetFileDataCount()const{ return(FileDataCount); }
   unsigned GetFileDataSize()const{ return(FileDataSize); }
+  llong GetFileDataPos()const{ return(FileDataPos); }
   void ReadFileData(bool resize);
 };
 
@@ -168,6 +170,15 @@ class JBinaryData : protected JObject
     };
   }StValue;
 
+  ///Structure that describes the position of the data of an array in a file.
+  typedef struct{
+    std::string name;             ///<Nombre del array con la ruta de items (ej: "Item1/Pos"). Name of array with the path of items (eg: "Item1/Pos").
+    JBinaryDataDef::TpData type;  ///<Tipo de datos. Type of data.
+    unsigned count;               ///<Numero de elementos. Number of elements.
+    unsigned size;                ///<Size de datos en fichero. Size of data in file.
+    llong pos;                    ///<Posicion de datos en fichero. Position of data in file.
+  }StFileArray;
+
  private:
   std::string Name;      ///<Nombre de item. Name of item.
   bool HideAll;          ///<Ignora el item en determinados metodos como SaveData(). It ignores the item in certain functions as SaveData().
@@ -181,6 +192,7 @@ class JBinaryData : protected JObject
   std::vector<StValue> Values;
 
   std::ifstream *FileStructure;
+  int FileStructureFd;   ///<Descriptor de FileStructure para lecturas con pread (-1:no disponible). Descriptor of FileStructure for reads with pread (-1:not available).
 
   //-Variables para cache de values. Variables to cache values.
   bool ValuesModif;
@@ -250,8 +262,8 @@ class JBinaryData : protected JObject
   void ValuesCachePrepare(bool down);
 
   void WriteArrayData(std::fstream *pf,const JBinaryDataArray *ar)const;
-  void WriteArray(std::fstream *pf,unsigned sbuf,byte *buf,const JBinaryDataArray *ar)const;
-  void WriteItem(std::fstream *pf,unsigned sbuf,byte *buf,bool all)const;
+  void WriteArray(std::fstream *pf,unsigned sbuf,byte *buf,const JBinaryDataArray *ar,std::vector<StFileArray> *farrays=NULL,const std::string &path="")const;
+  void WriteItem(std::fstream *pf,unsigned sbuf,byte *buf,bool all,std::vector<StFileArray> *farrays=NULL,const std::string &path="")const;
 
   unsigned ReadUint(std::ifstream *pf)const;
   void ReadArrayData(std::ifstream *pf,JBinaryDataArray *ar,unsigned countdata,unsigned sizedata,bool loadarraysdata);
@@ -308,6 +320,13 @@ class JBinaryData : protected JObject
   void OpenFileStructure(const std::string &file,const std::string &filecode="");
   void CloseFileStructure();
   std::ifstream* GetFileStructure()const;
+  void ReadFileStructureData(llong pos,llong size,void *ptr)const;
+  unsigned GetFileToc(std::vector<StFileArray> &toc,const std::string &path="")const;
+
+  void SaveFileSeriesHead(std::fstream *pf,const std::string &filecode)const;
+  llong SaveFileSeriesItem(std::fstream *pf,bool all,std::vector<StFileArray> *farrays=NULL);
+  void OpenFileSeries(const std::string &file,const std::string &filecode="");
+  JBinaryData* LoadFileSeriesItem(llong pos,bool create,bool loadarraysdata);
 
   void SaveFileXml(std::string file,bool svarrays=false,const std::string &head=" fmt=\"JBinaryData\"")const;
 
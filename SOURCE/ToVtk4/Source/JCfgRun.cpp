@@ -39,6 +39,8 @@ void JCfgRun::Reset(){
   FileXml="";
   First=-1;  Last=-1;
   SaveVtk=""; SaveCsv="";
+  OutIdp=OutVel=OutRhop=OutType=OutMk=OutPres=true;
+  OmpThreads=0;
 }
 
 //==============================================================================
@@ -59,6 +61,14 @@ void JCfgRun::VisuInfo()const{
   printf("  Define output files:\n");
   printf("    -savevtk <file>    Generates VTK(polydata) files with particle data\n");
   printf("    -savecsv <file>    Generates CSV files with particle data\n\n");
+  printf("    -vars:<values>     Selects the variables to be stored (+var adds and\n");
+  printf("                       -var removes): all,idp,vel,rhop,type,mk,pres.\n");
+  printf("                       Only the arrays needed by the selected variables\n");
+  printf("                       are read from the PART files (def=all)\n\n");
+  printf("  Execution options:\n");
+  printf("    -threads:<int>     Number of PARTs converted at the same time. Each\n");
+  printf("                       thread keeps its own particle arrays, so memory\n");
+  printf("                       grows with this value (def=number of cores)\n\n");
   printf("  Examples:\n");
   printf("     ToVtk4 -dirin . -filexml case.xml -savevkt part.vtk -savecsv: data\n");
   printf("\n");
@@ -77,6 +87,8 @@ void JCfgRun::VisuConfig()const{
   if(Last>=0)PrintVar("  Last",Last,ln);
   PrintVar("  SaveVtk",SaveVtk,ln);
   PrintVar("  SaveCsv",SaveCsv,ln);
+  PrintVar("  Vars",GetVarsStr(),ln);
+  if(OmpThreads>0)PrintVar("  OmpThreads",OmpThreads,ln);
   printf("\n");
 }
 
@@ -186,6 +198,8 @@ void JCfgRun::LoadOpts(std::string *optlis,int optn,int lv,std::string file){
       else if(txword=="LAST"){  Last=atoi(txopt.c_str()); if(Last<0)Last=-1; } 
       else if(txword=="SAVEVTK"&&c+1<optn){ SaveVtk=optlis[c+1]; c++; }
       else if(txword=="SAVECSV"&&c+1<optn){ SaveCsv=optlis[c+1]; c++; }
+      else if(txword=="THREADS"){ OmpThreads=atoi(txopt.c_str()); if(OmpThreads<0)OmpThreads=0; }
+      else if(txword=="VARS"){ if(!LoadVars(txopt))ErrorParm(opt,c,lv,file); }
       else if(txword=="OPT"&&c+1<optn){ LoadFile(optlis[c+1],lv+1); c++; }
       else if(txword=="H"||txword=="HELP"||txword=="?")PrintInfo=true;
       else ErrorParm(opt,c,lv,file);
@@ -201,3 +215,41 @@ void JCfgRun::ValidaCfg(){
   if(SaveVtk.empty()&&SaveCsv.empty())RunException(met,"Output files were not defined.");
 }
 
+//==============================================================================
+/// Loads the list of output variables (eg: "-all,+vel,+rhop"). Each value
+/// adds (+ or nothing) or removes (-) a variable. Returns false when some
+/// value is invalid.
+//==============================================================================
+bool JCfgRun::LoadVars(std::string txvars){
+  bool ok=true;
+  while(ok && !txvars.empty()){
+    const int pos=int(txvars.find(","));
+    string tx=StrUpper(StrTrim(pos>=0? txvars.substr(0,pos): txvars));
+    txvars=(pos>=0? txvars.substr(pos+1): "");
+    bool val=true;
+    if(!tx.empty()&&(tx[0]=='+'||tx[0]=='-')){ val=(tx[0]=='+'); tx=tx.substr(1); }
+    if(tx=="ALL")OutIdp=OutVel=OutRhop=OutType=OutMk=OutPres=val;
+    else if(tx=="IDP")OutIdp=val;
+    else if(tx=="VEL")OutVel=val;
+    else if(tx=="RHOP")OutRhop=val;
+    else if(tx=="TYPE")OutType=val;
+    else if(tx=="MK")OutMk=val;
+    else if(tx=="PRES"||tx=="PRESS")OutPres=val;
+    else ok=false;
+  }
+  return(ok);
+}
+
+//==============================================================================
+/// Returns the list of selected output variables.
+//==============================================================================
+std::string JCfgRun::GetVarsStr()const{
+  string tx;
+  if(OutIdp) tx=tx+",Idp";
+  if(OutVel) tx=tx+",Vel";
+  if(OutRhop)tx=tx+",Rhop";
+  if(OutType)tx=tx+",Type";
+  if(OutMk)  tx=tx+",Mk";
+  if(OutPres)tx=tx+",Pres";
+  return(tx.empty()? string("none"): tx.substr(1));
+}
@@ -36,6 +36,11 @@ public:
 
   std::string SaveVtk;
   std::string SaveCsv;
+
+  //-Variables de salida. Output variables.
+  bool OutIdp,OutVel,OutRhop,OutType,OutMk,OutPres;
+
+  int OmpThreads;  ///<Number of PARTs converted at the same time (0:number of cores).
   
 public:
   void ClearFilesIn(){ DirIn=""; FileIn=""; }
@@ -51,6 +56,8 @@ public:
   void LoadOpts(std::string *optlis,int optn,int lv,std::string file);
   void ErrorParm(const std::string &opt,int optc,int lv,const std::string &file)const;
   bool VtuOptGet(std::string name);
+  bool LoadVars(std::string txvars);
+  std::string GetVarsStr()const;
   void ValidaCfg();
 };
 
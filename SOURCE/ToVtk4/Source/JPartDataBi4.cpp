@@ -18,6 +18,7 @@
 /// \file JPartDataBi4.cpp \brief Implements the class \ref JPartDataBi4.
 
 #include "JPartDataBi4.h"
+#include "JPartSeriesBi4.h"
 //#include "JBinaryData.h"
 #include "Functions.h"
 
@@ -407,7 +408,7 @@ unsigned JPartDataBi4::GetPiecesFileCase(std::string dir,std::string casename)co
 //==============================================================================
 unsigned JPartDataBi4::GetPiecesFilePart(std::string dir,unsigned cpart)const{
   unsigned npieces=0;
-  if(fun::FileExists(Dir+GetFileNamePart(cpart,0,1)))npieces=1;
+  if(fun::FileExists(dir+GetFileNamePart(cpart,0,1)))npieces=1;
   else npieces=GetPiecesFile(dir+GetFileNamePart(cpart,0,2));
   return(npieces);
 }
@@ -443,6 +444,35 @@ void JPartDataBi4::LoadFilePart(std::string dir,unsigned cpart,unsigned piece,un
   LoadFileData(fun::GetDirWithSlash(dir)+GetFileNamePart(cpart,piece,npiece),cpart,piece,npiece);
 }
 
+//==============================================================================
+/// Carga PART de ficheros de series usando el indice ya cargado en series.
+/// Los datos de los arrays se leen bajo demanda.
+/// Loads PART from series files using the index already loaded in series.
+/// The array data is read on demand.
+//==============================================================================
+void JPartDataBi4::LoadFileSeries(const JPartSeriesBi4Load *series,unsigned cpart){
+  const char met[]="LoadFileSeries";
+  ResetData();
+  const JPartSeriesBi4Load::StPartPos &ps=series->GetPart(cpart);
+  Data->OpenFileSeries(series->GetFile(ps.file),ClassName);
+  Data->LoadFileSeriesItem(series->GetDataPos(ps.file),false,true);
+  Part=Data->LoadFileSeriesItem(ps.pos,true,false);
+  if(Part->GetName()!=GetNamePart(cpart))RunException(met,"PART data is invalid.",series->GetFile(ps.file));
+  Cpart=Part->GetvUint("Cpart");
+  Piece=Data->GetvUint("Piece");
+  Npiece=Data->GetvUint("Npiece");
+}
+
+//==============================================================================
+/// Carga PART de los ficheros de series del directorio indicado.
+/// Loads PART from the series files in the given directory.
+//==============================================================================
+void JPartDataBi4::LoadFileSeries(std::string dir,unsigned cpart){
+  JPartSeriesBi4Load series;
+  series.Config(dir);
+  LoadFileSeries(&series,cpart);
+}
+
 //==============================================================================
 /// Devuelve el puntero a Part con los datos del PART.
 /// Returns a pointer to Part with the data of the PART.
@@ -9,6 +9,7 @@
 #include <vector>
 #include <fstream>
 
+class JPartSeriesBi4Load;
 
 //##############################################################################
 //# JPartDataBi4
@@ -105,6 +106,8 @@ class JPartDataBi4 : protected JObject
   unsigned GetPiecesFilePart(std::string dir,unsigned cpart)const;
   void LoadFileCase(std::string dir,std::string casename,unsigned piece=0,unsigned npiece=1);
   void LoadFilePart(std::string dir,unsigned cpart,unsigned piece=0,unsigned npiece=1);
+  void LoadFileSeries(const JPartSeriesBi4Load *series,unsigned cpart);
+  void LoadFileSeries(std::string dir,unsigned cpart);
 
   //Obtencion de datos basicos:
   //Obtaining basic data:
@@ -180,6 +183,8 @@ class JPartDataBi4 : protected JObject
   unsigned Get_Rhop (unsigned size,float    *data)const{ return(GetArray("Rhop",JBinaryDataDef::DatFloat  )->GetDataCopy(size,data)); }
   unsigned Get_Mass (unsigned size,float    *data)const{ return(GetArray("Mass",JBinaryDataDef::DatFloat  )->GetDataCopy(size,data)); }
   unsigned Get_Hvar (unsigned size,float    *data)const{ return(GetArray("Hvar",JBinaryDataDef::DatFloat  )->GetDataCopy(size,data)); }
+  unsigned Get_ArrayRange(std::string name,JBinaryDataDef::TpData type,unsigned first,unsigned count,void *data)const{ return(GetArray(name,type)->GetDataRange(first,count,data)); }
+  unsigned GetArraysToc(std::vector<JBinaryData::StFileArray> &toc)const{ return(GetPart()->GetFileToc(toc)); }
 };
 
 
@@ -20,6 +20,7 @@
 #include "JCfgRun.h"
 #include "TypesDef.h"
 #include "JPartDataBi4.h"
+#include "JPartSeriesBi4.h"
 #include "JCreateVtk.h"
 #include "JXml.h"
 #include "JSpaceCtes.h"
@@ -33,6 +34,10 @@
 #include <cmath>
 #include <cstring>
 #include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <exception>
+#include <omp.h>
 
 //using namespace std;
 using std::string;
@@ -55,17 +60,193 @@ void ExceptionText(string msg){
   throw msg;
 }
 
+//==============================================================================
+/// Case data shared by all PARTs.
+//==============================================================================
+typedef struct{
+  unsigned casenp,casenfixed,casenmoving,casenfloat;
+  double cteb,rhop0,gamma;
+}StCaseData;
+
+//==============================================================================
+/// Particle arrays to process one PART (one set per thread). Only the arrays
+/// needed by the selected output variables are allocated.
+//==============================================================================
+typedef struct{
+  unsigned *idp;
+  tfloat3 *pos,*vel;
+  tdouble3 *posd;
+  float *rhop;
+  unsigned *ridp;
+  byte *type,*mk;
+  float *pres;
+}StPartBuf;
+
+//==============================================================================
+/// Allocates the arrays of buf for size particles.
+//==============================================================================
+void AllocPartBuf(const JCfgRun *cfg,unsigned size,StPartBuf &buf){
+  memset(&buf,0,sizeof(StPartBuf));
+  buf.pos=new tfloat3[size];
+  if(cfg->OutIdp||cfg->OutType||cfg->OutMk)buf.idp=new unsigned[size];
+  if(cfg->OutVel)buf.vel=new tfloat3[size];
+  if(cfg->OutRhop||cfg->OutPres)buf.rhop=new float[size];
+  if(cfg->OutMk)buf.mk=new byte[size];
+  if(cfg->OutType)buf.type=new byte[size];
+  if(cfg->OutPres)buf.pres=new float[size];
+  if(cfg->OutMk)buf.ridp=new unsigned[size];
+}
+
+//==============================================================================
+/// Frees the arrays of buf.
+//==============================================================================
+void FreePartBuf(StPartBuf &buf){
+  delete[] buf.pos;  delete[] buf.posd;
+  delete[] buf.vel;  delete[] buf.rhop;
+  delete[] buf.idp;  delete[] buf.ridp;
+  delete[] buf.mk;   delete[] buf.type;
+  delete[] buf.pres;
+  memset(&buf,0,sizeof(StPartBuf));
+}
+
+//==============================================================================
+/// Returns the number of pieces of PART (MPI runs save one piece per process).
+//==============================================================================
+unsigned PartPieces(const JCfgRun *cfg,const JPartSeriesBi4Load *series,byte npie,int part){
+  if(series||npie<2)return(1);
+  JPartDataBi4 pd;
+  const unsigned npiece=(!cfg->FileIn.empty()? pd.GetPiecesFileCase("",cfg->FileIn): pd.GetPiecesFilePart(fun::GetDirWithSlash(cfg->DirIn),part));
+  if(!npiece)ExceptionText("Error: The number of pieces of PART is invalid.");
+  return(npiece);
+}
+
+//==============================================================================
+/// Loads one piece of PART structure (the array data is read on demand).
+//==============================================================================
+void LoadPart(const JCfgRun *cfg,const JPartSeriesBi4Load *series,int part,unsigned piece,unsigned npiece,bool print,JPartDataBi4 &pd){
+  if(print){
+    string file;
+    if(series)file=fun::PrintStr("%s (PART_%04d)",series->GetFile(series->GetPart(part).file).c_str(),part);
+    else file=(!cfg->FileIn.empty()? JPartDataBi4::GetFileNameCase(cfg->FileIn,piece,npiece): fun::GetDirWithSlash(cfg->DirIn)+JPartDataBi4::GetFileNamePart(part,piece,npiece));
+    #pragma omp critical (print)
+    printf("load> %s\n",file.c_str());
+  }
+  if(series)pd.LoadFileSeries(series,part);
+  else if(!cfg->FileIn.empty())pd.LoadFileCase("",cfg->FileIn,piece,npiece);
+  else pd.LoadFilePart(cfg->DirIn,part,piece,npiece);
+  if(series && pd.GetNpiece()>1)ExceptionText("Error: The number of pieces in series files is higher than 1.");
+}
+
+//==============================================================================
+/// Converts one PART: loads only the needed arrays from the file, computes the
+/// derived variables and saves the VTK/CSV files.
+/// The pieces of PART saved by MPI runs are merged in one VTK/CSV file.
+//==============================================================================
+void ProcessPart(const JCfgRun *cfg,const JSpaceParts *xmlparts,const JPartSeriesBi4Load *series
+  ,byte npie,int part,const StCaseData &cdat,StPartBuf &buf)
+{
+  const bool onefile=!cfg->FileIn.empty();
+  const unsigned npiece=PartPieces(cfg,series,npie,part);
+
+  //-Reads particle data of all pieces.
+  unsigned np=0;
+  for(unsigned piece=0;piece<npiece;piece++){
+    JPartDataBi4 pd;
+    LoadPart(cfg,series,part,piece,npiece,true,pd);
+    const unsigned npp=pd.Get_Npok();
+    if(np+npp>cdat.casenp)ExceptionText("Error: The number of particles in PART is higher than CaseNp.");
+    if(npp){
+      if(buf.idp)pd.Get_Idp(npp,buf.idp+np);
+      if(buf.vel)pd.Get_Vel(npp,buf.vel+np);
+      if(buf.rhop)pd.Get_Rhop(npp,buf.rhop+np);
+      if(pd.Get_PosSimple())pd.Get_Pos(npp,buf.pos+np);
+      else{
+        if(!buf.posd)buf.posd=new tdouble3[cdat.casenp];
+        pd.Get_Posd(npp,buf.posd);
+        for(unsigned p=0;p<npp;p++)buf.pos[np+p]=ToTFloat3(buf.posd[p]);
+      }
+    }
+    np+=npp;
+  }
+
+  //-Computes other vars (in parallel when PARTs are not processed in parallel).
+  const int n=int(np);
+  if(buf.pres){
+    const float *rhop=buf.rhop;
+    float *pres=buf.pres;
+    #pragma omp parallel for schedule (static) if(!omp_in_parallel())
+    for(int c=0;c<n;c++)pres[c]=(float)(cdat.cteb*(pow(rhop[c]/cdat.rhop0,cdat.gamma)-1.));
+  }
+  if(buf.type){
+    const unsigned *idp=buf.idp;
+    byte *type=buf.type;
+    #pragma omp parallel for schedule (static) if(!omp_in_parallel())
+    for(int p=0;p<n;p++){
+      const unsigned id=idp[p];
+      type[p]=(id<cdat.casenfixed? 0: (id<cdat.casenmoving? 1: (id<cdat.casenfloat? 2: 3)));
+    }
+  }
+  if(buf.mk){
+    const unsigned *idp=buf.idp;
+    unsigned *ridp=buf.ridp;
+    byte *mk=buf.mk;
+    #pragma omp parallel if(!omp_in_parallel())
+    {
+      #pragma omp for schedule (static)
+      for(int c=0;c<n;c++)ridp[idp[c]]=unsigned(c);
+      for(unsigned c=0;c<xmlparts->CountBlocks();c++){
+        const JSpacePartBlock &block=xmlparts->GetBlock(c);
+        const byte mkblock=(byte)block.GetMk();
+        const int ipini=int(block.GetBegin());
+        const int ipend=int(block.GetBegin()+block.GetCount());
+        #pragma omp for schedule (static)
+        for(int ip=ipini;ip<ipend;ip++)mk[ridp[ip]]=mkblock;
+      }
+    }
+  }
+
+  //-Defines variables to save in VTk or CSV.
+  JCreateVtk::StScalarData fields[6];
+  unsigned nfields=0;
+  if(cfg->OutIdp){ fields[nfields]=JCreateVtk::DefineField("Idp" ,JCreateVtk::UInt32 ,1,buf.idp);   nfields++; }
+  if(cfg->OutVel){ fields[nfields]=JCreateVtk::DefineField("Vel" ,JCreateVtk::Float32,3,buf.vel);   nfields++; }
+  if(cfg->OutRhop){fields[nfields]=JCreateVtk::DefineField("Rhop",JCreateVtk::Float32,1,buf.rhop);  nfields++; }
+  if(buf.type){ fields[nfields]=JCreateVtk::DefineField("Type",JCreateVtk::UChar8 ,1,buf.type);  nfields++; }
+  if(buf.pres){ fields[nfields]=JCreateVtk::DefineField("Pres",JCreateVtk::Float32,1,buf.pres);  nfields++; }
+  if(buf.mk){   fields[nfields]=JCreateVtk::DefineField("Mk"  ,JCreateVtk::UChar8 ,1,buf.mk);    nfields++; }
+
+  //-Saves VTK files.
+  if(!cfg->SaveVtk.empty()){
+    string fileout=(onefile? cfg->SaveVtk: fun::FileNameSec(cfg->SaveVtk,part));
+    if(fun::GetExtension(fileout).empty())fileout=fun::AddExtension(fileout,"vtk");
+    #pragma omp critical (print)
+    printf("SaveVTK> %s\n",fun::ShortFileName(fileout,68).c_str());
+    JCreateVtk::SaveVtk(fileout,np,buf.pos,nfields,fields);
+  }
+  //-Saves CSV files.
+  if(!cfg->SaveCsv.empty()){
+    string fileout=(onefile? cfg->SaveCsv: fun::FileNameSec(cfg->SaveCsv,part));
+    if(fun::GetExtension(fileout).empty())fileout=fun::AddExtension(fileout,"csv");
+    #pragma omp critical (print)
+    printf("SaveCSV> %s\n",fun::ShortFileName(fileout,68).c_str());
+    JCreateVtk::SaveCsv(fileout,np,buf.pos,nfields,fields);
+  }
+}
+
 //==============================================================================
 /// Processes files.
+/// Only the arrays needed by the selected output variables are read from each
+/// PART (Pos always, Idp for idp/type/mk, Vel for vel and Rhop for rhop/pres).
+/// PARTs are converted in parallel, one per thread, so the reading of some
+/// PARTs overlaps the writing of others. Memory is bounded by the number of
+/// threads since each thread reuses its own set of arrays.
 //==============================================================================
 void RunFiles(const JCfgRun *cfg){
-  const bool outtype=true,outmk=true,outpres=true;
-
   //-Reads XML file.
   JSpaceCtes* xmlctes=NULL;
   JSpaceEParms* xmleparms=NULL;
   JSpaceParts* xmlparts=NULL;
-  if(outmk){
+  if(cfg->OutMk){
     if(!fun::FileExists(cfg->FileXml))ExceptionFile("XML file of case was not found.",(cfg->FileXml.empty()? string("???"): cfg->FileXml));
     JXml xml; xml.LoadFile(cfg->FileXml);
     xmlctes=new JSpaceCtes();     xmlctes->LoadXmlRun(&xml,"case.execution.constants");
@@ -73,152 +254,77 @@ void RunFiles(const JCfgRun *cfg){
     xmlparts=new JSpaceParts();   xmlparts->LoadXml(&xml,"case.execution.particles");
   }
 
-  //-Prepares input files.
+  //-Prepares input files (Part_XXXX.bi4 or PartSeries_XXXX.bi4s).
   const bool onefile=!cfg->FileIn.empty();
-  const string casein=cfg->FileIn;
   const string dirin=fun::GetDirWithSlash(cfg->DirIn);
   const int last=cfg->Last;
   int part=(onefile||cfg->First<0? 0: cfg->First);
-
-  unsigned npiece=0;
-  unsigned casenp=0,casenbound=0,casenfixed=0,casenmoving=0,casenfloat=0,casenfluid=0;
-  double cteb=0,rhop0=0,gamma=0;
-
-  double timestep=0;
-  unsigned *idp=NULL;
-  tfloat3 *pos=NULL,*vel=NULL;
-  tdouble3 *posd=NULL;
-  float *rhop=NULL;
-  unsigned *ridp=NULL;
-  byte *type=NULL,*mk=NULL;
-  float *pres=NULL;
-
-  //-Processes input files.
   byte npie=0;
-  string file=JPartDataBi4::GetFileData(casein,dirin,part,npie);
-  if(file.empty())ExceptionText("Error: Data files not found.");
-  bool firstdata=true;
-  while((last<0||part<=last) && fun::FileExists(file)){
-    if(!npiece){//-Reads initial data.
-      JPartDataBi4 pd;
-      if(onefile)pd.LoadFileCase("",casein,0,npie);
-      else pd.LoadFilePart(dirin,part,0,npie);
-      npiece=pd.GetNpiece();
-      if(npiece>1)ExceptionText("Error: The number of pieces is higher than 1.");
-      casenp=(unsigned)pd.Get_CaseNp();
-      if(pd.Get_CaseNp()!=casenp)ExceptionText("Error: The number of particles is too big.");
-      if(!pd.Get_IdpSimple())ExceptionText("Error: Only Idp (32 bits) is valid at the moment.");
-      casenfluid=(unsigned)pd.Get_CaseNfluid();
-      casenfixed=(unsigned)pd.Get_CaseNfixed();
-      casenmoving=(unsigned)pd.Get_CaseNmoving();
-      casenfloat=(unsigned)pd.Get_CaseNfloat();
-      casenbound=casenp-casenfluid;
-      cteb=pd.Get_B();
-      rhop0=pd.Get_Rhop0();
-      gamma=pd.Get_Gamma();
-      pos=new tfloat3[casenp];
-      posd=new tdouble3[casenp];
-      vel=new tfloat3[casenp];
-      rhop=new float[casenp];
-      idp=new unsigned[casenp];
-      //-Allocates memory to other variables.
-      if(outmk)mk=new byte[casenp];
-      if(outtype)type=new byte[casenp];
-      if(outpres)pres=new float[casenp];
-      if(outmk)ridp=new unsigned[casenp];
-    }
+  string file=JPartDataBi4::GetFileData(cfg->FileIn,dirin,part,npie);
+  JPartSeriesBi4Load *series=NULL;
+  if(file.empty() && !onefile && JPartSeriesBi4Load::Exists(dirin)){
+    series=new JPartSeriesBi4Load();
+    series->Config(dirin);
+  }
+  if(file.empty() && !series)ExceptionText("Error: Data files not found.");
+  std::vector<int> parts;
+  if(onefile)parts.push_back(part);
+  else for(;(last<0||part<=last) && (series? series->PartExists(part): fun::FileExists(dirin+JPartDataBi4::GetFileNamePart(part,0,npie)));part++)parts.push_back(part);
+
+  //-Reads case data from the first PART.
+  StCaseData cdat;
+  {
+    JPartDataBi4 pd;
+    LoadPart(cfg,series,parts[0],0,PartPieces(cfg,series,npie,parts[0]),false,pd);
+    cdat.casenp=(unsigned)pd.Get_CaseNp();
+    if(pd.Get_CaseNp()!=cdat.casenp)ExceptionText("Error: The number of particles is too big.");
+    if((cfg->OutIdp||cfg->OutType||cfg->OutMk) && !pd.Get_IdpSimple())ExceptionText("Error: Only Idp (32 bits) is valid at the moment.");
+    cdat.casenfixed=(unsigned)pd.Get_CaseNfixed();
+    cdat.casenmoving=(unsigned)pd.Get_CaseNmoving();
+    cdat.casenfloat=(unsigned)pd.Get_CaseNfloat();
+    cdat.cteb=pd.Get_B();
+    cdat.rhop0=pd.Get_Rhop0();
+    cdat.gamma=pd.Get_Gamma();
+  }
 
-    //-Reads particle data.
-    unsigned np=0;
-    for(unsigned cp=0;cp<npiece && cp<1;cp++){
-      file=(onefile? JPartDataBi4::GetFileNameCase(casein,cp,npiece): dirin+JPartDataBi4::GetFileNamePart(part,cp,npiece));
-      if(!cp)printf("load> %s\n",file.c_str());
-      JPartDataBi4 pd;
-      if(onefile)pd.LoadFileCase("",casein,0,npiece);
-      else pd.LoadFilePart(dirin,part,0,npiece);
-      if(!cp)timestep=pd.Get_TimeStep();
-      const bool possimple=pd.Get_PosSimple();
-      const unsigned npok=pd.Get_Npok();
-      if(npok){
-        //-Loads data from PART.
-        pd.Get_Idp(npok,idp);
-        pd.Get_Vel(npok,vel);
-        pd.Get_Rhop(npok,rhop);
-        if(possimple){
-          pd.Get_Pos(npok,pos);
+  //-Processes PARTs.
+  const int nparts=int(parts.size());
+  const int ompthreads=(cfg->OmpThreads>0? cfg->OmpThreads: omp_get_num_procs());
+  const int nthreads=std::max(1,std::min(ompthreads,nparts));
+  std::exception_ptr error;
+  int failed=0;
+  #pragma omp parallel num_threads(nthreads)
+  {
+    StPartBuf buf;
+    memset(&buf,0,sizeof(StPartBuf));
+    #pragma omp for schedule (dynamic)
+    for(int cp=0;cp<nparts;cp++){
+      int stop;
+      #pragma omp atomic read
+      stop=failed;
+      if(!stop){
+        try{
+          if(!buf.pos)AllocPartBuf(cfg,cdat.casenp,buf);
+          ProcessPart(cfg,xmlparts,series,npie,parts[cp],cdat,buf);
         }
-        else{ 
-          pd.Get_Posd(npok,posd);
-          for(unsigned p=0;p<npok;p++)pos[p]=ToTFloat3(posd[p]);
+        catch(...){
+          #pragma omp critical (error)
+          {
+            if(!failed)error=std::current_exception();
+            failed=1;
+          }
         }
       }
-      np=npok;
-    }
-
-    //-Loads other vars.
-    if(pres)for(unsigned c=0;c<np;c++)pres[c]=(float)(cteb*(pow(rhop[c]/rhop0,gamma)-1.));
-    if(type){
-      for(unsigned p=0;p<np;p++){
-        const unsigned id=idp[p];
-        type[p]=(id<casenfixed? 0: (id<casenmoving? 1: (id<casenfloat? 2: 3)));
-      }
-    }
-    if(ridp)for(unsigned c=0;c<np;c++)ridp[idp[c]]=c;
-    if(mk){
-      for(unsigned c=0;c<xmlparts->CountBlocks();c++){
-        const JSpacePartBlock &block=xmlparts->GetBlock(c);
-        const byte mkblock=(byte)block.GetMk();
-        const unsigned ipend=block.GetBegin()+block.GetCount();
-        for(unsigned ip=block.GetBegin();ip<ipend;ip++)mk[ridp[ip]]=mkblock;
-      }
-    }
-
-    //-Defines variables to save in VTk or CSV.
-    JCreateVtk::StScalarData fields[6];
-    unsigned nfields=0;
-    fields[nfields]=JCreateVtk::DefineField("Idp" ,JCreateVtk::UInt32 ,1,idp);  nfields++;
-    fields[nfields]=JCreateVtk::DefineField("Vel" ,JCreateVtk::Float32,3,vel);  nfields++;
-    fields[nfields]=JCreateVtk::DefineField("Rhop",JCreateVtk::Float32,1,rhop); nfields++;
-    if(type){ fields[nfields]=JCreateVtk::DefineField("Type",JCreateVtk::UChar8 ,1,type);  nfields++; }
-    if(pres){ fields[nfields]=JCreateVtk::DefineField("Pres",JCreateVtk::Float32,1,pres);  nfields++; }
-    if(mk){   fields[nfields]=JCreateVtk::DefineField("Mk"  ,JCreateVtk::UChar8 ,1,mk);    nfields++; }
-
-    //-Saves VTK files.
-    if(!cfg->SaveVtk.empty()){
-      string fileout=(onefile? cfg->SaveVtk: fun::FileNameSec(cfg->SaveVtk,part));
-      if(fun::GetExtension(fileout).empty())fileout=fun::AddExtension(fileout,"vtk");
-      printf("SaveVTK> %s\n",fun::ShortFileName(fileout,68).c_str());
-      JCreateVtk::SaveVtk(fileout,np,pos,nfields,fields);
-    }
-    //-Saves CSV files.
-    if(!cfg->SaveCsv.empty()){
-      string fileout=(onefile? cfg->SaveCsv: fun::FileNameSec(cfg->SaveCsv,part));
-      if(fun::GetExtension(fileout).empty())fileout=fun::AddExtension(fileout,"csv");
-      printf("SaveCSV> %s\n",fun::ShortFileName(fileout,68).c_str());
-      JCreateVtk::SaveCsv(fileout,np,pos,nfields,fields);
-    }
-
-    firstdata=false;
-    if(!onefile){
-      part++;
-      file=dirin+JPartDataBi4::GetFileNamePart(part,0,npiece);
     }
-    else break;
+    FreePartBuf(buf);
   }
 
   //-Free memory.
-  delete[] pos;  pos=NULL;
-  delete[] posd; posd=NULL;
-  delete[] vel;  vel=NULL;
-  delete[] rhop; rhop=NULL;
-  delete[] idp; idp=NULL;
-  delete[] ridp; ridp=NULL;
-  delete[] mk;   mk=NULL;
-  delete[] type; type=NULL;
-  delete[] pres; pres=NULL;
+  delete series; series=NULL;
   delete xmlctes;   xmlctes=NULL;
   delete xmleparms; xmleparms=NULL;
   delete xmlparts;  xmlparts=NULL;
+  if(failed)std::rethrow_exception(error);
 }
 
 //==============================================================================